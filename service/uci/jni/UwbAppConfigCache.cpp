@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "UwbAppConfigCache.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Walk a TLV list, calling f(id, value, valueLen) for every entry */
+template <typename F>
+static bool forEachTlv(const uint8_t *tlvs, uint16_t len, F f) {
+  uint16_t offset = 0;
+  while (offset < len) {
+    if (len - offset < UWB_APP_CONFIG_TLV_HDR_SIZE) {
+      return false;
+    }
+    uint8_t id = tlvs[offset];
+    uint8_t valueLen = tlvs[offset + 1];
+    offset += UWB_APP_CONFIG_TLV_HDR_SIZE;
+    if (len - offset < valueLen) {
+      return false;
+    }
+    f(id, &tlvs[offset], valueLen);
+    offset += valueLen;
+  }
+  return true;
+}
+
+bool UwbAppConfigCache::store(const uint8_t *tlvs, uint16_t len) {
+  std::map<uint8_t, std::vector<uint8_t>> values = mValues;
+  if (!forEachTlv(tlvs, len,
+                  [&values](uint8_t id, const uint8_t *value,
+                            uint8_t valueLen) {
+                    values[id].assign(value, value + valueLen);
+                  })) {
+    return false;
+  }
+  mValues.swap(values);
+  return true;
+}
+
+bool UwbAppConfigCache::storeApplied(const uint8_t *tlvs, uint16_t len,
+                                     uint8_t status) {
+  if (!store(tlvs, len)) {
+    return false;
+  }
+  mAcked = true;
+  mAckStatus = status;
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        setSessionState
+**
+** Description:     Track the state reported by SESSION_STATUS_NTF. Only IDLE
+**                  and ACTIVE keep the applied app configs, a session that
+**                  goes back to INIT (or DEINIT, or anything unknown) starts
+**                  over from the UWBS defaults.
+**
+** Params:          state: session state of the notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbAppConfigCache::setSessionState(uint8_t state) {
+  if (state != UWB_SESSION_IDLE && state != UWB_SESSION_ACTIVE) {
+    reset();
+  }
+  mStateKnown = true;
+  mState = state;
+}
+
+/*******************************************************************************
+**
+** Function:        getUnchangedStatus
+**
+** Description:     Whether a SET_APP_CONFIG that changes nothing can be
+**                  answered without a round trip. This is only the case in
+**                  IDLE, where the UWBS accepts every app config, and once
+**                  the UWBS has answered a set of this session; that answer
+**                  is then returned, never a made up one.
+**
+** Params:          status: receives the status of that UWBS answer.
+**
+** Returns:         false if the set must be sent to the UWBS.
+**
+*******************************************************************************/
+bool UwbAppConfigCache::getUnchangedStatus(uint8_t *status) const {
+  if (!mStateKnown || mState != UWB_SESSION_IDLE || !mAcked) {
+    return false;
+  }
+  *status = mAckStatus;
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        filterChanged
+**
+** Description:     Drop from a SET_APP_CONFIG TLV list the parameters that
+**                  already hold the requested value.
+**
+** Params:          tlvs: requested app config TLVs.
+**                  len: length of tlvs.
+**                  delta: receives the TLVs that must be sent.
+**                  noOfChanged: receives the number of TLVs in delta.
+**
+** Returns:         false if the list is malformed, delta is then unusable.
+**
+*******************************************************************************/
+bool UwbAppConfigCache::filterChanged(const uint8_t *tlvs, uint16_t len,
+                                      std::vector<uint8_t> &delta,
+                                      uint8_t *noOfChanged) const {
+  delta.clear();
+  *noOfChanged = 0;
+  return forEachTlv(tlvs, len,
+                    [&](uint8_t id, const uint8_t *value, uint8_t valueLen) {
+                      auto known = mValues.find(id);
+                      if (known != mValues.end() &&
+                          known->second.size() == valueLen &&
+                          std::equal(value, value + valueLen,
+                                     known->second.begin())) {
+                        return;
+                      }
+                      delta.push_back(id);
+                      delta.push_back(valueLen);
+                      delta.insert(delta.end(), value, value + valueLen);
+                      (*noOfChanged)++;
+                    });
+}
+
+bool UwbAppConfigCache::lookup(const uint8_t *ids, uint16_t count,
+                               std::vector<uint8_t> &tlvs) const {
+  tlvs.clear();
+  for (uint16_t i = 0; i < count; i++) {
+    auto known = mValues.find(ids[i]);
+    if (known == mValues.end()) {
+      return false;
+    }
+    tlvs.push_back(ids[i]);
+    tlvs.push_back(known->second.size());
+    tlvs.insert(tlvs.end(), known->second.begin(), known->second.end());
+  }
+  return count > 0;
+}
+
+} // namespace android
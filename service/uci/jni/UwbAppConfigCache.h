@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_APP_CONFIG_CACHE_H_
+#define _UWB_APP_CONFIG_CACHE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+namespace android {
+
+/* App config TLV header: one byte param ID, one byte value length */
+#define UWB_APP_CONFIG_TLV_HDR_SIZE 2
+
+/* Last value applied by the UWBS for each app config parameter of one
+ * session. Only parameters acknowledged by a successful SET_APP_CONFIG or
+ * returned by GET_APP_CONFIG are known; anything else goes to the UWBS. */
+class UwbAppConfigCache {
+public:
+  UwbAppConfigCache() : mStateKnown(false), mState(0), mAcked(false),
+                        mAckStatus(0) {}
+
+  /* The session state is kept, only SESSION_STATUS_NTF updates it */
+  void reset() {
+    mValues.clear();
+    mAcked = false;
+  }
+
+  /* Remember the values of a TLV list, false if the list is malformed */
+  bool store(const uint8_t *tlvs, uint16_t len);
+  /* Remember the values of a TLV list and the UWBS status that applied them */
+  bool storeApplied(const uint8_t *tlvs, uint16_t len, uint8_t status);
+  /* Track the session state, states that reset the app configs drop them */
+  void setSessionState(uint8_t state);
+  /* Status to answer an unchanged set with, false if it must be sent */
+  bool getUnchangedStatus(uint8_t *status) const;
+  /* Copy the TLVs whose value differs from the known one to delta */
+  bool filterChanged(const uint8_t *tlvs, uint16_t len,
+                     std::vector<uint8_t> &delta, uint8_t *noOfChanged) const;
+  /* Build the TLV list of the given param IDs, false if one is unknown */
+  bool lookup(const uint8_t *ids, uint16_t count,
+              std::vector<uint8_t> &tlvs) const;
+
+private:
+  std::map<uint8_t, std::vector<uint8_t>> mValues;
+  bool mStateKnown;
+  uint8_t mState;
+  bool mAcked;        // a SET_APP_CONFIG response was stored since reset()
+  uint8_t mAckStatus; // status of that response
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UwbBufferPool.h"
+#include "JniLog.h"
+
+namespace android {
+
+static UwbFixedBufferPool<UWB_PACKET_POOL_BLOCK_SIZE, UWB_PACKET_POOL_BLOCKS>
+    sPacketPool;
+static UwbFixedBufferPool<UWB_PSDU_POOL_BLOCK_SIZE, UWB_PSDU_POOL_BLOCKS>
+    sPsduPool;
+
+UwbBufferPool &UwbBufferPool::getPacketPool() { return sPacketPool; }
+
+UwbBufferPool &UwbBufferPool::getPsduPool() { return sPsduPool; }
+
+UwbBufferPool::UwbBufferPool(uint8_t *storage, uint8_t *freeList,
+                             uint16_t blockSize, uint8_t blocks) {
+  mStorage = storage;
+  mFreeList = freeList;
+  mBlockSize = blockSize;
+  mBlocks = blocks;
+  for (uint8_t i = 0; i < blocks; i++) {
+    mFreeList[i] = blocks - 1 - i;
+  }
+  mFree = blocks;
+  mHighWater = 0;
+  mLeases = 0;
+  mExhausted = 0;
+}
+
+/*******************************************************************************
+**
+** Function:        lease
+**
+** Description:     Take a free block for the request in flight. The most
+**                  recently returned block is handed out first, it is the
+**                  most likely to still be in cache.
+**
+** Params:          len: bytes the caller needs.
+**
+** Returns:         The lease, invalid if len does not fit a block or every
+**                  block is in use.
+**
+*******************************************************************************/
+UwbBufferLease UwbBufferPool::lease(uint16_t len) {
+  UwbBufferLease lease;
+  if (len > mBlockSize) {
+    JNI_TRACE_E("%s: %d bytes exceed the block size %d", __func__, len,
+                mBlockSize);
+    return lease;
+  }
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mFree == 0) {
+    mExhausted++;
+    JNI_TRACE_E("%s: all %d blocks in use", __func__, mBlocks);
+    return lease;
+  }
+  uint8_t index = mFreeList[--mFree];
+  mLeases++;
+  if (mBlocks - mFree > mHighWater) {
+    mHighWater = mBlocks - mFree;
+  }
+  lease.mPool = this;
+  lease.mData = mStorage + (size_t)index * mBlockSize;
+  lease.mIndex = index;
+  return lease;
+}
+
+void UwbBufferPool::giveBack(uint8_t index) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mFreeList[mFree++] = index;
+}
+
+void UwbBufferPool::getStats(int64_t stats[UWB_BUFFER_POOL_STAT_MAX]) {
+  std::lock_guard<std::mutex> lock(mLock);
+  stats[UWB_BUFFER_POOL_STAT_BLOCKS] = mBlocks;
+  stats[UWB_BUFFER_POOL_STAT_IN_USE] = mBlocks - mFree;
+  stats[UWB_BUFFER_POOL_STAT_HIGH_WATER] = mHighWater;
+  stats[UWB_BUFFER_POOL_STAT_LEASES] = mLeases;
+  stats[UWB_BUFFER_POOL_STAT_EXHAUSTED] = mExhausted;
+}
+
+UwbBufferLease::UwbBufferLease(UwbBufferLease &&other)
+    : mPool(other.mPool), mData(other.mData), mIndex(other.mIndex) {
+  other.mPool = NULL;
+  other.mData = NULL;
+}
+
+UwbBufferLease &UwbBufferLease::operator=(UwbBufferLease &&other) {
+  if (this != &other) {
+    release();
+    mPool = other.mPool;
+    mData = other.mData;
+    mIndex = other.mIndex;
+    other.mPool = NULL;
+    other.mData = NULL;
+  }
+  return *this;
+}
+
+uint16_t UwbBufferLease::size() const {
+  return mPool != NULL ? mPool->blockSize() : 0;
+}
+
+void UwbBufferLease::release() {
+  if (mPool != NULL) {
+    mPool->giveBack(mIndex);
+    mPool = NULL;
+    mData = NULL;
+  }
+}
+
+} // namespace android
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_BUFFER_POOL_H_
+#define _UWB_BUFFER_POOL_H_
+
+#include <stdint.h>
+
+#include <mutex>
+
+#include "uci_defs.h"
+
+namespace android {
+
+/* Command and response payloads of one UCI packet */
+#define UWB_PACKET_POOL_BLOCK_SIZE UCI_MAX_PKT_SIZE
+#define UWB_PACKET_POOL_BLOCKS 16
+/* PSDUs of the RF tests */
+#define UWB_PSDU_POOL_BLOCK_SIZE UCI_PSDU_SIZE_4K
+#define UWB_PSDU_POOL_BLOCKS 2
+
+/* Layout of the array returned by nativeGetBufferPoolStats(), repeated for
+ * the packet and the PSDU pool */
+enum {
+  UWB_BUFFER_POOL_STAT_BLOCKS = 0,
+  UWB_BUFFER_POOL_STAT_IN_USE,
+  UWB_BUFFER_POOL_STAT_HIGH_WATER,
+  UWB_BUFFER_POOL_STAT_LEASES,
+  UWB_BUFFER_POOL_STAT_EXHAUSTED, // leases refused because all were in use
+  UWB_BUFFER_POOL_STAT_MAX
+};
+
+class UwbBufferPool;
+
+/* Block leased from a pool, given back when the lease is released or goes
+ * out of scope. An invalid lease has no data. */
+class UwbBufferLease {
+public:
+  UwbBufferLease() : mPool(NULL), mData(NULL), mIndex(0) {}
+  UwbBufferLease(UwbBufferLease &&other);
+  UwbBufferLease &operator=(UwbBufferLease &&other);
+  ~UwbBufferLease() { release(); }
+
+  bool isValid() const { return mData != NULL; }
+  uint8_t *data() const { return mData; }
+  uint16_t size() const;
+  void release();
+
+private:
+  friend class UwbBufferPool;
+
+  UwbBufferLease(const UwbBufferLease &) = delete;
+  void operator=(const UwbBufferLease &) = delete;
+
+  UwbBufferPool *mPool;
+  uint8_t *mData;
+  uint8_t mIndex;
+};
+
+/* Fixed block allocator for UCI buffers. Requests lease a block for as long
+ * as they are in flight instead of sharing a static buffer per command type
+ * or allocating one per call, so concurrent commands never collide and the
+ * command paths stay off the heap. A lease fails rather than waits when all
+ * blocks are in use. */
+class UwbBufferPool {
+public:
+  static UwbBufferPool &getPacketPool();
+  static UwbBufferPool &getPsduPool();
+
+  /* An invalid lease if len exceeds the block size or no block is free */
+  UwbBufferLease lease(uint16_t len);
+  uint16_t blockSize() const { return mBlockSize; }
+  void getStats(int64_t stats[UWB_BUFFER_POOL_STAT_MAX]);
+
+protected:
+  UwbBufferPool(uint8_t *storage, uint8_t *freeList, uint16_t blockSize,
+                uint8_t blocks);
+
+private:
+  friend class UwbBufferLease;
+
+  void giveBack(uint8_t index);
+
+  std::mutex mLock;
+  uint8_t *mStorage;
+  uint8_t *mFreeList; // indexes of the free blocks, mFree of them
+  uint16_t mBlockSize;
+  uint8_t mBlocks;
+  uint8_t mFree;
+  uint8_t mHighWater;
+  int64_t mLeases;
+  int64_t mExhausted;
+};
+
+template <uint16_t BlockSize, uint8_t Blocks> struct UwbBufferPoolStorage {
+  alignas(8) uint8_t blocks[BlockSize * Blocks];
+  uint8_t freeList[Blocks];
+};
+
+/* Pool with its blocks inline, meant to be a static object. The storage is a
+ * base so that it exists before the pool initializes it. */
+template <uint16_t BlockSize, uint8_t Blocks>
+class UwbFixedBufferPool : private UwbBufferPoolStorage<BlockSize, Blocks>,
+                           public UwbBufferPool {
+public:
+  UwbFixedBufferPool()
+      : UwbBufferPool(this->blocks, this->freeList, BlockSize, Blocks) {}
+};
+
+} // namespace android
+#endif
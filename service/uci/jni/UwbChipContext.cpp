@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UwbChipContext.h"
+#include "JniLog.h"
+#include "UwbAdaptation.h"
+#include "uwb_api.h"
+
+namespace android {
+
+/* UWA stack linked into the library, bound to the default chip */
+static void defaultOpen() {
+  UwbAdaptation &theInstance = UwbAdaptation::GetInstance();
+  theInstance.Initialize(); // start GKI, UCI task, UWB task
+  UWA_Init(theInstance.GetHalEntryFuncs());
+}
+
+static void defaultClose(bool graceful) {
+  UwbAdaptation::GetInstance().Finalize(graceful);
+}
+
+static tUWA_STATUS defaultCoreInitialization() {
+  return UwbAdaptation::GetInstance().CoreInitialization();
+}
+
+static tUWA_STATUS defaultEnable(tUWA_DM_CBACK *dmCback,
+                                 tUWA_DM_TEST_CBACK *testCback) {
+  return UWA_Enable(dmCback, testCback);
+}
+
+static tUWA_STATUS defaultDisable(bool graceful) {
+  return UWA_Disable(graceful);
+}
+
+static tUWA_STATUS defaultSendDeviceReset(uint8_t resetConfig) {
+  return UWA_SendDeviceReset(resetConfig);
+}
+
+static tUWA_STATUS defaultGetDeviceInfo() { return UWA_GetDeviceInfo(); }
+
+static tUWA_STATUS defaultGetDeviceCapability() {
+  return UWA_GetCoreGetDeviceCapability();
+}
+
+static tUWA_STATUS defaultSetCoreConfig(tUWA_PMID paramId, uint8_t length,
+                                        uint8_t *data) {
+  return UWA_SetCoreConfig(paramId, length, data);
+}
+
+static tUWA_STATUS defaultGetCoreConfig(uint8_t numIds, tUWA_PMID *paramIds) {
+  return UWA_GetCoreConfig(numIds, paramIds);
+}
+
+static tUWA_STATUS defaultSetCountryCode(uint8_t *countryCode) {
+  return UWA_ControllerSetCountryCode(countryCode);
+}
+
+static void defaultEnableConformanceTest(bool enable) {
+  UWB_EnableConformanceTest(enable);
+}
+
+static tUWA_STATUS defaultSessionInit(uint32_t sessionId,
+                                      uint8_t sessionType) {
+  return UWA_SendSessionInit(sessionId, sessionType);
+}
+
+static tUWA_STATUS defaultSessionDeInit(uint32_t sessionId) {
+  return UWA_SendSessionDeInit(sessionId);
+}
+
+static tUWA_STATUS defaultGetSessionCount() { return UWA_GetSessionCount(); }
+
+static tUWA_STATUS defaultGetSessionStatus(uint32_t sessionId) {
+  return UWA_GetSessionStatus(sessionId);
+}
+
+static tUWA_STATUS defaultSetAppConfig(uint32_t sessionId, uint8_t noOfParams,
+                                       uint8_t appConfigLen,
+                                       uint8_t *appConfig) {
+  return UWA_SetAppConfig(sessionId, noOfParams, appConfigLen, appConfig);
+}
+
+static tUWA_STATUS defaultGetAppConfig(uint32_t sessionId, uint8_t noOfParams,
+                                       uint8_t appConfigLen,
+                                       uint8_t *appConfig) {
+  return UWA_GetAppConfig(sessionId, noOfParams, appConfigLen, appConfig);
+}
+
+static tUWA_STATUS defaultStartRanging(uint32_t sessionId) {
+  return UWA_StartRangingSession(sessionId);
+}
+
+static tUWA_STATUS defaultStopRanging(uint32_t sessionId) {
+  return UWA_StopRangingSession(sessionId);
+}
+
+static tUWA_STATUS defaultMulticastListUpdate(uint32_t sessionId,
+                                              uint8_t action,
+                                              uint8_t noOfControlees,
+                                              uint16_t *shortAddressList,
+                                              uint32_t *subSessionIdList) {
+  return UWA_ControllerMulticastListUpdate(sessionId, action, noOfControlees,
+                                           shortAddressList, subSessionIdList);
+}
+
+static tUWA_STATUS defaultSendRawCommand(uint16_t cmdLen, uint8_t *cmd,
+                                         tUWA_RAW_CMD_CBACK *cback) {
+  return UWA_SendRawCommand(cmdLen, cmd, cback);
+}
+
+static tUWA_STATUS defaultTestSetConfig(uint32_t sessionId,
+                                        uint8_t noOfParams,
+                                        uint8_t testConfigLen,
+                                        uint8_t *testConfig) {
+  return UWA_TestSetConfig(sessionId, noOfParams, testConfigLen, testConfig);
+}
+
+static tUWA_STATUS defaultTestGetConfig(uint32_t sessionId,
+                                        uint8_t noOfParams,
+                                        uint8_t testConfigLen,
+                                        uint8_t *testConfig) {
+  return UWA_TestGetConfig(sessionId, noOfParams, testConfigLen, testConfig);
+}
+
+static tUWA_STATUS defaultPeriodicTxTest(uint16_t psduLen, uint8_t *psdu) {
+  return UWA_PeriodicTxTest(psduLen, psdu);
+}
+
+static tUWA_STATUS defaultPerRxTest(uint16_t psduLen, uint8_t *refPsdu) {
+  return UWA_PerRxTest(psduLen, refPsdu);
+}
+
+static tUWA_STATUS defaultLoopBackTest(uint16_t psduLen, uint8_t *psdu) {
+  return UWA_UwbLoopBackTest(psduLen, psdu);
+}
+
+static tUWA_STATUS defaultRxTest() { return UWA_RxTest(); }
+
+static tUWA_STATUS defaultTestStopSession() { return UWA_TestStopSession(); }
+
+static const tUWB_CHIP_STACK sDefaultStack = {
+    defaultOpen,
+    defaultClose,
+    defaultCoreInitialization,
+    defaultEnable,
+    defaultDisable,
+    defaultSendDeviceReset,
+    defaultGetDeviceInfo,
+    defaultGetDeviceCapability,
+    defaultSetCoreConfig,
+    defaultGetCoreConfig,
+    defaultSetCountryCode,
+    defaultEnableConformanceTest,
+    defaultSessionInit,
+    defaultSessionDeInit,
+    defaultGetSessionCount,
+    defaultGetSessionStatus,
+    defaultSetAppConfig,
+    defaultGetAppConfig,
+    defaultStartRanging,
+    defaultStopRanging,
+    defaultMulticastListUpdate,
+    defaultSendRawCommand,
+    defaultTestSetConfig,
+    defaultTestGetConfig,
+    defaultPeriodicTxTest,
+    defaultPerRxTest,
+    defaultLoopBackTest,
+    defaultRxTest,
+    defaultTestStopSession,
+};
+
+std::mutex UwbChipContext::sChipsLock;
+std::atomic<UwbChipContext *> UwbChipContext::sChips[UWB_MAX_CHIPS];
+
+UwbChipContext::UwbChipContext(uint8_t chipId, const tUWB_CHIP_STACK &stack)
+    : mChipId(chipId), mStack(stack),
+      mEventManager(mControleeRegistry, mDispatcher),
+      mDispatcher(mEventManager, mStats), mCommandPipeline(mStats),
+      mRecorder(mDispatcher), mRfTestManager(*this) {}
+
+/*******************************************************************************
+**
+** Function:        getDefault
+**
+** Description:     Get the context of the chip bound to the UWA stack linked
+**                  into the library. It is constructed on first use.
+**
+** Params:          None
+**
+** Returns:         context of the default chip.
+**
+*******************************************************************************/
+UwbChipContext &UwbChipContext::getDefault() {
+  static UwbChipContext *sDefault =
+      new UwbChipContext(UWB_DEFAULT_CHIP_ID, sDefaultStack);
+  return *sDefault;
+}
+
+/*******************************************************************************
+**
+** Function:        get
+**
+** Description:     Look up the context of a chip by the id given to the
+**                  native APIs.
+**
+** Params:          chipId: UWB_DEFAULT_CHIP_ID or an id given to addChip().
+**
+** Returns:         context of the chip, NULL if there is none.
+**
+*******************************************************************************/
+UwbChipContext *UwbChipContext::get(jint chipId) {
+  if (chipId == UWB_DEFAULT_CHIP_ID) {
+    return &getDefault();
+  }
+  if (chipId < 0 || chipId >= UWB_MAX_CHIPS) {
+    return NULL;
+  }
+  return sChips[chipId].load(std::memory_order_acquire);
+}
+
+/*******************************************************************************
+**
+** Function:        addChip
+**
+** Description:     Create the context of a further chip, driven by its own
+**                  UWA stack instance. The context gets its own command
+**                  pipeline, dispatcher thread, registries and device
+**                  snapshot file.
+**
+** Params:          chipId: 1 to UWB_MAX_CHIPS - 1.
+**                  stack: entry points of the UWA stack instance of the
+**                         chip, copied.
+**
+** Returns:         true if the chip was added.
+**
+*******************************************************************************/
+bool UwbChipContext::addChip(uint8_t chipId, const tUWB_CHIP_STACK &stack) {
+  if (chipId == UWB_DEFAULT_CHIP_ID || chipId >= UWB_MAX_CHIPS) {
+    JNI_TRACE_E("%s: invalid chip id %d", __func__, chipId);
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(sChipsLock);
+  if (sChips[chipId].load(std::memory_order_relaxed) != NULL) {
+    JNI_TRACE_E("%s: chip %d already added", __func__, chipId);
+    return false;
+  }
+  sChips[chipId].store(new UwbChipContext(chipId, stack),
+                       std::memory_order_release);
+  return true;
+}
+
+} // namespace android
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_CHIP_CONTEXT_H_
+#define _UWB_CHIP_CONTEXT_H_
+
+#include <jni.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "UwbChipState.h"
+#include "UwbCommandPipeline.h"
+#include "UwbControleeRegistry.h"
+#include "UwbDeviceSnapshot.h"
+#include "UwbEventManager.h"
+#include "UwbJniStats.h"
+#include "UwbNotificationDispatcher.h"
+#include "UwbRfTestManager.h"
+#include "UwbSessionRegistry.h"
+#include "UwbUciRecorder.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Chips addressed by the chipId argument of the native APIs */
+#define UWB_MAX_CHIPS 4
+/* Chip bound to the UWA stack linked into the library */
+#define UWB_DEFAULT_CHIP_ID 0
+
+/* Entry points of the UWA stack instance driving one chip. The stack of the
+ * default chip forwards to the UWA_* API; an integration with several UWBS
+ * registers the entry points of every further stack instance with addChip().
+ * The callbacks given to enable() and sendRawCommand() identify the chip, so
+ * a stack instance must only ever deliver to the callbacks it was given. */
+typedef struct {
+  /* GKI, UCI and UWB tasks, HAL and UWA_Init */
+  void (*open)();
+  void (*close)(bool graceful);
+  tUWA_STATUS (*coreInitialization)();
+  tUWA_STATUS (*enable)(tUWA_DM_CBACK *dmCback, tUWA_DM_TEST_CBACK *testCback);
+  tUWA_STATUS (*disable)(bool graceful);
+  tUWA_STATUS (*sendDeviceReset)(uint8_t resetConfig);
+  tUWA_STATUS (*getDeviceInfo)();
+  tUWA_STATUS (*getDeviceCapability)();
+  tUWA_STATUS (*setCoreConfig)(tUWA_PMID paramId, uint8_t length,
+                               uint8_t *data);
+  tUWA_STATUS (*getCoreConfig)(uint8_t numIds, tUWA_PMID *paramIds);
+  tUWA_STATUS (*setCountryCode)(uint8_t *countryCode);
+  void (*enableConformanceTest)(bool enable);
+
+  tUWA_STATUS (*sessionInit)(uint32_t sessionId, uint8_t sessionType);
+  tUWA_STATUS (*sessionDeInit)(uint32_t sessionId);
+  tUWA_STATUS (*getSessionCount)();
+  tUWA_STATUS (*getSessionStatus)(uint32_t sessionId);
+  tUWA_STATUS (*setAppConfig)(uint32_t sessionId, uint8_t noOfParams,
+                              uint8_t appConfigLen, uint8_t *appConfig);
+  tUWA_STATUS (*getAppConfig)(uint32_t sessionId, uint8_t noOfParams,
+                              uint8_t appConfigLen, uint8_t *appConfig);
+  tUWA_STATUS (*startRanging)(uint32_t sessionId);
+  tUWA_STATUS (*stopRanging)(uint32_t sessionId);
+  tUWA_STATUS (*multicastListUpdate)(uint32_t sessionId, uint8_t action,
+                                     uint8_t noOfControlees,
+                                     uint16_t *shortAddressList,
+                                     uint32_t *subSessionIdList);
+  tUWA_STATUS (*sendRawCommand)(uint16_t cmdLen, uint8_t *cmd,
+                                tUWA_RAW_CMD_CBACK *cback);
+
+  tUWA_STATUS (*testSetConfig)(uint32_t sessionId, uint8_t noOfParams,
+                               uint8_t testConfigLen, uint8_t *testConfig);
+  tUWA_STATUS (*testGetConfig)(uint32_t sessionId, uint8_t noOfParams,
+                               uint8_t testConfigLen, uint8_t *testConfig);
+  tUWA_STATUS (*periodicTxTest)(uint16_t psduLen, uint8_t *psdu);
+  tUWA_STATUS (*perRxTest)(uint16_t psduLen, uint8_t *refPsdu);
+  tUWA_STATUS (*loopBackTest)(uint16_t psduLen, uint8_t *psdu);
+  tUWA_STATUS (*rxTest)();
+  tUWA_STATUS (*testStopSession)();
+} tUWB_CHIP_STACK;
+
+/* Native state of one UWBS: the UWA stack instance driving it, the command
+ * pipeline its responses complete, the dispatcher thread that delivers its
+ * notifications, its session and controlee registries, its stats and the
+ * Java objects its upcalls go to. Nothing in a context refers to another
+ * chip, so chips only share the timer wheel, the trace ring and the vendor
+ * notification policy.
+ *
+ * Contexts are created once and live until the process exits. */
+class UwbChipContext {
+public:
+  static UwbChipContext &getDefault();
+  /* NULL if no chip with that id was added */
+  static UwbChipContext *get(jint chipId);
+  /* Bind a further chip to its UWA stack instance, before nativeInit() is
+   * called for it. Fails for the default chip, an id in use or out of
+   * range. */
+  static bool addChip(uint8_t chipId, const tUWB_CHIP_STACK &stack);
+
+  uint8_t getChipId() const { return mChipId; }
+  const tUWB_CHIP_STACK &getStack() const { return mStack; }
+  UwbChipState &getState() { return mState; }
+  UwbJniStats &getStats() { return mStats; }
+  UwbCommandPipeline &getCommandPipeline() { return mCommandPipeline; }
+  UwbNotificationDispatcher &getDispatcher() { return mDispatcher; }
+  UwbEventManager &getEventManager() { return mEventManager; }
+  UwbSessionRegistry &getSessionRegistry() { return mSessionRegistry; }
+  UwbControleeRegistry &getControleeRegistry() { return mControleeRegistry; }
+  UwbDeviceSnapshot &getDeviceSnapshot() { return mDeviceSnapshot; }
+  UwbUciRecorder &getRecorder() { return mRecorder; }
+  UwbRfTestManager &getRfTestManager() { return mRfTestManager; }
+
+private:
+  UwbChipContext(uint8_t chipId, const tUWB_CHIP_STACK &stack);
+  UwbChipContext(const UwbChipContext &) = delete;
+  UwbChipContext &operator=(const UwbChipContext &) = delete;
+
+  static std::mutex sChipsLock; // serializes addChip()
+  static std::atomic<UwbChipContext *> sChips[UWB_MAX_CHIPS];
+
+  const uint8_t mChipId;
+  const tUWB_CHIP_STACK mStack;
+  UwbChipState mState;
+  /* In construction order, members only keep references to the members
+   * they are given and use them once constructed */
+  UwbJniStats mStats;
+  UwbControleeRegistry mControleeRegistry;
+  UwbSessionRegistry mSessionRegistry;
+  UwbEventManager mEventManager;
+  UwbNotificationDispatcher mDispatcher;
+  UwbCommandPipeline mCommandPipeline;
+  UwbDeviceSnapshot mDeviceSnapshot;
+  UwbUciRecorder mRecorder;
+  UwbRfTestManager mRfTestManager;
+};
+
+} // namespace android
+#endif
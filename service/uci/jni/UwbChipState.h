@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_CHIP_STATE_H_
+#define _UWB_CHIP_STATE_H_
+
+#include <jni.h>
+#include <stdint.h>
+
+#include <mutex>
+
+#include "SyncEvent.h"
+#include "UwbDeviceSnapshot.h"
+#include "UwbJniTypes.h"
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Layout of the array returned by nativeGetInitTiming(), durations in us of
+ * the last uwbNativeManager_doInitialize. DEVICE_INFO, CORE_CONFIG and
+ * CAPS_PREFETCH are in flight together and measured from their common
+ * start, 0 means the phase did not complete. */
+enum {
+  UWB_INIT_PHASE_ADAPTATION = 0, // GKI, HAL and UWA_Init
+  UWB_INIT_PHASE_ENABLE,
+  UWB_INIT_PHASE_CORE_INIT,
+  UWB_INIT_PHASE_DEVICE_INFO,
+  UWB_INIT_PHASE_CORE_CONFIG,
+  UWB_INIT_PHASE_CAPS_PREFETCH,
+  UWB_INIT_PHASE_TOTAL,
+  UWB_INIT_PHASE_MAX
+};
+
+/* Handshake state between the natives of UwbNativeManager and the device
+ * management callback of one chip. Response fields are only touched under
+ * the guard of the SyncEvent of their command. */
+struct UwbChipState {
+  UwbChipState()
+      : isUwaEnabled(false), deviceInfoRspReceived(false),
+        coreSetConfigRspReceived(false), deviceCapsRspReceived(false),
+        uwbVendorInfoLen(0), coreConfigTlvLen(0), rangingCount(0),
+        noOfCoreConfigIds(0), sessionCount(-1), devCapInfoLen(0),
+        devCapInfoIds(0), getCoreConfigLen(0), sendBlinkDataStatus(0),
+        sendRawResLen(0), sendRawResOverflow(false), sendRawResDest(NULL),
+        sendRawResCapacity(0), getCoreConfigDest(NULL),
+        getCoreConfigCapacity(0), deviceCapsDest(NULL), deviceCapsCapacity(0),
+        isDeviceResetDone(false), setCountryCodeStatus(false),
+        getDeviceCapsRespStatus(false), deviceCapsInfo(NULL),
+        deviceState(UWBS_STATUS_ERROR) {
+    uwbDeviceInfo = {};
+    for (int i = 0; i < UWB_INIT_PHASE_MAX; i++) {
+      initPhaseUs[i] = 0;
+    }
+  }
+
+  bool isUwaEnabled;
+
+  SyncEvent uwaEnableEvent;          // event for UWA_Enable()
+  SyncEvent uwaDisableEvent;         // event for UWA_Disable
+  SyncEvent uwaSetConfigEvent;       // event for Set_Config....
+  SyncEvent uwaGetConfigEvent;       // event for Get_Config....
+  SyncEvent uwaDeviceResetEvent;     // event for deviceResetEvent
+  SyncEvent uwaDeviceNtfEvent;       // event for device status NTF
+  SyncEvent uwaGetSessionCountEvent; // event for get session count response
+  SyncEvent uwaGetDeviceInfoEvent;   // event for get Device Info
+  SyncEvent uwaGetRangingCountEvent; // event for get ranging count response
+  SyncEvent uwaSendBlinkDataEvent;
+  SyncEvent errNotify;
+  SyncEvent uwaSetCountryCodeEvent; // event for UWA_ControllerSetCountryCode
+  SyncEvent uwaSendRawUciEvt;       // event for UWA_SendRawCommand
+  SyncEvent uwaGetDeviceCapsEvent;  // event for Get Device Capabilities
+  /* Set under the guard of the event when its response arrived, lets the
+   * init pipeline wait for responses that came in before it started
+   * waiting */
+  bool deviceInfoRspReceived;
+  bool coreSetConfigRspReceived;
+  bool deviceCapsRspReceived;
+
+  deviceInfo_t uwbDeviceInfo;
+  uint8_t uwbVendorInfoLen;
+  uint8_t uwbVendorInfo[UWB_DEVICE_SNAPSHOT_MAX_VENDOR_INFO];
+  /* Core config TLVs sent at init, persisted with the device snapshot */
+  uint8_t coreConfigTlvLen;
+  uint8_t coreConfigTlvs[UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG];
+  uint32_t rangingCount;
+  uint8_t noOfCoreConfigIds;
+  uint8_t sessionCount;
+  uint16_t devCapInfoLen;
+  uint16_t devCapInfoIds;
+  uint16_t getCoreConfigLen;
+  uint8_t sendBlinkDataStatus;
+  uint16_t sendRawResLen;
+  bool sendRawResOverflow;
+  /* Where the response callbacks copy payloads. The caller waiting for the
+   * command attaches its leased buffer under the guard of the command's
+   * SyncEvent and detaches it after the wait; a response arriving while no
+   * buffer is attached is dropped. */
+  uint8_t *sendRawResDest;
+  uint16_t sendRawResCapacity;
+  uint8_t *getCoreConfigDest;
+  uint16_t getCoreConfigCapacity;
+  uint8_t *deviceCapsDest;
+  uint16_t deviceCapsCapacity;
+
+  /* command response status */
+  bool isDeviceResetDone; // whether Reset Performed is Successful or not
+  bool setCountryCodeStatus;
+  bool getDeviceCapsRespStatus;
+  std::mutex deviceCapsMutex;
+  jobject deviceCapsInfo; // Global ref to UwbTlvData, per enable
+
+  eUWBS_DEVICE_STATUS_t deviceState;
+
+  int64_t initPhaseUs[UWB_INIT_PHASE_MAX];
+};
+
+} // namespace android
+#endif
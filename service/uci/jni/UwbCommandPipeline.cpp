@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "UwbJniInternal.h"
+#include "UwbCommandPipeline.h"
+#include "UwbJniStats.h"
+#include "UwbTrace.h"
+#include "JniLog.h"
+
+namespace android {
+
+/* The timer wheel may still hold the deadline of a request that is dropped
+ * before it fired */
+UwbCommandRequest::~UwbCommandRequest() {
+  UwbTimerWheel::getInstance().cancelSync(mTimer);
+}
+
+UwbCommandPipeline::UwbCommandPipeline(UwbJniStats &stats) : mStats(stats) {
+  mCreditLimit = UWB_CMD_PIPELINE_DEFAULT_CREDITS;
+  mInFlight = 0;
+  mNextToken = 1;
+  mCompletionCback = NULL;
+  mCompletionArg = NULL;
+}
+
+void UwbCommandPipeline::setCreditLimit(uint8_t credits) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mCreditLimit = (credits > 0) ? credits : 1;
+  mCreditAvailable.notify_all();
+}
+
+void UwbCommandPipeline::setCompletionCallback(
+    tUWB_CMD_COMPLETION_CBACK cback, void *arg) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mCompletionCback = cback;
+  mCompletionArg = arg;
+}
+
+/*******************************************************************************
+**
+** Function:        execute
+**
+** Description:     Submit a command and block until its response arrives or
+**                  UWB_CMD_TIMEOUT expires.
+**
+** Params:          cmd: command type, selects the response FIFO.
+**                  send: issues the UWA command.
+**                  result: response of this command, may be NULL.
+**
+** Returns:         UWA_STATUS_OK if the command was sent and answered,
+**                  result->status then holds the response status.
+**
+*******************************************************************************/
+tUWA_STATUS UwbCommandPipeline::execute(
+    eUWB_CMD cmd, const std::function<tUWA_STATUS()> &send,
+    tUWB_CMD_RESULT *result) {
+  std::shared_ptr<UwbCommandRequest> request = submit(cmd, send);
+  if (request == nullptr) {
+    return UWA_STATUS_FAILED;
+  }
+  return wait(request, UWB_CMD_TIMEOUT, result) ? UWA_STATUS_OK
+                                                : UWA_STATUS_FAILED;
+}
+
+/*******************************************************************************
+**
+** Function:        submit
+**
+** Description:     Take a credit, register a new request as the newest
+**                  pending one of its command type and send the command.
+**                  Registering and sending happen under one lock, so the
+**                  FIFO order matches the order seen by the UCI stack.
+**
+** Params:          cmd: command type.
+**                  send: issues the UWA command.
+**
+** Returns:         The request to wait on, nullptr if no credit became
+**                  available in time or the command could not be sent.
+**
+*******************************************************************************/
+std::shared_ptr<UwbCommandRequest>
+UwbCommandPipeline::submit(eUWB_CMD cmd,
+                           const std::function<tUWA_STATUS()> &send) {
+  std::unique_lock<std::mutex> lock(mLock);
+  return submitLocked(lock, cmd, 0, send, true);
+}
+
+/*******************************************************************************
+**
+** Function:        submitAsync
+**
+** Description:     Send a command whose response is delivered through the
+**                  completion callback. Never waits for a credit, the caller
+**                  retries once earlier commands completed. The request fails
+**                  with UWB_CMD_STATUS_TIMEOUT if no response arrives within
+**                  UWB_CMD_TIMEOUT.
+**
+** Params:          cmd: command type.
+**                  context: caller value passed back on completion.
+**                  send: issues the UWA command.
+**
+** Returns:         Token of the request, 0 if no credit was available, no
+**                  completion callback is set or the command failed.
+**
+*******************************************************************************/
+uint32_t
+UwbCommandPipeline::submitAsync(eUWB_CMD cmd, uint32_t context,
+                                const std::function<tUWA_STATUS()> &send) {
+  std::unique_lock<std::mutex> lock(mLock);
+  if (mCompletionCback == NULL) {
+    JNI_TRACE_E("%s: no completion callback", __func__);
+    return 0;
+  }
+  std::shared_ptr<UwbCommandRequest> request =
+      submitLocked(lock, cmd, context, send, false);
+  if (request == nullptr) {
+    return 0;
+  }
+  return request->mToken;
+}
+
+std::shared_ptr<UwbCommandRequest>
+UwbCommandPipeline::submitLocked(std::unique_lock<std::mutex> &lock,
+                                 eUWB_CMD cmd, uint32_t context,
+                                 const std::function<tUWA_STATUS()> &send,
+                                 bool waitForCredit) {
+  auto hasCredit = [this]() { return mInFlight < mCreditLimit; };
+  if (!(waitForCredit ? mCreditAvailable.wait_for(
+                            lock, std::chrono::milliseconds(UWB_CMD_TIMEOUT),
+                            hasCredit)
+                      : hasCredit())) {
+    JNI_TRACE_E("%s: no credit for command %d", __func__, cmd);
+    return nullptr;
+  }
+
+  std::shared_ptr<UwbCommandRequest> request =
+      std::make_shared<UwbCommandRequest>();
+  request->mPipeline = this;
+  request->mCmd = cmd;
+  request->mAsync = !waitForCredit;
+  request->mContext = context;
+  request->mSubmitUs = UwbJniStats::nowUs();
+  request->mToken = mNextToken++;
+  if (mNextToken == 0) {
+    mNextToken = 1;
+  }
+  UWB_TRACE(UWB_TRACE_CMD_SUBMIT, cmd, request->mToken, 0, 0);
+  mPending[cmd].push_back(request);
+  mInFlight++;
+  if (send() != UWA_STATUS_OK) {
+    JNI_TRACE_E("%s: failed to send command %d", __func__, cmd);
+    mPending[cmd].pop_back();
+    mInFlight--;
+    mCreditAvailable.notify_one();
+    return nullptr;
+  }
+  if (request->mAsync) {
+    UwbTimerWheel::getInstance().arm(request->mTimer, UWB_CMD_TIMEOUT,
+                                     requestTimerCallback, request.get());
+  }
+  return request;
+}
+
+/*******************************************************************************
+**
+** Function:        wait
+**
+** Description:     Wait for the response of a submitted request. A request
+**                  that times out is abandoned, see abandon().
+**
+** Params:          request: request returned by submit().
+**                  timeoutMs: maximum wait.
+**                  result: response of this command, may be NULL.
+**
+** Returns:         true if the response arrived in time.
+**
+*******************************************************************************/
+bool UwbCommandPipeline::wait(const std::shared_ptr<UwbCommandRequest> &request,
+                              uint32_t timeoutMs, tUWB_CMD_RESULT *result) {
+  std::unique_lock<std::mutex> lock(request->mLock);
+  if (!request->mCompleted.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                    [&request]() { return request->mDone; })) {
+    lock.unlock();
+    if (!abandon(request)) {
+      // Completed between the timeout and taking mLock, use the response
+      lock.lock();
+      request->mCompleted.wait(lock, [&request]() { return request->mDone; });
+    } else {
+      JNI_TRACE_E("%s: command response timeout", __func__);
+      mStats.recordCommandTimeout(request->mCmd);
+      UWB_TRACE(UWB_TRACE_CMD_TIMEOUT, request->mCmd, request->mToken, 0, 0);
+      return false;
+    }
+  }
+  if (request->mAborted) {
+    return false;
+  }
+  if (result != NULL) {
+    *result = request->mResult;
+  }
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        abandon
+**
+** Description:     Mark a timed out request abandoned. It keeps its place in
+**                  the FIFO and its credit: the UCI stack answers in order,
+**                  so a late response for it arrives before any response
+**                  for later requests of the same type and is dropped. If
+**                  none arrived after UWB_CMD_LATE_RESPONSE_GRACE_MS the
+**                  response is taken to be lost and the request removed.
+**
+** Params:          request: request that timed out.
+**
+** Returns:         false if the request already completed.
+**
+*******************************************************************************/
+bool UwbCommandPipeline::abandon(
+    const std::shared_ptr<UwbCommandRequest> &request) {
+  std::lock_guard<std::mutex> lock(mLock);
+  std::deque<std::shared_ptr<UwbCommandRequest>> &pending =
+      mPending[request->mCmd];
+  if (std::find(pending.begin(), pending.end(), request) == pending.end()) {
+    return false;
+  }
+  request->mAbandoned = true;
+  UwbTimerWheel::getInstance().arm(request->mTimer,
+                                   UWB_CMD_LATE_RESPONSE_GRACE_MS,
+                                   requestTimerCallback, request.get());
+  return true;
+}
+
+/* Runs on the timer wheel thread. The request destructor cancels the timer
+ * and waits for this callback, so target stays valid while it runs. */
+void UwbCommandPipeline::requestTimerCallback(void *arg) {
+  UwbCommandRequest *target = static_cast<UwbCommandRequest *>(arg);
+  target->mPipeline->onRequestTimer(target);
+}
+
+/* Deadline of an asynchronous request, or end of the late response grace
+ * of an abandoned one */
+void UwbCommandPipeline::onRequestTimer(UwbCommandRequest *target) {
+  // Released after mLock, the last reference may run the destructor
+  std::shared_ptr<UwbCommandRequest> request;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::deque<std::shared_ptr<UwbCommandRequest>> &pending =
+        mPending[target->mCmd];
+    auto it = std::find_if(
+        pending.begin(), pending.end(),
+        [target](const std::shared_ptr<UwbCommandRequest> &candidate) {
+          return candidate.get() == target;
+        });
+    if (it == pending.end()) {
+      return;
+    }
+    request = *it;
+    if (request->mAbandoned) {
+      JNI_TRACE_E("%s: no late response for command %d, credit returned",
+                  __func__, request->mCmd);
+      pending.erase(it);
+      mInFlight--;
+      mCreditAvailable.notify_one();
+      return;
+    }
+    request->mAbandoned = true;
+    UwbTimerWheel::getInstance().arm(request->mTimer,
+                                     UWB_CMD_LATE_RESPONSE_GRACE_MS,
+                                     requestTimerCallback, target);
+  }
+  JNI_TRACE_E("%s: command response timeout", __func__);
+  mStats.recordCommandTimeout(request->mCmd);
+  UWB_TRACE(UWB_TRACE_CMD_TIMEOUT, request->mCmd, request->mToken, 0, 0);
+  tUWB_CMD_RESULT timedOut = {};
+  timedOut.status = UWB_CMD_STATUS_TIMEOUT;
+  finish(*request, timedOut, true);
+}
+
+void UwbCommandPipeline::complete(eUWB_CMD cmd, const tUWB_CMD_RESULT &result) {
+  std::shared_ptr<UwbCommandRequest> request;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mPending[cmd].empty()) {
+      JNI_TRACE_E("%s: unexpected response for command %d", __func__, cmd);
+      return;
+    }
+    request = mPending[cmd].front();
+    mPending[cmd].pop_front();
+    UwbTimerWheel::getInstance().cancel(request->mTimer);
+    mInFlight--;
+    mCreditAvailable.notify_one();
+    if (request->mAbandoned) {
+      JNI_TRACE_E("%s: late response for command %d dropped", __func__, cmd);
+      return;
+    }
+    int64_t latencyUs = UwbJniStats::nowUs() - request->mSubmitUs;
+    mStats.recordCommandLatency(cmd, latencyUs);
+    UWB_TRACE(UWB_TRACE_CMD_COMPLETE, cmd, request->mToken, result.status,
+              latencyUs);
+  }
+  finish(*request, result, false);
+}
+
+void UwbCommandPipeline::abortAll() {
+  tUWB_CMD_RESULT aborted = {};
+  aborted.status = UWA_STATUS_FAILED;
+
+  std::deque<std::shared_ptr<UwbCommandRequest>> requests;
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (int i = 0; i < UWB_CMD_MAX; i++) {
+      for (auto &request : mPending[i]) {
+        UwbTimerWheel::getInstance().cancel(request->mTimer);
+        // Abandoned requests were already failed by their timeout
+        if (!request->mAbandoned) {
+          requests.push_back(request);
+        }
+      }
+      mPending[i].clear();
+    }
+    mInFlight = 0;
+    mCreditAvailable.notify_all();
+  }
+  for (auto &request : requests) {
+    finish(*request, aborted, true);
+  }
+}
+
+/* Called without mLock held, the completion callback may submit again */
+void UwbCommandPipeline::finish(UwbCommandRequest &request,
+                                const tUWB_CMD_RESULT &result, bool aborted) {
+  if (request.mAsync) {
+    tUWB_CMD_COMPLETION_CBACK cback;
+    void *arg;
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      cback = mCompletionCback;
+      arg = mCompletionArg;
+    }
+    if (cback != NULL) {
+      cback(request.mToken, request.mCmd, request.mContext, result, aborted,
+            arg);
+    }
+    return;
+  }
+  std::lock_guard<std::mutex> lock(request.mLock);
+  request.mResult = result;
+  request.mAborted = aborted;
+  request.mDone = true;
+  request.mCompleted.notify_all();
+}
+
+} // namespace android
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_COMMAND_PIPELINE_H_
+#define _UWB_COMMAND_PIPELINE_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "UwbTimerWheel.h"
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Commands whose responses are matched through the pipeline */
+typedef enum {
+  UWB_CMD_SESSION_INIT = 0,
+  UWB_CMD_SESSION_DEINIT,
+  UWB_CMD_SET_APP_CONFIG,
+  UWB_CMD_GET_APP_CONFIG,
+  UWB_CMD_RANGE_START,
+  UWB_CMD_RANGE_STOP,
+  UWB_CMD_GET_SESSION_STATE,
+  UWB_CMD_MC_LIST_UPDATE,
+  UWB_CMD_MAX
+} eUWB_CMD;
+
+/* Default number of pipelined commands outstanding at the UCI stack */
+#define UWB_CMD_PIPELINE_DEFAULT_CREDITS 4
+/* Completion status of an asynchronous request left unanswered for
+ * UWB_CMD_TIMEOUT. Not a UCI status, the UWBS never reports it. */
+#define UWB_CMD_STATUS_TIMEOUT 0xFE
+/* How long a timed out request keeps its place in the response FIFO to
+ * swallow a late response before its credit is returned */
+#define UWB_CMD_LATE_RESPONSE_GRACE_MS UWB_CMD_TIMEOUT
+
+/* Response of one command, owned by its request */
+typedef struct {
+  tUWA_STATUS status;
+  uint8_t value; // command specific: number of config ids, session state
+  uint16_t len;
+  uint8_t data[UCI_MAX_PAYLOAD_SIZE];
+} tUWB_CMD_RESULT;
+
+/* Completion handler of asynchronous requests. context is the value given
+ * to submitAsync(), aborted is set when abortAll() or the response deadline
+ * failed the request, arg the value given to setCompletionCallback(). */
+typedef void (*tUWB_CMD_COMPLETION_CBACK)(uint32_t token, eUWB_CMD cmd,
+                                          uint32_t context,
+                                          const tUWB_CMD_RESULT &result,
+                                          bool aborted, void *arg);
+
+class UwbCommandPipeline;
+class UwbJniStats;
+
+/* Completion object of one submitted command */
+class UwbCommandRequest {
+public:
+  UwbCommandRequest()
+      : mDone(false), mAborted(false), mAsync(false), mAbandoned(false),
+        mPipeline(NULL), mCmd(UWB_CMD_MAX), mToken(0), mContext(0),
+        mSubmitUs(0) {}
+  ~UwbCommandRequest();
+
+private:
+  friend class UwbCommandPipeline;
+
+  std::mutex mLock;
+  std::condition_variable mCompleted;
+  bool mDone;
+  bool mAborted;
+  bool mAsync;
+  bool mAbandoned; // timed out, waits for a late response, pipeline lock
+  UwbCommandPipeline *mPipeline;
+  UwbTimerEntry mTimer; // response deadline, then the late response grace
+  eUWB_CMD mCmd;
+  uint32_t mToken;
+  uint32_t mContext;
+  int64_t mSubmitUs;
+  tUWB_CMD_RESULT mResult;
+};
+
+/* Correlates UCI responses with the commands that caused them. The UCI stack
+ * answers commands in the order they were submitted, so every command type
+ * keeps a FIFO of pending requests and a response completes the oldest one.
+ * Requests carry their own result, so concurrent callers never share a
+ * response buffer, and up to the credit limit of commands can be queued at
+ * the UCI stack at the same time. A request that times out stays in its
+ * FIFO, abandoned, for UWB_CMD_LATE_RESPONSE_GRACE_MS: a late response then
+ * completes nothing instead of the next request of the same type. */
+class UwbCommandPipeline {
+public:
+  void setCreditLimit(uint8_t credits);
+
+  /* Submit a command and wait for its response. send issues the UWA call and
+   * is invoked with the pipeline ordering lock held. */
+  tUWA_STATUS execute(eUWB_CMD cmd, const std::function<tUWA_STATUS()> &send,
+                      tUWB_CMD_RESULT *result);
+
+  std::shared_ptr<UwbCommandRequest>
+  submit(eUWB_CMD cmd, const std::function<tUWA_STATUS()> &send);
+  bool wait(const std::shared_ptr<UwbCommandRequest> &request,
+            uint32_t timeoutMs, tUWB_CMD_RESULT *result);
+
+  /* Submit a command without waiting. The response is handed to the
+   * completion callback on the UCI stack callback thread, on the thread
+   * calling abortAll(), or on the timer wheel thread with
+   * UWB_CMD_STATUS_TIMEOUT once UWB_CMD_TIMEOUT passed without a response.
+   * Returns a non zero token, 0 if the command could not be queued right
+   * now. */
+  void setCompletionCallback(tUWB_CMD_COMPLETION_CBACK cback, void *arg);
+  uint32_t submitAsync(eUWB_CMD cmd, uint32_t context,
+                       const std::function<tUWA_STATUS()> &send);
+
+  /* Response side, called from the UCI stack callback thread */
+  void complete(eUWB_CMD cmd, const tUWB_CMD_RESULT &result);
+  /* Fail every pending request and return all credits */
+  void abortAll();
+
+private:
+  friend class UwbChipContext;
+  explicit UwbCommandPipeline(UwbJniStats &stats);
+
+  std::shared_ptr<UwbCommandRequest>
+  submitLocked(std::unique_lock<std::mutex> &lock, eUWB_CMD cmd,
+               uint32_t context, const std::function<tUWA_STATUS()> &send,
+               bool waitForCredit);
+  bool abandon(const std::shared_ptr<UwbCommandRequest> &request);
+  static void requestTimerCallback(void *arg);
+  void onRequestTimer(UwbCommandRequest *target);
+  void finish(UwbCommandRequest &request, const tUWB_CMD_RESULT &result,
+              bool aborted);
+
+  UwbJniStats &mStats; // of the chip
+  std::mutex mLock;
+  std::condition_variable mCreditAvailable;
+  uint8_t mCreditLimit;
+  uint8_t mInFlight;
+  uint32_t mNextToken;
+  tUWB_CMD_COMPLETION_CBACK mCompletionCback;
+  void *mCompletionArg;
+  std::deque<std::shared_ptr<UwbCommandRequest>> mPending[UWB_CMD_MAX];
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "JniLog.h"
+#include "UwbControleeRegistry.h"
+
+namespace android {
+
+/* Order of an update: by short address, a delete before an add */
+static bool updateOrder(const tUWB_CONTROLEE_OP &a,
+                        const tUWB_CONTROLEE_OP &b) {
+  if (a.shortAddress != b.shortAddress) {
+    return a.shortAddress < b.shortAddress;
+  }
+  return a.action == UWB_MC_LIST_ACTION_DELETE &&
+         b.action != UWB_MC_LIST_ACTION_DELETE;
+}
+
+static bool addressOrder(const tUWB_CONTROLEE_OP &a,
+                         const tUWB_CONTROLEE_OP &b) {
+  return a.shortAddress < b.shortAddress;
+}
+
+/*******************************************************************************
+**
+** Function:        diff
+**
+** Description:     Compute the operations that turn the members of a session
+**                  into the desired set. Duplicate addresses in desired keep
+**                  their first sub session.
+**
+** Params:          sessionId: session ID.
+**                  desired: controlees the session should have, action and
+**                  status are ignored.
+**                  count: number of entries in desired.
+**                  ops: receives the deletes followed by the adds.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbControleeRegistry::diff(uint32_t sessionId,
+                                const tUWB_CONTROLEE_OP *desired,
+                                uint16_t count,
+                                std::vector<tUWB_CONTROLEE_OP> &ops) {
+  std::vector<tUWB_CONTROLEE_OP> wanted(desired, desired + count);
+  std::stable_sort(wanted.begin(), wanted.end(), addressOrder);
+  wanted.erase(std::unique(wanted.begin(), wanted.end(),
+                           [](const tUWB_CONTROLEE_OP &a,
+                              const tUWB_CONTROLEE_OP &b) {
+                             return a.shortAddress == b.shortAddress;
+                           }),
+               wanted.end());
+
+  std::vector<tUWB_CONTROLEE_OP> adds;
+  ops.clear();
+  std::lock_guard<std::mutex> lock(mLock);
+  const std::vector<tUWB_CONTROLEE_OP> &members = mSessions[sessionId].members;
+  size_t m = 0, w = 0;
+  while (m < members.size() || w < wanted.size()) {
+    if (w == wanted.size() || (m < members.size() &&
+                               members[m].shortAddress <
+                                   wanted[w].shortAddress)) {
+      ops.push_back(members[m++]);
+      ops.back().action = UWB_MC_LIST_ACTION_DELETE;
+    } else if (m == members.size() ||
+               wanted[w].shortAddress < members[m].shortAddress) {
+      adds.push_back(wanted[w++]);
+    } else {
+      if (members[m].subSessionId != wanted[w].subSessionId) {
+        ops.push_back(members[m]);
+        ops.back().action = UWB_MC_LIST_ACTION_DELETE;
+        adds.push_back(wanted[w]);
+      }
+      m++;
+      w++;
+    }
+  }
+  for (auto &op : adds) {
+    op.action = UWB_MC_LIST_ACTION_ADD;
+  }
+  ops.insert(ops.end(), adds.begin(), adds.end());
+  for (auto &op : ops) {
+    op.status = UWB_MC_LIST_STATUS_PENDING;
+  }
+}
+
+void UwbControleeRegistry::beginUpdate(
+    uint32_t sessionId, const std::vector<tUWB_CONTROLEE_OP> &ops) {
+  std::lock_guard<std::mutex> lock(mLock);
+  Session &session = mSessions[sessionId];
+  if (session.unreported > 0) {
+    JNI_TRACE_E("%s: %d controlees of session %x never reported", __func__,
+                session.unreported, sessionId);
+  }
+  session.update = ops;
+  for (auto &op : session.update) {
+    op.status = UWB_MC_LIST_STATUS_PENDING;
+  }
+  std::stable_sort(session.update.begin(), session.update.end(),
+                   updateOrder);
+  session.unreported = session.update.size();
+  session.remainingList = 0;
+}
+
+/* Report the first unreported operation of shortAddress and apply it to the
+ * members if the UWBS accepted it. False if there is none. */
+bool UwbControleeRegistry::setStatus(Session &session, uint16_t shortAddress,
+                                     uint32_t subSessionId, uint8_t status) {
+  tUWB_CONTROLEE_OP key = {};
+  key.shortAddress = shortAddress;
+  auto op = std::lower_bound(session.update.begin(), session.update.end(), key,
+                             addressOrder);
+  while (op != session.update.end() && op->shortAddress == shortAddress &&
+         op->status != UWB_MC_LIST_STATUS_PENDING) {
+    op++;
+  }
+  if (op == session.update.end() || op->shortAddress != shortAddress) {
+    return false;
+  }
+  op->status = status;
+  session.unreported--;
+  if (status != UWB_MC_LIST_STATUS_OK) {
+    return true;
+  }
+
+  std::vector<tUWB_CONTROLEE_OP> &members = session.members;
+  auto member =
+      std::lower_bound(members.begin(), members.end(), key, addressOrder);
+  bool found = member != members.end() && member->shortAddress == shortAddress;
+  if (op->action == UWB_MC_LIST_ACTION_DELETE) {
+    if (found) {
+      members.erase(member);
+    }
+  } else if (found) {
+    member->subSessionId = subSessionId;
+  } else {
+    tUWB_CONTROLEE_OP added = *op;
+    added.subSessionId = subSessionId;
+    members.insert(member, added);
+  }
+  return true;
+}
+
+void UwbControleeRegistry::finish(uint32_t sessionId, Session &session,
+                                  tUWB_CONTROLEE_REPORT *report) {
+  report->sessionId = sessionId;
+  report->remainingList = session.remainingList;
+  report->ops.swap(session.update);
+  session.update.clear();
+}
+
+bool UwbControleeRegistry::failChunk(uint32_t sessionId,
+                                     const tUWB_CONTROLEE_OP *ops,
+                                     uint16_t count, uint8_t status,
+                                     tUWB_CONTROLEE_REPORT *report) {
+  std::lock_guard<std::mutex> lock(mLock);
+  auto it = mSessions.find(sessionId);
+  if (it == mSessions.end() || it->second.update.empty()) {
+    return false;
+  }
+  Session &session = it->second;
+  for (uint16_t i = 0; i < count; i++) {
+    setStatus(session, ops[i].shortAddress, ops[i].subSessionId, status);
+  }
+  if (session.unreported > 0) {
+    return false;
+  }
+  finish(sessionId, session, report);
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        merge
+**
+** Description:     Fold the controlee statuses of a multicast list
+**                  notification into the update in flight of its session.
+**                  Controlees the update does not know are ignored.
+**
+** Params:          ntf: multicast list update notification.
+**                  report: receives the merged statuses once every
+**                  controlee of the update was reported.
+**                  complete: set if report was filled.
+**
+** Returns:         false if the session has no update in flight and the
+**                  notification must be delivered on its own.
+**
+*******************************************************************************/
+bool UwbControleeRegistry::merge(
+    const tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF &ntf,
+    tUWB_CONTROLEE_REPORT *report, bool *complete) {
+  *complete = false;
+  std::lock_guard<std::mutex> lock(mLock);
+  auto it = mSessions.find(ntf.session_id);
+  if (it == mSessions.end() || it->second.update.empty()) {
+    return false;
+  }
+  Session &session = it->second;
+  uint8_t count = std::min<uint8_t>(ntf.no_of_controlees, MAX_NUM_CONTROLLEES);
+  for (uint8_t i = 0; i < count; i++) {
+    if (!setStatus(session, ntf.controlee_mac_address_list[i],
+                   ntf.subsession_id_list[i], ntf.status_list[i])) {
+      JNI_TRACE_E("%s: controlee %04x not in the update of session %x",
+                  __func__, ntf.controlee_mac_address_list[i],
+                  ntf.session_id);
+    }
+  }
+  session.remainingList = ntf.remaining_list;
+  if (session.unreported == 0) {
+    finish(ntf.session_id, session, report);
+    *complete = true;
+  }
+  return true;
+}
+
+void UwbControleeRegistry::remove(uint32_t sessionId) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mSessions.erase(sessionId);
+}
+
+void UwbControleeRegistry::clear() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mSessions.clear();
+}
+
+} // namespace android
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_CONTROLEE_REGISTRY_H_
+#define _UWB_CONTROLEE_REGISTRY_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "uwa_api.h"
+
+namespace android {
+
+/* Actions of SESSION_UPDATE_CONTROLLER_MULTICAST_LIST_CMD */
+#define UWB_MC_LIST_ACTION_ADD 0x00
+#define UWB_MC_LIST_ACTION_DELETE 0x01
+/* Controlee status of the multicast list notification */
+#define UWB_MC_LIST_STATUS_OK 0x00
+/* Status of a controlee not reported yet, never sent by the UWBS */
+#define UWB_MC_LIST_STATUS_PENDING 0xFF
+
+typedef struct {
+  uint16_t shortAddress;
+  uint32_t subSessionId;
+  uint8_t action; // UWB_MC_LIST_ACTION_*
+  uint8_t status; // UWB_MC_LIST_STATUS_* or the UWBS status
+} tUWB_CONTROLEE_OP;
+
+/* Statuses of one update, merged across its notifications */
+typedef struct {
+  uint32_t sessionId;
+  uint8_t remainingList; // of the last notification
+  std::vector<tUWB_CONTROLEE_OP> ops;
+} tUWB_CONTROLEE_REPORT;
+
+/* Controlees of the controller's one to many sessions. A session has at most
+ * one update in flight, built either from explicit add / delete operations or
+ * from the difference between the current and a desired set. The update is
+ * sent in chunks of up to MAX_NUM_CONTROLLEES, and the per controlee statuses
+ * of the multicast list notifications answering them are merged into a single
+ * report. Only controlees the UWBS confirmed are kept as members, updates
+ * made without this registry are not tracked. */
+class UwbControleeRegistry {
+public:
+  /* Operations turning the members of the session into desired, deletes
+   * first. A controlee whose sub session changed is deleted and added. */
+  void diff(uint32_t sessionId, const tUWB_CONTROLEE_OP *desired,
+            uint16_t count, std::vector<tUWB_CONTROLEE_OP> &ops);
+  /* Start tracking the statuses of ops, replacing an unfinished update */
+  void beginUpdate(uint32_t sessionId,
+                   const std::vector<tUWB_CONTROLEE_OP> &ops);
+  /* A chunk the UWBS rejected, its controlees will not be notified. Returns
+   * true and fills report if this completed the update. */
+  bool failChunk(uint32_t sessionId, const tUWB_CONTROLEE_OP *ops,
+                 uint16_t count, uint8_t status,
+                 tUWB_CONTROLEE_REPORT *report);
+  /* Notification side. Returns false if no update of the session is in
+   * flight, else merges the statuses and fills report once complete */
+  bool merge(const tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF &ntf,
+             tUWB_CONTROLEE_REPORT *report, bool *complete);
+
+  void remove(uint32_t sessionId);
+  void clear();
+
+private:
+  friend class UwbChipContext;
+  UwbControleeRegistry() {}
+
+  struct Session {
+    Session() : unreported(0), remainingList(0) {}
+
+    /* Confirmed members, sorted by short address */
+    std::vector<tUWB_CONTROLEE_OP> members;
+    /* Operations of the update in flight, sorted by short address, deletes
+     * before adds of the same address */
+    std::vector<tUWB_CONTROLEE_OP> update;
+    uint32_t unreported;
+    uint8_t remainingList;
+  };
+
+  static bool setStatus(Session &session, uint16_t shortAddress,
+                        uint32_t subSessionId, uint8_t status);
+  static void finish(uint32_t sessionId, Session &session,
+                     tUWB_CONTROLEE_REPORT *report);
+
+  std::mutex mLock;
+  std::map<uint32_t, Session> mSessions;
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "UwbDeliveryPolicy.h"
+
+namespace android {
+
+UwbDeliveryPolicy::UwbDeliveryPolicy() {
+  memset(&mConfig, 0, sizeof(mConfig));
+  reset();
+}
+
+bool UwbDeliveryPolicy::isValidConfig(
+    const tUWB_DELIVERY_POLICY_CONFIG &config) {
+  switch (config.mode) {
+  case UWB_DELIVERY_POLICY_ALL:
+    return true;
+  case UWB_DELIVERY_POLICY_EVERY_NTH:
+    return config.everyNth > 0;
+  case UWB_DELIVERY_POLICY_MIN_INTERVAL:
+    return config.minIntervalMs > 0;
+  case UWB_DELIVERY_POLICY_ON_CHANGE:
+    return config.distanceThreshold > 0 || config.angleThreshold > 0;
+  default:
+    return false;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        configure
+**
+** Description:     Select the delivery policy of the session. The next round
+**                  is always delivered.
+**
+** Params:          config: validated policy configuration.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbDeliveryPolicy::configure(const tUWB_DELIVERY_POLICY_CONFIG &config) {
+  mConfig = config;
+  reset();
+}
+
+void UwbDeliveryPolicy::reset() {
+  mRoundCount = 0;
+  mHasDelivered = false;
+  mLastDeliveryMs = 0;
+  mLastNoOfMeasurements = 0;
+}
+
+/*******************************************************************************
+**
+** Function:        admit
+**
+** Description:     Apply the policy to one ranging round. ON_CHANGE only
+**                  applies to two way rounds, other rounds are delivered.
+**
+** Params:          rangingNtf: ranging data notification, already filtered.
+**                  nowMs: monotonic time of the round.
+**
+** Returns:         true if the round must be delivered.
+**
+*******************************************************************************/
+bool UwbDeliveryPolicy::admit(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                              int64_t nowMs) {
+  bool deliver = true;
+  switch (mConfig.mode) {
+  case UWB_DELIVERY_POLICY_EVERY_NTH:
+    deliver = mRoundCount % mConfig.everyNth == 0;
+    mRoundCount++;
+    break;
+  case UWB_DELIVERY_POLICY_MIN_INTERVAL:
+    deliver = !mHasDelivered ||
+              nowMs - mLastDeliveryMs >= (int64_t)mConfig.minIntervalMs;
+    break;
+  case UWB_DELIVERY_POLICY_ON_CHANGE:
+    if (rangingNtf->ranging_measure_type != MEASUREMENT_TYPE_TWOWAY) {
+      break;
+    }
+    deliver = !mHasDelivered || hasChanged(rangingNtf);
+    if (deliver) {
+      remember(rangingNtf);
+    }
+    break;
+  default:
+    break;
+  }
+  if (deliver) {
+    mHasDelivered = true;
+    mLastDeliveryMs = nowMs;
+  }
+  return deliver;
+}
+
+bool UwbDeliveryPolicy::hasChanged(
+    const tUWA_RANGE_DATA_NTF *rangingNtf) const {
+  int noOfMeasurements =
+      std::min<int>(rangingNtf->no_of_measurements, MAX_NUM_RESPONDERS);
+  if (noOfMeasurements != mLastNoOfMeasurements) {
+    return true;
+  }
+  for (int i = 0; i < noOfMeasurements; i++) {
+    const tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    if (twr_range_measr.status != mLastStatus[i]) {
+      return true;
+    }
+    if (mConfig.distanceThreshold > 0 &&
+        abs(twr_range_measr.distance - mLastDistance[i]) >=
+            mConfig.distanceThreshold) {
+      return true;
+    }
+    if (mConfig.angleThreshold > 0 &&
+        (abs((int16_t)twr_range_measr.aoa_azimuth - mLastAzimuth[i]) >=
+             mConfig.angleThreshold ||
+         abs((int16_t)twr_range_measr.aoa_elevation - mLastElevation[i]) >=
+             mConfig.angleThreshold)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void UwbDeliveryPolicy::remember(const tUWA_RANGE_DATA_NTF *rangingNtf) {
+  mLastNoOfMeasurements =
+      std::min<int>(rangingNtf->no_of_measurements, MAX_NUM_RESPONDERS);
+  for (int i = 0; i < mLastNoOfMeasurements; i++) {
+    const tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    mLastStatus[i] = twr_range_measr.status;
+    mLastDistance[i] = twr_range_measr.distance;
+    mLastAzimuth[i] = (int16_t)twr_range_measr.aoa_azimuth;
+    mLastElevation[i] = (int16_t)twr_range_measr.aoa_elevation;
+  }
+}
+
+} // namespace android
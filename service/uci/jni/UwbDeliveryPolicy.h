@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_DELIVERY_POLICY_H_
+#define _UWB_DELIVERY_POLICY_H_
+
+#include <stdint.h>
+
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+typedef enum {
+  /* Deliver every round */
+  UWB_DELIVERY_POLICY_ALL = 0,
+  /* Deliver one round out of everyNth */
+  UWB_DELIVERY_POLICY_EVERY_NTH,
+  /* Deliver the latest round once minIntervalMs elapsed since the last one */
+  UWB_DELIVERY_POLICY_MIN_INTERVAL,
+  /* Deliver a two way round once a distance or angle moved beyond its
+   * threshold since the last delivered round */
+  UWB_DELIVERY_POLICY_ON_CHANGE,
+  UWB_DELIVERY_POLICY_MODE_MAX
+} eUWB_DELIVERY_POLICY_MODE;
+
+typedef struct {
+  uint8_t mode;
+  uint16_t everyNth;      // EVERY_NTH, 1 or more
+  uint32_t minIntervalMs; // MIN_INTERVAL, 1 or more
+  /* ON_CHANGE, 0 ignores the quantity. Angles are in the Q9.7 degree units
+   * of the notification */
+  uint16_t distanceThreshold; // cm
+  uint16_t angleThreshold;
+} tUWB_DELIVERY_POLICY_CONFIG;
+
+/* Decides which ranging rounds of a session cross JNI. Runs after the
+ * ranging filter, so suppressed rounds still feed it and the delivered round
+ * carries the filtered values. */
+class UwbDeliveryPolicy {
+public:
+  UwbDeliveryPolicy();
+
+  static bool isValidConfig(const tUWB_DELIVERY_POLICY_CONFIG &config);
+
+  void configure(const tUWB_DELIVERY_POLICY_CONFIG &config);
+  void reset();
+  bool isActive() const { return mConfig.mode != UWB_DELIVERY_POLICY_ALL; }
+
+  /* Whether the round must be delivered, nowMs is a monotonic time */
+  bool admit(const tUWA_RANGE_DATA_NTF *rangingNtf, int64_t nowMs);
+
+private:
+  bool hasChanged(const tUWA_RANGE_DATA_NTF *rangingNtf) const;
+  void remember(const tUWA_RANGE_DATA_NTF *rangingNtf);
+
+  tUWB_DELIVERY_POLICY_CONFIG mConfig;
+  uint32_t mRoundCount;
+  bool mHasDelivered;
+  int64_t mLastDeliveryMs;
+
+  /* ON_CHANGE, measurement i of the last delivered round */
+  uint8_t mLastNoOfMeasurements;
+  uint8_t mLastStatus[MAX_NUM_RESPONDERS];
+  uint16_t mLastDistance[MAX_NUM_RESPONDERS];
+  int16_t mLastAzimuth[MAX_NUM_RESPONDERS];
+  int16_t mLastElevation[MAX_NUM_RESPONDERS];
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "JniLog.h"
+#include "UwbDeviceSnapshot.h"
+
+namespace android {
+
+UwbDeviceSnapshot::UwbDeviceSnapshot() {
+  mValid = false;
+  mPath[0] = '\0';
+  memset(&mKey, 0, sizeof(mKey));
+  mCoreConfigLen = 0;
+  mNoOfCapTlvs = 0;
+  mCapLen = 0;
+}
+
+static uint32_t snapshotChecksum(const uint8_t *data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool sameKey(const tUWB_DEVICE_SNAPSHOT_KEY &a,
+                    const tUWB_DEVICE_SNAPSHOT_KEY &b) {
+  return a.deviceInfo.uciVersion == b.deviceInfo.uciVersion &&
+         a.deviceInfo.macVersion == b.deviceInfo.macVersion &&
+         a.deviceInfo.phyVersion == b.deviceInfo.phyVersion &&
+         a.deviceInfo.uciTestVersion == b.deviceInfo.uciTestVersion &&
+         a.vendorInfoLen == b.vendorInfoLen &&
+         memcmp(a.vendorInfo, b.vendorInfo, a.vendorInfoLen) == 0;
+}
+
+/*******************************************************************************
+**
+** Function:        load
+**
+** Description:     Map the snapshot file and take its values if the file is
+**                  complete and of the current version. The values stay
+**                  unverified until the chip reports its device info.
+**
+** Params:          path: snapshot file, also used by later updates.
+**
+** Returns:         true if a snapshot was loaded.
+**
+*******************************************************************************/
+bool UwbDeviceSnapshot::load(const char *path) {
+  std::lock_guard<std::mutex> lock(mLock);
+  snprintf(mPath, sizeof(mPath), "%s", path);
+  mValid = false;
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    JNI_TRACE_I("%s: no snapshot at %s", __func__, path);
+    return false;
+  }
+  struct stat st;
+  size_t maxSize = sizeof(tUWB_DEVICE_SNAPSHOT_HDR) +
+                   UWB_DEVICE_SNAPSHOT_MAX_VENDOR_INFO +
+                   UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG + UCI_MAX_PKT_SIZE;
+  if (fstat(fd, &st) != 0 ||
+      st.st_size < (off_t)sizeof(tUWB_DEVICE_SNAPSHOT_HDR) ||
+      st.st_size > (off_t)maxSize) {
+    JNI_TRACE_E("%s: invalid snapshot size", __func__);
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    JNI_TRACE_E("%s: cannot map %s", __func__, path);
+    return false;
+  }
+
+  const uint8_t *data = (const uint8_t *)map;
+  tUWB_DEVICE_SNAPSHOT_HDR hdr;
+  memcpy(&hdr, data, sizeof(hdr));
+  const uint8_t *payload = data + sizeof(hdr);
+  size_t payloadLen = size - sizeof(hdr);
+  if (hdr.magic != UWB_DEVICE_SNAPSHOT_MAGIC ||
+      hdr.version != UWB_DEVICE_SNAPSHOT_VERSION ||
+      hdr.headerSize != sizeof(hdr) ||
+      hdr.coreConfigLen > UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG ||
+      hdr.capLen > UCI_MAX_PKT_SIZE ||
+      payloadLen != (size_t)hdr.vendorInfoLen + hdr.coreConfigLen + hdr.capLen ||
+      hdr.checksum != snapshotChecksum(payload, payloadLen)) {
+    JNI_TRACE_E("%s: discarding invalid snapshot", __func__);
+    munmap(map, size);
+    return false;
+  }
+
+  memset(&mKey, 0, sizeof(mKey));
+  mKey.deviceInfo.uciVersion = hdr.uciVersion;
+  mKey.deviceInfo.macVersion = hdr.macVersion;
+  mKey.deviceInfo.phyVersion = hdr.phyVersion;
+  mKey.deviceInfo.uciTestVersion = hdr.uciTestVersion;
+  mKey.vendorInfoLen = hdr.vendorInfoLen;
+  memcpy(mKey.vendorInfo, payload, hdr.vendorInfoLen);
+  payload += hdr.vendorInfoLen;
+  mCoreConfigLen = hdr.coreConfigLen;
+  memcpy(mCoreConfig, payload, hdr.coreConfigLen);
+  payload += hdr.coreConfigLen;
+  mNoOfCapTlvs = hdr.noOfCapTlvs;
+  mCapLen = hdr.capLen;
+  memcpy(mCaps, payload, hdr.capLen);
+  munmap(map, size);
+
+  mValid = true;
+  JNI_TRACE_I("%s: loaded snapshot, UCI %x, %d capability TLVs", __func__,
+              mKey.deviceInfo.uciVersion, mNoOfCapTlvs);
+  return true;
+}
+
+bool UwbDeviceSnapshot::getDeviceInfo(deviceInfo_t *info) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (!mValid) {
+    return false;
+  }
+  *info = mKey.deviceInfo;
+  return true;
+}
+
+bool UwbDeviceSnapshot::getCapabilities(uint8_t *caps, uint16_t capacity,
+                                        uint16_t *capLen, uint16_t *noOfTlvs) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (!mValid || mCapLen > capacity) {
+    return false;
+  }
+  memcpy(caps, mCaps, mCapLen);
+  *capLen = mCapLen;
+  *noOfTlvs = mNoOfCapTlvs;
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        validate
+**
+** Description:     Check the snapshot against the device info reported by
+**                  the chip. A snapshot of another chip or firmware is no
+**                  longer served until update() replaces it.
+**
+** Params:          key: device info and vendor info read from the chip.
+**
+** Returns:         true if the snapshot describes this chip.
+**
+*******************************************************************************/
+bool UwbDeviceSnapshot::validate(const tUWB_DEVICE_SNAPSHOT_KEY &key) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mValid && !sameKey(mKey, key)) {
+    JNI_TRACE_I("%s: snapshot is stale", __func__);
+    mValid = false;
+  }
+  return mValid;
+}
+
+/*******************************************************************************
+**
+** Function:        update
+**
+** Description:     Take the values read from the chip during init. The file
+**                  is only rewritten if they differ from the snapshot.
+**
+** Params:          key: device info and vendor info read from the chip.
+**                  coreConfig: core config TLVs applied at init.
+**                  coreConfigLen: length of coreConfig.
+**                  caps: unfiltered capability TLVs.
+**                  capLen: length of caps.
+**                  noOfTlvs: number of capability TLVs.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbDeviceSnapshot::update(const tUWB_DEVICE_SNAPSHOT_KEY &key,
+                               const uint8_t *coreConfig, uint8_t coreConfigLen,
+                               const uint8_t *caps, uint16_t capLen,
+                               uint16_t noOfTlvs) {
+  if (coreConfigLen > UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG ||
+      capLen > UCI_MAX_PKT_SIZE) {
+    JNI_TRACE_E("%s: values too large for a snapshot", __func__);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mValid &&
+      sameLocked(key, coreConfig, coreConfigLen, caps, capLen, noOfTlvs)) {
+    return;
+  }
+  mKey = key;
+  mCoreConfigLen = coreConfigLen;
+  memcpy(mCoreConfig, coreConfig, coreConfigLen);
+  mCapLen = capLen;
+  mNoOfCapTlvs = noOfTlvs;
+  memcpy(mCaps, caps, capLen);
+  mValid = true;
+  if (mPath[0] != '\0' && !persistLocked()) {
+    JNI_TRACE_E("%s: cannot persist snapshot", __func__);
+  }
+}
+
+bool UwbDeviceSnapshot::sameLocked(const tUWB_DEVICE_SNAPSHOT_KEY &key,
+                                   const uint8_t *coreConfig,
+                                   uint8_t coreConfigLen, const uint8_t *caps,
+                                   uint16_t capLen, uint16_t noOfTlvs) const {
+  return sameKey(mKey, key) && mCoreConfigLen == coreConfigLen &&
+         memcmp(mCoreConfig, coreConfig, coreConfigLen) == 0 &&
+         mNoOfCapTlvs == noOfTlvs && mCapLen == capLen &&
+         memcmp(mCaps, caps, capLen) == 0;
+}
+
+/* Write to a temporary file and rename it, a crash never leaves a torn file */
+bool UwbDeviceSnapshot::persistLocked() {
+  std::vector<uint8_t> file(sizeof(tUWB_DEVICE_SNAPSHOT_HDR));
+  file.insert(file.end(), mKey.vendorInfo, mKey.vendorInfo + mKey.vendorInfoLen);
+  file.insert(file.end(), mCoreConfig, mCoreConfig + mCoreConfigLen);
+  file.insert(file.end(), mCaps, mCaps + mCapLen);
+
+  tUWB_DEVICE_SNAPSHOT_HDR hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = UWB_DEVICE_SNAPSHOT_MAGIC;
+  hdr.version = UWB_DEVICE_SNAPSHOT_VERSION;
+  hdr.headerSize = sizeof(hdr);
+  hdr.uciVersion = mKey.deviceInfo.uciVersion;
+  hdr.macVersion = mKey.deviceInfo.macVersion;
+  hdr.phyVersion = mKey.deviceInfo.phyVersion;
+  hdr.uciTestVersion = mKey.deviceInfo.uciTestVersion;
+  hdr.vendorInfoLen = mKey.vendorInfoLen;
+  hdr.coreConfigLen = mCoreConfigLen;
+  hdr.noOfCapTlvs = mNoOfCapTlvs;
+  hdr.capLen = mCapLen;
+  hdr.checksum = snapshotChecksum(file.data() + sizeof(hdr),
+                                  file.size() - sizeof(hdr));
+  memcpy(file.data(), &hdr, sizeof(hdr));
+
+  char tmpPath[sizeof(mPath) + 4];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", mPath);
+  int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = write(fd, file.data(), file.size()) == (ssize_t)file.size() &&
+            fsync(fd) == 0;
+  close(fd);
+  if (!ok || rename(tmpPath, mPath) != 0) {
+    unlink(tmpPath);
+    return false;
+  }
+  return true;
+}
+
+} // namespace android
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_DEVICE_SNAPSHOT_H_
+#define _UWB_DEVICE_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#include <mutex>
+
+#include "UwbJniTypes.h"
+#include "uci_defs.h"
+
+namespace android {
+
+/* Device info and capabilities of the last UWBS seen, kept across reboots.
+ * The default chip keeps the original path, every other chip its own file
+ * named after the chip id. */
+#define UWB_DEVICE_SNAPSHOT_PATH                                               \
+  "/data/misc/apexdata/com.android.uwb/uwb_device_snapshot.bin"
+#define UWB_DEVICE_SNAPSHOT_CHIP_PATH_FORMAT                                   \
+  "/data/misc/apexdata/com.android.uwb/uwb_device_snapshot_%d.bin"
+
+/* Snapshot file: a tUWB_DEVICE_SNAPSHOT_HDR followed by vendorInfoLen bytes
+ * of the vendor specific device info (firmware version), coreConfigLen bytes
+ * of core config TLVs applied at init and capLen bytes of the unfiltered
+ * capability TLVs. Integers are stored in host byte order. */
+#define UWB_DEVICE_SNAPSHOT_MAGIC 0x53425755 // "UWBS"
+#define UWB_DEVICE_SNAPSHOT_VERSION 1
+#define UWB_DEVICE_SNAPSHOT_MAX_VENDOR_INFO 255
+#define UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG 32
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint16_t uciVersion;
+  uint16_t macVersion;
+  uint16_t phyVersion;
+  uint16_t uciTestVersion;
+  uint8_t vendorInfoLen;
+  uint8_t coreConfigLen;
+  uint16_t noOfCapTlvs;
+  uint16_t capLen;
+  uint16_t reserved;
+  uint32_t checksum; // FNV-1a of everything after the header
+} tUWB_DEVICE_SNAPSHOT_HDR;
+
+/* Key of a snapshot, it only describes a UWBS reporting the same values */
+typedef struct {
+  deviceInfo_t deviceInfo;
+  uint8_t vendorInfoLen;
+  uint8_t vendorInfo[UWB_DEVICE_SNAPSHOT_MAX_VENDOR_INFO];
+} tUWB_DEVICE_SNAPSHOT_KEY;
+
+/* Serves device info and capability queries from the last persisted chip
+ * state while the UWBS is off or still initializing. A loaded snapshot is
+ * used as is until the chip reports its device info; a different key marks
+ * it stale, and the capability response of the same init replaces it. */
+class UwbDeviceSnapshot {
+public:
+  bool load(const char *path);
+
+  bool getDeviceInfo(deviceInfo_t *info);
+  bool getCapabilities(uint8_t *caps, uint16_t capacity, uint16_t *capLen,
+                       uint16_t *noOfTlvs);
+
+  /* Compare the key reported by the chip, false marks the snapshot stale */
+  bool validate(const tUWB_DEVICE_SNAPSHOT_KEY &key);
+  /* Take the values read from the chip, rewriting the file if they changed */
+  void update(const tUWB_DEVICE_SNAPSHOT_KEY &key, const uint8_t *coreConfig,
+              uint8_t coreConfigLen, const uint8_t *caps, uint16_t capLen,
+              uint16_t noOfTlvs);
+
+private:
+  friend class UwbChipContext;
+  UwbDeviceSnapshot();
+
+  bool persistLocked();
+  bool sameLocked(const tUWB_DEVICE_SNAPSHOT_KEY &key,
+                  const uint8_t *coreConfig, uint8_t coreConfigLen,
+                  const uint8_t *caps, uint16_t capLen,
+                  uint16_t noOfTlvs) const;
+
+  std::mutex mLock;
+  bool mValid;
+  char mPath[128];
+  tUWB_DEVICE_SNAPSHOT_KEY mKey;
+  uint8_t mCoreConfigLen;
+  uint8_t mCoreConfig[UWB_DEVICE_SNAPSHOT_MAX_CORE_CONFIG];
+  uint16_t mNoOfCapTlvs;
+  uint16_t mCapLen;
+  uint8_t mCaps[UCI_MAX_PKT_SIZE];
+};
+
+} // namespace android
+#endif
@@ -16,12 +16,17 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "UwbJniInternal.h"
+#include "UwbNotificationDispatcher.h"
 #include "UwbEventManager.h"
 #include "JniLog.h"
 #include "ScopedJniEnv.h"
 #include "SyncEvent.h"
 #include "UwbAdaptation.h"
+#include "UwbTrace.h"
+#include "UwbVendorNtfFilter.h"
 #include "uwb_config.h"
 #include "uwb_hal_int.h"
 
@@ -35,19 +40,24 @@ const char *RANGING_MEASURES_CLASS_NAME =
        TODO support for these class to be added in service.*/
 const char *MULTICAST_UPDATE_LIST_DATA_CLASS_NAME =
     "com/android/server/uwb/data/UwbMulticastListUpdateStatus";
-
-UwbEventManager UwbEventManager::mObjUwbManager;
-
-UwbEventManager &UwbEventManager::getInstance() { return mObjUwbManager; }
-
-UwbEventManager::UwbEventManager() {
+const char *VENDOR_UCI_RESPONSE_CLASS_NAME =
+    "com/android/server/uwb/data/UwbVendorUciResponse";
+const char *CONFIG_STATUS_DATA_CLASS_NAME =
+    "com/android/server/uwb/data/UwbConfigStatusData";
+const char *TLV_DATA_CLASS_NAME = "com/android/server/uwb/data/UwbTlvData";
+const char *SPECIFICATION_INFO_CLASS_NAME =
+    "com/android/server/uwb/info/UwbSpecificationInfo";
+
+/* Class references shared by the event managers of every chip */
+static std::once_flag sSymbolsOnce;
+
+UwbEventManager::UwbEventManager(UwbControleeRegistry &controleeRegistry,
+                                 UwbNotificationDispatcher &dispatcher)
+    : mControleeRegistry(controleeRegistry), mDispatcher(dispatcher),
+      mRangeDataBatchTimer(*this), mVendorNtfBatchTimer(*this) {
   mVm = NULL;
   mClass = NULL;
   mObject = NULL;
-  mRangeDataClass = NULL;
-  mRangingTwoWayMeasuresClass = NULL;
-  mRangeTdoaMeasuresClass = NULL;
-  mMulticastUpdateListDataClass = NULL;
   mOnDeviceStateNotificationReceived = NULL;
   mOnRangeDataNotificationReceived = NULL;
   mOnSessionStatusNotificationReceived = NULL;
@@ -57,6 +67,17 @@ UwbEventManager::UwbEventManager() {
   mOnRawUciNotificationReceived = NULL;
   mOnVendorUciNotificationReceived = NULL;
   mOnVendorDeviceInfo = NULL;
+  mOnRangeDataBatchReceived = NULL;
+  mOnCommandCompleted = NULL;
+  mOnVendorUciNotificationBatchReceived = NULL;
+  mOnPositionFixReceived = NULL;
+  mOnTdoaRangeDataBatchReceived = NULL;
+  mRangeDataBatchConfigPending = false;
+  mPendingBatchMaxRecords = 0;
+  mPendingBatchFlushTimeoutMs = 0;
+  mRangeDataBatchBuffer = NULL;
+  mTdoaRangeDataBatchBuffer = NULL;
+  mVendorNtfBatchCount = 0;
 }
 
 void UwbEventManager::onRangeDataNotificationReceived(
@@ -70,86 +91,87 @@ void UwbEventManager::onRangeDataNotificationReceived(
     return;
   }
 
-  jobject rangeDataObject;
-
-  if (ranging_ntf_data->ranging_measure_type == MEASUREMENT_TYPE_TWOWAY) {
-    JNI_TRACE_I("%s: ranging_measure_type = MEASUREMENT_TYPE_TWOWAY", fn);
-    jmethodID rngMeasuresCtor;
-    jmethodID rngDataCtorTwm;
-    jobjectArray rangeMeasuresArray;
-    rangeMeasuresArray =
-        env->NewObjectArray(ranging_ntf_data->no_of_measurements,
-                            mRangingTwoWayMeasuresClass, NULL);
-
-    /* Copy the data from structure to Java Object */
-    for (int i = 0; i < ranging_ntf_data->no_of_measurements; i++) {
-      jbyteArray macAddress;
-      jbyteArray rfu;
-
-      if (ranging_ntf_data->mac_addr_mode_indicator == SHORT_MAC_ADDRESS) {
-        macAddress = env->NewByteArray(2);
-        env->SetByteArrayRegion(
-            macAddress, 0, 2,
-            (jbyte *)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                .mac_addr);
-        rfu = env->NewByteArray(12);
-        env->SetByteArrayRegion(
-            rfu, 0, 12,
-            (jbyte *)ranging_ntf_data->ranging_measures.twr_range_measr[i].rfu);
-      } else {
-        macAddress = env->NewByteArray(8);
-        env->SetByteArrayRegion(
-            macAddress, 0, 8,
-            (jbyte *)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                .mac_addr);
-        rfu = env->NewByteArray(6);
-        env->SetByteArrayRegion(
-            rfu, 0, 6,
-            (jbyte *)ranging_ntf_data->ranging_measures.twr_range_measr[i].rfu);
-      }
-      rngMeasuresCtor = env->GetMethodID(mRangingTwoWayMeasuresClass, "<init>",
-                                         "([BIIIIIIIIIIII)V");
-
-      env->SetObjectArrayElement(
-          rangeMeasuresArray, i,
-          env->NewObject(
-              mRangingTwoWayMeasuresClass, rngMeasuresCtor, macAddress,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i].status,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i].nLos,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .distance,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_azimuth,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_azimuth_FOM,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_elevation,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_elevation_FOM,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_dest_azimuth,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_dest_azimuth_FOM,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_dest_elevation,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .aoa_dest_elevation_FOM,
-              (int)ranging_ntf_data->ranging_measures.twr_range_measr[i]
-                  .slot_index,
-              rfu));
+  // TDoA rounds are decoded by the dispatcher, see onTdoaRangeDataReceived().
+  if (ranging_ntf_data->ranging_measure_type != MEASUREMENT_TYPE_TWOWAY) {
+    JNI_TRACE_E("%s: unexpected measurement type %d", fn,
+                ranging_ntf_data->ranging_measure_type);
+    return;
+  }
+
+  if (mRangeDataBatch.isEnabled()) {
+    bool isFirstRecord = mRangeDataBatch.getRecordCount() == 0 &&
+                         mTdoaRangeDataBatch.getRecordCount() == 0;
+    if (mRangeDataBatch.append(ranging_ntf_data)) {
+      deliverRangeDataBatch(env);
+    } else if (isFirstRecord && mRangeDataBatch.getFlushTimeoutMs() > 0) {
+      mRangeDataBatchTimer.set(mRangeDataBatch.getFlushTimeoutMs(),
+                               rangeDataBatchTimerCallback);
     }
+    return;
+  }
+
+  jobjectArray rangeMeasuresArray;
+  rangeMeasuresArray =
+      env->NewObjectArray(ranging_ntf_data->no_of_measurements,
+                          gUwbJniSymbols.rangingTwoWayMeasuresClass, NULL);
+  if (rangeMeasuresArray == NULL) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to allocate range measures", fn);
+    return;
+  }
 
-    rngDataCtorTwm = env->GetMethodID(
-        mRangeDataClass, "<init>",
-        "(JJIJIII[Lcom/android/server/uwb/data/UwbTwoWayMeasurement;)V");
-    rangeDataObject = env->NewObject(
-        mRangeDataClass, rngDataCtorTwm, (long)ranging_ntf_data->seq_counter,
-        (long)ranging_ntf_data->session_id,
-        (int)ranging_ntf_data->rcr_indication,
-        (long)ranging_ntf_data->curr_range_interval,
-        ranging_ntf_data->ranging_measure_type,
-        ranging_ntf_data->mac_addr_mode_indicator,
-        (int)ranging_ntf_data->no_of_measurements, rangeMeasuresArray);
+  const bool isShortMac =
+      ranging_ntf_data->mac_addr_mode_indicator == SHORT_MAC_ADDRESS;
+  const jsize macAddressLen = isShortMac ? 2 : 8;
+  const jsize rfuLen = isShortMac ? 12 : 6;
+
+  /* Copy the data from structure to Java Object. Every local reference
+   * created for a measurement is released once it is stored in the array,
+   * so the local reference table stays flat regardless of the number of
+   * measurements. */
+  for (int i = 0; i < ranging_ntf_data->no_of_measurements; i++) {
+    tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        ranging_ntf_data->ranging_measures.twr_range_measr[i];
+
+    jbyteArray macAddress = env->NewByteArray(macAddressLen);
+    env->SetByteArrayRegion(macAddress, 0, macAddressLen,
+                            (jbyte *)twr_range_measr.mac_addr);
+    jbyteArray rfu = env->NewByteArray(rfuLen);
+    env->SetByteArrayRegion(rfu, 0, rfuLen, (jbyte *)twr_range_measr.rfu);
+
+    jobject rangeMeasuresObject = env->NewObject(
+        gUwbJniSymbols.rangingTwoWayMeasuresClass,
+        gUwbJniSymbols.rangingTwoWayMeasuresCtor, macAddress,
+        (int)twr_range_measr.status, (int)twr_range_measr.nLos,
+        (int)twr_range_measr.distance, (int)twr_range_measr.aoa_azimuth,
+        (int)twr_range_measr.aoa_azimuth_FOM,
+        (int)twr_range_measr.aoa_elevation,
+        (int)twr_range_measr.aoa_elevation_FOM,
+        (int)twr_range_measr.aoa_dest_azimuth,
+        (int)twr_range_measr.aoa_dest_azimuth_FOM,
+        (int)twr_range_measr.aoa_dest_elevation,
+        (int)twr_range_measr.aoa_dest_elevation_FOM,
+        (int)twr_range_measr.slot_index, rfu);
+    env->SetObjectArrayElement(rangeMeasuresArray, i, rangeMeasuresObject);
+
+    env->DeleteLocalRef(rangeMeasuresObject);
+    env->DeleteLocalRef(rfu);
+    env->DeleteLocalRef(macAddress);
+  }
+
+  jobject rangeDataObject = env->NewObject(
+      gUwbJniSymbols.rangeDataClass, gUwbJniSymbols.rangeDataTwoWayCtor,
+      (long)ranging_ntf_data->seq_counter,
+      (long)ranging_ntf_data->session_id,
+      (int)ranging_ntf_data->rcr_indication,
+      (long)ranging_ntf_data->curr_range_interval,
+      ranging_ntf_data->ranging_measure_type,
+      ranging_ntf_data->mac_addr_mode_indicator,
+      (int)ranging_ntf_data->no_of_measurements, rangeMeasuresArray);
+  if (rangeDataObject == NULL) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to allocate range data", fn);
+    return;
   }
 
   if (mOnRangeDataNotificationReceived != NULL) {
@@ -163,7 +185,212 @@ void UwbEventManager::onRangeDataNotificationReceived(
   } else {
     JNI_TRACE_E("%s: rangeDataNtf MID is NULL", fn);
   }
-  JNI_TRACE_I("%s: exit", fn);
+  UWB_TRACE(UWB_TRACE_RANGE_UPCALL, ranging_ntf_data->session_id,
+            ranging_ntf_data->seq_counter, 0, 0);
+}
+
+/*******************************************************************************
+**
+** Function:        setRangeDataBatching
+**
+** Description:     Apply new batching thresholds. The change is queued behind
+**                  the notifications already posted: the dispatcher thread
+**                  flushes the rounds buffered under the previous thresholds
+**                  and then applies it. The direct ByteBuffer over the batch
+**                  storage is created on first use and kept for the lifetime
+**                  of the process.
+**
+** Params:          env: JVM environment.
+**                  maxRecords: rounds per batch, 0 disables batching.
+**                  flushTimeoutMs: flush deadline, 0 flushes on count only.
+**
+** Returns:         true on success.
+**
+*******************************************************************************/
+bool UwbEventManager::setRangeDataBatching(JNIEnv *env, uint16_t maxRecords,
+                                           uint32_t flushTimeoutMs) {
+  static const char fn[] = "setRangeDataBatching";
+  UNUSED(fn);
+
+  std::lock_guard<std::mutex> lock(mRangeDataBatchMutex);
+  if (maxRecords > 0) {
+    if (mOnRangeDataBatchReceived == NULL) {
+      JNI_TRACE_E("%s: rangeDataBatch MID is NULL", fn);
+      return false;
+    }
+    if (mRangeDataBatchBuffer == NULL) {
+      jobject buffer = env->NewDirectByteBuffer(mRangeDataBatch.getBuffer(),
+                                                mRangeDataBatch.getCapacity());
+      if (buffer == NULL) {
+        env->ExceptionClear();
+        JNI_TRACE_E("%s: fail to allocate batch buffer", fn);
+        return false;
+      }
+      mRangeDataBatchBuffer = env->NewGlobalRef(buffer);
+      env->DeleteLocalRef(buffer);
+    }
+  }
+
+  mRangeDataBatchConfigPending = true;
+  mPendingBatchMaxRecords = maxRecords;
+  mPendingBatchFlushTimeoutMs = flushTimeoutMs;
+  mDispatcher.postRangeDataBatchFlush();
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        flushRangeDataBatch
+**
+** Description:     Deliver the buffered ranging rounds, if any, then apply
+**                  a batching change made by setRangeDataBatching(). Called
+**                  on the dispatcher thread for a queued flush.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::flushRangeDataBatch() {
+  static const char fn[] = "flushRangeDataBatch";
+  UNUSED(fn);
+
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", fn);
+    return;
+  }
+
+  deliverRangeDataBatch(env);
+  std::lock_guard<std::mutex> lock(mRangeDataBatchMutex);
+  if (mRangeDataBatchConfigPending) {
+    mRangeDataBatch.configure(mPendingBatchMaxRecords,
+                              mPendingBatchFlushTimeoutMs);
+    mTdoaRangeDataBatch.configure(mPendingBatchMaxRecords);
+    mRangeDataBatchConfigPending = false;
+  }
+}
+
+void UwbEventManager::deliverRangeDataBatch(JNIEnv *env) {
+  static const char fn[] = "deliverRangeDataBatch";
+  UNUSED(fn);
+
+  uint16_t recordCount = mRangeDataBatch.getRecordCount();
+  if (recordCount == 0 && mTdoaRangeDataBatch.getRecordCount() == 0) {
+    return;
+  }
+  if (mRangeDataBatch.getFlushTimeoutMs() > 0) {
+    // A zero interval disarms the pending deadline.
+    mRangeDataBatchTimer.set(0, rangeDataBatchTimerCallback);
+  }
+  deliverTdoaRangeDataBatch(env);
+  if (recordCount == 0) {
+    return;
+  }
+
+  jobject buffer;
+  {
+    std::lock_guard<std::mutex> lock(mRangeDataBatchMutex);
+    buffer = mRangeDataBatchBuffer;
+  }
+  if (mOnRangeDataBatchReceived != NULL && buffer != NULL) {
+    env->CallVoidMethod(mObject, mOnRangeDataBatchReceived, buffer,
+                        (int)recordCount,
+                        (int)sizeof(tUWB_RANGE_DATA_BATCH_RECORD));
+    if (env->ExceptionCheck()) {
+      env->ExceptionDescribe();
+      env->ExceptionClear();
+      JNI_TRACE_E("%s: fail to send range data batch", fn);
+    }
+  } else {
+    JNI_TRACE_E("%s: rangeDataBatch MID is NULL", fn);
+  }
+  mRangeDataBatch.reset();
+}
+
+void UwbEventManager::deliverTdoaRangeDataBatch(JNIEnv *env) {
+  static const char fn[] = "deliverTdoaRangeDataBatch";
+  UNUSED(fn);
+
+  uint16_t recordCount = mTdoaRangeDataBatch.getRecordCount();
+  if (recordCount == 0) {
+    return;
+  }
+  env->CallVoidMethod(mObject, mOnTdoaRangeDataBatchReceived,
+                      mTdoaRangeDataBatchBuffer, (int)recordCount,
+                      (int)sizeof(tUWB_TDOA_RANGE_DATA));
+  if (env->ExceptionCheck()) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to send TDoA range data batch", fn);
+  }
+  mTdoaRangeDataBatch.reset();
+}
+
+/*******************************************************************************
+**
+** Function:        onTdoaRangeDataReceived
+**
+** Description:     Deliver a decoded TDoA round through the direct ByteBuffer
+**                  of the TDoA batch. With batching off every round is
+**                  flushed as a batch of one, no Java object is created per
+**                  measurement either way.
+**
+** Params:          tdoaRangeData: TDoA round, see tUWB_TDOA_RANGE_DATA.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::onTdoaRangeDataReceived(
+    const tUWB_TDOA_RANGE_DATA &tdoaRangeData) {
+  static const char fn[] = "onTdoaRangeDataReceived";
+  UNUSED(fn);
+
+  if (mOnTdoaRangeDataBatchReceived == NULL) {
+    JNI_TRACE_E("%s: tdoaRangeDataBatch MID is NULL", fn);
+    return;
+  }
+
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", fn);
+    return;
+  }
+
+  if (mTdoaRangeDataBatchBuffer == NULL) {
+    jobject buffer = env->NewDirectByteBuffer(
+        mTdoaRangeDataBatch.getBuffer(), mTdoaRangeDataBatch.getCapacity());
+    if (buffer == NULL) {
+      env->ExceptionClear();
+      JNI_TRACE_E("%s: fail to allocate TDoA batch buffer", fn);
+      return;
+    }
+    mTdoaRangeDataBatchBuffer = env->NewGlobalRef(buffer);
+    env->DeleteLocalRef(buffer);
+  }
+
+  bool isFirstRecord = mRangeDataBatch.getRecordCount() == 0 &&
+                       mTdoaRangeDataBatch.getRecordCount() == 0;
+  if (mTdoaRangeDataBatch.append(tdoaRangeData) ||
+      !mRangeDataBatch.isEnabled()) {
+    deliverRangeDataBatch(env);
+  } else if (isFirstRecord && mRangeDataBatch.getFlushTimeoutMs() > 0) {
+    mRangeDataBatchTimer.set(mRangeDataBatch.getFlushTimeoutMs(),
+                             rangeDataBatchTimerCallback);
+  }
+  UWB_TRACE(UWB_TRACE_RANGE_UPCALL, tdoaRangeData.session_id,
+            tdoaRangeData.seq_counter, 0, 0);
+}
+
+/* Runs on the timer wheel thread, the flush itself is queued so that it is
+ * delivered in order with the rounds still waiting in the dispatcher */
+void UwbEventManager::rangeDataBatchTimerCallback(union sigval value) {
+  timerOwner(value).mDispatcher.postRangeDataBatchFlush();
+}
+
+/* sival_ptr is the IntervalTimer that expired, one of the BatchTimers */
+UwbEventManager &UwbEventManager::timerOwner(union sigval value) {
+  return static_cast<BatchTimer *>(
+             static_cast<IntervalTimer *>(value.sival_ptr))
+      ->mOwner;
 }
 
 void UwbEventManager::onRawUciNotificationReceived(uint8_t *data,
@@ -280,12 +507,6 @@ void UwbEventManager::onMulticastListUpdateNotificationReceived(
   UNUSED(fn);
   JNI_TRACE_I("%s: enter;", fn);
 
-  ScopedJniEnv env(mVm);
-  if (env == NULL) {
-    JNI_TRACE_E("%s: jni env is null", fn);
-    return;
-  }
-
   if (multicast_list_ntf == NULL) {
     JNI_TRACE_E("%s: multicast_list_ntf is null", fn);
     return;
@@ -297,54 +518,146 @@ void UwbEventManager::onMulticastListUpdateNotificationReceived(
     return;
   }
 
-  jintArray controleeMacAddressArray =
-      env->NewIntArray(multicast_list_ntf->no_of_controlees);
-  jlongArray subSessionIdArray =
-      env->NewLongArray(multicast_list_ntf->no_of_controlees);
-  jintArray statusArray =
-      env->NewIntArray(multicast_list_ntf->no_of_controlees);
+  // Updates made through the registry are reported once, when complete.
+  tUWB_CONTROLEE_REPORT report;
+  bool complete;
+  if (mControleeRegistry.merge(*multicast_list_ntf, &report,
+                                                &complete)) {
+    if (complete) {
+      onControleeReportReceived(report);
+    }
+    return;
+  }
+
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", fn);
+    return;
+  }
+  tUWB_CONTROLEE_OP ops[MAX_NUM_CONTROLLEES];
+  for (int i = 0; i < multicast_list_ntf->no_of_controlees; i++) {
+    ops[i].shortAddress = multicast_list_ntf->controlee_mac_address_list[i];
+    ops[i].subSessionId = multicast_list_ntf->subsession_id_list[i];
+    ops[i].status = multicast_list_ntf->status_list[i];
+  }
+  sendMulticastListUpdate(env, multicast_list_ntf->session_id,
+                          multicast_list_ntf->remaining_list, ops,
+                          multicast_list_ntf->no_of_controlees);
+  JNI_TRACE_I("%s: exit", fn);
+}
+
+void UwbEventManager::onControleeReportReceived(
+    const tUWB_CONTROLEE_REPORT &report) {
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", __func__);
+    return;
+  }
+  sendMulticastListUpdate(env, report.sessionId, report.remainingList,
+                          report.ops.data(), report.ops.size());
+}
 
-  if (multicast_list_ntf->no_of_controlees > 0) {
-    uint32_t controleeMacAddressList[multicast_list_ntf->no_of_controlees];
-    uint32_t statusList[multicast_list_ntf->no_of_controlees];
-    uint64_t subSessionIdList[multicast_list_ntf->no_of_controlees];
-    for (int i = 0; i < multicast_list_ntf->no_of_controlees; i++) {
-      controleeMacAddressList[i] =
-          multicast_list_ntf->controlee_mac_address_list[i];
-      statusList[i] = multicast_list_ntf->status_list[i];
+/*******************************************************************************
+**
+** Function:        onControleeChunkFailed
+**
+** Description:     Mark the controlees of a rejected multicast list chunk
+**                  with the status of the command and deliver the report of
+**                  the update once no controlee is left unreported. Called
+**                  on the dispatcher thread, like the merge of the
+**                  continuation notifications.
+**
+** Params:          chunk: controlees of the chunk, status_list holds the
+**                  status of the command.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::onControleeChunkFailed(
+    const tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF &chunk) {
+  tUWB_CONTROLEE_OP ops[MAX_NUM_CONTROLLEES];
+  uint8_t count =
+      std::min<uint8_t>(chunk.no_of_controlees, MAX_NUM_CONTROLLEES);
+  if (count == 0) {
+    return;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    ops[i].shortAddress = chunk.controlee_mac_address_list[i];
+    ops[i].subSessionId = chunk.subsession_id_list[i];
+  }
+  tUWB_CONTROLEE_REPORT report;
+  if (mControleeRegistry.failChunk(chunk.session_id, ops, count,
+                                   chunk.status_list[0], &report)) {
+    onControleeReportReceived(report);
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        sendMulticastListUpdate
+**
+** Description:     Deliver controlee statuses as one
+**                  UwbMulticastListUpdateStatus. The Java arrays are filled
+**                  in place, no intermediate copies.
+**
+** Params:          env: JVM environment.
+**                  sessionId: session ID.
+**                  remainingList: remaining multicast list size.
+**                  ops: controlees and their statuses.
+**                  count: number of entries in ops.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::sendMulticastListUpdate(JNIEnv *env, uint32_t sessionId,
+                                              uint8_t remainingList,
+                                              const tUWB_CONTROLEE_OP *ops,
+                                              uint32_t count) {
+  if (mOnMulticastListUpdateNotificationReceived == NULL) {
+    JNI_TRACE_E("%s: MulticastUpdateListNtf MID is null ", __func__);
+    return;
+  }
+  jintArray controleeMacAddressArray = env->NewIntArray(count);
+  jlongArray subSessionIdArray = env->NewLongArray(count);
+  jintArray statusArray = env->NewIntArray(count);
+  if (controleeMacAddressArray == NULL || subSessionIdArray == NULL ||
+      statusArray == NULL) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to allocate the controlee arrays", __func__);
+    return;
+  }
+  if (count > 0) {
+    jint *addresses = env->GetIntArrayElements(controleeMacAddressArray, NULL);
+    jlong *subSessionIds = env->GetLongArrayElements(subSessionIdArray, NULL);
+    jint *statuses = env->GetIntArrayElements(statusArray, NULL);
+    if (addresses != NULL && subSessionIds != NULL && statuses != NULL) {
+      for (uint32_t i = 0; i < count; i++) {
+        addresses[i] = ops[i].shortAddress;
+        subSessionIds[i] = ops[i].subSessionId;
+        statuses[i] = ops[i].status;
+      }
     }
-    for (int i = 0; i < multicast_list_ntf->no_of_controlees; i++) {
-      subSessionIdList[i] = multicast_list_ntf->subsession_id_list[i];
+    if (addresses != NULL) {
+      env->ReleaseIntArrayElements(controleeMacAddressArray, addresses, 0);
     }
-    env->SetIntArrayRegion(controleeMacAddressArray, 0,
-                           multicast_list_ntf->no_of_controlees,
-                           (jint *)controleeMacAddressList);
-    env->SetLongArrayRegion(subSessionIdArray, 0,
-                            multicast_list_ntf->no_of_controlees,
-                            (jlong *)subSessionIdList);
-    env->SetIntArrayRegion(statusArray, 0, multicast_list_ntf->no_of_controlees,
-                           (jint *)statusList);
-  }
-  jmethodID multicastUpdateListDataCtor =
-      env->GetMethodID(mMulticastUpdateListDataClass, "<init>", "(JII[I[J[I)V");
-  jobject multicastUpdateListDataObject =
-      env->NewObject(mMulticastUpdateListDataClass, multicastUpdateListDataCtor,
-                     (long)multicast_list_ntf->session_id,
-                     (int)multicast_list_ntf->remaining_list,
-                     (int)multicast_list_ntf->no_of_controlees,
-                     controleeMacAddressArray, subSessionIdArray, statusArray);
-
-  if (mOnMulticastListUpdateNotificationReceived != NULL) {
-    env->CallVoidMethod(mObject, mOnMulticastListUpdateNotificationReceived,
-                        multicastUpdateListDataObject);
-    if (env->ExceptionCheck()) {
-      env->ExceptionClear();
-      JNI_TRACE_E("%s: fail to send Multicast update list ntf", fn);
+    if (subSessionIds != NULL) {
+      env->ReleaseLongArrayElements(subSessionIdArray, subSessionIds, 0);
+    }
+    if (statuses != NULL) {
+      env->ReleaseIntArrayElements(statusArray, statuses, 0);
     }
-  } else {
-    JNI_TRACE_E("%s: MulticastUpdateListNtf MID is null ", fn);
   }
-  JNI_TRACE_I("%s: exit", fn);
+  jobject multicastUpdateListDataObject = env->NewObject(
+      gUwbJniSymbols.multicastUpdateListDataClass,
+      gUwbJniSymbols.multicastUpdateListDataCtor, (jlong)sessionId,
+      (jint)remainingList, (jint)count, controleeMacAddressArray,
+      subSessionIdArray, statusArray);
+  env->CallVoidMethod(mObject, mOnMulticastListUpdateNotificationReceived,
+                      multicastUpdateListDataObject);
+  if (env->ExceptionCheck()) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to send Multicast update list ntf", __func__);
+  }
 }
 
 void UwbEventManager::onBlinkDataTxNotificationReceived(uint8_t status) {
@@ -396,6 +709,106 @@ void UwbEventManager::onVendorUciNotificationReceived(uint8_t gid, uint8_t oid,
   JNI_TRACE_I("%s: exit", __func__);
 }
 
+/*******************************************************************************
+**
+** Function:        onVendorUciNotificationBatched
+**
+** Description:     Append a notification to the vendor batch. The batch is
+**                  delivered once the threshold of its key is reached, it
+**                  outgrows UWB_VENDOR_NTF_BATCH_MAX_BYTES or
+**                  UWB_VENDOR_NTF_BATCH_FLUSH_MS elapsed since its first
+**                  record.
+**
+** Params:          raw: data is a raw UCI packet including its header.
+**                  gid: group id.
+**                  oid: opcode id.
+**                  data: notification payload.
+**                  length: payload length.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::onVendorUciNotificationBatched(bool raw, uint8_t gid,
+                                                     uint8_t oid,
+                                                     uint8_t *data,
+                                                     uint16_t length) {
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", __func__);
+    return;
+  }
+
+  if (mVendorNtfBatch.size() + UWB_VENDOR_NTF_BATCH_RECORD_HDR_SIZE + length >
+      UWB_VENDOR_NTF_BATCH_MAX_BYTES) {
+    deliverVendorNtfBatch(env);
+  }
+  if (mVendorNtfBatch.capacity() == 0) {
+    mVendorNtfBatch.reserve(UWB_VENDOR_NTF_BATCH_MAX_BYTES);
+  }
+  mVendorNtfBatch.push_back(raw ? 1 : 0);
+  mVendorNtfBatch.push_back(gid);
+  mVendorNtfBatch.push_back(oid);
+  mVendorNtfBatch.push_back(length & 0xFF);
+  mVendorNtfBatch.push_back(length >> 8);
+  if (length > 0) {
+    mVendorNtfBatch.insert(mVendorNtfBatch.end(), data, data + length);
+  }
+  mVendorNtfBatchCount++;
+
+  if (mVendorNtfBatchCount >=
+      UwbVendorNtfFilter::getInstance().getBatchThreshold(gid, oid)) {
+    deliverVendorNtfBatch(env);
+  } else if (mVendorNtfBatchCount == 1) {
+    mVendorNtfBatchTimer.set(UWB_VENDOR_NTF_BATCH_FLUSH_MS,
+                             vendorNtfBatchTimerCallback);
+  }
+}
+
+/* Called on the dispatcher thread for a queued flush */
+void UwbEventManager::flushVendorNtfBatch() {
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", __func__);
+    return;
+  }
+  deliverVendorNtfBatch(env);
+}
+
+/* Records are {raw, gid, oid, length (2 bytes, little endian), payload} */
+void UwbEventManager::deliverVendorNtfBatch(JNIEnv *env) {
+  if (mVendorNtfBatchCount == 0) {
+    return;
+  }
+  mVendorNtfBatchTimer.set(0, vendorNtfBatchTimerCallback);
+
+  if (mOnVendorUciNotificationBatchReceived != NULL) {
+    jbyteArray dataArray = env->NewByteArray(mVendorNtfBatch.size());
+    if (dataArray != NULL) {
+      env->SetByteArrayRegion(dataArray, 0, mVendorNtfBatch.size(),
+                              (jbyte *)mVendorNtfBatch.data());
+      env->CallVoidMethod(mObject, mOnVendorUciNotificationBatchReceived,
+                          dataArray, (int)mVendorNtfBatchCount);
+      if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        JNI_TRACE_E("%s: fail to send vendor batch", __func__);
+      }
+      env->DeleteLocalRef(dataArray);
+    } else {
+      env->ExceptionClear();
+      JNI_TRACE_E("%s: fail to allocate vendor batch", __func__);
+    }
+  } else {
+    JNI_TRACE_E("%s: vendorNtfBatch MID is NULL", __func__);
+  }
+  mVendorNtfBatch.clear();
+  mVendorNtfBatchCount = 0;
+}
+
+/* Runs on the timer wheel thread, see rangeDataBatchTimerCallback() */
+void UwbEventManager::vendorNtfBatchTimerCallback(union sigval value) {
+  timerOwner(value).mDispatcher.postVendorNtfBatchFlush();
+}
+
 void UwbEventManager::onVendorDeviceInfo(uint8_t* data, uint8_t length) {
   static const char fn[] = "onVendorDeviceInfo";
   UNUSED(fn);
@@ -420,6 +833,97 @@ void UwbEventManager::onVendorDeviceInfo(uint8_t* data, uint8_t length) {
   JNI_TRACE_I("%s: exit", __func__);
 }
 
+/*******************************************************************************
+**
+** Function:        onCommandCompleted
+**
+** Description:     Deliver the response of an asynchronous native command.
+**
+** Params:          token: token returned by the asynchronous native API.
+**                  cmd: command type, one of eUWB_CMD.
+**                  status: response status, UWA_STATUS_FAILED if aborted,
+**                  UWB_CMD_STATUS_TIMEOUT if unanswered in UWB_CMD_TIMEOUT.
+**                  value: session state for get session state, number of
+**                  config ids for set app config, 0 otherwise.
+**                  data: param ids of a failed set app config, may be NULL.
+**                  length: length of data.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::onCommandCompleted(uint32_t token, uint8_t cmd,
+                                         uint8_t status, uint8_t value,
+                                         uint8_t *data, uint16_t length) {
+  static const char fn[] = "onCommandCompleted";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: token = %x cmd = %d status = %x", fn, token, cmd, status);
+
+  if (mOnCommandCompleted == NULL) {
+    JNI_TRACE_E("%s: onCommandCompleted MID is NULL", fn);
+    return;
+  }
+
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", fn);
+    return;
+  }
+
+  jbyteArray dataArray = env->NewByteArray((data == NULL) ? 0 : length);
+  if (dataArray == NULL) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to allocate data array", fn);
+    return;
+  }
+  if (data != NULL && length > 0) {
+    env->SetByteArrayRegion(dataArray, 0, length, (jbyte *)data);
+  }
+  env->CallVoidMethod(mObject, mOnCommandCompleted, (int)token, (int)cmd,
+                      (int)status, (int)value, dataArray);
+  if (env->ExceptionCheck()) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to notify", fn);
+  }
+  env->DeleteLocalRef(dataArray);
+  JNI_TRACE_I("%s: exit", fn);
+}
+
+/*******************************************************************************
+**
+** Function:        onPositionFixReceived
+**
+** Description:     Deliver a position fix solved from a two way ranging
+**                  notification, see UwbPositionSolver.
+**
+** Params:          fix: position fix, coordinates and residual in cm.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbEventManager::onPositionFixReceived(const tUWB_POSITION_FIX &fix) {
+  static const char fn[] = "onPositionFixReceived";
+  UNUSED(fn);
+
+  if (mOnPositionFixReceived == NULL) {
+    JNI_TRACE_E("%s: onPositionFixReceived MID is NULL", fn);
+    return;
+  }
+
+  ScopedJniEnv env(mVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", fn);
+    return;
+  }
+  env->CallVoidMethod(mObject, mOnPositionFixReceived, (jlong)fix.sessionId,
+                      (jlong)fix.seqCounter, (int)fix.status,
+                      (int)fix.noOfAnchors, (int)fix.x, (int)fix.y, (int)fix.z,
+                      (int)fix.rmsResidual, (int)fix.iterations);
+  if (env->ExceptionCheck()) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to notify", fn);
+  }
+}
+
 void UwbEventManager::doLoadSymbols(JNIEnv *env, jobject thiz) {
   static const char fn[] = "UwbEventManager::doLoadSymbols";
   UNUSED(fn);
@@ -452,12 +956,64 @@ void UwbEventManager::doLoadSymbols(JNIEnv *env, jobject thiz) {
             "onVendorUciNotificationReceived", "(II[B)V");
     mOnVendorDeviceInfo = env->GetMethodID(clazz,
             "onVendorDeviceInfo", "([B)V");
+    // Optional, batched ranging delivery stays unavailable without it.
+    mOnRangeDataBatchReceived = env->GetMethodID(
+        clazz, "onRangeDataBatchReceived", "(Ljava/nio/ByteBuffer;II)V");
+    if (mOnRangeDataBatchReceived == NULL) {
+      env->ExceptionClear();
+    }
+    // Optional, the asynchronous native APIs fail without it.
+    mOnCommandCompleted =
+        env->GetMethodID(clazz, "onCommandCompleted", "(IIII[B)V");
+    if (mOnCommandCompleted == NULL) {
+      env->ExceptionClear();
+    }
+    // Optional, UWB_VENDOR_NTF_BATCH is rejected without it.
+    mOnVendorUciNotificationBatchReceived = env->GetMethodID(
+        clazz, "onVendorUciNotificationBatchReceived", "([BI)V");
+    if (mOnVendorUciNotificationBatchReceived == NULL) {
+      env->ExceptionClear();
+    }
+    // Optional, TDoA ranging data is dropped without it.
+    mOnTdoaRangeDataBatchReceived = env->GetMethodID(
+        clazz, "onTdoaRangeDataBatchReceived", "(Ljava/nio/ByteBuffer;II)V");
+    if (mOnTdoaRangeDataBatchReceived == NULL) {
+      env->ExceptionClear();
+    }
+    // Optional, sessions keep delivering measurements without it.
+    mOnPositionFixReceived = env->GetMethodID(clazz, "onPositionFixReceived",
+                                              "(JJIIIIIII)V");
+    if (mOnPositionFixReceived == NULL) {
+      env->ExceptionClear();
+    }
 
-    uwb_jni_cache_jclass(env, RANGING_DATA_CLASS_NAME, &mRangeDataClass);
-    uwb_jni_cache_jclass(env, RANGING_MEASURES_CLASS_NAME,
-                         &mRangingTwoWayMeasuresClass);
-    uwb_jni_cache_jclass(env, MULTICAST_UPDATE_LIST_DATA_CLASS_NAME,
-                         &mMulticastUpdateListDataClass);
+    // Every chip loads its symbols from an object of the same class
+    std::call_once(sSymbolsOnce, [env]() {
+      uwb_jni_cache_ctor(
+          env, RANGING_DATA_CLASS_NAME,
+          "(JJIJIII[Lcom/android/server/uwb/data/UwbTwoWayMeasurement;)V",
+          &gUwbJniSymbols.rangeDataClass, &gUwbJniSymbols.rangeDataTwoWayCtor);
+      uwb_jni_cache_ctor(env, RANGING_MEASURES_CLASS_NAME, "([BIIIIIIIIIIII)V",
+                         &gUwbJniSymbols.rangingTwoWayMeasuresClass,
+                         &gUwbJniSymbols.rangingTwoWayMeasuresCtor);
+      uwb_jni_cache_ctor(env, MULTICAST_UPDATE_LIST_DATA_CLASS_NAME,
+                         "(JII[I[J[I)V",
+                         &gUwbJniSymbols.multicastUpdateListDataClass,
+                         &gUwbJniSymbols.multicastUpdateListDataCtor);
+      uwb_jni_cache_ctor(env, VENDOR_UCI_RESPONSE_CLASS_NAME, "(BII[B)V",
+                         &gUwbJniSymbols.vendorUciResponseClass,
+                         &gUwbJniSymbols.vendorUciResponseCtor);
+      uwb_jni_cache_ctor(env, CONFIG_STATUS_DATA_CLASS_NAME, "(II[B)V",
+                         &gUwbJniSymbols.configStatusDataClass,
+                         &gUwbJniSymbols.configStatusDataCtor);
+      uwb_jni_cache_ctor(env, TLV_DATA_CLASS_NAME, "(II[B)V",
+                         &gUwbJniSymbols.tlvDataClass,
+                         &gUwbJniSymbols.tlvDataCtor);
+      uwb_jni_cache_ctor(env, SPECIFICATION_INFO_CLASS_NAME,
+                         "(IIIIIIIIIIIIIIII)V",
+                         &gUwbJniSymbols.specificationInfoClass,
+                         &gUwbJniSymbols.specificationInfoCtor);
+    });
   }
   JNI_TRACE_I("%s: exit", fn);
 }
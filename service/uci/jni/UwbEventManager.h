@@ -19,40 +19,94 @@
 #ifndef _UWB_NATIVE_MANAGER_H_
 #define _UWB_NATIVE_MANAGER_H_
 
+#include <jni.h>
+
+#include <mutex>
+#include <vector>
+
+#include "IntervalTimer.h"
+#include "UwbControleeRegistry.h"
+#include "UwbPositionSolver.h"
+#include "UwbRangeDataBatch.h"
+#include "UwbTdoaRangeData.h"
+
 namespace android {
 
+class UwbNotificationDispatcher;
+
 class UwbEventManager {
 public:
-  static UwbEventManager &getInstance();
   void doLoadSymbols(JNIEnv *env, jobject o);
 
   void onDeviceStateNotificationReceived(uint8_t state);
   void onRangeDataNotificationReceived(tUWA_RANGE_DATA_NTF *ranging_ntf_data);
+  void onTdoaRangeDataReceived(const tUWB_TDOA_RANGE_DATA &tdoaRangeData);
   void onRawUciNotificationReceived(uint8_t *data, uint16_t length);
   void onSessionStatusNotificationReceived(uint32_t sessionId, uint8_t state,
                                            uint8_t reasonCode);
   void onCoreGenericErrorNotificationReceived(uint8_t state);
   void onMulticastListUpdateNotificationReceived(
       tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF *multicast_list_ntf);
+  /* Merged statuses of an update made through UwbControleeRegistry */
+  void onControleeReportReceived(const tUWB_CONTROLEE_REPORT &report);
+  void onControleeChunkFailed(
+      const tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF &chunk);
   void onBlinkDataTxNotificationReceived(uint8_t state);
   void onVendorUciNotificationReceived(uint8_t gid, uint8_t oid, uint8_t* data, uint16_t length);
   void onVendorDeviceInfo(uint8_t* data, uint8_t length);
+  void onCommandCompleted(uint32_t token, uint8_t cmd, uint8_t status,
+                          uint8_t value, uint8_t *data, uint16_t length);
+
+  /* Takes effect on the dispatcher thread, after the rounds already queued */
+  bool setRangeDataBatching(JNIEnv *env, uint16_t maxRecords,
+                            uint32_t flushTimeoutMs);
+  /* Dispatcher thread only, also applies a pending batching change */
+  void flushRangeDataBatch();
+
+  /* Vendor and raw notifications held back by UwbVendorNtfFilter */
+  bool isVendorNtfBatchingAvailable() const {
+    return mOnVendorUciNotificationBatchReceived != NULL;
+  }
+  /* Dispatcher thread only */
+  void onVendorUciNotificationBatched(bool raw, uint8_t gid, uint8_t oid,
+                                      uint8_t *data, uint16_t length);
+  void flushVendorNtfBatch();
+
+  /* Position fixes of sessions with anchors, see UwbPositionSolver */
+  bool isPositionFixAvailable() const {
+    return mOnPositionFixReceived != NULL;
+  }
+  void onPositionFixReceived(const tUWB_POSITION_FIX &fix);
 
 private:
-  UwbEventManager();
+  friend class UwbChipContext;
+  UwbEventManager(UwbControleeRegistry &controleeRegistry,
+                  UwbNotificationDispatcher &dispatcher);
+
+  /* Batch flush timer, the callback finds the event manager through it */
+  struct BatchTimer : public IntervalTimer {
+    explicit BatchTimer(UwbEventManager &owner) : mOwner(owner) {}
+    UwbEventManager &mOwner;
+  };
+  static UwbEventManager &timerOwner(union sigval value);
+
+  void sendMulticastListUpdate(JNIEnv *env, uint32_t sessionId,
+                               uint8_t remainingList,
+                               const tUWB_CONTROLEE_OP *ops, uint32_t count);
+  void deliverRangeDataBatch(JNIEnv *env);
+  void deliverTdoaRangeDataBatch(JNIEnv *env);
+  static void rangeDataBatchTimerCallback(union sigval);
+  void deliverVendorNtfBatch(JNIEnv *env);
+  static void vendorNtfBatchTimerCallback(union sigval);
 
-  static UwbEventManager mObjUwbManager;
+  UwbControleeRegistry &mControleeRegistry; // registry of the same chip
+  UwbNotificationDispatcher &mDispatcher;    // queues the batch flushes
 
   JavaVM *mVm;
 
   jclass mClass;   // Reference to Java  class
   jobject mObject; // Weak ref to Java object to call on
 
-  jclass mRangeDataClass;
-  jclass mRangingTwoWayMeasuresClass;
-  jclass mRangeTdoaMeasuresClass;
-  jclass mMulticastUpdateListDataClass;
-
   jmethodID mOnRangeDataNotificationReceived;
   jmethodID mOnSessionStatusNotificationReceived;
   jmethodID mOnCoreGenericErrorNotificationReceived;
@@ -63,6 +117,31 @@ private:
   jmethodID mOnRawUciNotificationReceived;
   jmethodID mOnVendorUciNotificationReceived;
   jmethodID mOnVendorDeviceInfo;
+  jmethodID mOnRangeDataBatchReceived;
+  jmethodID mOnCommandCompleted;
+  jmethodID mOnVendorUciNotificationBatchReceived;
+  jmethodID mOnPositionFixReceived;
+  jmethodID mOnTdoaRangeDataBatchReceived;
+
+  /* The batches are only touched on the dispatcher thread, which is also the
+   * only thread making the batch upcalls. The mutex hands a batching change
+   * and the buffer created for it over from the Java thread and is never
+   * held across an upcall. TDoA rounds share the thresholds and timer of the
+   * two way batch. */
+  std::mutex mRangeDataBatchMutex;
+  bool mRangeDataBatchConfigPending;
+  uint16_t mPendingBatchMaxRecords;
+  uint32_t mPendingBatchFlushTimeoutMs;
+  jobject mRangeDataBatchBuffer; // Global ref to direct ByteBuffer on batch
+  UwbRangeDataBatch mRangeDataBatch;
+  UwbTdoaRangeDataBatch mTdoaRangeDataBatch;
+  jobject mTdoaRangeDataBatchBuffer;
+  BatchTimer mRangeDataBatchTimer;
+
+  /* Dispatcher thread only, like the range data batches */
+  std::vector<uint8_t> mVendorNtfBatch; // records, see deliverVendorNtfBatch
+  uint16_t mVendorNtfBatchCount;
+  BatchTimer mVendorNtfBatchTimer;
 };
 
 } // namespace android
@@ -29,12 +29,12 @@ namespace android {
 
 #define UWB_CMD_TIMEOUT 4000 // JNI API wait timout
 
+class UwbChipContext;
+
 /* extern declarations */
 extern bool uwb_debug_enabled;
-extern bool gIsUwaEnabled;
 
-void clearRfTestContext();
-void uwaRfTestDeviceManagementCallback(uint8_t dmEvent,
-                                       tUWA_DM_TEST_CBACK_DATA *eventData);
+void notifyRangeDataNotification(UwbChipContext &chip,
+                                 tUWA_RANGE_DATA_NTF *ranging_data);
 } // namespace android
 #endif
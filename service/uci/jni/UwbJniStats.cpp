@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include "UwbJniStats.h"
+
+namespace android {
+
+UwbJniStats::UwbJniStats() {
+  for (int i = 0; i < UWB_CMD_MAX; i++) {
+    mCommandTimeouts[i] = 0;
+  }
+  for (int i = 0; i < UWB_STATS_MAX_SESSIONS; i++) {
+    mSessions[i].key = 0;
+    mSessions[i].count = 0;
+    mSessions[i].firstUs = 0;
+    mSessions[i].lastUs = 0;
+  }
+}
+
+UwbJniStats::Histogram::Histogram() {
+  count = 0;
+  totalUs = 0;
+  maxUs = 0;
+  for (int i = 0; i < UWB_STATS_LATENCY_BUCKETS; i++) {
+    buckets[i] = 0;
+  }
+}
+
+int64_t UwbJniStats::nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void UwbJniStats::Histogram::record(int64_t us) {
+  if (us < 0) {
+    us = 0;
+  }
+  int bucket = 0;
+  for (int64_t scaled = us >> 7;
+       scaled > 0 && bucket < UWB_STATS_LATENCY_BUCKETS - 1; scaled >>= 1) {
+    bucket++;
+  }
+  count.fetch_add(1, std::memory_order_relaxed);
+  totalUs.fetch_add(us, std::memory_order_relaxed);
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  int64_t max = maxUs.load(std::memory_order_relaxed);
+  while (us > max &&
+         !maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+void UwbJniStats::Histogram::read(std::vector<int64_t> &stats) const {
+  stats.push_back(count.load(std::memory_order_relaxed));
+  stats.push_back(totalUs.load(std::memory_order_relaxed));
+  stats.push_back(maxUs.load(std::memory_order_relaxed));
+  for (int i = 0; i < UWB_STATS_LATENCY_BUCKETS; i++) {
+    stats.push_back(buckets[i].load(std::memory_order_relaxed));
+  }
+}
+
+void UwbJniStats::recordCommandLatency(eUWB_CMD cmd, int64_t latencyUs) {
+  if (cmd < UWB_CMD_MAX) {
+    mCommandLatency[cmd].record(latencyUs);
+  }
+}
+
+void UwbJniStats::recordCommandTimeout(eUWB_CMD cmd) {
+  if (cmd < UWB_CMD_MAX) {
+    mCommandTimeouts[cmd].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void UwbJniStats::recordUpcall(uint8_t type, int64_t durationUs) {
+  if (type < UWB_NTF_TYPE_MAX) {
+    mUpcallDuration[type].record(durationUs);
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        recordRangeData
+**
+** Description:     Count a ranging notification of a session. The first
+**                  notification of an untracked session claims a free slot;
+**                  once all slots are taken further sessions are not counted.
+**
+** Params:          sessionId: session of the notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbJniStats::recordRangeData(uint32_t sessionId) {
+  uint64_t key = (uint64_t)sessionId + 1;
+  int64_t now = nowUs();
+  SessionRate *freeSlot = NULL;
+  for (int i = 0; i < UWB_STATS_MAX_SESSIONS; i++) {
+    SessionRate &slot = mSessions[i];
+    uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+    if (slotKey == key) {
+      slot.count.fetch_add(1, std::memory_order_relaxed);
+      slot.lastUs.store(now, std::memory_order_relaxed);
+      return;
+    }
+    if (slotKey == 0 && freeSlot == NULL) {
+      freeSlot = &slot;
+    }
+  }
+  if (freeSlot == NULL) {
+    return;
+  }
+  uint64_t expected = 0;
+  freeSlot->count.store(1, std::memory_order_relaxed);
+  freeSlot->firstUs.store(now, std::memory_order_relaxed);
+  freeSlot->lastUs.store(now, std::memory_order_relaxed);
+  freeSlot->key.compare_exchange_strong(expected, key,
+                                        std::memory_order_release);
+}
+
+void UwbJniStats::releaseSession(uint32_t sessionId) {
+  uint64_t key = (uint64_t)sessionId + 1;
+  for (int i = 0; i < UWB_STATS_MAX_SESSIONS; i++) {
+    uint64_t expected = key;
+    if (mSessions[i].key.compare_exchange_strong(expected, 0,
+                                                 std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+void UwbJniStats::snapshot(std::vector<int64_t> &stats) {
+  stats.clear();
+  stats.push_back(UWB_STATS_VERSION);
+  stats.push_back(UWB_CMD_MAX);
+  stats.push_back(UWB_NTF_TYPE_MAX);
+  stats.push_back(UWB_STATS_MAX_SESSIONS);
+  stats.push_back(UWB_STATS_LATENCY_BUCKETS);
+  for (int i = 0; i < UWB_CMD_MAX; i++) {
+    stats.push_back(mCommandTimeouts[i].load(std::memory_order_relaxed));
+    mCommandLatency[i].read(stats);
+  }
+  for (int i = 0; i < UWB_NTF_TYPE_MAX; i++) {
+    mUpcallDuration[i].read(stats);
+  }
+  for (int i = 0; i < UWB_STATS_MAX_SESSIONS; i++) {
+    SessionRate &slot = mSessions[i];
+    uint64_t key = slot.key.load(std::memory_order_acquire);
+    if (key == 0) {
+      stats.push_back(-1);
+      stats.push_back(0);
+      stats.push_back(0);
+      continue;
+    }
+    int64_t count = slot.count.load(std::memory_order_relaxed);
+    int64_t elapsedUs = slot.lastUs.load(std::memory_order_relaxed) -
+                        slot.firstUs.load(std::memory_order_relaxed);
+    stats.push_back(key - 1);
+    stats.push_back(count);
+    stats.push_back((count > 1 && elapsedUs > 0)
+                        ? (count - 1) * 1000000000LL / elapsedUs
+                        : 0);
+  }
+}
+
+} // namespace android
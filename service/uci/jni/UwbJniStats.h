@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_JNI_STATS_H_
+#define _UWB_JNI_STATS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "UwbCommandPipeline.h"
+#include "UwbNotificationDispatcher.h"
+
+namespace android {
+
+/* Bucket i > 0 counts latencies in [128us << (i - 1), 128us << i), bucket 0
+ * everything below 128us and the last bucket everything above */
+#define UWB_STATS_LATENCY_BUCKETS 16
+/* Sessions whose ranging notification rate is tracked at the same time */
+#define UWB_STATS_MAX_SESSIONS 16
+/* Version of the nativeGetStats() array layout */
+#define UWB_STATS_VERSION 1
+
+/* Layout of the array returned by nativeGetStats():
+ *   header:   version, UWB_CMD_MAX, UWB_NTF_TYPE_MAX, UWB_STATS_MAX_SESSIONS,
+ *             UWB_STATS_LATENCY_BUCKETS
+ *   commands: UWB_CMD_MAX x {timeouts, histogram}, response latency
+ *   upcalls:  UWB_NTF_TYPE_MAX x {histogram}, JNI upcall duration
+ *   sessions: UWB_STATS_MAX_SESSIONS x {session id or -1, notifications,
+ *             notifications per 1000 s}
+ * where histogram is {count, total us, max us, buckets}. */
+#define UWB_STATS_HEADER_SIZE 5
+#define UWB_STATS_HISTOGRAM_SIZE (3 + UWB_STATS_LATENCY_BUCKETS)
+#define UWB_STATS_SESSION_SIZE 3
+
+/* Always-on counters of the JNI layer, one set per chip. Every update is a
+ * handful of relaxed atomic operations, so they are safe on the UCI callback
+ * and dispatcher threads; readers get a consistent enough snapshot for
+ * dumpsys. */
+class UwbJniStats {
+public:
+  static int64_t nowUs();
+
+  void recordCommandLatency(eUWB_CMD cmd, int64_t latencyUs);
+  void recordCommandTimeout(eUWB_CMD cmd);
+  void recordUpcall(uint8_t type, int64_t durationUs);
+  /* UCI stack callback thread only */
+  void recordRangeData(uint32_t sessionId);
+  void releaseSession(uint32_t sessionId);
+
+  void snapshot(std::vector<int64_t> &stats);
+
+private:
+  friend class UwbChipContext;
+  UwbJniStats();
+
+  struct Histogram {
+    Histogram();
+
+    std::atomic<int64_t> count;
+    std::atomic<int64_t> totalUs;
+    std::atomic<int64_t> maxUs;
+    std::atomic<int64_t> buckets[UWB_STATS_LATENCY_BUCKETS];
+
+    void record(int64_t us);
+    void read(std::vector<int64_t> &stats) const;
+  };
+
+  struct SessionRate {
+    std::atomic<uint64_t> key; // session id + 1, 0 when free
+    std::atomic<int64_t> count;
+    std::atomic<int64_t> firstUs;
+    std::atomic<int64_t> lastUs;
+  };
+
+  std::atomic<int64_t> mCommandTimeouts[UWB_CMD_MAX];
+  Histogram mCommandLatency[UWB_CMD_MAX];
+  Histogram mUpcallDuration[UWB_NTF_TYPE_MAX];
+  SessionRate mSessions[UWB_STATS_MAX_SESSIONS];
+};
+
+} // namespace android
+#endif
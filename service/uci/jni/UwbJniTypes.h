@@ -19,8 +19,6 @@
 #ifndef _UWB_JNI_TYPES_
 #define _UWB_JNI_TYPES_
 
-#include <array>
-#include <deque>
 #include <map>
 #include <mutex>
 #include <numeric>
@@ -43,13 +41,4 @@ typedef struct conformanceTestData {
   uint8_t rsp_len;
 } conformanceTestData_t;
 
-/* Session Data contains M distance samples of N Anchors in order to provide
- * averaged distance for every anchor */
-/* N is Maximum Number of Anchors(MAX_NUM_RESPONDERS) */
-/* Where M is sampling Rate, the Max value is defined by Service */
-typedef struct sessionRangingData {
-  uint8_t samplingRate;
-  std::array<std::deque<uint32_t>, MAX_NUM_RESPONDERS> anchors;
-} SessionRangingData;
-
 #endif
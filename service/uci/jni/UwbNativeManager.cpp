@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <mutex>
 #include <vector>
 
 #include "UwbJniInternal.h"
@@ -23,7 +25,19 @@
 #include "ScopedJniEnv.h"
 #include "SyncEvent.h"
 #include "UwbAdaptation.h"
+#include "UwbBufferPool.h"
+#include "UwbChipContext.h"
+#include "UwbCommandPipeline.h"
+#include "UwbControleeRegistry.h"
+#include "UwbDeviceSnapshot.h"
 #include "UwbEventManager.h"
+#include "UwbJniStats.h"
+#include "UwbNotificationDispatcher.h"
+#include "UwbRangingFilter.h"
+#include "UwbSessionRegistry.h"
+#include "UwbTrace.h"
+#include "UwbUciRecorder.h"
+#include "UwbVendorNtfFilter.h"
 #include "uwb_api.h"
 #include "uwb_config.h"
 #include "uwb_hal_int.h"
@@ -38,130 +52,72 @@ const char *UWB_NATIVE_MANAGER_CLASS_NAME =
 bool uwb_debug_enabled = true;
 static conformanceTestData_t ConformanceDataConf;
 
-static std::map<unsigned int, SessionRangingData> sAveragedRangingData;
-static std::mutex sSessionMutex;
-
-bool gIsUwaEnabled = false;
 bool gIsMaxPpmValueAvailable = false;
 
-static SyncEvent sUwaEnableEvent;        // event for UWA_Enable()
-static SyncEvent sUwaDisableEvent;       // event for UWA_Disable
-static SyncEvent sUwaSetConfigEvent;     // event for Set_Config....
-static SyncEvent sUwaSetAppConfigEvent;  // event for Set_AppConfig....
-static SyncEvent sUwaGetConfigEvent;     // event for Get_Config....
-static SyncEvent sUwaGetAppConfigEvent;  // event for Get_AppConfig....
-static SyncEvent sUwaDeviceResetEvent;   // event for deviceResetEvent
-static SyncEvent sUwaRngStartEvent;      // event for ranging start
-static SyncEvent sUwaRngStopEvent;       // event for ranging stop
-static SyncEvent sUwadeviceNtfEvent;     // event for device status NTF
-static SyncEvent sUwaSessionInitEvent;   // event for sessionInit resp
-static SyncEvent sUwaSessionDeInitEvent; // event for sessionDeInit resp
-static SyncEvent
-    sUwaGetSessionCountEvent;            // event for get session count response
-static SyncEvent sUwaGetDeviceInfoEvent; // event for get Device Info
-static SyncEvent
-    sUwaGetRangingCountEvent; // event for get ranging count response
-static SyncEvent sUwaGetSessionStatusEvent; // event for get the session status
-static SyncEvent
-    sUwaMulticastListUpdateEvent; // event for
-                                  // UWA_ControllerMulticastListUpdate
-static SyncEvent sUwaSendBlinkDataEvent;
-static SyncEvent sErrNotify;
-static SyncEvent sUwaSetCountryCodeEvent; // event for
-                                          // UWA_ControllerSetCountryCode
-static SyncEvent sUwaSendRawUciEvt; // event for UWA_SendRawCommand
-static SyncEvent sUwaGetDeviceCapsEvent; // event for Get Device Capabilities
-
-static deviceInfo_t sUwbDeviceInfo;
-static uint8_t sSetAppConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sGetAppConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sGetCoreConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sSetCoreConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sUwbDeviceCapability[UCI_MAX_PKT_SIZE];
-static uint8_t sSendRawResData[UCI_MAX_PAYLOAD_SIZE];
-static uint32_t sRangingCount = 0;
-static uint8_t sNoOfAppConfigIds = 0x00;
-static uint8_t sNoOfCoreConfigIds = 0x00;
-static uint8_t sSessionCount = -1;
-static uint16_t sDevCapInfoLen = 0;
-static uint16_t sDevCapInfoIds = 0x00;
-static uint16_t sGetCoreConfigLen;
-static uint16_t sGetAppConfigLen;
-static uint16_t sSetAppConfigLen;
-static uint8_t sGetAppConfigStatus;
-static uint8_t sSetAppConfigStatus;
-static uint8_t sSendBlinkDataStatus;
-static uint16_t sSendRawResLen;
-
-/* command response status */
-static bool sSessionInitStatus = false;
-static bool sSessionDeInitStatus = false;
-static bool sIsDeviceResetDone =
-    false; // whether Reset Performed is Successful is done or not
-static bool sRangeStartStatus = false;
-static bool sRangeStopStatus = false;
-static bool sSetAppConfigRespStatus = false;
-static bool sGetAppConfigRespStatus = false;
-static bool sMulticastListUpdateStatus = false;
-static bool sSetCountryCodeStatus = false;
-static bool sGetDeviceCapsRespStatus = false;
-
-static uint8_t sSessionState = UWB_UNKNOWN_SESSION;
-
-static eUWBS_DEVICE_STATUS_t sDeviceState = UWBS_STATUS_ERROR;
-
-static UwbEventManager &uwbEventManager = UwbEventManager::getInstance();
+/*******************************************************************************
+**
+** Function:        getChip
+**
+** Description:     Look up the context of the chip a native is called for.
+**
+** Params:          fn: name of the native, for the trace.
+**                  chipId: chip ID given by Java.
+**
+** Returns:         Context of the chip, NULL if no such chip was added.
+**
+*******************************************************************************/
+static UwbChipContext *getChip(const char *fn, jint chipId) {
+  UwbChipContext *chip = UwbChipContext::get(chipId);
+  if (chip == NULL) {
+    JNI_TRACE_E("%s: unknown chip %d", fn, chipId);
+  }
+  return chip;
+}
 
 jint MSB_BITMASK = 0x000000FF;
 
-/* Function to calculate and update ranging data averaging value into ranging
- * data notification */
-static void update_ranging_data_average(tUWA_RANGE_DATA_NTF *rangingDataNtf) {
-  static const char fn[] = "update_ranging_data_average";
-  UNUSED(fn);
-  // Get Current Session Data
-  SessionRangingData &sessionData =
-      sAveragedRangingData[rangingDataNtf->session_id];
-
-  // Calculate the Average of N Distances for every Anchor, Where N is Sampling
-  // Rate for that Anchor
-  for (int i = 0; i < rangingDataNtf->no_of_measurements; i++) {
-    // Get current Two way measures object
-    tUWA_TWR_RANGING_MEASR &twr_range_measr =
-        rangingDataNtf->ranging_measures.twr_range_measr[i];
-    // Get the Current Anchor Distance Queue
-    auto &anchorDistanceQueue = sessionData.anchors[i];
-    JNI_TRACE_I("%s: Input Distance is: %d", fn, twr_range_measr.distance);
-    // If Number of distances in Queue is more than Sampling Rate
-    if (anchorDistanceQueue.size() >= sessionData.samplingRate) {
-      // Remove items from the queue until items in the queue is one less than
-      // sampling rate
-      while (anchorDistanceQueue.size() >= sessionData.samplingRate) {
-        JNI_TRACE_I("%s: Distance Popped from Queue: %d", fn,
-                    anchorDistanceQueue.front());
-        anchorDistanceQueue.pop_front();
-      }
-    }
-    // Push the New distance item into the Anchor Distance Queue
-    anchorDistanceQueue.push_back(twr_range_measr.distance);
-    // Calculate average of items(Except where distance is FFFF)
-    // in the Queue and update averaged distance into the distance field
-    uint32_t divider = 0;
-    uint32_t sum = 0;
-    for (auto it = anchorDistanceQueue.begin(); it != anchorDistanceQueue.end();
-         ++it) {
-      if (*it != 0xFFFF) {
-        sum = (uint32_t)(sum + *it);
-        divider++;
-      }
-    }
-    if (divider > 0) {
-      twr_range_measr.distance = sum / divider;
-    } else {
-      twr_range_measr.distance = 0xFFFF;
-    }
-    JNI_TRACE_I("%s: Averaged Distance is: %d", fn, twr_range_measr.distance);
+/* Complete the oldest pending command of the given type with a response
+ * that carries no payload */
+static void completeCommand(UwbChipContext &chip, eUWB_CMD cmd,
+                            tUWA_STATUS status, uint8_t value = 0) {
+  tUWB_CMD_RESULT result;
+  result.status = status;
+  result.value = value;
+  result.len = 0;
+  chip.getCommandPipeline().complete(cmd, result);
+}
+
+/*******************************************************************************
+**
+** Function:        onAsyncCommandComplete
+**
+** Description:     Completion callback of the asynchronous session commands.
+**                  Responses and aborted requests alike are forwarded
+**                  through the notification dispatcher so they reach Java
+**                  in order with each other and with the session
+**                  notifications, always on the dispatcher thread.
+**
+** Params:          token: token returned to Java.
+**                  cmd: command type.
+**                  context: session id of the command.
+**                  result: response of the command.
+**                  aborted: request failed by abortAll().
+**                  arg: context of the chip of the pipeline.
+**
+** Returns:         None
+**
+*******************************************************************************/
+static void onAsyncCommandComplete(uint32_t token, eUWB_CMD cmd,
+                                   uint32_t context,
+                                   const tUWB_CMD_RESULT &result,
+                                   bool aborted, void *arg) {
+  UwbChipContext &chip = *(UwbChipContext *)arg;
+  if (!aborted && cmd == UWB_CMD_SESSION_INIT &&
+      result.status == UWA_STATUS_OK &&
+      !chip.getSessionRegistry().add(context)) {
+    JNI_TRACE_E("%s: no room for session %x in registry", __func__, context);
   }
+  chip.getDispatcher().postCommandComplete(token, cmd, result);
 }
 
 /*******************************************************************************
@@ -170,105 +126,142 @@ static void update_ranging_data_average(tUWA_RANGE_DATA_NTF *rangingDataNtf) {
 **
 ** Description:     Notify the Range data  to application
 **
+** Params:          chip: chip that reported the data.
+**                  ranging_data: range data notification.
+**
 ** Returns:         void
 **
 *******************************************************************************/
-void notifyRangeDataNotification(tUWA_RANGE_DATA_NTF *ranging_data) {
+void notifyRangeDataNotification(UwbChipContext &chip,
+                                 tUWA_RANGE_DATA_NTF *ranging_data) {
   static const char fn[] = "notifyRangeDataNotification";
   UNUSED(fn);
-  JNI_TRACE_I("%s: Enter", fn);
+  UWB_TRACE(UWB_TRACE_RANGE_NTF, ranging_data->session_id,
+            ranging_data->seq_counter, ranging_data->no_of_measurements,
+            ranging_data->ranging_measure_type);
+  if (ranging_data->ranging_measure_type == MEASUREMENT_TYPE_TWOWAY &&
+      UwbTraceRing::getInstance().isEnabled()) {
+    int noOfMeasurements =
+        std::min<int>(ranging_data->no_of_measurements, MAX_NUM_RESPONDERS);
+    for (int i = 0; i < noOfMeasurements; i++) {
+      tUWA_TWR_RANGING_MEASR &twr_range_measr =
+          ranging_data->ranging_measures.twr_range_measr[i];
+      UWB_TRACE(UWB_TRACE_RANGE_MEASUREMENT, ranging_data->session_id, i,
+                twr_range_measr.distance, twr_range_measr.aoa_azimuth);
+    }
+  }
 
+  chip.getStats().recordRangeData(ranging_data->session_id);
+  int64_t nowMs = UwbJniStats::nowUs() / 1000;
   if (ranging_data->ranging_measure_type == ONE_WAY_RANGING) {
-    uwbEventManager.onRangeDataNotificationReceived(ranging_data);
+    if (!chip.getSessionRegistry().admitRangeData(ranging_data, nowMs)) {
+      return;
+    }
+    chip.getDispatcher().postTdoaRangeData(ranging_data);
   } else {
-    {
-      std::unique_lock<std::mutex> lock(sSessionMutex);
-      unsigned int session_id = ranging_data->session_id;
-      auto it = sAveragedRangingData.find(session_id);
-      if (it != sAveragedRangingData.end()) {
-        if (sAveragedRangingData[session_id].samplingRate > 1) {
-          JNI_TRACE_I("%s: Before Averaging", fn);
-          update_ranging_data_average(ranging_data);
-          JNI_TRACE_I("%s: After Averaging", fn);
-        }
+    chip.getSessionRegistry().applyFilter(ranging_data);
+    if (!chip.getSessionRegistry().admitRangeData(ranging_data, nowMs)) {
+      return;
+    }
+    tUWB_POSITION_FIX fix;
+    bool keepMeasurements = true;
+    if (chip.getEventManager().isPositionFixAvailable() &&
+        chip.getSessionRegistry().solvePosition(ranging_data, &fix,
+                                                &keepMeasurements)) {
+      chip.getDispatcher().postPositionFix(fix);
+      if (fix.status == UWB_POSITION_FIX_OK && !keepMeasurements) {
+        return;
       }
     }
-    uwbEventManager.onRangeDataNotificationReceived(ranging_data);
+    chip.getDispatcher().postRangeData(ranging_data);
   }
 }
 
 /*******************************************************************************
 **
-** Function:        uwaDeviceManagementCallback
+** Function:        onDeviceManagementEvent
 **
-** Description:     Receive device management events from UCI stack.
+** Description:     Receive device management events from the UCI stack of
+**                  a chip.
+**                  chip: chip of the stack.
 **                  dmEvent: Device-management event ID.
 **                  eventData: Data associated with event ID.
 **
 ** Returns:         None
 **
 *******************************************************************************/
-static void uwaDeviceManagementCallback(uint8_t dmEvent,
-                                        tUWA_DM_CBACK_DATA *eventData) {
+static void onDeviceManagementEvent(UwbChipContext &chip, uint8_t dmEvent,
+                                    tUWA_DM_CBACK_DATA *eventData) {
   static const char fn[] = "uwaDeviceManagementCallback";
   UNUSED(fn);
-  JNI_TRACE_I("%s: enter; event=0x%X", fn, dmEvent);
+  UwbChipState &state = chip.getState();
+  UWB_TRACE(UWB_TRACE_UCI_EVENT, dmEvent, 0, 0, 0);
+  if (chip.getRecorder().isCapturing()) {
+    chip.getRecorder().recordDmEvent(dmEvent, eventData);
+  }
 
   switch (dmEvent) {
   case UWA_DM_ENABLE_EVT: /* Result of UWA_Enable */
   {
-    SyncEventGuard guard(sUwaEnableEvent);
+    SyncEventGuard guard(state.uwaEnableEvent);
     JNI_TRACE_I("%s: uwa_dm_enable_EVT; status=0x%X", fn, eventData->status);
-    gIsUwaEnabled = eventData->status == UWA_STATUS_OK;
-    sUwaEnableEvent.notifyOne();
+    state.isUwaEnabled = eventData->status == UWA_STATUS_OK;
+    state.uwaEnableEvent.notifyOne();
   } break;
 
   case UWA_DM_DISABLE_EVT: /* Result of UWA_Disable */
   {
-    SyncEventGuard guard(sUwaDisableEvent);
+    SyncEventGuard guard(state.uwaDisableEvent);
     JNI_TRACE_I("%s: UWA_DM_DISABLE_EVT", fn);
-    gIsUwaEnabled = false;
-    sUwaDisableEvent.notifyOne();
+    state.isUwaEnabled = false;
+    state.uwaDisableEvent.notifyOne();
   } break;
   case UWA_DM_DEVICE_RESET_RSP_EVT: // result of UWA_SendDeviceReset
   {
     JNI_TRACE_I("%s: UWA_DM_DEVICE_RESET_RSP_EVT", fn);
-    SyncEventGuard guard(sUwaDeviceResetEvent);
+    SyncEventGuard guard(state.uwaDeviceResetEvent);
     if (eventData->status != UWA_STATUS_OK) {
       JNI_TRACE_E("%s: UWA_DM_DEVICE_RESET_RSP_EVT failed", fn);
     } else {
-      sIsDeviceResetDone = true;
+      state.isDeviceResetDone = true;
     }
-    sUwaDeviceResetEvent.notifyOne();
+    state.uwaDeviceResetEvent.notifyOne();
   } break;
   case UWA_DM_DEVICE_STATUS_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_DEVICE_STATUS_NTF_EVT", fn);
     {
       JNI_TRACE_I("device status = %x", eventData->dev_status.status);
-      SyncEventGuard guard(sUwadeviceNtfEvent);
-      sDeviceState = (eUWBS_DEVICE_STATUS_t)eventData->dev_status.status;
-      if (sDeviceState == UWBS_STATUS_ERROR)
-        sErrNotify.notifyAll();
+      SyncEventGuard guard(state.uwaDeviceNtfEvent);
+      state.deviceState = (eUWBS_DEVICE_STATUS_t)eventData->dev_status.status;
+      if (state.deviceState == UWBS_STATUS_ERROR)
+        state.errNotify.notifyAll();
       else
-        sUwadeviceNtfEvent.notifyOne();
-      uwbEventManager.onDeviceStateNotificationReceived(sDeviceState);
+        state.uwaDeviceNtfEvent.notifyOne();
+      chip.getDispatcher().postDeviceState(state.deviceState);
     }
     break;
   case UWA_DM_CORE_GET_DEVICE_INFO_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_CORE_GET_DEVICE_INFO_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetDeviceInfoEvent);
+      SyncEventGuard guard(state.uwaGetDeviceInfoEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sUwbDeviceInfo.uciVersion = eventData->sGet_device_info.uci_version;
-        sUwbDeviceInfo.macVersion = eventData->sGet_device_info.mac_version;
-        sUwbDeviceInfo.phyVersion = eventData->sGet_device_info.phy_version;
-        sUwbDeviceInfo.uciTestVersion =
+        state.uwbDeviceInfo.uciVersion =
+            eventData->sGet_device_info.uci_version;
+        state.uwbDeviceInfo.macVersion =
+            eventData->sGet_device_info.mac_version;
+        state.uwbDeviceInfo.phyVersion =
+            eventData->sGet_device_info.phy_version;
+        state.uwbDeviceInfo.uciTestVersion =
             eventData->sGet_device_info.uciTest_version;
-        uwbEventManager.onVendorDeviceInfo(eventData->sGet_device_info.vendor_info, eventData->sGet_device_info.vendor_info_len);
+        state.uwbVendorInfoLen = eventData->sGet_device_info.vendor_info_len;
+        memcpy(state.uwbVendorInfo, eventData->sGet_device_info.vendor_info,
+               state.uwbVendorInfoLen);
+        chip.getDispatcher().postVendorDeviceInfo(eventData->sGet_device_info.vendor_info, eventData->sGet_device_info.vendor_info_len);
       } else {
         JNI_TRACE_E("%s: UWA_DM_CORE_GET_DEVICE_INFO_RSP_EVT failed", fn);
       }
-      sUwaGetDeviceInfoEvent.notifyOne();
+      state.deviceInfoRspReceived = true;
+      state.uwaGetDeviceInfoEvent.notifyOne();
     }
     break;
   case UWA_DM_CORE_SET_CONFIG_RSP_EVT: // result of UWA_SetCoreConfig
@@ -277,59 +270,51 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
       if (eventData->status != UWA_STATUS_OK) {
         JNI_TRACE_E("%s: UWA_DM_CORE_SET_CONFIG_RSP_EVT failed", fn);
       }
-      if (eventData->sCore_set_config.tlv_size > 0) {
-        memcpy(sSetCoreConfig, eventData->sCore_set_config.param_ids,
-               eventData->sCore_set_config.tlv_size);
-      }
-      SyncEventGuard guard(sUwaSetConfigEvent);
-      sUwaSetConfigEvent.notifyOne();
+      SyncEventGuard guard(state.uwaSetConfigEvent);
+      state.coreSetConfigRspReceived = true;
+      state.uwaSetConfigEvent.notifyOne();
     }
     break;
   case UWA_DM_CORE_GET_CONFIG_RSP_EVT: /* Result of UWA_GetCoreConfig */
     JNI_TRACE_I("%s: UWA_DM_CORE_GET_CONFIG_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetConfigEvent);
-      if (eventData->status == UWA_STATUS_OK) {
-        sGetCoreConfigLen = eventData->sCore_get_config.tlv_size;
-        sNoOfCoreConfigIds = eventData->sCore_get_config.no_of_ids;
+      SyncEventGuard guard(state.uwaGetConfigEvent);
+      if (eventData->status == UWA_STATUS_OK &&
+          state.getCoreConfigDest != NULL &&
+          eventData->sCore_get_config.tlv_size <= state.getCoreConfigCapacity) {
+        state.getCoreConfigLen = eventData->sCore_get_config.tlv_size;
+        state.noOfCoreConfigIds = eventData->sCore_get_config.no_of_ids;
+        memcpy(state.getCoreConfigDest, eventData->sCore_get_config.param_tlvs,
+               state.getCoreConfigLen);
       } else {
         JNI_TRACE_E("%s: UWA_DM_GET_CONFIG failed", fn);
         /* As of now will cary the failed ids list till this point */
-        sGetCoreConfigLen = 0;
-        sNoOfCoreConfigIds = 0;
+        state.getCoreConfigLen = 0;
+        state.noOfCoreConfigIds = 0;
       }
-      if (eventData->sCore_get_config.tlv_size > 0 &&
-          eventData->sCore_get_config.tlv_size <= sizeof(sGetCoreConfig)) {
-        memcpy(sGetCoreConfig, eventData->sCore_get_config.param_tlvs,
-               eventData->sCore_get_config.tlv_size);
-      }
-      sUwaGetConfigEvent.notifyOne();
+      state.uwaGetConfigEvent.notifyOne();
     }
     break;
   case UWA_DM_SESSION_INIT_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_SESSION_INIT_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaSessionInitEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sSessionInitStatus = true;
         JNI_TRACE_I("%s: UWA_DM_SESSION_INIT_RSP_EVT Success", fn);
       } else {
         JNI_TRACE_E("%s: UWA_DM_SESSION_INIT_RSP_EVT failed", fn);
       }
-      sUwaSessionInitEvent.notifyOne();
+      completeCommand(chip, UWB_CMD_SESSION_INIT, eventData->status);
     }
     break;
   case UWA_DM_SESSION_DEINIT_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_SESSION_DEINIT_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaSessionDeInitEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sSessionDeInitStatus = true;
         JNI_TRACE_I("%s: UWA_DM_SESSION_DEINIT_RSP_EVT Success", fn);
       } else {
         JNI_TRACE_E("%s: UWA_DM_SESSION_DEINIT_RSP_EVT failed", fn);
       }
-      sUwaSessionDeInitEvent.notifyOne();
+      completeCommand(chip, UWB_CMD_SESSION_DEINIT, eventData->status);
     }
     break;
   case UWA_DM_SESSION_STATUS_NTF_EVT:
@@ -337,16 +322,17 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
     {
       unsigned int session_id = eventData->sSessionStatus.session_id;
 
+      chip.getSessionRegistry().updateSessionState(session_id,
+                                          eventData->sSessionStatus.state);
       if (UWB_SESSION_DEINITIALIZED == eventData->sSessionStatus.state) {
-        std::unique_lock<std::mutex> lock(sSessionMutex);
-        auto it = sAveragedRangingData.find(session_id);
-        if (it != sAveragedRangingData.end()) {
-          sAveragedRangingData.erase(session_id);
+        chip.getStats().releaseSession(session_id);
+        chip.getControleeRegistry().remove(session_id);
+        if (chip.getSessionRegistry().remove(session_id)) {
           JNI_TRACE_E("%s: deinit: Averaging Disabled for Session %d", fn,
                       session_id);
         }
       }
-      uwbEventManager.onSessionStatusNotificationReceived(
+      chip.getDispatcher().postSessionStatus(
           eventData->sSessionStatus.session_id, eventData->sSessionStatus.state,
           eventData->sSessionStatus.reason_code);
     }
@@ -354,103 +340,98 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
   case UWA_DM_SESSION_SET_CONFIG_RSP_EVT: // result of UWA_SetAppConfig
     JNI_TRACE_I("%s: UWA_DM_SESSION_SET_CONFIG_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaSetAppConfigEvent);
-      sSetAppConfigRespStatus = true;
-      sSetAppConfigStatus = eventData->status;
-      sSetAppConfigLen = eventData->sApp_set_config.tlv_size;
-      sNoOfAppConfigIds = eventData->sApp_set_config.num_param_id;
-      if (eventData->sApp_set_config.tlv_size > 0) {
-        memcpy(sSetAppConfig, eventData->sApp_set_config.param_ids,
-               eventData->sApp_set_config.tlv_size);
+      tUWB_CMD_RESULT result;
+      result.status = eventData->status;
+      result.value = eventData->sApp_set_config.num_param_id;
+      result.len = 0;
+      if (eventData->sApp_set_config.tlv_size > 0 &&
+          eventData->sApp_set_config.tlv_size <= sizeof(result.data)) {
+        result.len = eventData->sApp_set_config.tlv_size;
+        memcpy(result.data, eventData->sApp_set_config.param_ids, result.len);
       }
-      sUwaSetAppConfigEvent.notifyOne();
+      chip.getCommandPipeline().complete(UWB_CMD_SET_APP_CONFIG, result);
     }
     break;
   case UWA_DM_SESSION_GET_CONFIG_RSP_EVT: /* Result of UWA_GetAppConfig */
     JNI_TRACE_I("%s: UWA_DM_SESSION_GET_CONFIG_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetAppConfigEvent);
-      sGetAppConfigRespStatus = true;
-      sGetAppConfigStatus = eventData->status;
-      sGetAppConfigLen = eventData->sApp_get_config.tlv_size;
-      sNoOfAppConfigIds = eventData->sApp_get_config.no_of_ids;
-      if (eventData->sApp_get_config.tlv_size > 0) {
-        memcpy(sGetAppConfig, eventData->sApp_get_config.param_tlvs,
-               eventData->sApp_get_config.tlv_size);
+      tUWB_CMD_RESULT result;
+      result.status = eventData->status;
+      result.value = eventData->sApp_get_config.no_of_ids;
+      result.len = 0;
+      if (eventData->sApp_get_config.tlv_size > 0 &&
+          eventData->sApp_get_config.tlv_size <= sizeof(result.data)) {
+        result.len = eventData->sApp_get_config.tlv_size;
+        memcpy(result.data, eventData->sApp_get_config.param_tlvs, result.len);
       }
-      sUwaGetAppConfigEvent.notifyOne();
+      chip.getCommandPipeline().complete(UWB_CMD_GET_APP_CONFIG, result);
     }
     break;
   case UWA_DM_RANGE_START_RSP_EVT: /* result of range start command */
     JNI_TRACE_I("%s: UWA_DM_RANGE_START_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaRngStartEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sRangeStartStatus = true;
         JNI_TRACE_I("%s: UWA_DM_RANGE_START_RSP_EVT Success", fn);
       } else {
-        sRangeStartStatus = false;
         JNI_TRACE_E("%s: UWA_DM_RANGE_START_RSP_EVT failed", fn);
       }
-      sUwaRngStartEvent.notifyOne();
+      completeCommand(chip, UWB_CMD_RANGE_START, eventData->status);
     }
     break;
   case UWA_DM_RANGE_STOP_RSP_EVT: /* result of range stop command */
     JNI_TRACE_I("%s: UWA_DM_RANGE_STOP_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaRngStopEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sRangeStopStatus = true;
         JNI_TRACE_I("%s: UWA_DM_RANGE_STOP_RSP_EVT Success", fn);
       } else {
-        sRangeStopStatus = false;
         JNI_TRACE_E("%s: UWA_DM_RANGE_STOP_RSP_EVT failed", fn);
       }
-      sUwaRngStopEvent.notifyOne();
+      completeCommand(chip, UWB_CMD_RANGE_STOP, eventData->status);
     }
+    /* Deliver the rounds buffered before the stop rather than on deadline */
+    chip.getDispatcher().postRangeDataBatchFlush();
     break;
   case UWA_DM_GET_RANGE_COUNT_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_GET_RANGE_COUNT_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetRangingCountEvent);
+      SyncEventGuard guard(state.uwaGetRangingCountEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sRangingCount = eventData->sGet_range_cnt.count;
+        state.rangingCount = eventData->sGet_range_cnt.count;
       } else {
         JNI_TRACE_E("%s: get range count Request is failed", fn);
-        sRangingCount = 0;
+        state.rangingCount = 0;
       }
-      sUwaGetRangingCountEvent.notifyOne();
+      state.uwaGetRangingCountEvent.notifyOne();
     }
     break;
   case UWA_DM_RANGE_DATA_NTF_EVT:
-    JNI_TRACE_I("%s: UWA_DM_RANGE_DATA_NTF_EVT", fn);
-    { notifyRangeDataNotification(&eventData->sRange_data); }
+    { notifyRangeDataNotification(chip, &eventData->sRange_data); }
     break;
   case UWA_DM_SESSION_GET_COUNT_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_SESSION_GET_COUNT_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetSessionCountEvent);
+      SyncEventGuard guard(state.uwaGetSessionCountEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sSessionCount = eventData->sGet_session_cnt.count;
+        state.sessionCount = eventData->sGet_session_cnt.count;
       } else {
         JNI_TRACE_E("%s: get session count Request is failed", fn);
-        sSessionCount = -1;
+        state.sessionCount = -1;
       }
-      sUwaGetSessionCountEvent.notifyOne();
+      state.uwaGetSessionCountEvent.notifyOne();
     }
     break;
 
   case UWA_DM_SESSION_GET_STATE_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_SESSION_GET_STATE_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaGetSessionStatusEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sSessionState = eventData->sGet_session_state.session_state;
+        completeCommand(chip, UWB_CMD_GET_SESSION_STATE, eventData->status,
+                        eventData->sGet_session_state.session_state);
       } else {
         JNI_TRACE_E("%s: get session state Request is failed", fn);
-        sSessionState = UWB_UNKNOWN_SESSION;
+        completeCommand(chip, UWB_CMD_GET_SESSION_STATE, eventData->status,
+                        UWB_UNKNOWN_SESSION);
       }
-      sUwaGetSessionStatusEvent.notifyOne();
     }
     break;
 
@@ -458,21 +439,19 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
                                                  multicast list */
     JNI_TRACE_I("%s: UWA_DM_SESSION_MC_LIST_UPDATE_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaMulticastListUpdateEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sMulticastListUpdateStatus = true;
         JNI_TRACE_I("%s: UWA_DM_SESSION_MC_LIST_UPDATE_RSP_EVT Success", fn);
       } else {
         JNI_TRACE_E("%s: UWA_DM_SESSION_MC_LIST_UPDATE_RSP_EVT failed", fn);
       }
-      sUwaMulticastListUpdateEvent.notifyOne();
+      completeCommand(chip, UWB_CMD_MC_LIST_UPDATE, eventData->status);
     }
     break;
 
   case UWA_DM_SESSION_MC_LIST_UPDATE_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_SESSION_MC_LIST_UPDATE_NTF_EVT", fn);
     {
-      uwbEventManager.onMulticastListUpdateNotificationReceived(
+      chip.getDispatcher().postMulticastListUpdate(
           &eventData->sMulticast_list_ntf);
     }
     break;
@@ -480,46 +459,50 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
   case UWA_DM_SET_COUNTRY_CODE_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_COUNTRY_CODE_UPDATE_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaSetCountryCodeEvent);
+      SyncEventGuard guard(state.uwaSetCountryCodeEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        sSetCountryCodeStatus = true;
+        state.setCountryCodeStatus = true;
         JNI_TRACE_I("%s: UWA_DM_COUNTRY_CODE_UPDATE_RSP_EVT Success", fn);
       } else {
         JNI_TRACE_E("%s: UWA_DM_COUNTRY_CODE_UPDATE_RSP_EVT failed", fn);
       }
-      sUwaSetCountryCodeEvent.notifyOne();
+      state.uwaSetCountryCodeEvent.notifyOne();
     }
     break;
 
   case UWA_DM_SEND_BLINK_DATA_RSP_EVT:
     JNI_TRACE_I("%s: UWA_DM_SEND_BLINK_DATA_RSP_EVT", fn);
     {
-      SyncEventGuard guard(sUwaSendBlinkDataEvent);
-      sSendBlinkDataStatus = eventData->status;
-      sUwaSendBlinkDataEvent.notifyOne();
+      SyncEventGuard guard(state.uwaSendBlinkDataEvent);
+      state.sendBlinkDataStatus = eventData->status;
+      state.uwaSendBlinkDataEvent.notifyOne();
     }
     break;
 
   case UWA_DM_GET_CORE_DEVICE_CAP_RSP_EVT:
     JNI_TRACE_D("%s: UWA_DM_API_CORE_GET_DEVICE_CAPABILITY_EVT", fn);
     {
-     SyncEventGuard guard(sUwaGetDeviceCapsEvent);
-     sGetDeviceCapsRespStatus = true;
-     sDevCapInfoLen = 0;
-     if (eventData->sGet_device_capability.status == UWA_STATUS_OK) {
-        sDevCapInfoIds = eventData->sGet_device_capability.no_of_tlvs;
-        sDevCapInfoLen = eventData->sGet_device_capability.tlv_buffer_len;
-        if (eventData->sGet_device_capability.tlv_buffer_len > 0 && (eventData->sGet_device_capability.tlv_buffer_len <= UCI_MAX_PKT_SIZE)) {
-            memcpy(sUwbDeviceCapability, eventData->sGet_device_capability.tlv_buffer, eventData->sGet_device_capability.tlv_buffer_len);
-        }
+     SyncEventGuard guard(state.uwaGetDeviceCapsEvent);
+     state.devCapInfoLen = 0;
+     if (eventData->sGet_device_capability.status == UWA_STATUS_OK &&
+         state.deviceCapsDest != NULL &&
+         eventData->sGet_device_capability.tlv_buffer_len <=
+             state.deviceCapsCapacity) {
+        state.getDeviceCapsRespStatus = true;
+        state.devCapInfoIds = eventData->sGet_device_capability.no_of_tlvs;
+        state.devCapInfoLen = eventData->sGet_device_capability.tlv_buffer_len;
+        memcpy(state.deviceCapsDest,
+               eventData->sGet_device_capability.tlv_buffer,
+               state.devCapInfoLen);
      }
-     sUwaGetDeviceCapsEvent.notifyOne();
+     state.deviceCapsRspReceived = true;
+     state.uwaGetDeviceCapsEvent.notifyOne();
      }
     break;
   case UWA_DM_SEND_BLINK_DATA_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_SEND_BLINK_DATA_NTF_EVT", fn);
     {
-      uwbEventManager.onBlinkDataTxNotificationReceived(
+      chip.getDispatcher().postBlinkDataTx(
           eventData->sBlink_data_ntf.repetition_count_status);
     }
     break;
@@ -532,21 +515,21 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
       ntf_data = (uint8_t *) eventData->sVendor_specific_ntf.data + UCI_MSG_HDR_SIZE;
       UCI_MSG_PRS_HDR0(p_ntf_hdr, mt, pbf, gid);
       UCI_MSG_PRS_HDR1(p_ntf_hdr, oid);
-      uwbEventManager.onVendorUciNotificationReceived(gid, oid,
+      chip.getDispatcher().postVendorUciNotification(gid, oid,
        ntf_data, len);
      }
      break;
   case UWA_DM_CONFORMANCE_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_CONFORMANCE_NTF_EVT", fn);
     {
-      uwbEventManager.onRawUciNotificationReceived(eventData->sConformance_ntf.data,
+      chip.getDispatcher().postRawUciNotification(eventData->sConformance_ntf.data,
       eventData->sConformance_ntf.length);
     }
     break;
   case UWA_DM_CORE_GEN_ERR_STATUS_EVT:
     JNI_TRACE_I("%s: UWA_DM_CORE_GEN_ERR_STATUS_EVT", fn);
     {
-      uwbEventManager.onCoreGenericErrorNotificationReceived(
+      chip.getDispatcher().postCoreGenericError(
           eventData->sCore_gen_err_status.status);
     }
     break;
@@ -567,11 +550,12 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
 
 /*******************************************************************************
 **
-** Function:        CommandResponse_Cb
+** Function:        onRawCommandResponse
 **
 ** Description:     Receive response from the stack for raw command sent from
 *                   jni.
 **
+**                  chip: chip of the stack.
 **                  event:  event ID.
 **                  paramLength: length of the response
 **                  pResponseBuffer: pointer to data
@@ -579,57 +563,112 @@ static void uwaDeviceManagementCallback(uint8_t dmEvent,
 ** Returns:         None
 **
 *******************************************************************************/
-static void CommandResponse_Cb(uint8_t event, uint16_t paramLength,
-                               uint8_t *pResponseBuffer) {
+static void onRawCommandResponse(UwbChipContext &chip, uint8_t event,
+                                 uint16_t paramLength,
+                                 uint8_t *pResponseBuffer) {
   JNI_TRACE_I("%s: Entry", __func__);
+  UwbChipState &state = chip.getState();
 
+  // The waiter may attach or detach the destination, so copy under the guard.
+  SyncEventGuard guard(state.uwaSendRawUciEvt);
   if ((paramLength > UCI_RESPONSE_STATUS_OFFSET) && (pResponseBuffer != NULL)) {
     JNI_TRACE_I("CommandResponse_Cb Received length data = 0x%x status = 0x%x",
                 paramLength, pResponseBuffer[UCI_RESPONSE_STATUS_OFFSET]);
-   sSendRawResLen = paramLength-UCI_MSG_HDR_SIZE;
-   memcpy(sSendRawResData, pResponseBuffer+UCI_MSG_HDR_SIZE, sSendRawResLen);
+    uint16_t rspLen = paramLength - UCI_MSG_HDR_SIZE;
+    if (state.sendRawResDest == NULL) {
+      JNI_TRACE_E("%s: no command waits for the response", __func__);
+    } else if (rspLen > state.sendRawResCapacity) {
+      JNI_TRACE_E("%s: response of %d bytes does not fit %d", __func__, rspLen,
+                  state.sendRawResCapacity);
+      state.sendRawResLen = 0;
+      state.sendRawResOverflow = true;
+    } else {
+      state.sendRawResLen = rspLen;
+      memcpy(state.sendRawResDest, pResponseBuffer + UCI_MSG_HDR_SIZE, rspLen);
+    }
   } else {
     JNI_TRACE_E("%s:CommandResponse_Cb responseBuffer is NULL or Length < "
                 "UCI_RESPONSE_STATUS_OFFSET",
                 __func__);
   }
-  SyncEventGuard guard(sUwaSendRawUciEvt);
-  sUwaSendRawUciEvt.notifyOne();
+  state.uwaSendRawUciEvt.notifyOne();
 
   JNI_TRACE_I("%s: Exit", __func__);
 }
 
+/* The UWA callbacks carry no context of their own. Every chip hands its stack
+ * the instances bound to its chip ID, UwbChipContext::get() of that ID is
+ * set before the stack is enabled and never cleared. */
+template <uint8_t chipId>
+static void uwaDeviceManagementCallback(uint8_t dmEvent,
+                                        tUWA_DM_CBACK_DATA *eventData) {
+  onDeviceManagementEvent(*UwbChipContext::get(chipId), dmEvent, eventData);
+}
+
+template <uint8_t chipId>
+static void uwaRfTestDeviceManagementCallback(
+    uint8_t dmEvent, tUWA_DM_TEST_CBACK_DATA *eventData) {
+  UwbChipContext::get(chipId)->getRfTestManager().onDeviceManagementEvent(
+      dmEvent, eventData);
+}
+
+template <uint8_t chipId>
+static void CommandResponse_Cb(uint8_t event, uint16_t paramLength,
+                               uint8_t *pResponseBuffer) {
+  onRawCommandResponse(*UwbChipContext::get(chipId), event, paramLength,
+                       pResponseBuffer);
+}
+
+static_assert(UWB_MAX_CHIPS == 4, "one callback instance per chip");
+static tUWA_DM_CBACK *const sDmCbacks[UWB_MAX_CHIPS] = {
+    uwaDeviceManagementCallback<0>, uwaDeviceManagementCallback<1>,
+    uwaDeviceManagementCallback<2>, uwaDeviceManagementCallback<3>};
+static tUWA_DM_TEST_CBACK *const sRfTestCbacks[UWB_MAX_CHIPS] = {
+    uwaRfTestDeviceManagementCallback<0>,
+    uwaRfTestDeviceManagementCallback<1>,
+    uwaRfTestDeviceManagementCallback<2>,
+    uwaRfTestDeviceManagementCallback<3>};
+static tUWA_RAW_CMD_CBACK *const sRawCmdCbacks[UWB_MAX_CHIPS] = {
+    CommandResponse_Cb<0>, CommandResponse_Cb<1>, CommandResponse_Cb<2>,
+    CommandResponse_Cb<3>};
+
 /*******************************************************************************
 **
 ** Function:        setAppConfiguration
 **
 ** Description:     Set the session specific App Config
 **
-** Params:          session_id: Session Id of the required App Config
+** Params:          chip: chip of the session.
+**                  session_id: Session Id of the required App Config
 **                  noOfParams: Number of Params need to configure
 **                  paramLen: Total Params Lentgh
 **                  appConfigParams: AppConfigs List in TLV format
+**                  result: response of the command
 **
-** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
+** Returns:         UWA_STATUS_OK if the response was received, else
+**                  UWA_STATUS_FAILED
 **
 *******************************************************************************/
-static tUWA_STATUS setAppConfiguration(uint32_t session_id, uint8_t noOfParams,
+static tUWA_STATUS setAppConfiguration(UwbChipContext &chip,
+                                       uint32_t session_id, uint8_t noOfParams,
                                        uint8_t paramLen,
-                                       uint8_t appConfigParams[]) {
+                                       uint8_t appConfigParams[],
+                                       tUWB_CMD_RESULT *result) {
   static const char fn[] = "setAppConfiguration";
   UNUSED(fn);
-  tUWA_STATUS status;
-  sSetAppConfigRespStatus = false;
-  SyncEventGuard guard(sUwaSetAppConfigEvent);
-  status = UWA_SetAppConfig(session_id, noOfParams, paramLen, appConfigParams);
+  tUWA_STATUS status = chip.getCommandPipeline().execute(
+      UWB_CMD_SET_APP_CONFIG,
+      [&]() {
+        return chip.getStack().setAppConfig(session_id, noOfParams, paramLen,
+                                            appConfigParams);
+      },
+      result);
   if (status == UWA_STATUS_OK) {
-    sUwaSetAppConfigEvent.wait(UWB_CMD_TIMEOUT);
     JNI_TRACE_I("%s: Success UWA_SetAppConfig Command", fn);
   } else {
     JNI_TRACE_E("%s: Failed UWA_SetAppConfig Command", fn);
-    return UWA_STATUS_FAILED;
   }
-  return (sSetAppConfigRespStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return status;
 }
 
 /*******************************************************************************
@@ -638,15 +677,21 @@ static tUWA_STATUS setAppConfiguration(uint32_t session_id, uint8_t noOfParams,
 **
 ** Description:     Invoked this API to send raw uci cmds
 **
-** Params:          rawCmd: Ponter to the raw uci command
+** Params:          chip: chip receiving the command.
+**                  rawCmd: Ponter to the raw uci command
 **                  cmdLen: Length of the command
-**                  rsoData: Pointer to the response for sendRawUci cmd
-**                  rspLen: Length of response
+**                  rspData: Buffer receiving the response payload.
+**                  rspCapacity: Size of rspData
+**                  rspLen: Receives the length of the response payload.
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-static tUWA_STATUS sendRawUci(uint8_t gid, uint8_t oid, uint8_t *rawCmd, uint16_t cmdLen) {
+static tUWA_STATUS sendRawUci(UwbChipContext &chip, uint8_t gid, uint8_t oid,
+                              uint8_t *rawCmd, uint16_t cmdLen,
+                              uint8_t *rspData, uint16_t rspCapacity,
+                              uint16_t *rspLen) {
+  UwbChipState &state = chip.getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   uint8_t* pp;
   uint8_t* p;
@@ -654,7 +699,7 @@ static tUWA_STATUS sendRawUci(uint8_t gid, uint8_t oid, uint8_t *rawCmd, uint16_
   p = pp =  (uint8_t *) phUwb_GKI_getbuf(len);
 
   if (pp != NULL) {
-     SyncEventGuard guard(sUwaSendRawUciEvt);
+     SyncEventGuard guard(state.uwaSendRawUciEvt);
      UCI_MSG_BLD_HDR0(pp, UCI_MT_CMD, gid);
      UCI_MSG_BLD_HDR1(pp, oid);
      UINT8_TO_STREAM(pp, 0x00);
@@ -666,13 +711,26 @@ static tUWA_STATUS sendRawUci(uint8_t gid, uint8_t oid, uint8_t *rawCmd, uint16_
        ARRAY_TO_STREAM(pp, rawCmd, cmdLen);
      }
 
-     status = UWA_SendRawCommand(len, p, CommandResponse_Cb);
+     state.sendRawResLen = 0;
+     state.sendRawResOverflow = false;
+     state.sendRawResDest = rspData;
+     state.sendRawResCapacity = rspCapacity;
+     status = chip.getStack().sendRawCommand(
+         len, p, sRawCmdCbacks[chip.getChipId()]);
      phUwb_GKI_freebuf(p);
 
      if (status == UWA_STATUS_OK) {
        JNI_TRACE_I("%s: Success UWA_SendRawCommand", __func__);
-        sUwaSendRawUciEvt.wait(UWB_CMD_TIMEOUT);
-     } else {
+        state.uwaSendRawUciEvt.wait(UWB_CMD_TIMEOUT);
+     }
+     // A late response must not reach a caller buffer that is gone.
+     state.sendRawResDest = NULL;
+     state.sendRawResCapacity = 0;
+     *rspLen = state.sendRawResLen;
+     if (status == UWA_STATUS_OK && state.sendRawResOverflow) {
+       status = UWA_STATUS_FAILED;
+     }
+     if (status != UWA_STATUS_OK) {
        JNI_TRACE_E("%s: Failed UWA_SendRawCommand", __func__);
        return status;
      }
@@ -684,17 +742,20 @@ static tUWA_STATUS sendRawUci(uint8_t gid, uint8_t oid, uint8_t *rawCmd, uint16_
 
 /*******************************************************************************
 **
-** Function:        SetCoreDeviceConfigurations
+** Function:        SendCoreDeviceConfigurations
 **
-** Description:     Set the Core Device Config
+** Description:     Send the Core Device Config. The caller waits for the
+**                  response on the uwaSetConfigEvent of the chip.
 **
+** Params:          chip: chip to configure.
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-static tUWA_STATUS SetCoreDeviceConfigurations() {
+static tUWA_STATUS SendCoreDeviceConfigurations(UwbChipContext &chip) {
+  UwbChipState &state = chip.getState();
   uint8_t coreConfigsCount = 1;
-  static const char fn[] = "SetCoreDeviceConfigurations";
+  static const char fn[] = "SendCoreDeviceConfigurations";
   UNUSED(fn);
   tUWA_STATUS status;
   uint8_t configParam[] = {0x00, 0x00, 0x00};
@@ -705,18 +766,16 @@ static tUWA_STATUS SetCoreDeviceConfigurations() {
   JNI_TRACE_I("%s: NAME_UWB_LOW_POWER_MODE value %d ", fn, (uint8_t)config);
 
   configParam[0] = (uint8_t)config;
-
-  {
-    SyncEventGuard guard(sUwaSetConfigEvent);
-    status = UWA_SetCoreConfig(UCI_PARAM_ID_LOW_POWER_MODE, coreConfigsCount,
-                               &configParam[0]);
-    if (status == UWA_STATUS_OK) {
-      sUwaSetConfigEvent.wait(UWB_CMD_TIMEOUT);
-      JNI_TRACE_I("%s: low power mode config is success", fn);
-    } else {
-      JNI_TRACE_E("%s: low power mode config is failed", fn);
-      return UWA_STATUS_FAILED;
-    }
+  state.coreConfigTlvs[0] = UCI_PARAM_ID_LOW_POWER_MODE;
+  state.coreConfigTlvs[1] = coreConfigsCount;
+  state.coreConfigTlvs[2] = configParam[0];
+  state.coreConfigTlvLen = 3;
+
+  status = chip.getStack().setCoreConfig(UCI_PARAM_ID_LOW_POWER_MODE,
+                                         coreConfigsCount, &configParam[0]);
+  if (status != UWA_STATUS_OK) {
+    JNI_TRACE_E("%s: low power mode config is failed", fn);
+    return UWA_STATUS_FAILED;
   }
 
   JNI_TRACE_I("%s: Exit ", fn);
@@ -730,15 +789,73 @@ static tUWA_STATUS SetCoreDeviceConfigurations() {
 ** Description:     This API is invoked before Init and during DeInit to clear
 **                  All the Session specific context.
 **
+** Params:          chip: chip of the sessions.
+**
 ** Returns:         Nothing
 **
 *******************************************************************************/
-void clearAllSessionContext() {
-  {
-    std::unique_lock<std::mutex> lock(sSessionMutex);
-    sAveragedRangingData.clear();
+void clearAllSessionContext(UwbChipContext &chip) {
+  chip.getSessionRegistry().clear();
+  chip.getControleeRegistry().clear();
+  chip.getCommandPipeline().abortAll();
+  chip.getRfTestManager().clearTestContext();
+}
+
+/* Drop the capability object cached for the current enable cycle */
+static void releaseDeviceCapsCache(JNIEnv *env, UwbChipState &state) {
+  std::lock_guard<std::mutex> lock(state.deviceCapsMutex);
+  if (state.deviceCapsInfo != NULL) {
+    env->DeleteGlobalRef(state.deviceCapsInfo);
+    state.deviceCapsInfo = NULL;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        filterDeviceCapability
+**
+** Description:     Copy the capability TLVs, dropping the vendor extension
+**                  TLVs (ext id 0xE0, sub id, length, value) that the service
+**                  does not understand.
+**
+** Params:          caps: capability TLVs of the UWBS.
+**                  capsLen: length of caps.
+**                  noOfTlvs: number of TLVs in caps.
+**                  filtered: receives the remaining TLVs, capsLen bytes.
+**                  filteredLen: receives the length of filtered.
+**
+** Returns:         Number of TLVs in filtered.
+**
+*******************************************************************************/
+static uint16_t filterDeviceCapability(const uint8_t *caps, uint16_t capsLen,
+                                       uint16_t noOfTlvs, uint8_t *filtered,
+                                       uint16_t *filteredLen) {
+  uint16_t index = 0;
+  *filteredLen = 0;
+  while (index < capsLen) {
+    uint16_t tlvLen;
+    if (caps[index] == 0xE0) { // Ext id
+      if (capsLen - index < 3) {
+        break;
+      }
+      tlvLen = 3 + caps[index + 2];
+      if (noOfTlvs > 0) {
+        noOfTlvs--;
+      }
+    } else {
+      if (capsLen - index < 2) {
+        break;
+      }
+      tlvLen = 2 + caps[index + 1];
+      if (capsLen - index < tlvLen) {
+        break;
+      }
+      memcpy(&filtered[*filteredLen], &caps[index], tlvLen);
+      *filteredLen += tlvLen;
+    }
+    index += tlvLen;
   }
-  clearRfTestContext();
+  return noOfTlvs;
 }
 
 /*******************************************************************************
@@ -747,36 +864,39 @@ void clearAllSessionContext() {
 **
 ** Description:     Send Device Reset Command.
 **
-** Params:          resetConfig: Manufacturer/Vendor Specific Reset Data
+** Params:          chip: chip to reset.
+**                  resetConfig: Manufacturer/Vendor Specific Reset Data
 
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-bool UwbDeviceReset(uint8_t resetConfig) {
+bool UwbDeviceReset(UwbChipContext &chip, uint8_t resetConfig) {
   static const char fn[] = "UwbDeviceReset";
   UNUSED(fn);
+  UwbChipState &state = chip.getState();
   tUWA_STATUS status;
   JNI_TRACE_I("%s: Enter", fn);
 
-  sIsDeviceResetDone = false;
+  state.isDeviceResetDone = false;
+  chip.getSessionRegistry().invalidateAllAppConfig();
   {
-    SyncEventGuard guard(sUwaDeviceResetEvent);
-    status = UWA_SendDeviceReset((uint8_t)resetConfig);
+    SyncEventGuard guard(state.uwaDeviceResetEvent);
+    status = chip.getStack().sendDeviceReset((uint8_t)resetConfig);
     if (status == UWA_STATUS_OK)
-      sUwaDeviceResetEvent.wait(UWB_CMD_TIMEOUT); /* wait for callback */
+      state.uwaDeviceResetEvent.wait(UWB_CMD_TIMEOUT); /* wait for callback */
   }
   if (status == UWA_STATUS_OK) {
     JNI_TRACE_E("%s: Success UWA_SendDeviceReset", fn);
-    if (sIsDeviceResetDone) {
-      SyncEventGuard guard(sUwadeviceNtfEvent);
-      sUwadeviceNtfEvent.wait(UWB_CMD_TIMEOUT);
-      switch (sDeviceState) {
+    if (state.isDeviceResetDone) {
+      SyncEventGuard guard(state.uwaDeviceNtfEvent);
+      state.uwaDeviceNtfEvent.wait(UWB_CMD_TIMEOUT);
+      switch (state.deviceState) {
       case UWBS_STATUS_READY: {
-        clearAllSessionContext();
-        JNI_TRACE_I("%s: Device Reset is success %d", fn, sDeviceState);
+        clearAllSessionContext(chip);
+        JNI_TRACE_I("%s: Device Reset is success %d", fn, state.deviceState);
       } break;
       default: {
-        JNI_TRACE_E("%s: Device state is = %d", fn, sDeviceState);
+        JNI_TRACE_E("%s: Device state is = %d", fn, state.deviceState);
       } break;
       }
     }
@@ -784,7 +904,98 @@ bool UwbDeviceReset(uint8_t resetConfig) {
     JNI_TRACE_E("%s: Failed UWA_SendDeviceReset", fn);
   }
   JNI_TRACE_I("%s: Exit", fn);
-  return sIsDeviceResetDone ? TRUE : FALSE;
+  return state.isDeviceResetDone ? TRUE : FALSE;
+}
+
+/*******************************************************************************
+**
+** Function:        buildDeviceCapsInfo
+**
+** Description:     Build the UwbTlvData of a capability response.
+**
+** Params:          env: JVM environment.
+**                  caps: unfiltered capability TLVs.
+**                  capsLen: length of caps.
+**                  noOfIds: number of TLVs in caps.
+**
+** Returns:         Local reference to the capability object, NULL on failure.
+**
+*******************************************************************************/
+static jobject buildDeviceCapsInfo(JNIEnv *env, uint8_t *caps,
+                                   uint16_t capsLen, uint16_t noOfIds) {
+  jclass tlvDataClass = gUwbJniSymbols.tlvDataClass;
+  jmethodID constructor = gUwbJniSymbols.tlvDataCtor;
+  if (constructor == JNI_NULL) {
+    JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", __func__);
+    return NULL;
+  }
+
+  //remove vendor ext parameters
+  uint8_t sUwbDeviceCapaInfos[UCI_MAX_PKT_SIZE];
+  uint16_t capLen = 0;
+  uint16_t noOfTlvs =
+      filterDeviceCapability(caps, std::min<uint16_t>(capsLen, UCI_MAX_PKT_SIZE),
+                             noOfIds, sUwbDeviceCapaInfos, &capLen);
+  jbyteArray deviceCapabilityInfo = env->NewByteArray(capLen);
+  env->SetByteArrayRegion(deviceCapabilityInfo, 0, capLen,
+                          (jbyte*)&sUwbDeviceCapaInfos[0]);
+  jobject capsInfo = env->NewObject(tlvDataClass, constructor, UWA_STATUS_OK,
+                                    noOfTlvs, deviceCapabilityInfo);
+  env->DeleteLocalRef(deviceCapabilityInfo);
+  return capsInfo;
+}
+
+/* Build the capability object of the last response and keep it for the
+ * enable cycle, the deviceCapsMutex of the chip is held */
+static jobject cacheDeviceCapsInfoLocked(JNIEnv *env, UwbChipState &state,
+                                         uint8_t *caps) {
+  jobject capsInfo =
+      buildDeviceCapsInfo(env, caps, state.devCapInfoLen, state.devCapInfoIds);
+  if (capsInfo != NULL) {
+    state.deviceCapsInfo = env->NewGlobalRef(capsInfo);
+  }
+  return capsInfo;
+}
+
+/* Device info and vendor info reported by the chip at the last init */
+static tUWB_DEVICE_SNAPSHOT_KEY deviceSnapshotKey(const UwbChipState &state) {
+  tUWB_DEVICE_SNAPSHOT_KEY key;
+  memset(&key, 0, sizeof(key));
+  key.deviceInfo = state.uwbDeviceInfo;
+  key.vendorInfoLen = state.uwbVendorInfoLen;
+  memcpy(key.vendorInfo, state.uwbVendorInfo, state.uwbVendorInfoLen);
+  return key;
+}
+
+/* Device info of the chip once enabled, of the persisted snapshot before */
+static bool getKnownDeviceInfo(UwbChipContext &chip, deviceInfo_t *info) {
+  UwbChipState &state = chip.getState();
+  if (state.isUwaEnabled) {
+    *info = state.uwbDeviceInfo;
+    return true;
+  }
+  return chip.getDeviceSnapshot().getDeviceInfo(info);
+}
+
+/* Wait for a response of the init pipeline and record its phase time. Only
+ * the guard of this phase is held, so the callback thread can deliver the
+ * responses of the other phases meanwhile. */
+static bool waitInitPhase(UwbChipState &state, SyncEvent &event,
+                          const bool &received, bool sent, int phase,
+                          int64_t startUs) {
+  if (!sent) {
+    return false;
+  }
+  SyncEventGuard guard(event);
+  if (!received) {
+    event.wait(UWB_CMD_TIMEOUT);
+  }
+  if (!received) {
+    JNI_TRACE_E("%s: init phase %d timed out", __func__, phase);
+    return false;
+  }
+  state.initPhaseUs[phase] = UwbJniStats::nowUs() - startUs;
+  return true;
 }
 
 /*******************************************************************************
@@ -796,93 +1007,154 @@ bool UwbDeviceReset(uint8_t resetConfig) {
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip to turn on.
 **
 ** Returns:         True if UWB device initialization is success.
 **
 *******************************************************************************/
-jboolean uwbNativeManager_doInitialize(JNIEnv *env, jobject o) {
+jboolean uwbNativeManager_doInitialize(JNIEnv *env, jobject o, jint chipId) {
   static const char fn[] = "uwbNativeManager_doInitialize";
   UNUSED(fn);
   tUWA_STATUS status;
   uint8_t resetConfig = 0;
-  JNI_TRACE_I("%s: enter", fn);
+  JNI_TRACE_I("%s: enter; chip %d", fn, chipId);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return JNI_FALSE;
+  }
+  UwbChipState &state = chip->getState();
+  const tUWB_CHIP_STACK &stack = chip->getStack();
 
-  if (gIsUwaEnabled) {
+  if (state.isUwaEnabled) {
     JNI_TRACE_I("%s: Already Initialized", fn);
-    UwbDeviceReset(resetConfig);
+    UwbDeviceReset(*chip, resetConfig);
     return JNI_TRUE;
   }
 
-  sDeviceState = UWBS_STATUS_ERROR;
-  UwbAdaptation &theInstance = UwbAdaptation::GetInstance();
-  theInstance.Initialize(); // start GKI, UCI task, UWB task
-  tHAL_UWB_ENTRY *halFuncEntries = theInstance.GetHalEntryFuncs();
-  UWA_Init(halFuncEntries);
-  clearAllSessionContext();
+  state.deviceState = UWBS_STATUS_ERROR;
+  releaseDeviceCapsCache(env, state);
+  memset(state.initPhaseUs, 0, sizeof(state.initPhaseUs));
+  int64_t initStartUs = UwbJniStats::nowUs();
+  int64_t phaseStartUs = initStartUs;
+  stack.open(); // start GKI, UCI task, UWB task
+  clearAllSessionContext(*chip);
+  state.initPhaseUs[UWB_INIT_PHASE_ADAPTATION] =
+      UwbJniStats::nowUs() - phaseStartUs;
+  phaseStartUs = UwbJniStats::nowUs();
   {
-    SyncEventGuard guard(sUwaEnableEvent);
-    status = UWA_Enable(uwaDeviceManagementCallback,
-                        uwaRfTestDeviceManagementCallback);
+    SyncEventGuard guard(state.uwaEnableEvent);
+    status = stack.enable(sDmCbacks[chipId], sRfTestCbacks[chipId]);
     if (status == UWA_STATUS_OK)
-      sUwaEnableEvent.wait(UWB_CMD_TIMEOUT);
+      state.uwaEnableEvent.wait(UWB_CMD_TIMEOUT);
   }
+  state.initPhaseUs[UWB_INIT_PHASE_ENABLE] =
+      UwbJniStats::nowUs() - phaseStartUs;
   if (status == UWA_STATUS_OK) {
-    if (!gIsUwaEnabled) {
+    if (!state.isUwaEnabled) {
       JNI_TRACE_E("%s: UWB Enable failed", fn);
       goto error;
     }
-    status = theInstance.CoreInitialization();
+    phaseStartUs = UwbJniStats::nowUs();
+    status = stack.coreInitialization();
+    state.initPhaseUs[UWB_INIT_PHASE_CORE_INIT] =
+        UwbJniStats::nowUs() - phaseStartUs;
     JNI_TRACE_I("%s: CoreInitialization status: %d", fn, status);
 
     if (status == UWA_STATUS_OK) {
-#if 1 // WA waiting binding status NTF/ SE comm error NTF
-#endif
+      /* Device info, core config and the capability prefetch do not depend
+       * on each other: queue all three in the UCI stack, then collect the
+       * responses, which arrive in command order. No guard is held while
+       * sending, and each wait holds only its own, so the callback thread
+       * never blocks on a phase that is not being waited for. */
+      bool infoDone, configDone, capsDone;
+      UwbBufferLease caps =
+          UwbBufferPool::getPacketPool().lease(UCI_MAX_PKT_SIZE);
       {
-        /* Get Device Info */
-        {
-          SyncEventGuard guard(sUwaGetDeviceInfoEvent);
-          status = UWA_GetDeviceInfo();
-
-          if (status == UWA_STATUS_OK) {
-            sUwaGetDeviceInfoEvent.wait();
-            JNI_TRACE_I("UCI Version : %x.%x",
-                        (sUwbDeviceInfo.uciVersion & 0X00FF),
-                        (sUwbDeviceInfo.uciVersion >> 8));
-          }
-        }
+        SyncEventGuard guard(state.uwaGetDeviceInfoEvent);
+        state.deviceInfoRspReceived = false;
+      }
+      {
+        SyncEventGuard guard(state.uwaSetConfigEvent);
+        state.coreSetConfigRspReceived = false;
+      }
+      {
+        SyncEventGuard guard(state.uwaGetDeviceCapsEvent);
+        state.deviceCapsRspReceived = false;
+        state.getDeviceCapsRespStatus = false;
+        state.deviceCapsDest = caps.data();
+        state.deviceCapsCapacity = caps.size();
+      }
+      phaseStartUs = UwbJniStats::nowUs();
+      bool infoSent = stack.getDeviceInfo() == UWA_STATUS_OK;
+      bool configSent =
+          infoSent && SendCoreDeviceConfigurations(*chip) == UWA_STATUS_OK;
+      bool capsSent = configSent && caps.isValid() &&
+                      stack.getDeviceCapability() == UWA_STATUS_OK;
+
+      infoDone = waitInitPhase(state, state.uwaGetDeviceInfoEvent,
+                               state.deviceInfoRspReceived, infoSent,
+                               UWB_INIT_PHASE_DEVICE_INFO, phaseStartUs);
+      configDone = waitInitPhase(state, state.uwaSetConfigEvent,
+                                 state.coreSetConfigRspReceived, configSent,
+                                 UWB_INIT_PHASE_CORE_CONFIG, phaseStartUs);
+      capsDone = waitInitPhase(state, state.uwaGetDeviceCapsEvent,
+                               state.deviceCapsRspReceived, capsSent,
+                               UWB_INIT_PHASE_CAPS_PREFETCH, phaseStartUs);
+      {
+        SyncEventGuard guard(state.uwaGetDeviceCapsEvent);
+        state.deviceCapsDest = NULL;
+        state.deviceCapsCapacity = 0;
+      }
+      if (infoDone) {
+        JNI_TRACE_I("UCI Version : %x.%x",
+                    (state.uwbDeviceInfo.uciVersion & 0X00FF),
+                    (state.uwbDeviceInfo.uciVersion >> 8));
+        chip->getDeviceSnapshot().validate(deviceSnapshotKey(state));
+      }
 
-        if (status == UWA_STATUS_OK) {
-          gIsUwaEnabled = true;
-          status = SetCoreDeviceConfigurations();
-          if (status == UWA_STATUS_OK) {
-            JNI_TRACE_I("%s: SetCoreDeviceConfigurations is SUCCESS %d", fn,
-                        status);
-          } else {
-            JNI_TRACE_I("%s: SetCoreDeviceConfigurations is Failed %d", fn,
-                        status);
-            goto error;
+      if (infoDone && configDone) {
+        state.isUwaEnabled = true;
+        JNI_TRACE_I("%s: SetCoreDeviceConfigurations is SUCCESS", fn);
+        if (capsDone && state.getDeviceCapsRespStatus) {
+          std::lock_guard<std::mutex> lock(state.deviceCapsMutex);
+          jobject capsInfo =
+              cacheDeviceCapsInfoLocked(env, state, caps.data());
+          if (capsInfo != NULL) {
+            env->DeleteLocalRef(capsInfo);
           }
-          goto end;
+          chip->getDeviceSnapshot().update(
+              deviceSnapshotKey(state), state.coreConfigTlvs,
+              state.coreConfigTlvLen, caps.data(), state.devCapInfoLen,
+              state.devCapInfoIds);
+        } else {
+          // Not fatal, the first capability query fetches them again.
+          JNI_TRACE_E("%s: capability prefetch failed", fn);
         }
+        goto end;
       }
+      JNI_TRACE_E("%s: device info %d or core config %d failed", fn, infoDone,
+                  configDone);
+      status = UWA_STATUS_FAILED;
     }
   }
 error:
-  JNI_TRACE_E("%s: device status is failed %d", fn, sDeviceState);
-  gIsUwaEnabled = false;
-  status = UWA_Disable(false); /* gracefull exit */
+  JNI_TRACE_E("%s: device status is failed %d", fn, state.deviceState);
+  state.isUwaEnabled = false;
+  status = stack.disable(false); /* gracefull exit */
   if (status == UWA_STATUS_OK) {
     JNI_TRACE_I("%s: UWA_Disable(false) SUCCESS %d", fn, status);
   } else {
     JNI_TRACE_E("%s: UWA_Disable(false) is failed %d", fn, status);
   }
-  theInstance.Finalize(false); // disable GKI, UCI task, UWB task
+  stack.close(false); // disable GKI, UCI task, UWB task
 end:
-  if (gIsUwaEnabled) {
-    sDeviceState = UWBS_STATUS_READY;
+  if (state.isUwaEnabled) {
+    state.deviceState = UWBS_STATUS_READY;
   }
+  state.initPhaseUs[UWB_INIT_PHASE_TOTAL] =
+      UwbJniStats::nowUs() - initStartUs;
   JNI_TRACE_I("%s: exit", fn);
-  return gIsUwaEnabled ? JNI_TRUE : JNI_FALSE;
+  return state.isUwaEnabled ? JNI_TRUE : JNI_FALSE;
 }
 
 /*******************************************************************************
@@ -893,33 +1165,40 @@ end:
 **                  of the UWB device.
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip to turn off.
 **
 ** Returns:         True if UWB device De-initialization is success.
 **
 *******************************************************************************/
-jboolean uwbNativeManager_doDeinitialize(JNIEnv *env, jobject obj) {
+jboolean uwbNativeManager_doDeinitialize(JNIEnv *env, jobject obj,
+                                         jint chipId) {
   static const char fn[] = "uwbNativeManager_doDeinitialize";
   UNUSED(fn);
   tUWA_STATUS status;
-  JNI_TRACE_I("%s: Enter", fn);
-  UwbAdaptation &theInstance = UwbAdaptation::GetInstance();
+  JNI_TRACE_I("%s: Enter; chip %d", fn, chipId);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return JNI_FALSE;
+  }
+  UwbChipState &state = chip->getState();
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is already De-initialized", fn);
     return JNI_TRUE;
   }
 
-  SyncEventGuard guard(sUwaDisableEvent);
-  status = UWA_Disable(true); /* gracefull exit */
+  SyncEventGuard guard(state.uwaDisableEvent);
+  status = chip->getStack().disable(true); /* gracefull exit */
   if (status == UWA_STATUS_OK) {
     JNI_TRACE_I("%s: wait for de-init completion:", fn);
-    sUwaDisableEvent.wait();
+    state.uwaDisableEvent.wait();
   } else {
     JNI_TRACE_E("%s: De-Init is failed:", fn);
   }
-  clearAllSessionContext();
-  gIsUwaEnabled = false;
-  theInstance.Finalize(true); // disable GKI, UCI task, UWB task
+  clearAllSessionContext(*chip);
+  releaseDeviceCapsCache(env, state);
+  state.isUwaEnabled = false;
+  chip->getStack().close(true); // disable GKI, UCI task, UWB task
   JNI_TRACE_I("%s: Exit", fn);
   return JNI_TRUE;
 }
@@ -931,16 +1210,22 @@ jboolean uwbNativeManager_doDeinitialize(JNIEnv *env, jobject obj) {
 ** Description:     retrieve the UWB device information etc.
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip to query.
 **
 ** Returns:         device info class object or NULL.
 **
 *******************************************************************************/
-jobject uwbNativeManager_getDeviceInfo(JNIEnv *env, jobject obj) {
+jobject uwbNativeManager_getDeviceInfo(JNIEnv *env, jobject obj, jint chipId) {
   static const char fn[] = "uwbNativeManager_getDeviceInfo";
   UNUSED(fn);
   JNI_TRACE_I("%s: Enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
 
-  if (!gIsUwaEnabled) {
+  deviceInfo_t deviceInfo;
+  if (!getKnownDeviceInfo(*chip, &deviceInfo)) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return NULL;
   }
@@ -956,10 +1241,10 @@ jobject uwbNativeManager_getDeviceInfo(JNIEnv *env, jobject obj) {
     return NULL;
   }
 
-  jint uciVersion = sUwbDeviceInfo.uciVersion;
-  jint uciTestVersion = sUwbDeviceInfo.uciTestVersion;
-  jint macVersion = sUwbDeviceInfo.macVersion;
-  jint phyVersion = sUwbDeviceInfo.phyVersion;
+  jint uciVersion = deviceInfo.uciVersion;
+  jint uciTestVersion = deviceInfo.uciTestVersion;
+  jint macVersion = deviceInfo.macVersion;
+  jint phyVersion = deviceInfo.phyVersion;
 
   JNI_TRACE_I("%s: Exit", fn);
 
@@ -974,42 +1259,46 @@ jobject uwbNativeManager_getDeviceInfo(JNIEnv *env, jobject obj) {
 ** Description:     retrieve the UWB device specific information etc.
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip to query.
 **
 ** Returns:         device info class object or NULL.
 **
 *******************************************************************************/
-jobject uwbNativeManager_getSpecificationInfo(JNIEnv *env, jobject obj) {
+jobject uwbNativeManager_getSpecificationInfo(JNIEnv *env, jobject obj,
+                                              jint chipId) {
   static const char fn[] = "uwbNativeManager_getSpecificationInfo";
   UNUSED(fn);
   JNI_TRACE_I("%s: Enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
 
-  if (!gIsUwaEnabled) {
+  deviceInfo_t deviceInfo;
+  if (!getKnownDeviceInfo(*chip, &deviceInfo)) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return NULL;
   }
 
-  const char *DEVICE_DATA_CLASS_NAME =
-      "com/android/server/uwb/info/UwbSpecificationInfo";
-  jclass deviceDataClass = env->FindClass(DEVICE_DATA_CLASS_NAME);
-  jmethodID constructor =
-      env->GetMethodID(deviceDataClass, "<init>", "(IIIIIIIIIIIIIIII)V");
+  jclass deviceDataClass = gUwbJniSymbols.specificationInfoClass;
+  jmethodID constructor = gUwbJniSymbols.specificationInfoCtor;
   if (constructor == JNI_NULL) {
     JNI_TRACE_E("%s: jni cannot find the method deviceInfoClass", fn);
     return NULL;
   }
 
-  jint uciMajor = (sUwbDeviceInfo.uciVersion & MSB_BITMASK);
-  jint uciMaintenance = (sUwbDeviceInfo.uciVersion >> 8) & 0x0F;
-  jint uciMinor = (sUwbDeviceInfo.uciVersion >> 12) & 0x0F;
-  jint macMajor = (sUwbDeviceInfo.macVersion & MSB_BITMASK);
-  jint macMaintenance = (sUwbDeviceInfo.macVersion >> 8) & 0x0F;
-  jint macMinor = (sUwbDeviceInfo.macVersion >> 12) & 0x0F;
-  jint phyMajor = (sUwbDeviceInfo.phyVersion & MSB_BITMASK);
-  jint phyMaintenance = (sUwbDeviceInfo.phyVersion >> 8) & 0x0F;
-  jint phyMinor = (sUwbDeviceInfo.phyVersion >> 12) & 0x0F;
-  jint uciTestMajor = (sUwbDeviceInfo.uciTestVersion) & MSB_BITMASK;
-  jint uciTestMaintenance = (sUwbDeviceInfo.uciTestVersion >> 8) & 0x0F;
-  jint uciTestMinor = (sUwbDeviceInfo.uciTestVersion >> 12) & 0x0F;
+  jint uciMajor = (deviceInfo.uciVersion & MSB_BITMASK);
+  jint uciMaintenance = (deviceInfo.uciVersion >> 8) & 0x0F;
+  jint uciMinor = (deviceInfo.uciVersion >> 12) & 0x0F;
+  jint macMajor = (deviceInfo.macVersion & MSB_BITMASK);
+  jint macMaintenance = (deviceInfo.macVersion >> 8) & 0x0F;
+  jint macMinor = (deviceInfo.macVersion >> 12) & 0x0F;
+  jint phyMajor = (deviceInfo.phyVersion & MSB_BITMASK);
+  jint phyMaintenance = (deviceInfo.phyVersion >> 8) & 0x0F;
+  jint phyMinor = (deviceInfo.phyVersion >> 12) & 0x0F;
+  jint uciTestMajor = (deviceInfo.uciTestVersion) & MSB_BITMASK;
+  jint uciTestMaintenance = (deviceInfo.uciTestVersion >> 8) & 0x0F;
+  jint uciTestMinor = (deviceInfo.uciTestVersion >> 12) & 0x0F;
 
   JNI_TRACE_I("%s: Exit", fn);
 
@@ -1029,34 +1318,52 @@ jobject uwbNativeManager_getSpecificationInfo(JNIEnv *env, jobject obj) {
 **
 ** Params :         env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip to query.
 **
 ** Returns:         device state.
 **
 *******************************************************************************/
-jint uwbNativeManager_getUwbDeviceState(JNIEnv *env, jobject obj) {
+jint uwbNativeManager_getUwbDeviceState(JNIEnv *env, jobject obj,
+                                        jint chipId) {
   static const char fn[] = "uwbNativeManager_getUwbDeviceState";
   UNUSED(fn);
-  eUWBS_DEVICE_STATUS_t sDeviceState = UWBS_STATUS_ERROR;
+  eUWBS_DEVICE_STATUS_t deviceState = UWBS_STATUS_ERROR;
   JNI_TRACE_I("%s: Enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return deviceState;
+  }
+  UwbChipState &state = chip->getState();
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
-    return sDeviceState;
+    return deviceState;
   }
 
+  UwbBufferLease coreConfig =
+      UwbBufferPool::getPacketPool().lease(UCI_MAX_PAYLOAD_SIZE);
+  if (!coreConfig.isValid()) {
+    return deviceState;
+  }
   tUWA_PMID configParam[] = {UCI_PARAM_ID_DEVICE_STATE};
-  SyncEventGuard guard(sUwaGetConfigEvent);
-  tUWA_STATUS status = UWA_GetCoreConfig(sizeof(configParam), configParam);
+  SyncEventGuard guard(state.uwaGetConfigEvent);
+  state.getCoreConfigLen = 0;
+  state.getCoreConfigDest = coreConfig.data();
+  state.getCoreConfigCapacity = coreConfig.size();
+  tUWA_STATUS status =
+      chip->getStack().getCoreConfig(sizeof(configParam), configParam);
   if (status == UWA_STATUS_OK) {
-    sUwaGetConfigEvent.wait(UWB_CMD_TIMEOUT);
-    if (sGetCoreConfigLen > 0) {
-      if (sGetCoreConfig[0] == UCI_PARAM_ID_DEVICE_STATE) {
-        sDeviceState = (eUWBS_DEVICE_STATUS_t)sGetCoreConfig[2];
+    state.uwaGetConfigEvent.wait(UWB_CMD_TIMEOUT);
+    if (state.getCoreConfigLen > 2) {
+      if (coreConfig.data()[0] == UCI_PARAM_ID_DEVICE_STATE) {
+        deviceState = (eUWBS_DEVICE_STATUS_t)coreConfig.data()[2];
       }
     }
   }
+  state.getCoreConfigDest = NULL;
+  state.getCoreConfigCapacity = 0;
   JNI_TRACE_I("%s: Exit", fn);
-  return sDeviceState;
+  return deviceState;
 }
 
 /*******************************************************************************
@@ -1067,12 +1374,13 @@ jint uwbNativeManager_getUwbDeviceState(JNIEnv *env, jobject obj) {
 **
 ** Params:          env: JVM environment.
 **                  obj: Java object.
+**                  chipId: chip to reset.
 **                  resetConfig: Manufacturer/Vendor Specific Reset Data
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-jbyte uwbNativeManager_deviceReset(JNIEnv *env, jobject obj,
+jbyte uwbNativeManager_deviceReset(JNIEnv *env, jobject obj, jint chipId,
                                    jbyte resetConfig) {
   static const char fn[] = "uwbNativeManager_deviceReset";
   UNUSED(fn);
@@ -1087,12 +1395,12 @@ jbyte uwbNativeManager_deviceReset(JNIEnv *env, jobject obj,
   // and SUS applet from ESE
   status = true; // true always
 #if 0
-  if(!gIsUwaEnabled) {
+  if(!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return UWA_STATUS_FAILED;
   }
 
-  status = UwbDeviceReset((uint8_t)resetConfig);
+  status = UwbDeviceReset(*getChip(fn, chipId), (uint8_t)resetConfig);
 #endif
   JNI_TRACE_I("%s: Exit", fn);
   return status ? UWA_STATUS_OK : UWA_STATUS_FAILED;
@@ -1106,32 +1414,43 @@ jbyte uwbNativeManager_deviceReset(JNIEnv *env, jobject obj,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-jbyte uwbNativeManager_sessionInit(JNIEnv *env, jobject o, jint sessionId,
-                                   jbyte sessionType) {
+jbyte uwbNativeManager_sessionInit(JNIEnv *env, jobject o, jint chipId,
+                                   jint sessionId, jbyte sessionType) {
   static const char fn[] = "uwbNativeManager_sessionInit";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: Enter", fn);
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return status;
   }
 
-  sSessionInitStatus = false;
-  SyncEventGuard guard(sUwaSessionInitEvent);
-  status = UWA_SendSessionInit(sessionId, sessionType);
-  if (UWA_STATUS_OK == status) {
-    sUwaSessionInitEvent.wait(UWB_CMD_TIMEOUT);
-  } else {
+  tUWB_CMD_RESULT result;
+  status = chip->getCommandPipeline().execute(
+      UWB_CMD_SESSION_INIT,
+      [&]() { return chip->getStack().sessionInit(sessionId, sessionType); },
+      &result);
+  if (UWA_STATUS_OK != status) {
     JNI_TRACE_E("%s: Session Init command is  failed", fn);
+    return UWA_STATUS_FAILED;
+  }
+  if (result.status == UWA_STATUS_OK &&
+      !chip->getSessionRegistry().add(sessionId)) {
+    JNI_TRACE_E("%s: no room for session %x in registry", fn, sessionId);
   }
 
   JNI_TRACE_I("%s: Exit", fn);
-  return (sSessionInitStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (result.status == UWA_STATUS_OK) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -1143,30 +1462,129 @@ jbyte uwbNativeManager_sessionInit(JNIEnv *env, jobject o, jint sessionId,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-jbyte uwbNativeManager_sessionDeInit(JNIEnv *env, jobject o, jint sessionId) {
+jbyte uwbNativeManager_sessionDeInit(JNIEnv *env, jobject o, jint chipId,
+                                     jint sessionId) {
   static const char fn[] = "uwbNativeManager_sessionDeInit";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: Enter", fn);
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return status;
   }
 
-  sSessionDeInitStatus = false;
-  SyncEventGuard guard(sUwaSessionDeInitEvent);
-  status = UWA_SendSessionDeInit(sessionId);
-  if (UWA_STATUS_OK == status) {
-    sUwaSessionDeInitEvent.wait(UWB_CMD_TIMEOUT);
-  } else {
+  chip->getSessionRegistry().invalidateAppConfig(sessionId);
+  tUWB_CMD_RESULT result;
+  status = chip->getCommandPipeline().execute(
+      UWB_CMD_SESSION_DEINIT,
+      [&]() { return chip->getStack().sessionDeInit(sessionId); }, &result);
+  if (UWA_STATUS_OK != status) {
     JNI_TRACE_E("%s: Session DeInit command is  failed", fn);
+    return UWA_STATUS_FAILED;
   }
   JNI_TRACE_I("%s: Exit", fn);
-  return (sSessionDeInitStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (result.status == UWA_STATUS_OK) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+}
+
+/* Build the UwbConfigStatusData returned by setAppConfigurations */
+static jobject newConfigStatusData(JNIEnv *env, uint8_t status,
+                                   uint8_t noOfIds, const uint8_t *data,
+                                   uint16_t len) {
+  jclass configStatusDataClass = gUwbJniSymbols.configStatusDataClass;
+  jmethodID constructor = gUwbJniSymbols.configStatusDataCtor;
+  if (constructor == JNI_NULL) {
+    JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", __func__);
+    return NULL;
+  }
+  jbyteArray appConfigArray = env->NewByteArray(len);
+  if (len > 0) {
+    env->SetByteArrayRegion(appConfigArray, 0, len, (jbyte *)data);
+  }
+  return env->NewObject(configStatusDataClass, constructor, status, noOfIds,
+                        appConfigArray);
+}
+
+/* Build the UwbTlvData returned by getAppConfigurations */
+static jobject newTlvData(JNIEnv *env, uint8_t status, uint8_t noOfIds,
+                          const uint8_t *data, uint16_t len) {
+  jclass tlvDataClass = gUwbJniSymbols.tlvDataClass;
+  jmethodID constructor = gUwbJniSymbols.tlvDataCtor;
+  if (constructor == JNI_NULL) {
+    JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", __func__);
+    return NULL;
+  }
+  jbyteArray appConfigArray = env->NewByteArray(len);
+  if (len > 0) {
+    env->SetByteArrayRegion(appConfigArray, 0, len, (jbyte *)data);
+  }
+  return env->NewObject(tlvDataClass, constructor, status, noOfIds,
+                        appConfigArray);
+}
+
+/*******************************************************************************
+**
+** Function:        applyAppConfigurations
+**
+** Description:     Send the app configs of a session that differ from the
+**                  ones already applied and update the cache.
+**
+** Params:          chip: chip of the session
+**                  sessionId: session of the app configs
+**                  noOfParams: number of TLVs in appConfigData
+**                  appConfigLen: length of appConfigData
+**                  appConfigData: app configs in TLV format
+**                  result: response, when nothing had to be sent the status
+**                  of the last set the UWBS answered for the session
+**
+** Returns:         UWA_STATUS_OK if the response was received, else
+**                  UWA_STATUS_FAILED
+**
+*******************************************************************************/
+static tUWA_STATUS applyAppConfigurations(UwbChipContext &chip,
+                                          uint32_t sessionId,
+                                          uint8_t noOfParams,
+                                          uint16_t appConfigLen,
+                                          uint8_t *appConfigData,
+                                          tUWB_CMD_RESULT *result) {
+  std::vector<uint8_t> delta;
+  uint8_t noOfChanged = 0;
+  uint8_t unchangedStatus = UWA_STATUS_FAILED;
+  uint8_t *sendData = appConfigData;
+  uint8_t sendParams = noOfParams;
+  uint16_t sendLen = appConfigLen;
+  if (chip.getSessionRegistry().filterAppConfig(
+          sessionId, appConfigData, appConfigLen, delta, &noOfChanged,
+          &unchangedStatus)) {
+    if (noOfChanged == 0) {
+      JNI_TRACE_I("%s: all app configs already applied", __func__);
+      result->status = unchangedStatus;
+      result->value = 0;
+      result->len = 0;
+      return UWA_STATUS_OK;
+    }
+    sendData = delta.data();
+    sendParams = noOfChanged;
+    sendLen = delta.size();
+  }
+  tUWA_STATUS status = setAppConfiguration(chip, sessionId, sendParams,
+                                           sendLen, sendData, result);
+  if (status == UWA_STATUS_OK && result->status == UWA_STATUS_OK) {
+    chip.getSessionRegistry().storeAppliedAppConfig(sessionId, sendData,
+                                                    sendLen, result->status);
+  } else {
+    chip.getSessionRegistry().invalidateAppConfig(sessionId);
+  }
+  return status;
 }
 
 /*******************************************************************************
@@ -1178,6 +1596,7 @@ jbyte uwbNativeManager_sessionDeInit(JNIEnv *env, jobject o, jint sessionId) {
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  sessionId: All APP configurations belonging to this Session
 *ID
 **                  noOfParams : The number of APP Configuration fields to
@@ -1189,46 +1608,45 @@ jbyte uwbNativeManager_sessionDeInit(JNIEnv *env, jobject o, jint sessionId) {
 **
 *******************************************************************************/
 jobject uwbNativeManager_setAppConfigurations(JNIEnv *env, jobject o,
-                                                 jint sessionId,
-                                                 jint noOfParams,
-                                                 jint appConfigLen,
-                                                 jbyteArray AppConfig) {
+                                              jint chipId, jint sessionId,
+                                              jint noOfParams,
+                                              jint appConfigLen,
+                                              jbyteArray AppConfig) {
   static const char fn[] = "uwbNativeManager_setAppConfigurations";
   UNUSED(fn);
-  uint8_t *appConfigData = NULL;
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: Enter", fn);
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return NULL;
   }
+  if (appConfigLen < 0 || appConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: invalid app config length %d", fn, appConfigLen);
+    return NULL;
+  }
 
-  appConfigData = (uint8_t *)malloc(sizeof(uint8_t) * appConfigLen);
-  if (appConfigData != NULL) {
-      memset(appConfigData, 0, (sizeof(uint8_t) * appConfigLen));
-      env->GetByteArrayRegion(AppConfig, 0, appConfigLen, (jbyte *)appConfigData);
+  UwbBufferLease appConfigData =
+      UwbBufferPool::getPacketPool().lease(appConfigLen);
+  if (appConfigData.isValid()) {
+      env->GetByteArrayRegion(AppConfig, 0, appConfigLen,
+                              (jbyte *)appConfigData.data());
       JNI_TRACE_I("%d: appConfigLen", appConfigLen);
-      status =
-          setAppConfiguration(sessionId, noOfParams, appConfigLen, appConfigData);
-      free(appConfigData);
-      if (sSetAppConfigRespStatus) {
-          const char *UWB_CONFIG_STATUS_DATA =
-                  "com/android/server/uwb/data/UwbConfigStatusData";
-          jclass configStatusDataClass = env->FindClass(UWB_CONFIG_STATUS_DATA);
-          jmethodID constructor =
-              env->GetMethodID(configStatusDataClass, "<init>", "(II[B)V");
-          if (constructor == JNI_NULL) {
-            JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", fn);
-            return NULL;
-          }
-          jbyteArray appConfigArray =
-              env->NewByteArray(sSetAppConfigLen);
-          env->SetByteArrayRegion(appConfigArray, 0, sSetAppConfigLen,
-                                  (jbyte *)&sSetAppConfig[0]);
-          return env->NewObject(configStatusDataClass, constructor, sSetAppConfigStatus, sNoOfAppConfigIds, appConfigArray);
+      tUWB_CMD_RESULT result;
+      status = applyAppConfigurations(*chip, sessionId, noOfParams,
+                                      appConfigLen, appConfigData.data(),
+                                      &result);
+      appConfigData.release();
+      if (status == UWA_STATUS_OK) {
+          return newConfigStatusData(env, result.status, result.value,
+                                     result.data, result.len);
       } else {
           JNI_TRACE_E("%s: Failed setAppConfigurations, Status = %d", fn,
-                    sSetAppConfigRespStatus);
+                    status);
       }
   } else {
     JNI_TRACE_E("%s: Unable to Allocate Memory", fn);
@@ -1245,19 +1663,23 @@ jobject uwbNativeManager_setAppConfigurations(JNIEnv *env, jobject o,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  rawUci: Uci data to send to controller
 **                  cmdLen: uci data lentgh
 **
 ** Returns:         Returns byte array for raw uci rsp
 **
 *******************************************************************************/
-jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o,
-                                       jint gid, jint oid,
-                                       jbyteArray rawUci) {
+jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o, jint chipId,
+                                    jint gid, jint oid, jbyteArray rawUci) {
   static const char fn[] = "uwbNativeManager_sendRawUci";
   UNUSED(fn);
   JNI_TRACE_I("%s: enter; ", fn);
-  uint8_t *cmd = NULL;
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   jint cmdLen = env->GetArrayLength(rawUci);
   if (cmdLen > UCI_MAX_PAYLOAD_SIZE) {
@@ -1266,37 +1688,35 @@ jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o,
     return NULL;
   }
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return NULL;
   }
 
-  cmd = (uint8_t *)malloc(sizeof(uint8_t) * cmdLen);
-  if (cmd == NULL) {
-    JNI_TRACE_E("%s: malloc failure for raw cmd", __func__);
+  UwbBufferPool &pool = UwbBufferPool::getPacketPool();
+  UwbBufferLease cmd = pool.lease(cmdLen);
+  UwbBufferLease rsp = pool.lease(UCI_MAX_PAYLOAD_SIZE);
+  if (!cmd.isValid() || !rsp.isValid()) {
+    JNI_TRACE_E("%s: no buffer for raw cmd", __func__);
     return NULL;
   }
-  memset(cmd, 0, (sizeof(uint8_t) * cmdLen));
-  env->GetByteArrayRegion(rawUci, 0, cmdLen, (jbyte *)cmd);
+  env->GetByteArrayRegion(rawUci, 0, cmdLen, (jbyte *)cmd.data());
 
-  status = sendRawUci(gid, oid, cmd, cmdLen);
-  free(cmd);
+  uint16_t rspLen = 0;
+  status = sendRawUci(*chip, gid, oid, cmd.data(), cmdLen, rsp.data(),
+                      UCI_MAX_PAYLOAD_SIZE, &rspLen);
+  cmd.release();
 
-  const char *UWB_VENDOR_RES_DATA =
-          "com/android/server/uwb/data/UwbVendorUciResponse";
-  jclass resDataClass = env->FindClass(UWB_VENDOR_RES_DATA);
-  jmethodID constructor =
-      env->GetMethodID(resDataClass, "<init>", "(BII[B)V");
+  jclass resDataClass = gUwbJniSymbols.vendorUciResponseClass;
+  jmethodID constructor = gUwbJniSymbols.vendorUciResponseCtor;
   if (constructor == JNI_NULL) {
     JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", fn);
     return NULL;
   }
   JNI_TRACE_I("%s: exit sendRawUCi= 0x%x", __func__, status);
   if (status == UWA_STATUS_OK) {
-     jbyteArray rawResArray =
-         env->NewByteArray(sSendRawResLen);
-     env->SetByteArrayRegion(rawResArray, 0, sSendRawResLen,
-                             (jbyte *)&sSendRawResData[0]);
+     jbyteArray rawResArray = env->NewByteArray(rspLen);
+     env->SetByteArrayRegion(rawResArray, 0, rspLen, (jbyte *)rsp.data());
      return env->NewObject(resDataClass, constructor, status, gid, oid, rawResArray);
   } else {
      return env->NewObject(resDataClass, constructor, status, gid, oid, NULL);
@@ -1304,6 +1724,141 @@ jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o,
 
 }
 
+/* Address of a direct ByteBuffer holding at least len bytes, NULL otherwise */
+static uint8_t *getDirectBuffer(JNIEnv *env, jobject buffer, jlong len) {
+  if (buffer == NULL) {
+    return NULL;
+  }
+  uint8_t *address = (uint8_t *)env->GetDirectBufferAddress(buffer);
+  if (address == NULL || env->GetDirectBufferCapacity(buffer) < len) {
+    JNI_TRACE_E("%s: not a direct buffer of %d bytes", __func__, (int)len);
+    return NULL;
+  }
+  return address;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setAppConfigurationsDirect()
+**
+** Description:     Same as uwbNativeManager_setAppConfigurations with the
+**                  app configs read from and the response written to direct
+**                  ByteBuffers owned by the caller, so no Java array or
+**                  object is created per call.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session of the app configs
+**                  noOfParams: number of TLVs in appConfig
+**                  appConfigLen: length of the TLVs in appConfig
+**                  appConfig: direct ByteBuffer with the TLVs
+**                  rsp: direct ByteBuffer receiving status, number of config
+**                  status entries and the entries
+**
+** Returns:         Bytes written to rsp, -1 on failure
+**
+*******************************************************************************/
+jint uwbNativeManager_setAppConfigurationsDirect(JNIEnv *env, jobject o,
+                                                 jint chipId, jint sessionId,
+                                                 jint noOfParams,
+                                                 jint appConfigLen,
+                                                 jobject appConfig,
+                                                 jobject rsp) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return -1;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return -1;
+  }
+  if (appConfigLen <= 0 || appConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: invalid appConfigLen %d", __func__, appConfigLen);
+    return -1;
+  }
+  uint8_t *appConfigData = getDirectBuffer(env, appConfig, appConfigLen);
+  uint8_t *rspData = getDirectBuffer(env, rsp, 2);
+  if (appConfigData == NULL || rspData == NULL) {
+    return -1;
+  }
+
+  tUWB_CMD_RESULT result;
+  if (applyAppConfigurations(*chip, sessionId, noOfParams, appConfigLen,
+                             appConfigData, &result) != UWA_STATUS_OK) {
+    JNI_TRACE_E("%s: Failed setAppConfigurations", __func__);
+    return -1;
+  }
+  if (env->GetDirectBufferCapacity(rsp) < 2 + result.len) {
+    JNI_TRACE_E("%s: response of %d bytes does not fit", __func__,
+                2 + result.len);
+    return -1;
+  }
+  rspData[0] = result.status;
+  rspData[1] = result.value;
+  memcpy(&rspData[2], result.data, result.len);
+  return 2 + result.len;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_sendRawUciDirect()
+**
+** Description:     Same as uwbNativeManager_sendRawUci with the payload read
+**                  from and the response payload written to direct
+**                  ByteBuffers owned by the caller. The command is built
+**                  straight from cmd and the response callback copies into
+**                  rsp, without intermediate buffers or Java objects.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  gid: group id
+**                  oid: opcode id
+**                  cmd: direct ByteBuffer with the payload
+**                  cmdLen: payload length
+**                  rsp: direct ByteBuffer receiving the response payload
+**
+** Returns:         Bytes written to rsp, -1 on failure
+**
+*******************************************************************************/
+jint uwbNativeManager_sendRawUciDirect(JNIEnv *env, jobject o, jint chipId,
+                                       jint gid, jint oid, jobject cmd,
+                                       jint cmdLen, jobject rsp) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return -1;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return -1;
+  }
+  if (cmdLen < 0 || cmdLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: CmdLen %d is beyond max allowed range %d", __func__,
+                cmdLen, UCI_MAX_PAYLOAD_SIZE);
+    return -1;
+  }
+  uint8_t *cmdData = getDirectBuffer(env, cmd, cmdLen);
+  uint8_t *rspData = getDirectBuffer(env, rsp, 0);
+  if (cmdData == NULL || rspData == NULL) {
+    return -1;
+  }
+  jlong rspCapacity = env->GetDirectBufferCapacity(rsp);
+  if (rspCapacity > UCI_MAX_PAYLOAD_SIZE) {
+    rspCapacity = UCI_MAX_PAYLOAD_SIZE;
+  }
+
+  uint16_t rspLen = 0;
+  if (sendRawUci(*chip, gid, oid, cmdData, cmdLen, rspData, rspCapacity,
+                 &rspLen) != UWA_STATUS_OK) {
+    JNI_TRACE_E("%s: Failed sendRawUci", __func__);
+    return -1;
+  }
+  return rspLen;
+}
+
 /*******************************************************************************
 **
 ** Function:        uwbNativeManager_getAppConfigurations
@@ -1312,6 +1867,7 @@ jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  session id : Session Id for the given set of App params
 **                  noOfParams: Number of Params
 **                  appConfigLen: Total App config Lentgh
@@ -1321,50 +1877,59 @@ jobject uwbNativeManager_sendRawUci(JNIEnv *env, jobject o,
 **
 *******************************************************************************/
 jobject uwbNativeManager_getAppConfigurations(JNIEnv *env, jobject o,
-                                                 jint sessionId,
-                                                 jint noOfParams,
-                                                 jint appConfigLen,
-                                                 jbyteArray AppConfig) {
+                                              jint chipId, jint sessionId,
+                                              jint noOfParams,
+                                              jint appConfigLen,
+                                              jbyteArray AppConfig) {
   static const char fn[] = "uwbNativeManager_getAppConfigurations";
   UNUSED(fn);
-  tUWA_STATUS status;
-  uint8_t *appConfigData = NULL;
   JNI_TRACE_I("%s: Enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return NULL;
   }
+  if (appConfigLen < 0 || appConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: invalid app config length %d", fn, appConfigLen);
+    return NULL;
+  }
 
-  sGetAppConfigRespStatus = false;
-  appConfigData = (uint8_t *)malloc(sizeof(uint8_t) * appConfigLen);
-  if (appConfigData != NULL) {
-      memset(appConfigData, 0, (sizeof(uint8_t) * appConfigLen));
-      env->GetByteArrayRegion(AppConfig, 0, appConfigLen, (jbyte *)appConfigData);
-      SyncEventGuard guard(sUwaGetAppConfigEvent);
-      status =
-          UWA_GetAppConfig(sessionId, noOfParams, appConfigLen, appConfigData);
-      free(appConfigData);
-      if (status == UWA_STATUS_OK) {
-          sUwaGetAppConfigEvent.wait(UWB_CMD_TIMEOUT);
-          if (sGetAppConfigRespStatus) {
-              const char *UWB_TLV_DATA =
-                 "com/android/server/uwb/data/UwbTlvData";
-              jclass tlvDataClass = env->FindClass(UWB_TLV_DATA);
-              jmethodID constructor =
-                env->GetMethodID(tlvDataClass, "<init>", "(II[B)V");
-               if (constructor == JNI_NULL) {
-                   JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", fn);
-                   return NULL;
+  UwbBufferLease appConfigData =
+      UwbBufferPool::getPacketPool().lease(appConfigLen);
+  if (appConfigData.isValid()) {
+      env->GetByteArrayRegion(AppConfig, 0, appConfigLen,
+                              (jbyte *)appConfigData.data());
+      std::vector<uint8_t> cached;
+      if (chip->getSessionRegistry().lookupAppConfig(
+              sessionId, appConfigData.data(), appConfigLen, cached)) {
+        JNI_TRACE_I("%s: served from app config cache", fn);
+        return newTlvData(env, UWA_STATUS_OK, noOfParams, cached.data(),
+                          cached.size());
+      }
+      tUWB_CMD_RESULT result;
+      std::shared_ptr<UwbCommandRequest> request =
+          chip->getCommandPipeline().submit(UWB_CMD_GET_APP_CONFIG, [&]() {
+            return chip->getStack().getAppConfig(sessionId, noOfParams,
+                                                 appConfigLen,
+                                                 appConfigData.data());
+          });
+      appConfigData.release();
+      if (request != nullptr) {
+          if (chip->getCommandPipeline().wait(request, UWB_CMD_TIMEOUT,
+                                              &result)) {
+               if (result.status == UWA_STATUS_OK) {
+                 chip->getSessionRegistry().storeAppConfig(
+                     sessionId, result.data, result.len);
                }
-               jbyteArray appConfigArray =
-                   env->NewByteArray(sGetAppConfigLen);
-               env->SetByteArrayRegion(appConfigArray, 0, sGetAppConfigLen,
-                                  (jbyte *)&sGetAppConfig[0]);
-               return env->NewObject(tlvDataClass, constructor, sGetAppConfigStatus, sNoOfAppConfigIds, appConfigArray);
+               return newTlvData(env, result.status, result.value,
+                                 result.data, result.len);
           } else {
-               JNI_TRACE_E("%s: Failed getAppConfigurations, Status = %d", fn,
-                      sGetAppConfigRespStatus);
+               JNI_TRACE_E("%s: Failed getAppConfigurations, no response", fn);
           }
       } else {
         JNI_TRACE_E("%s: Failed UWA_GetAppConfig", fn);
@@ -1385,30 +1950,37 @@ jobject uwbNativeManager_getAppConfigurations(JNIEnv *env, jobject o,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  sessionId :  Session ID for which ranging shall start
 **
 ** Returns:         If Success UWA_STATUS_OK  else UWA_STATUS_FAILED
 **
 *******************************************************************************/
-jbyte uwbNativeManager_startRanging(JNIEnv *env, jobject obj, jint sessionId) {
+jbyte uwbNativeManager_startRanging(JNIEnv *env, jobject obj, jint chipId,
+                                    jint sessionId) {
   static const char fn[] = "uwbNativeManager_startRanging";
   UNUSED(fn);
-  tUWA_STATUS status = UWA_STATUS_FAILED;
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
+  tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: enter", fn);
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not enabled", fn);
     return status;
   }
 
-  sRangeStartStatus = false;
-  SyncEventGuard guard(sUwaRngStartEvent);
-  status = UWA_StartRangingSession(sessionId);
-  if (status == UWA_STATUS_OK) {
-    sUwaRngStartEvent.wait(UWB_CMD_TIMEOUT);
-  }
+  tUWB_CMD_RESULT result;
+  status = chip->getCommandPipeline().execute(
+      UWB_CMD_RANGE_START,
+      [&]() { return chip->getStack().startRanging(sessionId); }, &result);
   JNI_TRACE_I("%s: exit", fn);
-  return (sRangeStartStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (status == UWA_STATUS_OK && result.status == UWA_STATUS_OK)
+             ? UWA_STATUS_OK
+             : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -1419,31 +1991,40 @@ jbyte uwbNativeManager_startRanging(JNIEnv *env, jobject obj, jint sessionId) {
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  sessionId :  Session ID for which ranging shall start
 **
 ** Returns:         UWA_STATUS_OK if ranging session stop is success.
 **
 *******************************************************************************/
-jbyte uwbNativeManager_stopRanging(JNIEnv *env, jobject obj, jint sessionId) {
+jbyte uwbNativeManager_stopRanging(JNIEnv *env, jobject obj, jint chipId,
+                                   jint sessionId) {
   static const char fn[] = "uwbNativeManager_stopRanging";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: enter", fn);
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not enabled", fn);
     return status;
   }
 
-  sRangeStopStatus = false;
-  SyncEventGuard guard(sUwaRngStopEvent);
-  status = UWA_StopRangingSession(sessionId);
-  if (status == UWA_STATUS_OK) {
-    sUwaRngStopEvent.wait(UWB_CMD_TIMEOUT);
-  } else {
+  tUWB_CMD_RESULT result;
+  status = chip->getCommandPipeline().execute(
+      UWB_CMD_RANGE_STOP,
+      [&]() { return chip->getStack().stopRanging(sessionId); },
+      &result);
+  if (status != UWA_STATUS_OK) {
     JNI_TRACE_E("%s: Stop ranging is failed  error:%x:", fn, status);
   }
   JNI_TRACE_I("%s: exit", fn);
-  return (sRangeStopStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (status == UWA_STATUS_OK && result.status == UWA_STATUS_OK)
+             ? UWA_STATUS_OK
+             : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -1454,31 +2035,37 @@ jbyte uwbNativeManager_stopRanging(JNIEnv *env, jobject obj, jint sessionId) {
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **
 ** Returns:         session count on success
 **
 *******************************************************************************/
-jbyte uwbNativeManager_getSessionCount(JNIEnv *env, jobject obj) {
+jbyte uwbNativeManager_getSessionCount(JNIEnv *env, jobject obj, jint chipId) {
   static const char fn[] = "uwbNativeManager_getSessionCount";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return -1;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status;
-  sSessionCount = -1;
+  state.sessionCount = -1;
   JNI_TRACE_I("%s: Enter", fn);
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
-    return sSessionCount;
+    return state.sessionCount;
   }
 
-  SyncEventGuard guard(sUwaGetSessionCountEvent);
-  status = UWA_GetSessionCount();
+  SyncEventGuard guard(state.uwaGetSessionCountEvent);
+  status = chip->getStack().getSessionCount();
   if (UWA_STATUS_OK == status) {
-    sUwaGetSessionCountEvent.wait(UWB_CMD_TIMEOUT);
+    state.uwaGetSessionCountEvent.wait(UWB_CMD_TIMEOUT);
   } else {
     JNI_TRACE_E("%s: get session count command is  failed", fn);
   }
   JNI_TRACE_I("%s: Exit", fn);
-  return sSessionCount;
+  return state.sessionCount;
 }
 
 jint uwbNativeManager_getMaxSessionNumber(JNIEnv *env, jobject obj) {
@@ -1488,9 +2075,14 @@ jint uwbNativeManager_getMaxSessionNumber(JNIEnv *env, jobject obj) {
   return 5;
 }
 
-jbyte uwbNativeManager_resetDevice(JNIEnv *env, jbyte resetConfig) {
+jbyte uwbNativeManager_resetDevice(JNIEnv *env, jobject o, jint chipId,
+                                   jbyte resetConfig) {
   static const char fn[] = "uwbNativeManager_resetDevice";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
 
   return UWA_STATUS_OK;
 }
@@ -1503,32 +2095,36 @@ jbyte uwbNativeManager_resetDevice(JNIEnv *env, jbyte resetConfig) {
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  sessionId :  Session ID for which to get the session status
 **
 ** Returns:         current session status if UWb_STATUS_OK else returns
 **                  UWA_STATUS_FAILED.
 **
 *******************************************************************************/
-jbyte uwbNativeManager_getSessionState(JNIEnv *env, jobject obj,
+jbyte uwbNativeManager_getSessionState(JNIEnv *env, jobject obj, jint chipId,
                                        jint sessionId) {
   static const char fn[] = "uwbNativeManager_getSessionState";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWB_UNKNOWN_SESSION;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status;
   JNI_TRACE_I("%s: enter", fn);
-  sSessionState = UWB_UNKNOWN_SESSION;
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not enabled", fn);
-    return sSessionState;
+    return UWB_UNKNOWN_SESSION;
   }
 
-  SyncEventGuard guard(sUwaGetSessionStatusEvent);
-  status = UWA_GetSessionStatus(sessionId);
-  if (status == UWA_STATUS_OK) {
-    sUwaGetSessionStatusEvent.wait(UWB_CMD_TIMEOUT);
-  }
+  tUWB_CMD_RESULT result;
+  status = chip->getCommandPipeline().execute(
+      UWB_CMD_GET_SESSION_STATE,
+      [&]() { return chip->getStack().getSessionStatus(sessionId); }, &result);
   JNI_TRACE_I("%s: exit", fn);
-  return sSessionState;
+  return (status == UWA_STATUS_OK) ? result.value : UWB_UNKNOWN_SESSION;
 }
 
 /*******************************************************************************
@@ -1539,6 +2135,7 @@ jbyte uwbNativeManager_getSessionState(JNIEnv *env, jobject obj,
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  sessionId: Session Id to which update the list
 **                  action: Required Action to be taken
 **                  noOfControlees: Number of Responders
@@ -1549,16 +2146,22 @@ jbyte uwbNativeManager_getSessionState(JNIEnv *env, jobject obj,
 **
 *******************************************************************************/
 jbyte uwbNativeManager_ControllerMulticastListUpdate(
-    JNIEnv *env, jobject o, jint sessionId, jbyte action, jbyte noOfControlees,
-    jshortArray shortAddressList, jintArray subSessionIdList) {
+    JNIEnv *env, jobject o, jint chipId, jint sessionId, jbyte action,
+    jbyte noOfControlees, jshortArray shortAddressList,
+    jintArray subSessionIdList) {
   static const char fn[] = "uwbNativeManager_ControllerMulticastListUpdate";
   UNUSED(fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
-  uint16_t *shortAddressArray = NULL;
-  uint32_t *subSessionIdArray = NULL;
+  uint16_t shortAddressArray[MAX_NUM_CONTROLLEES];
+  uint32_t subSessionIdArray[MAX_NUM_CONTROLLEES];
   JNI_TRACE_E("%s: enter; ", fn);
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return status;
   }
@@ -1567,48 +2170,236 @@ jbyte uwbNativeManager_ControllerMulticastListUpdate(
     JNI_TRACE_E("%s: subSessionIdList or shortAddressList value is NULL", fn);
     return status;
   }
-  uint8_t shortAddressLen = env->GetArrayLength(shortAddressList);
-  uint8_t subSessionIdLen = env->GetArrayLength(subSessionIdList);
-  if (noOfControlees > MAX_NUM_CONTROLLEES) {
+  jsize shortAddressLen = env->GetArrayLength(shortAddressList);
+  jsize subSessionIdLen = env->GetArrayLength(subSessionIdList);
+  if (noOfControlees > MAX_NUM_CONTROLLEES ||
+      shortAddressLen > MAX_NUM_CONTROLLEES ||
+      subSessionIdLen > MAX_NUM_CONTROLLEES) {
     JNI_TRACE_E("%s: no Of Controlees %d exceeded than %d ", fn,
                 shortAddressLen, MAX_NUM_CONTROLLEES);
     return status;
   }
 
   if ((shortAddressLen > 0) && (subSessionIdLen > 0)) {
-    shortAddressArray = (uint16_t *)malloc(shortAddressLen);
-    if (shortAddressArray == NULL) {
-      JNI_TRACE_E("%s: malloc failure for shortAddressArray", fn);
-      return status;
-    }
-    memset(shortAddressArray, 0, shortAddressLen);
+    memset(shortAddressArray, 0, sizeof(shortAddressArray));
     env->GetShortArrayRegion(shortAddressList, 0, shortAddressLen,
                             (jshort *)shortAddressArray);
-
-    subSessionIdArray = (uint32_t *)malloc(SESSION_ID_LEN * subSessionIdLen);
-    if (subSessionIdArray == NULL) {
-      free(shortAddressArray);
-      JNI_TRACE_E("%s: malloc failure for subSessionIdArray", fn);
-      return status;
-    }
-    memset(subSessionIdArray, 0, (SESSION_ID_LEN * subSessionIdLen));
+    memset(subSessionIdArray, 0, sizeof(subSessionIdArray));
     env->GetIntArrayRegion(subSessionIdList, 0, subSessionIdLen,
                            (jint *)subSessionIdArray);
 
-    sMulticastListUpdateStatus = false;
-    SyncEventGuard guard(sUwaMulticastListUpdateEvent);
-    status = UWA_ControllerMulticastListUpdate(
-        sessionId, action, noOfControlees, shortAddressArray, subSessionIdArray);
-    if (status == UWA_STATUS_OK) {
-      sUwaMulticastListUpdateEvent.wait(UWB_CMD_TIMEOUT);
+    tUWB_CMD_RESULT result;
+    status = chip->getCommandPipeline().execute(
+        UWB_CMD_MC_LIST_UPDATE,
+        [&]() {
+          return chip->getStack().multicastListUpdate(
+              sessionId, action, noOfControlees, shortAddressArray,
+              subSessionIdArray);
+        },
+        &result);
+    if (status == UWA_STATUS_OK && result.status != UWA_STATUS_OK) {
+      status = UWA_STATUS_FAILED;
     }
-    free(shortAddressArray);
-    free(subSessionIdArray);
   } else {
     JNI_TRACE_E("%s: controleeListArray length is not valid", fn);
   }
   JNI_TRACE_I("%s: exit", fn);
-  return (sMulticastListUpdateStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (status == UWA_STATUS_OK) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+}
+
+/* Multicast list update of up to MAX_NUM_CONTROLLEES with the same action */
+struct ControleeChunk {
+  size_t first; // index in the update
+  uint8_t action;
+  uint8_t count;
+  uint16_t shortAddresses[MAX_NUM_CONTROLLEES];
+  uint32_t subSessionIds[MAX_NUM_CONTROLLEES];
+  std::shared_ptr<UwbCommandRequest> request;
+};
+
+/*******************************************************************************
+**
+** Function:        updateControlees
+**
+** Description:     Send an update of the controlee registry in chunks the
+**                  controller accepts. All chunks are pipelined. Statuses of
+**                  rejected chunks are posted to the notification dispatcher
+**                  and merged there like those of the multicast list
+**                  notifications, so the report reaches Java on one thread.
+**
+** Params:          chip: chip of the session.
+**                  sessionId: session to update.
+**                  ops: operations, consecutive ones with the same action
+**                  share chunks.
+**
+** Returns:         UWA_STATUS_OK if every chunk was accepted
+**
+*******************************************************************************/
+static tUWA_STATUS updateControlees(UwbChipContext &chip, uint32_t sessionId,
+                                    const std::vector<tUWB_CONTROLEE_OP> &ops) {
+  UwbControleeRegistry &registry = chip.getControleeRegistry();
+  if (ops.empty()) {
+    return UWA_STATUS_OK;
+  }
+  registry.beginUpdate(sessionId, ops);
+
+  std::vector<ControleeChunk> chunks;
+  for (size_t i = 0; i < ops.size();) {
+    chunks.emplace_back();
+    ControleeChunk &chunk = chunks.back();
+    chunk.first = i;
+    chunk.action = ops[i].action;
+    chunk.count = 0;
+    while (i < ops.size() && ops[i].action == chunk.action &&
+           chunk.count < MAX_NUM_CONTROLLEES) {
+      chunk.shortAddresses[chunk.count] = ops[i].shortAddress;
+      chunk.subSessionIds[chunk.count] = ops[i].subSessionId;
+      chunk.count++;
+      i++;
+    }
+  }
+  for (auto &chunk : chunks) {
+    chunk.request =
+        chip.getCommandPipeline().submit(UWB_CMD_MC_LIST_UPDATE, [&]() {
+          return chip.getStack().multicastListUpdate(
+              sessionId, chunk.action, chunk.count, chunk.shortAddresses,
+              chunk.subSessionIds);
+        });
+  }
+
+  tUWA_STATUS status = UWA_STATUS_OK;
+  for (auto &chunk : chunks) {
+    tUWB_CMD_RESULT result;
+    uint8_t chunkStatus = UWA_STATUS_FAILED;
+    if (chunk.request != nullptr &&
+        chip.getCommandPipeline().wait(chunk.request, UWB_CMD_TIMEOUT,
+                                       &result)) {
+      chunkStatus = result.status;
+    }
+    if (chunkStatus == UWA_STATUS_OK) {
+      continue;
+    }
+    status = UWA_STATUS_FAILED;
+    chip.getDispatcher().postControleeChunkFailed(
+        sessionId, &ops[chunk.first], chunk.count, chunkStatus);
+  }
+  return status;
+}
+
+/* Read parallel controlee arrays, subSessionIdList may be NULL */
+static bool readControlees(JNIEnv *env, jshortArray shortAddressList,
+                           jintArray subSessionIdList, uint8_t action,
+                           std::vector<tUWB_CONTROLEE_OP> &ops) {
+  if (shortAddressList == NULL) {
+    return false;
+  }
+  jsize count = env->GetArrayLength(shortAddressList);
+  if (subSessionIdList != NULL &&
+      env->GetArrayLength(subSessionIdList) != count) {
+    return false;
+  }
+  std::vector<jshort> shortAddresses(count);
+  std::vector<jint> subSessionIds(count, 0);
+  env->GetShortArrayRegion(shortAddressList, 0, count, shortAddresses.data());
+  if (subSessionIdList != NULL) {
+    env->GetIntArrayRegion(subSessionIdList, 0, count, subSessionIds.data());
+  }
+  ops.resize(count);
+  for (jsize i = 0; i < count; i++) {
+    ops[i].shortAddress = (uint16_t)shortAddresses[i];
+    ops[i].subSessionId = (uint32_t)subSessionIds[i];
+    ops[i].action = action;
+    ops[i].status = UWB_MC_LIST_STATUS_PENDING;
+  }
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_controllerMulticastListBulkUpdate
+**
+** Description:     Add or delete any number of controlees of a session. The
+**                  list is split into chunks the controller accepts and a
+**                  single UwbMulticastListUpdateStatus reports all of them.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session to update.
+**                  action: UWB_MC_LIST_ACTION_ADD or _DELETE.
+**                  shortAddressList: short address of each controlee.
+**                  subSessionIdList: sub session of each controlee, or null.
+**
+** Returns:         UWA_STATUS_OK if every chunk was accepted
+**
+*******************************************************************************/
+jbyte uwbNativeManager_controllerMulticastListBulkUpdate(
+    JNIEnv *env, jobject o, jint chipId, jint sessionId, jbyte action,
+    jshortArray shortAddressList, jintArray subSessionIdList) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return UWA_STATUS_FAILED;
+  }
+  if (action != UWB_MC_LIST_ACTION_ADD &&
+      action != UWB_MC_LIST_ACTION_DELETE) {
+    JNI_TRACE_E("%s: invalid action %d", __func__, action);
+    return UWA_STATUS_FAILED;
+  }
+  std::vector<tUWB_CONTROLEE_OP> ops;
+  if (!readControlees(env, shortAddressList, subSessionIdList, action, ops)) {
+    JNI_TRACE_E("%s: invalid controlee list", __func__);
+    return UWA_STATUS_FAILED;
+  }
+  return updateControlees(*chip, sessionId, ops);
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setControleeList
+**
+** Description:     Make the controlees of a session the given set. Only the
+**                  controlees that differ from the confirmed members are
+**                  deleted or added, see uwbNativeManager_
+**                  controllerMulticastListBulkUpdate for the reporting.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session to update.
+**                  shortAddressList: short address of each controlee.
+**                  subSessionIdList: sub session of each controlee, or null.
+**
+** Returns:         UWA_STATUS_OK if every chunk was accepted
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setControleeList(JNIEnv *env, jobject o, jint chipId,
+                                        jint sessionId,
+                                        jshortArray shortAddressList,
+                                        jintArray subSessionIdList) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return UWA_STATUS_FAILED;
+  }
+  std::vector<tUWB_CONTROLEE_OP> desired;
+  if (!readControlees(env, shortAddressList, subSessionIdList,
+                      UWB_MC_LIST_ACTION_ADD, desired)) {
+    JNI_TRACE_E("%s: invalid controlee list", __func__);
+    return UWA_STATUS_FAILED;
+  }
+  std::vector<tUWB_CONTROLEE_OP> ops;
+  chip->getControleeRegistry().diff(sessionId, desired.data(), desired.size(),
+                                    ops);
+  return updateControlees(*chip, sessionId, ops);
 }
 
 /*******************************************************************************
@@ -1619,19 +2410,25 @@ jbyte uwbNativeManager_ControllerMulticastListUpdate(
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **                  countryCode: ISO country code
 **
 ** Returns:         UFA_STATUS_OK on success or UFA_STATUS_FAILED on failure
 **
 *******************************************************************************/
-jbyte uwbNativeManager_SetCountryCode(JNIEnv *env, jobject o,
+jbyte uwbNativeManager_SetCountryCode(JNIEnv *env, jobject o, jint chipId,
                                       jbyteArray countryCode) {
   static const char fn[] = "uwbNativeManager_SetCountryCode";
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
   tUWA_STATUS status = UWA_STATUS_FAILED;
-  uint8_t *countryCodeArray = NULL;
+  uint8_t countryCodeArray[2];
   JNI_TRACE_E("%s: enter; ", fn);
 
-  if (!gIsUwaEnabled) {
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", fn);
     return status;
   }
@@ -1646,23 +2443,16 @@ jbyte uwbNativeManager_SetCountryCode(JNIEnv *env, jobject o,
     return status;
   }
 
-  countryCodeArray = (uint8_t *)malloc(countryCodeArrayLen);
-  if (countryCodeArray == NULL) {
-    JNI_TRACE_E("%s: malloc failure for countryCodeArray", fn);
-    return status;
-  }
-  memset(countryCodeArray, 0, countryCodeArrayLen);
   env->GetByteArrayRegion(countryCode, 0, countryCodeArrayLen,
                           (jbyte *)countryCodeArray);
-  sSetCountryCodeStatus = false;
-  SyncEventGuard guard(sUwaSetCountryCodeEvent);
-  status = UWA_ControllerSetCountryCode(countryCodeArray);
+  state.setCountryCodeStatus = false;
+  SyncEventGuard guard(state.uwaSetCountryCodeEvent);
+  status = chip->getStack().setCountryCode(countryCodeArray);
   if (status == UWA_STATUS_OK) {
-    sUwaSetCountryCodeEvent.wait(UWB_CMD_TIMEOUT);
+    state.uwaSetCountryCodeEvent.wait(UWB_CMD_TIMEOUT);
   }
-  free(countryCodeArray);
   JNI_TRACE_I("%s: exit", fn);
-  return (sSetCountryCodeStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (state.setCountryCodeStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -1673,114 +2463,1229 @@ jbyte uwbNativeManager_SetCountryCode(JNIEnv *env, jobject o,
 **
 ** Params           env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
 **
 ** Returns:         True if ok.
 **
 *******************************************************************************/
-jboolean uwbNativeManager_init(JNIEnv *env, jobject o) {
-  uwbEventManager.doLoadSymbols(env, o);
+jboolean uwbNativeManager_init(JNIEnv *env, jobject o, jint chipId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return JNI_FALSE;
+  }
+  JavaVM *vm = NULL;
+  chip->getEventManager().doLoadSymbols(env, o);
+  env->GetJavaVM(&vm);
+  chip->getDispatcher().start(vm);
+  chip->getCommandPipeline().setCompletionCallback(onAsyncCommandComplete,
+                                                   chip);
+  if (chipId == UWB_DEFAULT_CHIP_ID) {
+    chip->getDeviceSnapshot().load(UWB_DEVICE_SNAPSHOT_PATH);
+  } else {
+    char snapshotPath[sizeof(UWB_DEVICE_SNAPSHOT_CHIP_PATH_FORMAT) + 8];
+    snprintf(snapshotPath, sizeof(snapshotPath),
+             UWB_DEVICE_SNAPSHOT_CHIP_PATH_FORMAT, chipId);
+    chip->getDeviceSnapshot().load(snapshotPath);
+  }
   return JNI_TRUE;
 }
 
 /*******************************************************************************
 **
-** Function:        uwbNativeManager_enableConformanceTest
+** Function:        uwbNativeManager_setRangingFilter
 **
-** Description:     Enable or disable MCTT mode of operation.
+** Description:     Select the distance filter applied to the two way ranging
+**                  data of a session before it is delivered. The samples
+**                  collected so far for the session are dropped.
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
-**                  enable: enable/disable MCTT mode
+**                  chipId: chip ID.
+**                  sessionId: session ID.
+**                  mode: 0 none, 1 mean, 2 median, 3 EWMA, 4 Kalman with
+**                  the default tuning.
+**                  window: number of samples for mean and median.
+**                  ewmaAlpha: EWMA smoothing factor in 1/256 units.
+**                  minFom: minimum azimuth FOM of a valid sample, 0 disables.
 **
-********************************************************************************/
-jbyte uwbNativeManager_enableConformanceTest(JNIEnv *env, jobject o,
-                                             jboolean enable) {
-  static const char fn[] = "uwbNativeManager_enableConformanceTest";
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setRangingFilter(JNIEnv *env, jobject o, jint chipId,
+                                        jint sessionId, jint mode, jint window,
+                                        jint ewmaAlpha, jint minFom) {
+  static const char fn[] = "uwbNativeManager_setRangingFilter";
   UNUSED(fn);
-  JNI_TRACE_I("%s: enter", fn);
-  tUWA_STATUS status = UWA_STATUS_FAILED;
+  JNI_TRACE_I("%s: enter; session ID=%x mode=%d", fn, sessionId, mode);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
 
-  if (!gIsUwaEnabled) {
-    JNI_TRACE_E("%s: UWB device is not enabled", fn);
-    return status;
+  if (mode < 0 || mode > UINT8_MAX || window < 0 || window > UINT8_MAX ||
+      ewmaAlpha < 0 || ewmaAlpha > UINT8_MAX || minFom < 0 ||
+      minFom > UINT8_MAX) {
+    JNI_TRACE_E("%s: invalid filter parameters", fn);
+    return UWA_STATUS_FAILED;
+  }
+  tUWB_RANGING_FILTER_CONFIG config = {};
+  config.mode = mode;
+  config.window = window;
+  config.ewmaAlpha = ewmaAlpha;
+  config.minFom = minFom;
+  if (!UwbRangingFilter::isValidConfig(config)) {
+    JNI_TRACE_E("%s: invalid filter parameters", fn);
+    return UWA_STATUS_FAILED;
+  }
+
+  if (!chip->getSessionRegistry().configureFilter(sessionId, config)) {
+    JNI_TRACE_E("%s: no room for session %x", fn, sessionId);
+    return UWA_STATUS_FAILED;
   }
-  UWB_EnableConformanceTest(enable);
   JNI_TRACE_I("%s: exit", fn);
   return UWA_STATUS_OK;
 }
 
 /*******************************************************************************
 **
-** Function:        uwbNativeManager_GetDeviceCapebilityParams()
+** Function:        uwbNativeManager_setRangingTrackingFilter
 **
-** Description:     Invoked this API to get the device capability information.
+** Description:     Select the Kalman tracking filter for the two way ranging
+**                  data of a session. Distance, azimuth and elevation of each
+**                  responder are tracked with a constant velocity model. The
+**                  tracks collected so far for the session are dropped.
 **
 ** Params:          env: JVM environment.
 **                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session ID.
+**                  accelNoise: distance process noise in cm/s^2.
+**                  angularAccelNoise: AoA process noise in degree/s^2.
+**                  distanceNoise: distance measurement noise in cm.
+**                  angleNoise: AoA measurement noise at FOM 100 in degree.
+**                  nlosGate: innovation gate of NLOS samples in standard
+**                  deviations.
+**                  minFom: minimum azimuth FOM of a valid sample, 0 disables.
+**                  Parameters of 0 select their default.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
 **
-** Returns:         Returns byte array
+*******************************************************************************/
+jbyte uwbNativeManager_setRangingTrackingFilter(JNIEnv *env, jobject o,
+                                                jint chipId, jint sessionId,
+                                                jint accelNoise,
+                                                jint angularAccelNoise,
+                                                jint distanceNoise,
+                                                jint angleNoise, jint nlosGate,
+                                                jint minFom) {
+  static const char fn[] = "uwbNativeManager_setRangingTrackingFilter";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: enter; session ID=%x", fn, sessionId);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+
+  if (accelNoise < 0 || accelNoise > UINT16_MAX || angularAccelNoise < 0 ||
+      angularAccelNoise > UINT16_MAX || distanceNoise < 0 ||
+      distanceNoise > UINT16_MAX || angleNoise < 0 ||
+      angleNoise > UINT16_MAX || nlosGate < 0 || nlosGate > UINT8_MAX ||
+      minFom < 0 || minFom > UINT8_MAX) {
+    JNI_TRACE_E("%s: invalid filter parameters", fn);
+    return UWA_STATUS_FAILED;
+  }
+  tUWB_RANGING_FILTER_CONFIG config = {};
+  config.mode = UWB_RANGING_FILTER_KALMAN;
+  config.minFom = minFom;
+  config.accelNoise = accelNoise;
+  config.angularAccelNoise = angularAccelNoise;
+  config.distanceNoise = distanceNoise;
+  config.angleNoise = angleNoise;
+  config.nlosGate = nlosGate;
+
+  if (!chip->getSessionRegistry().configureFilter(sessionId, config)) {
+    JNI_TRACE_E("%s: no room for session %x", fn, sessionId);
+    return UWA_STATUS_FAILED;
+  }
+  JNI_TRACE_I("%s: exit", fn);
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setRangingDeliveryPolicy
+**
+** Description:     Select which ranging rounds of a session are delivered to
+**                  Java. Dropped rounds still feed the ranging filter, the
+**                  delivered rounds carry the filtered values.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session ID.
+**                  mode: 0 all, 1 every Nth, 2 min interval, 3 on change.
+**                  everyNth: deliver one round out of everyNth.
+**                  minIntervalMs: minimum time between delivered rounds.
+**                  distanceThreshold: on change distance threshold in cm.
+**                  angleThreshold: on change AoA threshold in Q9.7 degrees.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
 **
 *******************************************************************************/
-jobject uwbNativeManager_GetDeviceCapebilityParams(JNIEnv* env, jobject o) {
-  JNI_TRACE_I("%s: Entry", __func__);
-  tUWA_STATUS status;
+jbyte uwbNativeManager_setRangingDeliveryPolicy(JNIEnv *env, jobject o,
+                                                jint chipId, jint sessionId,
+                                                jint mode, jint everyNth,
+                                                jint minIntervalMs,
+                                                jint distanceThreshold,
+                                                jint angleThreshold) {
+  static const char fn[] = "uwbNativeManager_setRangingDeliveryPolicy";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: enter; session ID=%x mode=%d", fn, sessionId, mode);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+
+  if (mode < 0 || mode > UINT8_MAX || everyNth < 0 || everyNth > UINT16_MAX ||
+      minIntervalMs < 0 || distanceThreshold < 0 ||
+      distanceThreshold > UINT16_MAX || angleThreshold < 0 ||
+      angleThreshold > UINT16_MAX) {
+    JNI_TRACE_E("%s: invalid delivery policy", fn);
+    return UWA_STATUS_FAILED;
+  }
+  tUWB_DELIVERY_POLICY_CONFIG config;
+  config.mode = mode;
+  config.everyNth = everyNth;
+  config.minIntervalMs = minIntervalMs;
+  config.distanceThreshold = distanceThreshold;
+  config.angleThreshold = angleThreshold;
+  if (!UwbDeliveryPolicy::isValidConfig(config)) {
+    JNI_TRACE_E("%s: invalid delivery policy", fn);
+    return UWA_STATUS_FAILED;
+  }
+
+  if (!chip->getSessionRegistry().configureDeliveryPolicy(sessionId, config)) {
+    JNI_TRACE_E("%s: no room for session %x", fn, sessionId);
+    return UWA_STATUS_FAILED;
+  }
+  JNI_TRACE_I("%s: exit", fn);
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setSessionAnchors
+**
+** Description:     Register the anchors of a session. Its two way ranging
+**                  data is then solved into a position fix delivered through
+**                  onPositionFixReceived, instead of the measurements unless
+**                  UWB_POSITION_FLAG_KEEP_MEASUREMENTS is set. Notifications
+**                  whose fix fails still deliver the measurements.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session ID.
+**                  macAddresses: 8 bytes per anchor, short addresses use the
+**                  first two. NULL or empty disables the solver.
+**                  coordinates: x, y, z in cm per anchor.
+**                  flags: UWB_POSITION_FLAG_* bits.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setSessionAnchors(JNIEnv *env, jobject o, jint chipId,
+                                         jint sessionId,
+                                         jbyteArray macAddresses,
+                                         jintArray coordinates, jint flags) {
+  static const char fn[] = "uwbNativeManager_setSessionAnchors";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: enter; session ID=%x", fn, sessionId);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+
+  jsize noOfAnchors =
+      macAddresses == NULL ? 0 : env->GetArrayLength(macAddresses) / 8;
+  if (flags < 0 || flags > UINT8_MAX ||
+      !UwbPositionSolver::isValidFlags(flags) ||
+      noOfAnchors > MAX_NUM_RESPONDERS ||
+      (macAddresses != NULL &&
+       env->GetArrayLength(macAddresses) != noOfAnchors * 8)) {
+    JNI_TRACE_E("%s: invalid anchors", fn);
+    return UWA_STATUS_FAILED;
+  }
+  if (noOfAnchors > 0 &&
+      (coordinates == NULL ||
+       env->GetArrayLength(coordinates) != noOfAnchors * 3)) {
+    JNI_TRACE_E("%s: anchor coordinates do not match", fn);
+    return UWA_STATUS_FAILED;
+  }
+
+  tUWB_POSITION_ANCHOR anchors[MAX_NUM_RESPONDERS];
+  jint xyz[MAX_NUM_RESPONDERS * 3];
+  if (noOfAnchors > 0) {
+    env->GetIntArrayRegion(coordinates, 0, noOfAnchors * 3, xyz);
+  }
+  for (jsize i = 0; i < noOfAnchors; i++) {
+    env->GetByteArrayRegion(macAddresses, i * 8, 8,
+                            (jbyte *)anchors[i].macAddr);
+    anchors[i].x = xyz[i * 3];
+    anchors[i].y = xyz[i * 3 + 1];
+    anchors[i].z = xyz[i * 3 + 2];
+  }
+
+  if (!chip->getSessionRegistry().configureAnchors(sessionId, anchors,
+                                                   noOfAnchors, flags)) {
+    JNI_TRACE_E("%s: no room for session %x", fn, sessionId);
+    return UWA_STATUS_FAILED;
+  }
+  JNI_TRACE_I("%s: exit", fn);
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setNotificationQueuePolicy
+**
+** Description:     Select how ranging notifications are handled when the
+**                  notification dispatcher queue is full.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  policy: 0 drop oldest, 1 coalesce per session (default),
+**                  2 block.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setNotificationQueuePolicy(JNIEnv *env, jobject o,
+                                                  jint chipId, jint policy) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  if (policy < 0 || !chip->getDispatcher().setOverflowPolicy(policy)) {
+    return UWA_STATUS_FAILED;
+  }
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setCommandCreditLimit
+**
+** Description:     Set how many session commands may be outstanding at the
+**                  UCI stack at the same time.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  credits: command credits of the controller, 1 to 255.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setCommandCreditLimit(JNIEnv *env, jobject o,
+                                             jint chipId, jint credits) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  if (credits <= 0 || credits > UINT8_MAX) {
+    return UWA_STATUS_FAILED;
+  }
+  chip->getCommandPipeline().setCreditLimit(credits);
+  return UWA_STATUS_OK;
+}
 
-  if (!gIsUwaEnabled) {
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_sessionInitAsync
+**
+** Description:     Non blocking variant of sessionInit. The asynchronous
+**                  variants return a request token right away and report the
+**                  response through onCommandCompleted(token, cmd, status,
+**                  value, data) on the notification dispatcher thread.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session to initialize.
+**                  sessionType: type of the session.
+**
+** Returns:         Request token, 0 if the command could not be queued.
+**
+*******************************************************************************/
+jint uwbNativeManager_sessionInitAsync(JNIEnv *env, jobject o, jint chipId,
+                                       jint sessionId, jbyte sessionType) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
-    return NULL;
+    return 0;
   }
+  return chip->getCommandPipeline().submitAsync(
+      UWB_CMD_SESSION_INIT, sessionId,
+      [&]() { return chip->getStack().sessionInit(sessionId, sessionType); });
+}
 
-  sGetDeviceCapsRespStatus = false;
-  SyncEventGuard guard(sUwaGetDeviceCapsEvent);
-  status = UWA_GetCoreGetDeviceCapability();
-  if (status == UWA_STATUS_OK) {
-    JNI_TRACE_D("%s: Success UWA_GetCoreGetDeviceCapability", __func__);
-    sUwaGetDeviceCapsEvent.wait(UWB_CMD_TIMEOUT);
-  } else {
-    JNI_TRACE_E("%s: Failed UWA_GetCoreGetDeviceCapability", __func__);
-    return NULL;
+jint uwbNativeManager_sessionDeInitAsync(JNIEnv *env, jobject o, jint chipId,
+                                         jint sessionId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
   }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return 0;
+  }
+  chip->getSessionRegistry().invalidateAppConfig(sessionId);
+  return chip->getCommandPipeline().submitAsync(
+      UWB_CMD_SESSION_DEINIT, sessionId,
+      [&]() { return chip->getStack().sessionDeInit(sessionId); });
+}
 
-  if (!sGetDeviceCapsRespStatus) {
-    JNI_TRACE_E("%s: Failed getDeviceCapabilityInfo, Status = %d", __func__,
-                sGetDeviceCapsRespStatus);
-    return NULL;
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setAppConfigurationsAsync
+**
+** Description:     Non blocking variant of setAppConfigurations. The
+**                  completion carries the number of config ids as value and
+**                  the config status list as data.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionId: session to configure.
+**                  noOfParams: number of TLVs in AppConfig.
+**                  appConfigLen: length of AppConfig.
+**                  AppConfig: App Configurations in TLV format.
+**
+** Returns:         Request token, 0 if the command could not be queued.
+**
+*******************************************************************************/
+jint uwbNativeManager_setAppConfigurationsAsync(JNIEnv *env, jobject o,
+                                                jint chipId, jint sessionId,
+                                                jint noOfParams,
+                                                jint appConfigLen,
+                                                jbyteArray AppConfig) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return 0;
+  }
+  if (appConfigLen <= 0 || appConfigLen > UCI_MAX_PAYLOAD_SIZE ||
+      AppConfig == NULL || env->GetArrayLength(AppConfig) < appConfigLen) {
+    JNI_TRACE_E("%s: invalid app config length %d", __func__, appConfigLen);
+    return 0;
   }
 
-  const char *UWB_TLV_DATA =
-	"com/android/server/uwb/data/UwbTlvData";
-  jclass tlvDataClass = env->FindClass(UWB_TLV_DATA);
-  jmethodID constructor =
-      env->GetMethodID(tlvDataClass, "<init>", "(II[B)V");
-  if (constructor == JNI_NULL) {
-    JNI_TRACE_E("%s: jni cannot find the method for UwbTlvDATA", __func__);
-    return NULL;
+  UwbBufferLease appConfigData =
+      UwbBufferPool::getPacketPool().lease(appConfigLen);
+  if (!appConfigData.isValid()) {
+    return 0;
   }
+  env->GetByteArrayRegion(AppConfig, 0, appConfigLen,
+                          (jbyte *)appConfigData.data());
+  /* The applied values are not tracked for asynchronous sets */
+  chip->getSessionRegistry().invalidateAppConfig(sessionId);
+  uint32_t token =
+      chip->getCommandPipeline().submitAsync(
+          UWB_CMD_SET_APP_CONFIG, sessionId, [&]() {
+            return chip->getStack().setAppConfig(sessionId, noOfParams,
+                                                 appConfigLen,
+                                                 appConfigData.data());
+          });
+  return token;
+}
 
-  //remove vendor ext parameters
-  uint8_t sUwbDeviceCapaInfos[UCI_MAX_PKT_SIZE];
-  uint16_t capLen = 0;
-  for( uint16_t index= 0;index< sDevCapInfoLen;) {
-      if (sUwbDeviceCapability[index] == 0xE0 ) { //Ext id
-         switch (sUwbDeviceCapability[index+1]) { //Ext sub id
-             case 0x00:
-             case 0x01:
-             case 0x02:
-	       int lenofParam =  sUwbDeviceCapability[index+2]; //Get the length of Ext paramaeter
-	       index = index + (lenofParam+3); // increament index by (Ext id+ Ext sub id + length of ext param + velue of param)
-               sDevCapInfoIds--;
-	      break;
-	 }
-      } else {
-	 sUwbDeviceCapaInfos[capLen++] = sUwbDeviceCapability[index];
-         index++;
-      }
+jint uwbNativeManager_startRangingAsync(JNIEnv *env, jobject o, jint chipId,
+                                        jint sessionId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
   }
-  jbyteArray deviceCapabilityInfo = env->NewByteArray(capLen);
-  env->SetByteArrayRegion(deviceCapabilityInfo, 0, capLen,
-                          (jbyte*)&sUwbDeviceCapaInfos[0]);
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return 0;
+  }
+  return chip->getCommandPipeline().submitAsync(
+      UWB_CMD_RANGE_START, sessionId,
+      [&]() { return chip->getStack().startRanging(sessionId); });
+}
+
+jint uwbNativeManager_stopRangingAsync(JNIEnv *env, jobject o, jint chipId,
+                                       jint sessionId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+    return 0;
+  }
+  return chip->getCommandPipeline().submitAsync(
+      UWB_CMD_RANGE_STOP, sessionId,
+      [&]() { return chip->getStack().stopRanging(sessionId); });
+}
+
+/* The completion carries the session state as value */
+jint uwbNativeManager_getSessionStateAsync(JNIEnv *env, jobject o, jint chipId,
+                                           jint sessionId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return 0;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not enabled", __func__);
+    return 0;
+  }
+  return chip->getCommandPipeline().submitAsync(
+      UWB_CMD_GET_SESSION_STATE, sessionId,
+      [&]() { return chip->getStack().getSessionStatus(sessionId); });
+}
+
+/* Stage a session of a bring-up plan reached, reported with its status */
+enum {
+  UWB_BRINGUP_STAGE_SESSION_INIT = 0,
+  UWB_BRINGUP_STAGE_SET_APP_CONFIG,
+  UWB_BRINGUP_STAGE_RANGE_START,
+  UWB_BRINGUP_STAGE_DONE,
+};
+
+struct BringUpSession {
+  uint32_t sessionId;
+  uint8_t sessionType;
+  uint8_t noOfParams;
+  std::vector<uint8_t> appConfig;
+  uint8_t stage;
+  uint8_t status;
+  std::shared_ptr<UwbCommandRequest> request;
+};
+
+/*******************************************************************************
+**
+** Function:        runBringUpStage
+**
+** Description:     Submit one command for every session waiting at the given
+**                  stage, then collect the responses. Commands of different
+**                  sessions are outstanding together up to the credit limit
+**                  of the command pipeline.
+**
+** Params:          chip: chip of the sessions.
+**                  sessions: sessions of the plan.
+**                  stage: stage to run.
+**                  cmd: command of the stage.
+**                  send: issues the UWA command of one session on the stack
+**                  of the chip.
+**
+** Returns:         None
+**
+*******************************************************************************/
+static void runBringUpStage(
+    UwbChipContext &chip, std::vector<BringUpSession> &sessions, uint8_t stage,
+    eUWB_CMD cmd,
+    const std::function<tUWA_STATUS(const tUWB_CHIP_STACK &, BringUpSession &)>
+        &send) {
+  for (auto &session : sessions) {
+    if (session.status != UWA_STATUS_OK || session.stage != stage) {
+      continue;
+    }
+    session.request = chip.getCommandPipeline().submit(
+        cmd, [&]() { return send(chip.getStack(), session); });
+    if (session.request == nullptr) {
+      session.status = UWA_STATUS_FAILED;
+    }
+  }
+
+  for (auto &session : sessions) {
+    if (session.request == nullptr) {
+      continue;
+    }
+    tUWB_CMD_RESULT result;
+    if (!chip.getCommandPipeline().wait(session.request, UWB_CMD_TIMEOUT,
+                                        &result)) {
+      session.status = UWA_STATUS_FAILED;
+    } else if (result.status != UWA_STATUS_OK) {
+      session.status = result.status;
+    } else {
+      if (cmd == UWB_CMD_SET_APP_CONFIG) {
+        chip.getSessionRegistry().storeAppliedAppConfig(
+            session.sessionId, session.appConfig.data(),
+            session.appConfig.size(), result.status);
+      }
+      if (cmd == UWB_CMD_SESSION_INIT &&
+          !chip.getSessionRegistry().add(session.sessionId)) {
+        JNI_TRACE_E("%s: no room for session %x in registry", __func__,
+                    session.sessionId);
+      }
+      session.stage++;
+    }
+    if (cmd == UWB_CMD_SET_APP_CONFIG && session.status != UWA_STATUS_OK) {
+      chip.getSessionRegistry().invalidateAppConfig(session.sessionId);
+    }
+    session.request.reset();
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_bringUpSessions
+**
+** Description:     Run session init, set app config and optionally range
+**                  start for a list of sessions in one call. Every stage is
+**                  pipelined across the sessions; a session that fails a
+**                  stage is left there and skipped by the following stages.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  sessionIds: sessions to bring up.
+**                  sessionTypes: type of every session.
+**                  noOfParams: number of TLVs in every app config.
+**                  appConfigs: app config TLVs of every session, an empty
+**                  array skips the set app config stage.
+**                  startRanging: also start ranging.
+**
+** Returns:         byte array of {stage, status} per session in input order,
+**                  stage is UWB_BRINGUP_STAGE_DONE on success. NULL if the
+**                  plan itself is invalid.
+**
+*******************************************************************************/
+jbyteArray uwbNativeManager_bringUpSessions(JNIEnv *env, jobject o, jint chipId,
+                                            jintArray sessionIds,
+                                            jbyteArray sessionTypes,
+                                            jintArray noOfParams,
+                                            jobjectArray appConfigs,
+                                            jboolean startRanging) {
+  static const char fn[] = "uwbNativeManager_bringUpSessions";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: Enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not initialized", fn);
+    return NULL;
+  }
+  if (sessionIds == NULL || sessionTypes == NULL || noOfParams == NULL ||
+      appConfigs == NULL) {
+    JNI_TRACE_E("%s: invalid plan", fn);
+    return NULL;
+  }
+  jsize count = env->GetArrayLength(sessionIds);
+  if (count == 0 || env->GetArrayLength(sessionTypes) != count ||
+      env->GetArrayLength(noOfParams) != count ||
+      env->GetArrayLength(appConfigs) != count) {
+    JNI_TRACE_E("%s: plan arrays do not match", fn);
+    return NULL;
+  }
+
+  std::vector<jint> ids(count);
+  std::vector<jbyte> types(count);
+  std::vector<jint> params(count);
+  env->GetIntArrayRegion(sessionIds, 0, count, ids.data());
+  env->GetByteArrayRegion(sessionTypes, 0, count, types.data());
+  env->GetIntArrayRegion(noOfParams, 0, count, params.data());
+
+  std::vector<BringUpSession> sessions(count);
+  for (jsize i = 0; i < count; i++) {
+    BringUpSession &session = sessions[i];
+    session.sessionId = ids[i];
+    session.sessionType = types[i];
+    session.noOfParams = params[i];
+    session.stage = UWB_BRINGUP_STAGE_SESSION_INIT;
+    session.status = UWA_STATUS_OK;
+    jbyteArray appConfig =
+        (jbyteArray)env->GetObjectArrayElement(appConfigs, i);
+    if (appConfig != NULL) {
+      jsize appConfigLen = env->GetArrayLength(appConfig);
+      if (appConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+        JNI_TRACE_E("%s: app config of session %x too long", fn, ids[i]);
+        session.status = UWA_STATUS_FAILED;
+      } else {
+        session.appConfig.resize(appConfigLen);
+        env->GetByteArrayRegion(appConfig, 0, appConfigLen,
+                                (jbyte *)session.appConfig.data());
+      }
+      env->DeleteLocalRef(appConfig);
+    }
+  }
+
+  runBringUpStage(
+      *chip, sessions, UWB_BRINGUP_STAGE_SESSION_INIT, UWB_CMD_SESSION_INIT,
+      [](const tUWB_CHIP_STACK &stack, BringUpSession &session) {
+        return stack.sessionInit(session.sessionId, session.sessionType);
+      });
+  for (auto &session : sessions) {
+    if (session.stage == UWB_BRINGUP_STAGE_SET_APP_CONFIG &&
+        session.appConfig.empty()) {
+      session.stage++;
+    }
+  }
+  runBringUpStage(
+      *chip, sessions, UWB_BRINGUP_STAGE_SET_APP_CONFIG, UWB_CMD_SET_APP_CONFIG,
+      [](const tUWB_CHIP_STACK &stack, BringUpSession &session) {
+        return stack.setAppConfig(session.sessionId, session.noOfParams,
+                                  session.appConfig.size(),
+                                  session.appConfig.data());
+      });
+  if (startRanging) {
+    runBringUpStage(
+        *chip, sessions, UWB_BRINGUP_STAGE_RANGE_START, UWB_CMD_RANGE_START,
+        [](const tUWB_CHIP_STACK &stack, BringUpSession &session) {
+          return stack.startRanging(session.sessionId);
+        });
+  } else {
+    for (auto &session : sessions) {
+      if (session.stage == UWB_BRINGUP_STAGE_RANGE_START) {
+        session.stage++;
+      }
+    }
+  }
+
+  std::vector<jbyte> report(2 * count);
+  for (jsize i = 0; i < count; i++) {
+    report[2 * i] = sessions[i].stage;
+    report[2 * i + 1] = sessions[i].status;
+  }
+  jbyteArray reportArray = env->NewByteArray(report.size());
+  if (reportArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate report", fn);
+    return NULL;
+  }
+  env->SetByteArrayRegion(reportArray, 0, report.size(), report.data());
+  JNI_TRACE_I("%s: Exit", fn);
+  return reportArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getNotificationQueueStats
+**
+** Description:     Get the notification dispatcher queue counters: depth,
+**                  high water mark, enqueued, dropped, coalesced, the
+**                  number of times the UCI callback thread had to wait and
+**                  the dropped control notifications.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**
+** Returns:         long array of the counters, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_getNotificationQueueStats(JNIEnv *env, jobject o,
+                                                      jint chipId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  int64_t stats[UWB_NTF_QUEUE_STAT_MAX];
+  chip->getDispatcher().getStats(stats);
+
+  jlongArray statsArray = env->NewLongArray(UWB_NTF_QUEUE_STAT_MAX);
+  if (statsArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate stats array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(statsArray, 0, UWB_NTF_QUEUE_STAT_MAX,
+                          (jlong *)stats);
+  return statsArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getBufferPoolStats
+**
+** Description:     Get the UCI buffer pool counters: blocks, in use, high
+**                  water mark, leases and refused leases, first for the
+**                  packet pool and then for the RF test PSDU pool.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**
+** Returns:         long array of the counters, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_getBufferPoolStats(JNIEnv *env, jobject o) {
+  int64_t stats[2 * UWB_BUFFER_POOL_STAT_MAX];
+  UwbBufferPool::getPacketPool().getStats(stats);
+  UwbBufferPool::getPsduPool().getStats(stats + UWB_BUFFER_POOL_STAT_MAX);
+
+  jlongArray statsArray = env->NewLongArray(2 * UWB_BUFFER_POOL_STAT_MAX);
+  if (statsArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate stats array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(statsArray, 0, 2 * UWB_BUFFER_POOL_STAT_MAX,
+                          (jlong *)stats);
+  return statsArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getStats
+**
+** Description:     Get the always-on JNI counters: command response latency
+**                  histograms and timeouts, JNI upcall durations and per
+**                  session ranging notification rates. See UwbJniStats.h for
+**                  the layout.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**
+** Returns:         long array of the counters, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_getStats(JNIEnv *env, jobject o, jint chipId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  std::vector<int64_t> stats;
+  chip->getStats().snapshot(stats);
+
+  jlongArray statsArray = env->NewLongArray(stats.size());
+  if (statsArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate stats array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(statsArray, 0, stats.size(), (jlong *)stats.data());
+  return statsArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getTrace
+**
+** Description:     Format the binary trace ring, oldest record first.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**
+** Returns:         One line per record: time, thread, event, arguments.
+**
+*******************************************************************************/
+jstring uwbNativeManager_getTrace(JNIEnv *env, jobject o) {
+  std::string trace = UwbTraceRing::getInstance().dump();
+  return env->NewStringUTF(trace.c_str());
+}
+
+void uwbNativeManager_setTraceEnabled(JNIEnv *env, jobject o,
+                                      jboolean enabled) {
+  UwbTraceRing::getInstance().setEnabled(enabled == JNI_TRUE);
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setVendorNtfPolicy
+**
+** Description:     Select how vendor and raw UCI notifications of a GID/OID
+**                  are delivered, see eUWB_VENDOR_NTF_MODE.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  gid: group id.
+**                  oid: opcode id, UWB_VENDOR_NTF_ANY_OID for the whole group.
+**                  mode: UWB_VENDOR_NTF_* mode.
+**                  param: sampling interval or batch threshold.
+**
+** Returns:         true if the policy was applied.
+**
+*******************************************************************************/
+jboolean uwbNativeManager_setVendorNtfPolicy(JNIEnv *env, jobject o, jint gid,
+                                             jint oid, jint mode, jint param) {
+  if (gid < 0 || gid >= UWB_VENDOR_NTF_MAX_GID ||
+      ((oid < 0 || oid >= UWB_VENDOR_NTF_MAX_OID) &&
+       oid != UWB_VENDOR_NTF_ANY_OID) ||
+      param < 0 || param > UINT16_MAX ||
+      !UwbVendorNtfFilter::isValidPolicy(mode, param)) {
+    JNI_TRACE_E("%s: invalid policy gid %d oid %d mode %d param %d", __func__,
+                gid, oid, mode, param);
+    return JNI_FALSE;
+  }
+  /* The policy applies to every chip, each one must be able to batch */
+  for (jint chipId = 0; mode == UWB_VENDOR_NTF_BATCH && chipId < UWB_MAX_CHIPS;
+       chipId++) {
+    UwbChipContext *chip = UwbChipContext::get(chipId);
+    if (chip != NULL &&
+        !chip->getEventManager().isVendorNtfBatchingAvailable()) {
+      JNI_TRACE_E("%s: vendor batch callback is not available on chip %d",
+                  __func__, chipId);
+      return JNI_FALSE;
+    }
+  }
+  UwbVendorNtfFilter::getInstance().setPolicy(gid, oid, mode, param);
+  return JNI_TRUE;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getVendorNtfStats
+**
+** Description:     Read the per GID/OID counters of the vendor notification
+**                  filter.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**
+** Returns:         UWB_VENDOR_NTF_STATS_ROW_SIZE values per key seen or
+**                  configured, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_getVendorNtfStats(JNIEnv *env, jobject o) {
+  std::vector<int64_t> stats;
+  UwbVendorNtfFilter::getInstance().getStats(stats);
+  jlongArray statsArray = env->NewLongArray(stats.size());
+  if (statsArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate stats array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(statsArray, 0, stats.size(), (jlong *)stats.data());
+  return statsArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_getInitTiming
+**
+** Description:     Read the phase durations of the last device
+**                  initialization.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**
+** Returns:         UWB_INIT_PHASE_MAX durations in us, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_getInitTiming(JNIEnv *env, jobject o, jint chipId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
+  jlongArray timingArray = env->NewLongArray(UWB_INIT_PHASE_MAX);
+  if (timingArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate timing array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(timingArray, 0, UWB_INIT_PHASE_MAX,
+                          (jlong *)state.initPhaseUs);
+  return timingArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_startUciCapture
+**
+** Description:     Record every event delivered by the UCI stack to a file
+**                  until nativeStopUciCapture() is called.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  path: capture file.
+**
+** Returns:         true if the capture started.
+**
+*******************************************************************************/
+jboolean uwbNativeManager_startUciCapture(JNIEnv *env, jobject o, jint chipId,
+                                          jstring path) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return JNI_FALSE;
+  }
+  if (path == NULL) {
+    return JNI_FALSE;
+  }
+  const char *capturePath = env->GetStringUTFChars(path, NULL);
+  if (capturePath == NULL) {
+    return JNI_FALSE;
+  }
+  bool started = chip->getRecorder().startCapture(capturePath);
+  env->ReleaseStringUTFChars(path, capturePath);
+  return started ? JNI_TRUE : JNI_FALSE;
+}
+
+void uwbNativeManager_stopUciCapture(JNIEnv *env, jobject o, jint chipId) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return;
+  }
+  chip->getRecorder().stopCapture();
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_replayUciCapture
+**
+** Description:     Feed a capture through the UCI callbacks on the calling
+**                  thread, driving the same native and Java paths as live
+**                  traffic. Only allowed while UWB is disabled, so the
+**                  replay is the only producer of notifications.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  path: capture file.
+**                  speedPercent: 100 for the recorded pace, 0 for as fast as
+**                  possible.
+**
+** Returns:         UWB_REPLAY_RESULT_* figures, NULL on failure.
+**
+*******************************************************************************/
+jlongArray uwbNativeManager_replayUciCapture(JNIEnv *env, jobject o,
+                                             jint chipId, jstring path,
+                                             jint speedPercent) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
+  if (state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB must be disabled for a replay", __func__);
+    return NULL;
+  }
+  if (path == NULL || speedPercent < 0) {
+    return NULL;
+  }
+  const char *capturePath = env->GetStringUTFChars(path, NULL);
+  if (capturePath == NULL) {
+    return NULL;
+  }
+  int64_t results[UWB_REPLAY_RESULT_MAX];
+  bool replayed = chip->getRecorder().replay(
+      capturePath, speedPercent, sDmCbacks[chipId], sRfTestCbacks[chipId],
+      results);
+  env->ReleaseStringUTFChars(path, capturePath);
+  if (!replayed) {
+    return NULL;
+  }
+  jlongArray resultArray = env->NewLongArray(UWB_REPLAY_RESULT_MAX);
+  if (resultArray == NULL) {
+    JNI_TRACE_E("%s: fail to allocate result array", __func__);
+    return NULL;
+  }
+  env->SetLongArrayRegion(resultArray, 0, UWB_REPLAY_RESULT_MAX,
+                          (jlong *)results);
+  return resultArray;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setRangeDataBatching
+**
+** Description:     Enable or disable batched delivery of two way ranging data.
+**                  While enabled, ranging rounds are packed into a direct
+**                  ByteBuffer handed to onRangeDataBatchReceived() once
+**                  maxRecords rounds are buffered or flushTimeoutMs elapsed
+**                  since the first buffered round. The buffer is reused by
+**                  the next batch, so Java must consume it in the callback.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  maxRecords: rounds per batch, 0 disables batching.
+**                  flushTimeoutMs: flush deadline, 0 flushes on count only.
+**
+** Returns:         UWA_STATUS_OK on success, UWA_STATUS_FAILED otherwise.
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setRangeDataBatching(JNIEnv *env, jobject o, jint chipId,
+                                            jint maxRecords,
+                                            jint flushTimeoutMs) {
+  static const char fn[] = "uwbNativeManager_setRangeDataBatching";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: enter; maxRecords = %d flushTimeoutMs = %d", fn, maxRecords,
+              flushTimeoutMs);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+
+  if (maxRecords < 0 || maxRecords > UWB_RANGE_DATA_BATCH_MAX_RECORDS ||
+      flushTimeoutMs < 0) {
+    JNI_TRACE_E("%s: invalid batching parameters", fn);
+    return UWA_STATUS_FAILED;
+  }
+  if (!chip->getEventManager().setRangeDataBatching(env, maxRecords,
+                                                    flushTimeoutMs)) {
+    return UWA_STATUS_FAILED;
+  }
+  JNI_TRACE_I("%s: exit", fn);
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_setRfTestAggregation
+**
+** Description:     Aggregate RF test notifications natively. Java then only
+**                  receives onRfTestSummaryReceived(long[]) every interval
+**                  instead of one result object per notification.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  summaryIntervalMs: time between two summaries, 0 delivers
+**                  every notification again.
+**                  logPath: file receiving the raw notifications, or null.
+**
+** Returns:         UWA_STATUS_OK if the settings were applied else
+**                  UWA_STATUS_FAILED
+**
+*******************************************************************************/
+jbyte uwbNativeManager_setRfTestAggregation(JNIEnv *env, jobject o, jint chipId,
+                                            jint summaryIntervalMs,
+                                            jstring logPath) {
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  if (summaryIntervalMs < 0) {
+    return UWA_STATUS_FAILED;
+  }
+  const char *path = NULL;
+  if (logPath != NULL) {
+    path = env->GetStringUTFChars(logPath, NULL);
+    if (path == NULL) {
+      return UWA_STATUS_FAILED;
+    }
+  }
+  bool applied = chip->getRfTestManager().setAggregation(
+      env, o, (uint32_t)summaryIntervalMs, path);
+  if (path != NULL) {
+    env->ReleaseStringUTFChars(logPath, path);
+  }
+  return applied ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_enableConformanceTest
+**
+** Description:     Enable or disable MCTT mode of operation.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**                  enable: enable/disable MCTT mode
+**
+********************************************************************************/
+jbyte uwbNativeManager_enableConformanceTest(JNIEnv *env, jobject o,
+                                             jint chipId, jboolean enable) {
+  static const char fn[] = "uwbNativeManager_enableConformanceTest";
+  UNUSED(fn);
+  JNI_TRACE_I("%s: enter", fn);
+  UwbChipContext *chip = getChip(fn, chipId);
+  if (chip == NULL) {
+    return UWA_STATUS_FAILED;
+  }
+  UwbChipState &state = chip->getState();
+  tUWA_STATUS status = UWA_STATUS_FAILED;
+
+  if (!state.isUwaEnabled) {
+    JNI_TRACE_E("%s: UWB device is not enabled", fn);
+    return status;
+  }
+  chip->getStack().enableConformanceTest(enable);
+  JNI_TRACE_I("%s: exit", fn);
+  return UWA_STATUS_OK;
+}
+
+/*******************************************************************************
+**
+** Function:        uwbNativeManager_GetDeviceCapebilityParams()
+**
+** Description:     Invoked this API to get the device capability information.
+**
+** Params:          env: JVM environment.
+**                  o: Java object.
+**                  chipId: chip ID.
+**
+** Returns:         Returns byte array
+**
+*******************************************************************************/
+jobject uwbNativeManager_GetDeviceCapebilityParams(JNIEnv* env, jobject o,
+                                                   jint chipId) {
+  JNI_TRACE_I("%s: Entry", __func__);
+  UwbChipContext *chip = getChip(__func__, chipId);
+  if (chip == NULL) {
+    return NULL;
+  }
+  UwbChipState &state = chip->getState();
+  tUWA_STATUS status;
+
+  if (!state.isUwaEnabled) {
+    // Answer from the snapshot of the last chip until it is up again
+    uint8_t caps[UCI_MAX_PKT_SIZE];
+    uint16_t capsLen = 0, noOfIds = 0;
+    if (!chip->getDeviceSnapshot().getCapabilities(caps, sizeof(caps),
+                                                   &capsLen, &noOfIds)) {
+      JNI_TRACE_E("%s: UWB device is not initialized", __func__);
+      return NULL;
+    }
+    JNI_TRACE_I("%s: Exit, snapshot", __func__);
+    return buildDeviceCapsInfo(env, caps, capsLen, noOfIds);
+  }
+
+  std::lock_guard<std::mutex> lock(state.deviceCapsMutex);
+  if (state.deviceCapsInfo != NULL) {
+    JNI_TRACE_I("%s: Exit, cached", __func__);
+    return env->NewLocalRef(state.deviceCapsInfo);
+  }
+
+  UwbBufferLease caps = UwbBufferPool::getPacketPool().lease(UCI_MAX_PKT_SIZE);
+  if (!caps.isValid()) {
+    return NULL;
+  }
+  state.getDeviceCapsRespStatus = false;
+  {
+    SyncEventGuard guard(state.uwaGetDeviceCapsEvent);
+    state.deviceCapsDest = caps.data();
+    state.deviceCapsCapacity = caps.size();
+    status = chip->getStack().getDeviceCapability();
+    if (status == UWA_STATUS_OK) {
+      JNI_TRACE_D("%s: Success UWA_GetCoreGetDeviceCapability", __func__);
+      state.uwaGetDeviceCapsEvent.wait(UWB_CMD_TIMEOUT);
+    } else {
+      JNI_TRACE_E("%s: Failed UWA_GetCoreGetDeviceCapability", __func__);
+    }
+    state.deviceCapsDest = NULL;
+    state.deviceCapsCapacity = 0;
+  }
+  if (status != UWA_STATUS_OK) {
+    return NULL;
+  }
+
+  if (!state.getDeviceCapsRespStatus) {
+    JNI_TRACE_E("%s: Failed getDeviceCapabilityInfo, Status = %d", __func__,
+                state.getDeviceCapsRespStatus);
+    return NULL;
+  }
+
+  jobject capsInfo = cacheDeviceCapsInfoLocked(env, state, caps.data());
   JNI_TRACE_I("%s: Exit", __func__);
-  return env->NewObject(tlvDataClass, constructor, status, sDevCapInfoIds, deviceCapabilityInfo);
+  return capsInfo;
 }
 
 /*****************************************************************************
@@ -1790,36 +3695,96 @@ jobject uwbNativeManager_GetDeviceCapebilityParams(JNIEnv* env, jobject o) {
 **
 *****************************************************************************/
 static const JNINativeMethod gMethods[] = {
-    {"nativeInit", "()Z", (void *)uwbNativeManager_init},
-    {"nativeDoInitialize", "()Z", (void *)uwbNativeManager_doInitialize},
-    {"nativeDoDeinitialize", "()Z", (void *)uwbNativeManager_doDeinitialize},
-    {"nativeSessionInit", "(IB)B", (void *)uwbNativeManager_sessionInit},
-    {"nativeSessionDeInit", "(I)B", (void *)uwbNativeManager_sessionDeInit},
+    {"nativeInit", "(I)Z", (void *)uwbNativeManager_init},
+    {"nativeDoInitialize", "(I)Z", (void *)uwbNativeManager_doInitialize},
+    {"nativeDoDeinitialize", "(I)Z", (void *)uwbNativeManager_doDeinitialize},
+    {"nativeSessionInit", "(IIB)B", (void *)uwbNativeManager_sessionInit},
+    {"nativeSessionDeInit", "(II)B", (void *)uwbNativeManager_sessionDeInit},
     {"nativeSetAppConfigurations",
-      "(III[B)Lcom/android/server/uwb/data/UwbConfigStatusData;",
+      "(IIII[B)Lcom/android/server/uwb/data/UwbConfigStatusData;",
      (void *)uwbNativeManager_setAppConfigurations},
+    {"nativeSetAppConfigurationsDirect",
+     "(IIIILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)I",
+     (void *)uwbNativeManager_setAppConfigurationsDirect},
     {"nativeGetAppConfigurations",
-      "(III[B)Lcom/android/server/uwb/data/UwbTlvData;",
+      "(IIII[B)Lcom/android/server/uwb/data/UwbTlvData;",
      (void *)uwbNativeManager_getAppConfigurations},
-    {"nativeRangingStart", "(I)B", (void *)uwbNativeManager_startRanging},
-    {"nativeRangingStop", "(I)B", (void *)uwbNativeManager_stopRanging},
-    {"nativeGetSessionCount", "()B", (void *)uwbNativeManager_getSessionCount},
-    {"nativeGetSessionState", "(I)B", (void *)uwbNativeManager_getSessionState},
-    {"nativeControllerMulticastListUpdate", "(IBB[S[I)B",
+    {"nativeRangingStart", "(II)B", (void *)uwbNativeManager_startRanging},
+    {"nativeRangingStop", "(II)B", (void *)uwbNativeManager_stopRanging},
+    {"nativeGetSessionCount", "(I)B", (void *)uwbNativeManager_getSessionCount},
+    {"nativeGetSessionState", "(II)B",
+     (void *)uwbNativeManager_getSessionState},
+    {"nativeControllerMulticastListUpdate", "(IIBB[S[I)B",
      (void *)uwbNativeManager_ControllerMulticastListUpdate},
-    {"nativeSetCountryCode", "([B)B", (void *)uwbNativeManager_SetCountryCode},
-    {"nativeSendRawVendorCmd", "(II[B)Lcom/android/server/uwb/data/UwbVendorUciResponse;",
+    {"nativeControllerMulticastListBulkUpdate", "(IIB[S[I)B",
+     (void *)uwbNativeManager_controllerMulticastListBulkUpdate},
+    {"nativeSetControleeList", "(II[S[I)B",
+     (void *)uwbNativeManager_setControleeList},
+    {"nativeSetCountryCode", "(I[B)B", (void *)uwbNativeManager_SetCountryCode},
+    {"nativeSendRawVendorCmd", "(III[B)Lcom/android/server/uwb/data/UwbVendorUciResponse;",
     (void*)uwbNativeManager_sendRawUci},
-    {"nativeEnableConformanceTest", "(Z)B",
+    {"nativeSendRawVendorCmdDirect",
+     "(IIILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)I",
+     (void *)uwbNativeManager_sendRawUciDirect},
+    {"nativeEnableConformanceTest", "(IZ)B",
      (void*)uwbNativeManager_enableConformanceTest},
     {"nativeGetMaxSessionNumber", "()I",
      (void *)uwbNativeManager_getMaxSessionNumber},
-    {"nativeResetDevice", "(B)B", (void *)uwbNativeManager_resetDevice},
+    {"nativeResetDevice", "(IB)B", (void *)uwbNativeManager_resetDevice},
     {"nativeGetSpecificationInfo",
-     "()Lcom/android/server/uwb/info/UwbSpecificationInfo;",
+     "(I)Lcom/android/server/uwb/info/UwbSpecificationInfo;",
      (void *)uwbNativeManager_getSpecificationInfo},
-    {"nativeGetCapsInfo", "()Lcom/android/server/uwb/data/UwbTlvData;",
-     (void*)uwbNativeManager_GetDeviceCapebilityParams}
+    {"nativeGetCapsInfo", "(I)Lcom/android/server/uwb/data/UwbTlvData;",
+     (void*)uwbNativeManager_GetDeviceCapebilityParams},
+    {"nativeSetRangeDataBatching", "(III)B",
+     (void *)uwbNativeManager_setRangeDataBatching},
+    {"nativeSetRangingFilter", "(IIIIII)B",
+     (void *)uwbNativeManager_setRangingFilter},
+    {"nativeSetRangingTrackingFilter", "(IIIIIIII)B",
+     (void *)uwbNativeManager_setRangingTrackingFilter},
+    {"nativeSetRangingDeliveryPolicy", "(IIIIIII)B",
+     (void *)uwbNativeManager_setRangingDeliveryPolicy},
+    {"nativeSetSessionAnchors", "(II[B[II)B",
+     (void *)uwbNativeManager_setSessionAnchors},
+    {"nativeSetNotificationQueuePolicy", "(II)B",
+     (void *)uwbNativeManager_setNotificationQueuePolicy},
+    {"nativeGetNotificationQueueStats", "(I)[J",
+     (void *)uwbNativeManager_getNotificationQueueStats},
+    {"nativeSetCommandCreditLimit", "(II)B",
+     (void *)uwbNativeManager_setCommandCreditLimit},
+    {"nativeSessionInitAsync", "(IIB)I",
+     (void *)uwbNativeManager_sessionInitAsync},
+    {"nativeSessionDeInitAsync", "(II)I",
+     (void *)uwbNativeManager_sessionDeInitAsync},
+    {"nativeSetAppConfigurationsAsync", "(IIII[B)I",
+     (void *)uwbNativeManager_setAppConfigurationsAsync},
+    {"nativeRangingStartAsync", "(II)I",
+     (void *)uwbNativeManager_startRangingAsync},
+    {"nativeRangingStopAsync", "(II)I",
+     (void *)uwbNativeManager_stopRangingAsync},
+    {"nativeGetSessionStateAsync", "(II)I",
+     (void *)uwbNativeManager_getSessionStateAsync},
+    {"nativeBringUpSessions", "(I[I[B[I[[BZ)[B",
+     (void *)uwbNativeManager_bringUpSessions},
+    {"nativeGetStats", "(I)[J", (void *)uwbNativeManager_getStats},
+    {"nativeGetTrace", "()Ljava/lang/String;",
+     (void *)uwbNativeManager_getTrace},
+    {"nativeSetTraceEnabled", "(Z)V",
+     (void *)uwbNativeManager_setTraceEnabled},
+    {"nativeStartUciCapture", "(ILjava/lang/String;)Z",
+     (void *)uwbNativeManager_startUciCapture},
+    {"nativeStopUciCapture", "(I)V", (void *)uwbNativeManager_stopUciCapture},
+    {"nativeReplayUciCapture", "(ILjava/lang/String;I)[J",
+     (void *)uwbNativeManager_replayUciCapture},
+    {"nativeSetVendorNtfPolicy", "(IIII)Z",
+     (void *)uwbNativeManager_setVendorNtfPolicy},
+    {"nativeGetVendorNtfStats", "()[J",
+     (void *)uwbNativeManager_getVendorNtfStats},
+    {"nativeGetInitTiming", "(I)[J", (void *)uwbNativeManager_getInitTiming},
+    {"nativeSetRfTestAggregation", "(IILjava/lang/String;)B",
+     (void *)uwbNativeManager_setRfTestAggregation},
+    {"nativeGetBufferPoolStats", "()[J",
+     (void *)uwbNativeManager_getBufferPoolStats}
 };
 
 /*******************************************************************************
@@ -0,0 +1,635 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "UwbJniInternal.h"
+#include "UwbEventManager.h"
+#include "UwbJniStats.h"
+#include "UwbNotificationDispatcher.h"
+#include "UwbTrace.h"
+#include "UwbVendorNtfFilter.h"
+#include "JniLog.h"
+
+namespace android {
+
+static const char *DISPATCHER_THREAD_NAME = "UwbNtfDispatcher";
+
+UwbNotificationDispatcher::UwbNotificationDispatcher(
+    UwbEventManager &eventManager, UwbJniStats &stats)
+    : mEventManager(eventManager), mStats(stats) {
+  mVm = NULL;
+  mPolicy = UWB_NTF_QUEUE_POLICY_COALESCE_PER_SESSION;
+  mConsumerWaiting = false;
+  mProducerWaiting = false;
+  mHighWater = 0;
+  mEnqueued = 0;
+  mDropped = 0;
+  mCoalesced = 0;
+  mBlocked = 0;
+  mControlDropped = 0;
+  mNextSeq = 0;
+  mControlHead = 0;
+  mControlCount = 0;
+  mControlPending = 0;
+  for (int i = 0; i < UWB_NOTIFICATION_MAX_MAILBOXES; i++) {
+    mMailboxes[i].pending = false;
+    mMailboxes[i].sessionId = 0;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        start
+**
+** Description:     Start the dispatcher thread. Only the first call has an
+**                  effect, the thread lives for the lifetime of the process.
+**
+** Params:          vm: Java VM the dispatcher thread attaches to.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbNotificationDispatcher::start(JavaVM *vm) {
+  std::call_once(mStartOnce, [this, vm]() {
+    mVm = vm;
+    mThread = std::thread(&UwbNotificationDispatcher::dispatchLoop, this);
+    mThread.detach();
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        setOverflowPolicy
+**
+** Description:     Select what happens to ranging notifications when the
+**                  queue is full, UWB_NTF_QUEUE_POLICY_COALESCE_PER_SESSION
+**                  until changed.
+**
+** Params:          policy: one of UWB_NTF_QUEUE_POLICY_*.
+**
+** Returns:         true if the policy is valid.
+**
+*******************************************************************************/
+bool UwbNotificationDispatcher::setOverflowPolicy(uint8_t policy) {
+  if (policy > UWB_NTF_QUEUE_POLICY_BLOCK) {
+    JNI_TRACE_E("%s: invalid policy %d", __func__, policy);
+    return false;
+  }
+  mPolicy = policy;
+  return true;
+}
+
+void UwbNotificationDispatcher::getStats(
+    int64_t stats[UWB_NTF_QUEUE_STAT_MAX]) {
+  stats[UWB_NTF_QUEUE_STAT_DEPTH] = mQueue.size() + mControlPending;
+  stats[UWB_NTF_QUEUE_STAT_HIGH_WATER] = mHighWater;
+  stats[UWB_NTF_QUEUE_STAT_ENQUEUED] = mEnqueued;
+  stats[UWB_NTF_QUEUE_STAT_DROPPED] = mDropped;
+  stats[UWB_NTF_QUEUE_STAT_COALESCED] = mCoalesced;
+  stats[UWB_NTF_QUEUE_STAT_BLOCKED] = mBlocked;
+  stats[UWB_NTF_QUEUE_STAT_CONTROL_DROPPED] = mControlDropped;
+}
+
+/*******************************************************************************
+**
+** Function:        postControl
+**
+** Description:     Append a control notification to the control ring. Never
+**                  waits for the dispatcher thread and never allocates: a
+**                  vendor or raw UCI notification is dropped once the free
+**                  entries are down to UWB_NOTIFICATION_CONTROL_RESERVE, any
+**                  other once the ring is full.
+**
+** Params:          fill: fills in the queue entry, called with the control
+**                  queue lock held.
+**
+** Returns:         None
+**
+*******************************************************************************/
+template <typename F> void UwbNotificationDispatcher::postControl(F fill) {
+  uint8_t type;
+  {
+    std::lock_guard<std::mutex> lock(mControlMutex);
+    if (mControlCount >= UWB_NOTIFICATION_CONTROL_DEPTH) {
+      mControlDropped++;
+      JNI_TRACE_E("%s: control queue full, notification dropped", __func__);
+      return;
+    }
+    tUWB_NOTIFICATION &ntf =
+        mControlRing[(mControlHead + mControlCount) %
+                     UWB_NOTIFICATION_CONTROL_DEPTH];
+    fill(ntf);
+    type = ntf.type;
+    bool isBulk = type == UWB_NTF_VENDOR_UCI || type == UWB_NTF_RAW_UCI ||
+                  type == UWB_NTF_VENDOR_UCI_BATCHED ||
+                  type == UWB_NTF_RAW_UCI_BATCHED;
+    if (isBulk && mControlCount >= UWB_NOTIFICATION_CONTROL_DEPTH -
+                                       UWB_NOTIFICATION_CONTROL_RESERVE) {
+      mControlDropped++;
+      JNI_TRACE_E("%s: control queue reserve reached, type %d dropped",
+                  __func__, type);
+      return;
+    }
+    ntf.seq = mNextSeq.fetch_add(1, std::memory_order_relaxed);
+    mControlCount++;
+    mControlPending++;
+  }
+  mEnqueued++;
+  UWB_TRACE(UWB_TRACE_NTF_POST, type, mControlPending.load(), 0, 0);
+  onPosted();
+}
+
+void UwbNotificationDispatcher::postDeviceState(uint8_t state) {
+  postControl([state](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_DEVICE_STATE;
+    ntf.status = state;
+  });
+}
+
+void UwbNotificationDispatcher::postVendorDeviceInfo(uint8_t *data,
+                                                     uint8_t length) {
+  postPayload(UWB_NTF_VENDOR_DEVICE_INFO, 0, 0, data, length);
+}
+
+void UwbNotificationDispatcher::postSessionStatus(uint32_t sessionId,
+                                                  uint8_t state,
+                                                  uint8_t reasonCode) {
+  postControl([sessionId, state, reasonCode](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_SESSION_STATUS;
+    ntf.session_status.session_id = sessionId;
+    ntf.session_status.state = state;
+    ntf.session_status.reason_code = reasonCode;
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        postRangeData
+**
+** Description:     Queue a two way ranging notification according to the
+**                  overflow policy. The notification is copied by value.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbNotificationDispatcher::postRangeData(tUWA_RANGE_DATA_NTF *rangingNtf) {
+  uint8_t policy = mPolicy;
+  if (policy == UWB_NTF_QUEUE_POLICY_COALESCE_PER_SESSION &&
+      postToMailbox(rangingNtf)) {
+    return;
+  }
+  mProducerNtf.type = UWB_NTF_RANGE_DATA;
+  mProducerNtf.range_data = *rangingNtf;
+  post(policy != UWB_NTF_QUEUE_POLICY_BLOCK);
+}
+
+/*******************************************************************************
+**
+** Function:        postTdoaRangeData
+**
+** Description:     Decode a TDoA ranging notification into the queue entry,
+**                  copying the device info and blink payloads it points to.
+**                  TDoA rounds are not coalesced, under that policy the
+**                  oldest ranging entry is evicted to make room.
+**
+** Params:          rangingNtf: one way ranging data notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbNotificationDispatcher::postTdoaRangeData(
+    tUWA_RANGE_DATA_NTF *rangingNtf) {
+  mProducerNtf.type = UWB_NTF_TDOA_RANGE_DATA;
+  UwbTdoaRangeDataBatch::decode(rangingNtf, &mProducerNtf.tdoa_range_data);
+  post(mPolicy != UWB_NTF_QUEUE_POLICY_BLOCK);
+}
+
+/* Position fixes are evictable like the ranging data they replace */
+void UwbNotificationDispatcher::postPositionFix(const tUWB_POSITION_FIX &fix) {
+  mProducerNtf.type = UWB_NTF_POSITION_FIX;
+  mProducerNtf.position_fix = fix;
+  post(mPolicy != UWB_NTF_QUEUE_POLICY_BLOCK);
+}
+
+void UwbNotificationDispatcher::postRangeDataBatchFlush() {
+  postControl([](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_RANGE_DATA_BATCH_FLUSH;
+  });
+}
+
+void UwbNotificationDispatcher::postVendorNtfBatchFlush() {
+  postControl([](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_VENDOR_UCI_BATCH_FLUSH;
+  });
+}
+
+void UwbNotificationDispatcher::postMulticastListUpdate(
+    tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF *multicastListNtf) {
+  postControl([multicastListNtf](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_MULTICAST_LIST_UPDATE;
+    ntf.multicast_list = *multicastListNtf;
+  });
+}
+
+/* A multicast list chunk the UWBS rejected, posted from the JNI caller so
+ * that its report is merged and delivered in order with the continuation
+ * notifications of the same update */
+void UwbNotificationDispatcher::postControleeChunkFailed(
+    uint32_t sessionId, const tUWB_CONTROLEE_OP *ops, uint8_t count,
+    uint8_t status) {
+  count = std::min<uint8_t>(count, MAX_NUM_CONTROLLEES);
+  postControl([sessionId, ops, count, status](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_CONTROLEE_CHUNK_FAILED;
+    ntf.multicast_list.session_id = sessionId;
+    ntf.multicast_list.remaining_list = 0;
+    ntf.multicast_list.no_of_controlees = count;
+    for (uint8_t i = 0; i < count; i++) {
+      ntf.multicast_list.controlee_mac_address_list[i] = ops[i].shortAddress;
+      ntf.multicast_list.subsession_id_list[i] = ops[i].subSessionId;
+      ntf.multicast_list.status_list[i] = status;
+    }
+  });
+}
+
+void UwbNotificationDispatcher::postBlinkDataTx(uint8_t status) {
+  postControl([status](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_BLINK_DATA_TX;
+    ntf.status = status;
+  });
+}
+
+void UwbNotificationDispatcher::postVendorUciNotification(uint8_t gid,
+                                                          uint8_t oid,
+                                                          uint8_t *data,
+                                                          uint16_t length) {
+  switch (UwbVendorNtfFilter::getInstance().classify(gid, oid)) {
+  case UWB_VENDOR_NTF_DROP:
+    return;
+  case UWB_VENDOR_NTF_BATCH:
+    postPayload(UWB_NTF_VENDOR_UCI_BATCHED, gid, oid, data, length);
+    return;
+  default:
+    postPayload(UWB_NTF_VENDOR_UCI, gid, oid, data, length);
+    return;
+  }
+}
+
+/* Raw notifications are filtered by the GID and OID of their UCI header */
+void UwbNotificationDispatcher::postRawUciNotification(uint8_t *data,
+                                                       uint16_t length) {
+  uint8_t mode = UWB_VENDOR_NTF_PASS;
+  uint8_t gid = 0;
+  uint8_t oid = 0;
+  if (data != NULL && length >= UCI_MSG_HDR_SIZE) {
+    gid = data[0] & 0x0F;
+    oid = data[1] & 0x3F;
+    mode = UwbVendorNtfFilter::getInstance().classify(gid, oid);
+  }
+  switch (mode) {
+  case UWB_VENDOR_NTF_DROP:
+    return;
+  case UWB_VENDOR_NTF_BATCH:
+    postPayload(UWB_NTF_RAW_UCI_BATCHED, gid, oid, data, length);
+    return;
+  default:
+    postPayload(UWB_NTF_RAW_UCI, 0, 0, data, length);
+    return;
+  }
+}
+
+void UwbNotificationDispatcher::postCoreGenericError(uint8_t status) {
+  postControl([status](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_CORE_GENERIC_ERROR;
+    ntf.status = status;
+  });
+}
+
+/* Also posted from the thread calling UwbCommandPipeline::abortAll() */
+void UwbNotificationDispatcher::postCommandComplete(
+    uint32_t token, eUWB_CMD cmd, const tUWB_CMD_RESULT &result) {
+  postControl([token, cmd, &result](tUWB_NOTIFICATION &ntf) {
+    ntf.type = UWB_NTF_COMMAND_COMPLETE;
+    ntf.command.token = token;
+    ntf.command.cmd = cmd;
+    ntf.command.status = result.status;
+    ntf.command.value = result.value;
+    ntf.command.len =
+        std::min<uint16_t>(result.len, sizeof(ntf.command.data));
+    if (ntf.command.len > 0) {
+      memcpy(ntf.command.data, result.data, ntf.command.len);
+    }
+  });
+}
+
+void UwbNotificationDispatcher::postPayload(uint8_t type, uint8_t gid,
+                                            uint8_t oid, uint8_t *data,
+                                            uint16_t length) {
+  if (length > sizeof(mProducerNtf.payload.data)) {
+    JNI_TRACE_E("%s: length %d exceeds max %zu, truncated", __func__, length,
+                sizeof(mProducerNtf.payload.data));
+    length = sizeof(mProducerNtf.payload.data);
+  }
+  postControl([type, gid, oid, data, length](tUWB_NOTIFICATION &ntf) {
+    ntf.type = type;
+    ntf.payload.gid = gid;
+    ntf.payload.oid = oid;
+    ntf.payload.len = (data == NULL) ? 0 : length;
+    if (ntf.payload.len > 0) {
+      memcpy(ntf.payload.data, data, ntf.payload.len);
+    }
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        postToMailbox
+**
+** Description:     Store a ranging notification in its session mailbox. Only
+**                  the first notification of an undelivered mailbox queues a
+**                  token, later ones replace the mailbox content.
+**
+** Params:          rangingNtf: ranging data notification.
+**
+** Returns:         false if no mailbox is available for the session.
+**
+*******************************************************************************/
+bool UwbNotificationDispatcher::postToMailbox(tUWA_RANGE_DATA_NTF *rangingNtf) {
+  int freeMailbox = -1;
+  {
+    std::lock_guard<std::mutex> lock(mMailboxMutex);
+    for (int i = 0; i < UWB_NOTIFICATION_MAX_MAILBOXES; i++) {
+      Mailbox &mailbox = mMailboxes[i];
+      if (mailbox.pending && mailbox.sessionId == rangingNtf->session_id) {
+        mailbox.rangeData = *rangingNtf;
+        mCoalesced++;
+        return true;
+      }
+      if (!mailbox.pending && freeMailbox < 0) {
+        freeMailbox = i;
+      }
+    }
+    if (freeMailbox < 0) {
+      return false;
+    }
+    Mailbox &mailbox = mMailboxes[freeMailbox];
+    mailbox.pending = true;
+    mailbox.sessionId = rangingNtf->session_id;
+    mailbox.rangeData = *rangingNtf;
+  }
+  mProducerNtf.type = UWB_NTF_RANGE_DATA_MAILBOX;
+  mProducerNtf.mailbox = freeMailbox;
+  // Mailbox tokens are never evicted and take at most
+  // UWB_NOTIFICATION_MAX_MAILBOXES entries, so eviction always makes room
+  post(true);
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        post
+**
+** Description:     Push mProducerNtf, a ranging notification, to the data
+**                  queue. When the queue is full, either evict the oldest
+**                  queued ranging notification or wait for the dispatcher
+**                  thread, as the overflow policy says. A mailbox token at
+**                  the head is moved behind the others rather than evicted,
+**                  its mailbox already holds the newest round.
+**
+** Params:          mayDropOldest: eviction allowed for this notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbNotificationDispatcher::post(bool mayDropOldest) {
+  mProducerNtf.seq = mNextSeq.fetch_add(1, std::memory_order_relaxed);
+  while (!mQueue.tryPush(mProducerNtf)) {
+    if (mayDropOldest && mQueue.tryPop(mEvictedNtf)) {
+      if (mEvictedNtf.type == UWB_NTF_RANGE_DATA_MAILBOX) {
+        // Only this thread pushes, the cell just freed is still free
+        mQueue.tryPush(mEvictedNtf);
+      } else {
+        mDropped++;
+      }
+      continue;
+    }
+    waitNotFull();
+  }
+  mEnqueued++;
+  int64_t depth = mQueue.size();
+  UWB_TRACE(UWB_TRACE_NTF_POST, mProducerNtf.type, depth, 0, 0);
+  int64_t highWater = mHighWater.load(std::memory_order_relaxed);
+  while (depth > highWater &&
+         !mHighWater.compare_exchange_weak(highWater, depth,
+                                           std::memory_order_relaxed)) {
+  }
+  onPosted();
+}
+
+void UwbNotificationDispatcher::onPosted() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mConsumerWaiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mNotEmpty.notify_one();
+  }
+}
+
+void UwbNotificationDispatcher::waitNotFull() {
+  mBlocked++;
+  std::unique_lock<std::mutex> lock(mWaitMutex);
+  mProducerWaiting.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  mNotFull.wait(lock, [this]() { return !mQueue.full(); });
+  mProducerWaiting.store(false, std::memory_order_relaxed);
+}
+
+/*******************************************************************************
+**
+** Function:        dispatchLoop
+**
+** Description:     Body of the dispatcher thread. Attaches to the JVM once so
+**                  the ScopedJniEnv in UwbEventManager finds an attached
+**                  thread and never attaches or detaches per notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbNotificationDispatcher::dispatchLoop() {
+  JNIEnv *env = NULL;
+  JavaVMAttachArgs args = {JNI_VERSION_1_6, DISPATCHER_THREAD_NAME, NULL};
+  if (mVm->AttachCurrentThread(&env, &args) != JNI_OK) {
+    JNI_TRACE_E("%s: fail to attach dispatcher thread", __func__);
+  }
+
+  for (;;) {
+    if (popNext(mConsumerNtf)) {
+      dispatch(mConsumerNtf);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    mConsumerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    mNotEmpty.wait(lock, [this]() { return hasPending(); });
+    mConsumerWaiting.store(false, std::memory_order_relaxed);
+  }
+}
+
+bool UwbNotificationDispatcher::hasPending() const {
+  return !mQueue.empty() || mControlPending.load() > 0;
+}
+
+/*******************************************************************************
+**
+** Function:        popNext
+**
+** Description:     Take the oldest notification of the data and control
+**                  queues. The head of the data queue is looked at first:
+**                  control notifications posted on the callback thread
+**                  before it are then already visible.
+**
+** Params:          ntf: receives the notification.
+**
+** Returns:         false if nothing was taken, the caller checks again.
+**
+*******************************************************************************/
+bool UwbNotificationDispatcher::popNext(tUWB_NOTIFICATION &ntf) {
+  bool haveData = false;
+  uint32_t dataSeq = 0;
+  mQueue.tryPopIf(
+      [&haveData, &dataSeq](const tUWB_NOTIFICATION &head) {
+        haveData = true;
+        dataSeq = head.seq;
+        return false;
+      },
+      ntf);
+
+  if (mControlPending.load() > 0) {
+    std::lock_guard<std::mutex> lock(mControlMutex);
+    tUWB_NOTIFICATION &control = mControlRing[mControlHead];
+    if (!haveData || (int32_t)(control.seq - dataSeq) < 0) {
+      ntf = control;
+      mControlHead = (mControlHead + 1) % UWB_NOTIFICATION_CONTROL_DEPTH;
+      mControlCount--;
+      mControlPending--;
+      return true;
+    }
+  }
+
+  // The producer may have evicted the head since, then look again
+  if (!haveData ||
+      !mQueue.tryPopIf(
+          [dataSeq](const tUWB_NOTIFICATION &head) {
+            return head.seq == dataSeq;
+          },
+          ntf)) {
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mProducerWaiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mNotFull.notify_one();
+  }
+  return true;
+}
+
+void UwbNotificationDispatcher::dispatch(tUWB_NOTIFICATION &ntf) {
+  UwbEventManager &uwbEventManager = mEventManager;
+  uint8_t type = ntf.type;
+  int64_t startUs = UwbJniStats::nowUs();
+
+  switch (ntf.type) {
+  case UWB_NTF_DEVICE_STATE:
+    uwbEventManager.onDeviceStateNotificationReceived(ntf.status);
+    break;
+  case UWB_NTF_VENDOR_DEVICE_INFO:
+    uwbEventManager.onVendorDeviceInfo(ntf.payload.data, ntf.payload.len);
+    break;
+  case UWB_NTF_SESSION_STATUS:
+    uwbEventManager.onSessionStatusNotificationReceived(
+        ntf.session_status.session_id, ntf.session_status.state,
+        ntf.session_status.reason_code);
+    break;
+  case UWB_NTF_RANGE_DATA:
+    uwbEventManager.onRangeDataNotificationReceived(&ntf.range_data);
+    break;
+  case UWB_NTF_RANGE_DATA_MAILBOX: {
+    {
+      std::lock_guard<std::mutex> lock(mMailboxMutex);
+      Mailbox &mailbox = mMailboxes[ntf.mailbox];
+      ntf.type = UWB_NTF_RANGE_DATA;
+      ntf.range_data = mailbox.rangeData;
+      mailbox.pending = false;
+    }
+    uwbEventManager.onRangeDataNotificationReceived(&ntf.range_data);
+  } break;
+  case UWB_NTF_RANGE_DATA_BATCH_FLUSH:
+    uwbEventManager.flushRangeDataBatch();
+    break;
+  case UWB_NTF_TDOA_RANGE_DATA:
+    uwbEventManager.onTdoaRangeDataReceived(ntf.tdoa_range_data);
+    break;
+  case UWB_NTF_POSITION_FIX:
+    uwbEventManager.onPositionFixReceived(ntf.position_fix);
+    break;
+  case UWB_NTF_MULTICAST_LIST_UPDATE:
+    uwbEventManager.onMulticastListUpdateNotificationReceived(
+        &ntf.multicast_list);
+    break;
+  case UWB_NTF_CONTROLEE_CHUNK_FAILED:
+    uwbEventManager.onControleeChunkFailed(ntf.multicast_list);
+    break;
+  case UWB_NTF_BLINK_DATA_TX:
+    uwbEventManager.onBlinkDataTxNotificationReceived(ntf.status);
+    break;
+  case UWB_NTF_VENDOR_UCI:
+    uwbEventManager.onVendorUciNotificationReceived(
+        ntf.payload.gid, ntf.payload.oid, ntf.payload.data, ntf.payload.len);
+    break;
+  case UWB_NTF_RAW_UCI:
+    uwbEventManager.onRawUciNotificationReceived(ntf.payload.data,
+                                                 ntf.payload.len);
+    break;
+  case UWB_NTF_VENDOR_UCI_BATCHED:
+  case UWB_NTF_RAW_UCI_BATCHED:
+    uwbEventManager.onVendorUciNotificationBatched(
+        ntf.type == UWB_NTF_RAW_UCI_BATCHED, ntf.payload.gid, ntf.payload.oid,
+        ntf.payload.data, ntf.payload.len);
+    break;
+  case UWB_NTF_VENDOR_UCI_BATCH_FLUSH:
+    uwbEventManager.flushVendorNtfBatch();
+    break;
+  case UWB_NTF_CORE_GENERIC_ERROR:
+    uwbEventManager.onCoreGenericErrorNotificationReceived(ntf.status);
+    break;
+  case UWB_NTF_COMMAND_COMPLETE:
+    uwbEventManager.onCommandCompleted(ntf.command.token, ntf.command.cmd,
+                                       ntf.command.status, ntf.command.value,
+                                       ntf.command.data, ntf.command.len);
+    break;
+  default:
+    JNI_TRACE_E("%s: unknown notification type %d", __func__, ntf.type);
+    break;
+  }
+  int64_t durationUs = UwbJniStats::nowUs() - startUs;
+  mStats.recordUpcall(type, durationUs);
+  UWB_TRACE(UWB_TRACE_NTF_DISPATCH, type, durationUs, 0, 0);
+}
+
+} // namespace android
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_NOTIFICATION_DISPATCHER_H_
+#define _UWB_NOTIFICATION_DISPATCHER_H_
+
+#include <jni.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "UwbBoundedQueue.h"
+#include "UwbCommandPipeline.h"
+#include "UwbControleeRegistry.h"
+#include "UwbPositionSolver.h"
+#include "UwbTdoaRangeData.h"
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+class UwbEventManager;
+class UwbJniStats;
+
+/* Number of notifications buffered between the UCI callback and Java */
+#define UWB_NOTIFICATION_QUEUE_DEPTH 32
+/* Control notifications buffered between their posters and Java */
+#define UWB_NOTIFICATION_CONTROL_DEPTH 64
+/* Control entries vendor and raw UCI notifications may not take, kept for
+ * status notifications, command completions and batch flushes */
+#define UWB_NOTIFICATION_CONTROL_RESERVE 16
+/* Sessions that can hold a coalesced ranging notification at the same time */
+#define UWB_NOTIFICATION_MAX_MAILBOXES 16
+
+/* What the producer does when the ranging queue is full. Control
+ * notifications (session/device status, errors, multicast, vendor, command
+ * completions, batch flushes) have a fixed ring of their own and never wait:
+ * vendor and raw UCI notifications are dropped once they would eat into
+ * UWB_NOTIFICATION_CONTROL_RESERVE, everything else only once the ring is
+ * full. Drops are counted. */
+enum {
+  /* Evict the oldest queued ranging notification or position fix */
+  UWB_NTF_QUEUE_POLICY_DROP_OLDEST = 0,
+  /* Keep only the newest undelivered two way ranging notification per
+   * session, default. Rounds without a free mailbox and TDoA rounds fall
+   * back to drop oldest, the UCI callback thread never waits. */
+  UWB_NTF_QUEUE_POLICY_COALESCE_PER_SESSION = 1,
+  /* Wait for the dispatcher thread to make room. A slow Java listener then
+   * stalls the UCI callback thread and the responses behind the ranging
+   * data, only meant for capture and test setups that must not lose data */
+  UWB_NTF_QUEUE_POLICY_BLOCK = 2,
+};
+
+/* Layout of the array returned by nativeGetNotificationQueueStats() */
+enum {
+  UWB_NTF_QUEUE_STAT_DEPTH = 0,
+  UWB_NTF_QUEUE_STAT_HIGH_WATER,
+  UWB_NTF_QUEUE_STAT_ENQUEUED,
+  UWB_NTF_QUEUE_STAT_DROPPED,
+  UWB_NTF_QUEUE_STAT_COALESCED,
+  UWB_NTF_QUEUE_STAT_BLOCKED,
+  UWB_NTF_QUEUE_STAT_CONTROL_DROPPED,
+  UWB_NTF_QUEUE_STAT_MAX
+};
+
+typedef enum {
+  UWB_NTF_DEVICE_STATE,
+  UWB_NTF_VENDOR_DEVICE_INFO,
+  UWB_NTF_SESSION_STATUS,
+  UWB_NTF_RANGE_DATA,
+  UWB_NTF_RANGE_DATA_MAILBOX,
+  UWB_NTF_RANGE_DATA_BATCH_FLUSH,
+  UWB_NTF_MULTICAST_LIST_UPDATE,
+  UWB_NTF_BLINK_DATA_TX,
+  UWB_NTF_VENDOR_UCI,
+  UWB_NTF_RAW_UCI,
+  UWB_NTF_CORE_GENERIC_ERROR,
+  UWB_NTF_COMMAND_COMPLETE,
+  UWB_NTF_VENDOR_UCI_BATCHED,
+  UWB_NTF_RAW_UCI_BATCHED,
+  UWB_NTF_POSITION_FIX,
+  UWB_NTF_TDOA_RANGE_DATA,
+  UWB_NTF_VENDOR_UCI_BATCH_FLUSH,
+  UWB_NTF_CONTROLEE_CHUNK_FAILED,
+  UWB_NTF_TYPE_MAX
+} eUWB_NOTIFICATION_TYPE;
+
+/* Self contained copy of a notification, nothing points back into the
+ * callback data of the UCI stack. */
+typedef struct {
+  uint8_t type;
+  uint32_t seq; // posting order across the data and control queues
+  union {
+    uint8_t status;
+    uint8_t mailbox;
+    struct {
+      uint32_t session_id;
+      uint8_t state;
+      uint8_t reason_code;
+    } session_status;
+    tUWA_RANGE_DATA_NTF range_data;
+    tUWB_POSITION_FIX position_fix;
+    tUWB_TDOA_RANGE_DATA tdoa_range_data;
+    tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF multicast_list; // also chunks
+    struct {
+      uint8_t gid;
+      uint8_t oid;
+      uint16_t len;
+      uint8_t data[UCI_MAX_PKT_SIZE];
+    } payload;
+    struct {
+      uint32_t token;
+      uint8_t cmd;
+      uint8_t status;
+      uint8_t value;
+      uint16_t len;
+      uint8_t data[UCI_MAX_PAYLOAD_SIZE];
+    } command;
+  };
+} tUWB_NOTIFICATION;
+
+/* Moves JNI upcalls off the UCI stack callback thread. The callback thread
+ * copies each ranging notification into a bounded lock-free queue and
+ * returns; control notifications go to a fixed mutex guarded ring that any
+ * thread may post to and that never makes the poster wait or allocate. A single
+ * dispatcher thread, attached to the JVM once, drains both queues into
+ * UwbEventManager in posting order. */
+class UwbNotificationDispatcher {
+public:
+  void start(JavaVM *vm);
+  bool setOverflowPolicy(uint8_t policy);
+  void getStats(int64_t stats[UWB_NTF_QUEUE_STAT_MAX]);
+
+  /* Producer side. Ranging data is posted from the UCI stack callback thread
+   * only, control notifications may be posted from any thread. */
+  void postDeviceState(uint8_t state);
+  void postVendorDeviceInfo(uint8_t *data, uint8_t length);
+  void postSessionStatus(uint32_t sessionId, uint8_t state,
+                         uint8_t reasonCode);
+  void postRangeData(tUWA_RANGE_DATA_NTF *rangingNtf);
+  void postTdoaRangeData(tUWA_RANGE_DATA_NTF *rangingNtf);
+  void postRangeDataBatchFlush();
+  void postVendorNtfBatchFlush();
+  void postPositionFix(const tUWB_POSITION_FIX &fix);
+  void postMulticastListUpdate(
+      tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF *multicastListNtf);
+  void postControleeChunkFailed(uint32_t sessionId,
+                                const tUWB_CONTROLEE_OP *ops, uint8_t count,
+                                uint8_t status);
+  void postBlinkDataTx(uint8_t status);
+  void postVendorUciNotification(uint8_t gid, uint8_t oid, uint8_t *data,
+                                 uint16_t length);
+  void postRawUciNotification(uint8_t *data, uint16_t length);
+  void postCoreGenericError(uint8_t status);
+  void postCommandComplete(uint32_t token, eUWB_CMD cmd,
+                           const tUWB_CMD_RESULT &result);
+
+private:
+  friend class UwbChipContext;
+  UwbNotificationDispatcher(UwbEventManager &eventManager, UwbJniStats &stats);
+
+  void postPayload(uint8_t type, uint8_t gid, uint8_t oid, uint8_t *data,
+                   uint16_t length);
+  void post(bool mayDropOldest);
+  template <typename F> void postControl(F fill);
+  bool postToMailbox(tUWA_RANGE_DATA_NTF *rangingNtf);
+  bool popNext(tUWB_NOTIFICATION &ntf);
+  bool hasPending() const;
+  void waitNotFull();
+  void onPosted();
+  void dispatchLoop();
+  void dispatch(tUWB_NOTIFICATION &ntf);
+
+  UwbEventManager &mEventManager; // upcall target of the chip
+  UwbJniStats &mStats;
+
+  struct Mailbox {
+    bool pending;
+    uint32_t sessionId;
+    tUWA_RANGE_DATA_NTF rangeData;
+  };
+
+  JavaVM *mVm;
+  std::once_flag mStartOnce;
+  std::thread mThread;
+  std::atomic<uint8_t> mPolicy;
+
+  UwbBoundedQueue<tUWB_NOTIFICATION, UWB_NOTIFICATION_QUEUE_DEPTH> mQueue;
+  std::atomic<uint32_t> mNextSeq;
+  tUWB_NOTIFICATION mProducerNtf; // producer scratch, callback thread only
+  tUWB_NOTIFICATION mEvictedNtf;  // drop-oldest victim, callback thread only
+  tUWB_NOTIFICATION mConsumerNtf; // consumer scratch, dispatcher thread only
+
+  std::mutex mControlMutex;
+  tUWB_NOTIFICATION mControlRing[UWB_NOTIFICATION_CONTROL_DEPTH];
+  uint32_t mControlHead;
+  uint32_t mControlCount;
+  std::atomic<uint32_t> mControlPending; // mControlCount, read without lock
+
+  std::mutex mMailboxMutex;
+  Mailbox mMailboxes[UWB_NOTIFICATION_MAX_MAILBOXES];
+
+  std::mutex mWaitMutex;
+  std::condition_variable mNotEmpty;
+  std::condition_variable mNotFull;
+  std::atomic<bool> mConsumerWaiting;
+  std::atomic<bool> mProducerWaiting;
+
+  std::atomic<int64_t> mHighWater;
+  std::atomic<int64_t> mEnqueued;
+  std::atomic<int64_t> mDropped;
+  std::atomic<int64_t> mCoalesced;
+  std::atomic<int64_t> mBlocked;
+  std::atomic<int64_t> mControlDropped;
+};
+
+} // namespace android
+#endif
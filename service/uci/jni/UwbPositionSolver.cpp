@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "UwbPositionSolver.h"
+
+namespace android {
+
+/* Pivot below this fraction of the largest diagonal element is singular */
+#define UWB_POSITION_SINGULAR_EPSILON 1e-9
+
+/* Solve the dim x dim system m * x = v by Gaussian elimination with partial
+ * pivoting, m and v are overwritten. */
+static bool solveNormalEquations(double m[3][3], double v[3], int dim,
+                                 double *x) {
+  double scale = 0;
+  for (int i = 0; i < dim; i++) {
+    scale = std::max(scale, fabs(m[i][i]));
+  }
+  if (scale == 0) {
+    return false;
+  }
+  for (int col = 0; col < dim; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < dim; row++) {
+      if (fabs(m[row][col]) > fabs(m[pivot][col])) {
+        pivot = row;
+      }
+    }
+    if (fabs(m[pivot][col]) <= UWB_POSITION_SINGULAR_EPSILON * scale) {
+      return false;
+    }
+    if (pivot != col) {
+      for (int k = 0; k < dim; k++) {
+        std::swap(m[col][k], m[pivot][k]);
+      }
+      std::swap(v[col], v[pivot]);
+    }
+    for (int row = col + 1; row < dim; row++) {
+      double factor = m[row][col] / m[col][col];
+      for (int k = col; k < dim; k++) {
+        m[row][k] -= factor * m[col][k];
+      }
+      v[row] -= factor * v[col];
+    }
+  }
+  for (int row = dim - 1; row >= 0; row--) {
+    double sum = v[row];
+    for (int k = row + 1; k < dim; k++) {
+      sum -= m[row][k] * x[k];
+    }
+    x[row] = sum / m[row][row];
+  }
+  return true;
+}
+
+UwbPositionSolver::UwbPositionSolver() { reset(); }
+
+/*******************************************************************************
+**
+** Function:        configure
+**
+** Description:     Register the anchors of the session.
+**
+** Params:          anchors: anchor addresses and coordinates.
+**                  noOfAnchors: number of anchors, at most MAX_NUM_RESPONDERS.
+**                  flags: UWB_POSITION_FLAG_* bits.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbPositionSolver::configure(const tUWB_POSITION_ANCHOR *anchors,
+                                  uint8_t noOfAnchors, uint8_t flags) {
+  mFlags = flags;
+  mNoOfAnchors = std::min<uint8_t>(noOfAnchors, MAX_NUM_RESPONDERS);
+  for (int i = 0; i < mNoOfAnchors; i++) {
+    memcpy(mMacAddr[i], anchors[i].macAddr, sizeof(mMacAddr[i]));
+    mAnchorX[i] = anchors[i].x;
+    mAnchorY[i] = anchors[i].y;
+    mAnchorZ[i] = anchors[i].z;
+  }
+}
+
+int UwbPositionSolver::findAnchor(const uint8_t *macAddr,
+                                  int macAddrLen) const {
+  for (int i = 0; i < mNoOfAnchors; i++) {
+    if (memcmp(mMacAddr[i], macAddr, macAddrLen) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*******************************************************************************
+**
+** Function:        solve
+**
+** Description:     Solve the tag position from the two way distances of the
+**                  notification to the registered anchors. Measurements of
+**                  unknown peers or without a valid distance are skipped.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**                  fix: receives the position, check its status.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbPositionSolver::solve(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                              tUWB_POSITION_FIX *fix) {
+  memset(fix, 0, sizeof(*fix));
+  fix->sessionId = rangingNtf->session_id;
+  fix->seqCounter = rangingNtf->seq_counter;
+
+  const int macAddrLen =
+      rangingNtf->mac_addr_mode_indicator == SHORT_MAC_ADDRESS ? 2 : 8;
+  const int dim = (mFlags & UWB_POSITION_FLAG_2D) ? 2 : 3;
+  int noOfMeasurements =
+      std::min<int>(rangingNtf->no_of_measurements, MAX_NUM_RESPONDERS);
+  int n = 0;
+  for (int i = 0; i < noOfMeasurements; i++) {
+    const tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    if (twr_range_measr.status != UWA_STATUS_OK ||
+        twr_range_measr.distance == UWB_INVALID_DISTANCE) {
+      continue;
+    }
+    int anchor = findAnchor(twr_range_measr.mac_addr, macAddrLen);
+    if (anchor < 0) {
+      continue;
+    }
+    mX[n] = mAnchorX[anchor];
+    mY[n] = mAnchorY[anchor];
+    mZ[n] = dim == 3 ? mAnchorZ[anchor] : 0;
+    mDistance[n] = twr_range_measr.distance;
+    n++;
+  }
+  fix->noOfAnchors = n;
+  if (n < dim + 1) {
+    fix->status = UWB_POSITION_FIX_NOT_ENOUGH_ANCHORS;
+    return;
+  }
+
+  double position[3] = {0, 0, 0};
+  if (!linearSolve(n, dim, position)) {
+    fix->status = UWB_POSITION_FIX_DEGENERATE;
+    return;
+  }
+  bool converged = false;
+  fix->iterations = gaussNewton(n, dim, position, &converged);
+  fix->status = converged ? UWB_POSITION_FIX_OK : UWB_POSITION_FIX_NOT_CONVERGED;
+
+  double sumSquares = 0;
+  for (int i = 0; i < n; i++) {
+    double dx = position[0] - mX[i];
+    double dy = position[1] - mY[i];
+    double dz = position[2] - mZ[i];
+    double r = sqrt(dx * dx + dy * dy + dz * dz) - mDistance[i];
+    sumSquares += r * r;
+  }
+  fix->x = (int32_t)lround(position[0]);
+  fix->y = (int32_t)lround(position[1]);
+  fix->z = (int32_t)lround(position[2]);
+  fix->rmsResidual = (uint16_t)std::min(lround(sqrt(sumSquares / n)), 0xFFFFL);
+}
+
+/* Initial estimate: subtracting the range equation of the first anchor from
+ * the others removes the quadratic term, leaving the linear system
+ * 2 (a_i - a_0) . p = |a_i|^2 - |a_0|^2 - d_i^2 + d_0^2, solved in the least
+ * squares sense. */
+bool UwbPositionSolver::linearSolve(int n, int dim, double *position) const {
+  double ax[MAX_NUM_RESPONDERS], ay[MAX_NUM_RESPONDERS], az[MAX_NUM_RESPONDERS];
+  double b[MAX_NUM_RESPONDERS];
+  const double k0 = mX[0] * mX[0] + mY[0] * mY[0] + mZ[0] * mZ[0] -
+                    mDistance[0] * mDistance[0];
+  for (int i = 1; i < n; i++) {
+    ax[i] = 2 * (mX[i] - mX[0]);
+    ay[i] = 2 * (mY[i] - mY[0]);
+    az[i] = 2 * (mZ[i] - mZ[0]);
+    b[i] = mX[i] * mX[i] + mY[i] * mY[i] + mZ[i] * mZ[i] -
+           mDistance[i] * mDistance[i] - k0;
+  }
+
+  double m[3][3] = {}, v[3] = {};
+  for (int i = 1; i < n; i++) {
+    m[0][0] += ax[i] * ax[i];
+    m[0][1] += ax[i] * ay[i];
+    m[0][2] += ax[i] * az[i];
+    m[1][1] += ay[i] * ay[i];
+    m[1][2] += ay[i] * az[i];
+    m[2][2] += az[i] * az[i];
+    v[0] += ax[i] * b[i];
+    v[1] += ay[i] * b[i];
+    v[2] += az[i] * b[i];
+  }
+  m[1][0] = m[0][1];
+  m[2][0] = m[0][2];
+  m[2][1] = m[1][2];
+  return solveNormalEquations(m, v, dim, position);
+}
+
+/* Refine the estimate by minimizing the range residuals
+ * r_i = |p - a_i| - d_i. Returns the number of iterations run. */
+int UwbPositionSolver::gaussNewton(int n, int dim, double *position,
+                                   bool *converged) const {
+  double ux[MAX_NUM_RESPONDERS], uy[MAX_NUM_RESPONDERS], uz[MAX_NUM_RESPONDERS];
+  double r[MAX_NUM_RESPONDERS];
+  int iteration = 0;
+  while (iteration < UWB_POSITION_MAX_ITERATIONS) {
+    iteration++;
+    /* Unit vectors from the anchors to the estimate form the Jacobian */
+    for (int i = 0; i < n; i++) {
+      double dx = position[0] - mX[i];
+      double dy = position[1] - mY[i];
+      double dz = position[2] - mZ[i];
+      double range = sqrt(dx * dx + dy * dy + dz * dz);
+      double inv = range > 0 ? 1 / range : 0;
+      ux[i] = dx * inv;
+      uy[i] = dy * inv;
+      uz[i] = dz * inv;
+      r[i] = range - mDistance[i];
+    }
+
+    double m[3][3] = {}, v[3] = {};
+    for (int i = 0; i < n; i++) {
+      m[0][0] += ux[i] * ux[i];
+      m[0][1] += ux[i] * uy[i];
+      m[0][2] += ux[i] * uz[i];
+      m[1][1] += uy[i] * uy[i];
+      m[1][2] += uy[i] * uz[i];
+      m[2][2] += uz[i] * uz[i];
+      v[0] -= ux[i] * r[i];
+      v[1] -= uy[i] * r[i];
+      v[2] -= uz[i] * r[i];
+    }
+    m[1][0] = m[0][1];
+    m[2][0] = m[0][2];
+    m[2][1] = m[1][2];
+
+    double delta[3] = {0, 0, 0};
+    if (!solveNormalEquations(m, v, dim, delta)) {
+      break;
+    }
+    double step = 0;
+    for (int k = 0; k < dim; k++) {
+      position[k] += delta[k];
+      step += delta[k] * delta[k];
+    }
+    if (step < UWB_POSITION_CONVERGENCE_CM * UWB_POSITION_CONVERGENCE_CM) {
+      *converged = true;
+      break;
+    }
+  }
+  return iteration;
+}
+
+} // namespace android
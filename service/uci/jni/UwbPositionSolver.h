@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_POSITION_SOLVER_H_
+#define _UWB_POSITION_SOLVER_H_
+
+#include <stdint.h>
+
+#include "UwbRangingFilter.h"
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Solve in the horizontal plane, the z coordinates are ignored */
+#define UWB_POSITION_FLAG_2D 0x01
+/* Deliver the two way measurements in addition to the position fix */
+#define UWB_POSITION_FLAG_KEEP_MEASUREMENTS 0x02
+#define UWB_POSITION_FLAGS_MASK 0x03
+
+/* Gauss-Newton stops once a step is below this distance, in cm */
+#define UWB_POSITION_CONVERGENCE_CM 0.5
+#define UWB_POSITION_MAX_ITERATIONS 10
+
+typedef enum {
+  UWB_POSITION_FIX_OK = 0,
+  /* Fewer anchors with a valid distance than unknowns + 1 */
+  UWB_POSITION_FIX_NOT_ENOUGH_ANCHORS,
+  /* Anchors are collinear (2D) or coplanar (3D) */
+  UWB_POSITION_FIX_DEGENERATE,
+  /* Gauss-Newton did not converge, the best estimate is reported */
+  UWB_POSITION_FIX_NOT_CONVERGED,
+} eUWB_POSITION_FIX_STATUS;
+
+/* Anchor of a session, the coordinates are in cm */
+typedef struct {
+  uint8_t macAddr[8]; // short addresses use the first two bytes
+  int32_t x;
+  int32_t y;
+  int32_t z;
+} tUWB_POSITION_ANCHOR;
+
+typedef struct {
+  uint32_t sessionId;
+  uint32_t seqCounter;
+  uint8_t status;      // eUWB_POSITION_FIX_STATUS
+  uint8_t noOfAnchors; // anchors used by the solution
+  uint8_t iterations;
+  int32_t x; // cm
+  int32_t y;
+  int32_t z;
+  uint16_t rmsResidual; // cm
+} tUWB_POSITION_FIX;
+
+/* Tag position of one ranging session from the two way distances to anchors
+ * at known coordinates. A linearized least-squares solution seeds a
+ * Gauss-Newton refinement of the range residuals. Anchor coordinates are
+ * kept as separate arrays and every per-anchor step is a flat loop over
+ * them, so the compiler can vectorize it. */
+class UwbPositionSolver {
+public:
+  UwbPositionSolver();
+
+  static bool isValidFlags(uint8_t flags) {
+    return (flags & ~UWB_POSITION_FLAGS_MASK) == 0;
+  }
+
+  /* noOfAnchors 0 disables the solver */
+  void configure(const tUWB_POSITION_ANCHOR *anchors, uint8_t noOfAnchors,
+                 uint8_t flags);
+  void reset() { configure(NULL, 0, 0); }
+  bool isActive() const { return mNoOfAnchors > 0; }
+  bool keepMeasurements() const {
+    return (mFlags & UWB_POSITION_FLAG_KEEP_MEASUREMENTS) != 0;
+  }
+
+  /* Solve the position of a two way ranging notification */
+  void solve(const tUWA_RANGE_DATA_NTF *rangingNtf, tUWB_POSITION_FIX *fix);
+
+private:
+  int findAnchor(const uint8_t *macAddr, int macAddrLen) const;
+  bool linearSolve(int n, int dim, double *position) const;
+  int gaussNewton(int n, int dim, double *position, bool *converged) const;
+
+  uint8_t mFlags;
+  uint8_t mNoOfAnchors;
+  uint8_t mMacAddr[MAX_NUM_RESPONDERS][8];
+  int32_t mAnchorX[MAX_NUM_RESPONDERS];
+  int32_t mAnchorY[MAX_NUM_RESPONDERS];
+  int32_t mAnchorZ[MAX_NUM_RESPONDERS];
+
+  /* Anchors with a valid distance in the notification being solved */
+  double mX[MAX_NUM_RESPONDERS];
+  double mY[MAX_NUM_RESPONDERS];
+  double mZ[MAX_NUM_RESPONDERS];
+  double mDistance[MAX_NUM_RESPONDERS];
+};
+
+} // namespace android
+#endif
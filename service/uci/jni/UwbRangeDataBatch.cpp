@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "UwbRangeDataBatch.h"
+
+namespace android {
+
+UwbRangeDataBatch::UwbRangeDataBatch() {
+  mMaxRecords = 0;
+  mFlushTimeoutMs = 0;
+  mRecordCount = 0;
+}
+
+/*******************************************************************************
+**
+** Function:        configure
+**
+** Description:     Set the flush thresholds of the batch. Records already
+**                  buffered are dropped, callers flush before reconfiguring.
+**
+** Params:          maxRecords: records per batch, 0 disables batching.
+**                  flushTimeoutMs: deadline after the first buffered record,
+**                  0 flushes on count only.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRangeDataBatch::configure(uint16_t maxRecords, uint32_t flushTimeoutMs) {
+  if (maxRecords > UWB_RANGE_DATA_BATCH_MAX_RECORDS) {
+    maxRecords = UWB_RANGE_DATA_BATCH_MAX_RECORDS;
+  }
+  mMaxRecords = maxRecords;
+  mFlushTimeoutMs = flushTimeoutMs;
+  mRecordCount = 0;
+}
+
+/*******************************************************************************
+**
+** Function:        append
+**
+** Description:     Copy one two way ranging notification into the next free
+**                  record.
+**
+** Params:          rangingNtf: ranging data notification.
+**
+** Returns:         true once the batch holds maxRecords records and must be
+**                  flushed.
+**
+*******************************************************************************/
+bool UwbRangeDataBatch::append(const tUWA_RANGE_DATA_NTF *rangingNtf) {
+  if (mRecordCount >= mMaxRecords) {
+    return true;
+  }
+  tUWB_RANGE_DATA_BATCH_RECORD &record = mRecords[mRecordCount++];
+  uint8_t noOfMeasurements = rangingNtf->no_of_measurements;
+  if (noOfMeasurements > MAX_NUM_RESPONDERS) {
+    noOfMeasurements = MAX_NUM_RESPONDERS;
+  }
+
+  record.session_id = rangingNtf->session_id;
+  record.seq_counter = rangingNtf->seq_counter;
+  record.curr_range_interval = rangingNtf->curr_range_interval;
+  record.rcr_indication = rangingNtf->rcr_indication;
+  record.ranging_measure_type = rangingNtf->ranging_measure_type;
+  record.mac_addr_mode_indicator = rangingNtf->mac_addr_mode_indicator;
+  record.no_of_measurements = noOfMeasurements;
+
+  for (int i = 0; i < noOfMeasurements; i++) {
+    const tUWA_TWR_RANGING_MEASR &measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    record.distance[i] = measr.distance;
+    record.aoa_azimuth[i] = measr.aoa_azimuth;
+    record.aoa_elevation[i] = measr.aoa_elevation;
+    record.aoa_dest_azimuth[i] = measr.aoa_dest_azimuth;
+    record.aoa_dest_elevation[i] = measr.aoa_dest_elevation;
+    record.status[i] = measr.status;
+    record.nLos[i] = measr.nLos;
+    record.aoa_azimuth_FOM[i] = measr.aoa_azimuth_FOM;
+    record.aoa_elevation_FOM[i] = measr.aoa_elevation_FOM;
+    record.aoa_dest_azimuth_FOM[i] = measr.aoa_dest_azimuth_FOM;
+    record.aoa_dest_elevation_FOM[i] = measr.aoa_dest_elevation_FOM;
+    record.slot_index[i] = measr.slot_index;
+    memcpy(record.mac_addr[i], measr.mac_addr, sizeof(record.mac_addr[i]));
+  }
+  return mRecordCount >= mMaxRecords;
+}
+
+} // namespace android
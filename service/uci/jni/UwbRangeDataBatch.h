@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_RANGE_DATA_BATCH_H_
+#define _UWB_RANGE_DATA_BATCH_H_
+
+#include <stdint.h>
+
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Maximum number of ranging rounds held in one batch */
+#define UWB_RANGE_DATA_BATCH_MAX_RECORDS 64
+/* Layout version reported to Java, bump on any change of the record below */
+#define UWB_RANGE_DATA_BATCH_VERSION 1
+
+/* One ranging round in columnar form. Every record has the same size, so
+ * record i of a batch starts at i * sizeof(tUWB_RANGE_DATA_BATCH_RECORD). Each
+ * column holds MAX_NUM_RESPONDERS entries of which the first
+ * no_of_measurements are valid. Multi-byte values are in native byte order. */
+typedef struct {
+  uint32_t session_id;
+  uint32_t seq_counter;
+  uint32_t curr_range_interval;
+  uint8_t rcr_indication;
+  uint8_t ranging_measure_type;
+  uint8_t mac_addr_mode_indicator;
+  uint8_t no_of_measurements;
+  uint16_t distance[MAX_NUM_RESPONDERS];
+  uint16_t aoa_azimuth[MAX_NUM_RESPONDERS];
+  uint16_t aoa_elevation[MAX_NUM_RESPONDERS];
+  uint16_t aoa_dest_azimuth[MAX_NUM_RESPONDERS];
+  uint16_t aoa_dest_elevation[MAX_NUM_RESPONDERS];
+  uint8_t status[MAX_NUM_RESPONDERS];
+  uint8_t nLos[MAX_NUM_RESPONDERS];
+  uint8_t aoa_azimuth_FOM[MAX_NUM_RESPONDERS];
+  uint8_t aoa_elevation_FOM[MAX_NUM_RESPONDERS];
+  uint8_t aoa_dest_azimuth_FOM[MAX_NUM_RESPONDERS];
+  uint8_t aoa_dest_elevation_FOM[MAX_NUM_RESPONDERS];
+  uint8_t slot_index[MAX_NUM_RESPONDERS];
+  uint8_t mac_addr[MAX_NUM_RESPONDERS][8];
+} tUWB_RANGE_DATA_BATCH_RECORD;
+
+/* Fixed-capacity buffer of ranging records. The storage is allocated once and
+ * exposed to Java as a direct ByteBuffer, so a flush is a single upcall with no
+ * per-round Java object. Not thread safe, callers serialize access. */
+class UwbRangeDataBatch {
+public:
+  UwbRangeDataBatch();
+
+  /* maxRecords of 0 disables batching */
+  void configure(uint16_t maxRecords, uint32_t flushTimeoutMs);
+  bool isEnabled() const { return mMaxRecords > 0; }
+  uint32_t getFlushTimeoutMs() const { return mFlushTimeoutMs; }
+
+  /* Append one ranging round, returns true once the batch is full */
+  bool append(const tUWA_RANGE_DATA_NTF *rangingNtf);
+  uint16_t getRecordCount() const { return mRecordCount; }
+  void reset() { mRecordCount = 0; }
+
+  void *getBuffer() { return mRecords; }
+  size_t getCapacity() const { return sizeof(mRecords); }
+
+private:
+  uint16_t mMaxRecords;
+  uint32_t mFlushTimeoutMs;
+  uint16_t mRecordCount;
+  tUWB_RANGE_DATA_BATCH_RECORD mRecords[UWB_RANGE_DATA_BATCH_MAX_RECORDS];
+};
+
+} // namespace android
+#endif
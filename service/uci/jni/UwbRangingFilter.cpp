@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "UwbRangingFilter.h"
+
+namespace android {
+
+UwbRangingFilter::UwbRangingFilter() {
+  memset(&mConfig, 0, sizeof(mConfig));
+  reset();
+}
+
+bool UwbRangingFilter::isValidConfig(const tUWB_RANGING_FILTER_CONFIG &config) {
+  switch (config.mode) {
+  case UWB_RANGING_FILTER_NONE:
+    return true;
+  case UWB_RANGING_FILTER_MEAN:
+  case UWB_RANGING_FILTER_MEDIAN:
+    return config.window > 0 && config.window <= UWB_RANGING_FILTER_MAX_WINDOW;
+  case UWB_RANGING_FILTER_EWMA:
+    return config.ewmaAlpha > 0;
+  case UWB_RANGING_FILTER_KALMAN:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        configure
+**
+** Description:     Select the filter mode of the session and drop the samples
+**                  collected so far.
+**
+** Params:          config: validated filter configuration.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRangingFilter::configure(const tUWB_RANGING_FILTER_CONFIG &config) {
+  mConfig = config;
+  if (mConfig.mode == UWB_RANGING_FILTER_KALMAN) {
+    if (mConfig.accelNoise == 0) {
+      mConfig.accelNoise = UWB_KALMAN_DEFAULT_ACCEL_NOISE;
+    }
+    if (mConfig.angularAccelNoise == 0) {
+      mConfig.angularAccelNoise = UWB_KALMAN_DEFAULT_ANGULAR_ACCEL_NOISE;
+    }
+    if (mConfig.distanceNoise == 0) {
+      mConfig.distanceNoise = UWB_KALMAN_DEFAULT_DISTANCE_NOISE;
+    }
+    if (mConfig.angleNoise == 0) {
+      mConfig.angleNoise = UWB_KALMAN_DEFAULT_ANGLE_NOISE;
+    }
+    if (mConfig.nlosGate == 0) {
+      mConfig.nlosGate = UWB_KALMAN_DEFAULT_NLOS_GATE;
+    }
+  }
+  reset();
+}
+
+void UwbRangingFilter::reset() {
+  memset(mSlotAddr, 0, sizeof(mSlotAddr));
+  memset(mSlotInUse, 0, sizeof(mSlotInUse));
+  memset(mAnchors, 0, sizeof(mAnchors));
+  memset(&mTracks, 0, sizeof(mTracks));
+}
+
+void UwbRangingFilter::resetSlot(int slot) {
+  memset(&mAnchors[slot], 0, sizeof(mAnchors[slot]));
+  for (int q = 0; q < KALMAN_MAX; q++) {
+    mTracks.x[q][slot] = 0;
+    mTracks.v[q][slot] = 0;
+    mTracks.p00[q][slot] = 0;
+    mTracks.p01[q][slot] = 0;
+    mTracks.p11[q][slot] = 0;
+    mTracks.valid[q][slot] = 0;
+    mTracks.rejects[q][slot] = 0;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        mapSlots
+**
+** Description:     Find the slot of every measurement by its MAC address.
+**                  Slots whose address is not in the round are released,
+**                  new addresses take a released slot with no history.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**                  slots: receives the slot of each measurement.
+**
+** Returns:         Number of measurements
+**
+*******************************************************************************/
+int UwbRangingFilter::mapSlots(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                               uint8_t *slots) {
+  const int macAddrLen =
+      rangingNtf->mac_addr_mode_indicator == SHORT_MAC_ADDRESS ? 2 : 8;
+  int n = std::min<int>(rangingNtf->no_of_measurements, MAX_NUM_RESPONDERS);
+  uint64_t addr[MAX_NUM_RESPONDERS];
+  bool seen[MAX_NUM_RESPONDERS] = {};
+  bool mapped[MAX_NUM_RESPONDERS] = {};
+  for (int i = 0; i < n; i++) {
+    addr[i] = 0;
+    memcpy(&addr[i], rangingNtf->ranging_measures.twr_range_measr[i].mac_addr,
+           macAddrLen);
+    for (int s = 0; s < MAX_NUM_RESPONDERS; s++) {
+      if (mSlotInUse[s] && mSlotAddr[s] == addr[i]) {
+        slots[i] = s;
+        seen[s] = true;
+        mapped[i] = true;
+        break;
+      }
+    }
+  }
+  for (int s = 0; s < MAX_NUM_RESPONDERS; s++) {
+    mSlotInUse[s] = seen[s];
+  }
+  for (int i = 0; i < n; i++) {
+    if (mapped[i]) {
+      continue;
+    }
+    /* A free slot always exists, one round has at most one per slot */
+    int free = -1;
+    for (int s = 0; s < MAX_NUM_RESPONDERS; s++) {
+      if (mSlotInUse[s] && mSlotAddr[s] == addr[i]) {
+        free = s; // same address twice in the round
+        break;
+      }
+      if (!mSlotInUse[s] && free < 0) {
+        free = s;
+      }
+    }
+    if (!mSlotInUse[free]) {
+      resetSlot(free);
+      mSlotInUse[free] = true;
+      mSlotAddr[free] = addr[i];
+    }
+    slots[i] = free;
+  }
+  return n;
+}
+
+/*******************************************************************************
+**
+** Function:        apply
+**
+** Description:     Filter the distance of every two way measurement of the
+**                  notification in place. Each measurement feeds the slot of
+**                  its MAC address.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRangingFilter::apply(tUWA_RANGE_DATA_NTF *rangingNtf) {
+  if (mConfig.mode == UWB_RANGING_FILTER_KALMAN) {
+    applyKalman(rangingNtf);
+    return;
+  }
+  uint8_t slots[MAX_NUM_RESPONDERS];
+  int noOfMeasurements = mapSlots(rangingNtf, slots);
+  for (int i = 0; i < noOfMeasurements; i++) {
+    tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    uint16_t sample = twr_range_measr.distance;
+    if (mConfig.minFom > 0 && twr_range_measr.aoa_azimuth_FOM < mConfig.minFom) {
+      sample = UWB_INVALID_DISTANCE;
+    }
+    twr_range_measr.distance = filterSample(mAnchors[slots[i]], sample);
+  }
+}
+
+/* AoA values are signed degrees in Q9.7 */
+#define UWB_KALMAN_ANGLE_SCALE 128.0f
+#define UWB_KALMAN_HALF_TURN (180.0f * UWB_KALMAN_ANGLE_SCALE)
+
+static inline float wrapAngle(float angle) {
+  if (angle >= UWB_KALMAN_HALF_TURN) {
+    return angle - 2 * UWB_KALMAN_HALF_TURN;
+  }
+  if (angle < -UWB_KALMAN_HALF_TURN) {
+    return angle + 2 * UWB_KALMAN_HALF_TURN;
+  }
+  return angle;
+}
+
+/*******************************************************************************
+**
+** Function:        applyKalman
+**
+** Description:     Track distance, azimuth and elevation of every anchor with
+**                  a constant velocity model. AoA samples are weighted by
+**                  their FOM, NLOS samples get a larger variance and a
+**                  tighter innovation gate. Quantities without a valid sample
+**                  report their prediction. The tracks are indexed by slot,
+**                  slots without a measurement in the round only predict.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRangingFilter::applyKalman(tUWA_RANGE_DATA_NTF *rangingNtf) {
+  uint8_t slots[MAX_NUM_RESPONDERS];
+  int n = mapSlots(rangingNtf, slots);
+  int width = 0; // slots up to the last one fed by this round
+  for (int i = 0; i < n; i++) {
+    width = std::max(width, slots[i] + 1);
+  }
+  uint32_t intervalMs = rangingNtf->curr_range_interval > 0
+                            ? rangingNtf->curr_range_interval
+                            : UWB_KALMAN_DEFAULT_INTERVAL_MS;
+  float dt = intervalMs / 1000.0f;
+
+  /* Per slot sample and variance of each quantity, a variance of 0 marks
+   * a missing sample */
+  float z[KALMAN_MAX][MAX_NUM_RESPONDERS];
+  float r[KALMAN_MAX][MAX_NUM_RESPONDERS] = {};
+  float gate[MAX_NUM_RESPONDERS] = {};
+  const float distanceVar =
+      (float)mConfig.distanceNoise * mConfig.distanceNoise;
+  const float angleNoise = mConfig.angleNoise * UWB_KALMAN_ANGLE_SCALE;
+  const float angleVar = angleNoise * angleNoise;
+  const float nlosGate = mConfig.nlosGate;
+  for (int i = 0; i < n; i++) {
+    const tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    const int s = slots[i];
+    bool valid = twr_range_measr.status == UWA_STATUS_OK &&
+                 twr_range_measr.distance != UWB_INVALID_DISTANCE &&
+                 (mConfig.minFom == 0 ||
+                  twr_range_measr.aoa_azimuth_FOM >= mConfig.minFom);
+    float noiseFactor =
+        twr_range_measr.nLos ? UWB_KALMAN_NLOS_NOISE_FACTOR : 1;
+    gate[s] = twr_range_measr.nLos ? nlosGate * nlosGate
+                                   : UWB_KALMAN_LOS_GATE * UWB_KALMAN_LOS_GATE;
+
+    z[KALMAN_DISTANCE][s] = twr_range_measr.distance;
+    r[KALMAN_DISTANCE][s] = valid ? distanceVar * noiseFactor : 0;
+    z[KALMAN_AZIMUTH][s] = (int16_t)twr_range_measr.aoa_azimuth;
+    r[KALMAN_AZIMUTH][s] =
+        valid && twr_range_measr.aoa_azimuth_FOM > 0
+            ? angleVar * noiseFactor * 100 / twr_range_measr.aoa_azimuth_FOM
+            : 0;
+    z[KALMAN_ELEVATION][s] = (int16_t)twr_range_measr.aoa_elevation;
+    r[KALMAN_ELEVATION][s] =
+        valid && twr_range_measr.aoa_elevation_FOM > 0
+            ? angleVar * noiseFactor * 100 / twr_range_measr.aoa_elevation_FOM
+            : 0;
+  }
+
+  const float angularAccelNoise =
+      mConfig.angularAccelNoise * UWB_KALMAN_ANGLE_SCALE;
+  updateKalman(KALMAN_DISTANCE, width, dt, mConfig.accelNoise,
+               z[KALMAN_DISTANCE], r[KALMAN_DISTANCE], gate, false);
+  updateKalman(KALMAN_AZIMUTH, width, dt, angularAccelNoise, z[KALMAN_AZIMUTH],
+               r[KALMAN_AZIMUTH], gate, true);
+  updateKalman(KALMAN_ELEVATION, width, dt, angularAccelNoise,
+               z[KALMAN_ELEVATION], r[KALMAN_ELEVATION], gate, false);
+
+  for (int i = 0; i < n; i++) {
+    tUWA_TWR_RANGING_MEASR &twr_range_measr =
+        rangingNtf->ranging_measures.twr_range_measr[i];
+    const int s = slots[i];
+    if (mTracks.valid[KALMAN_DISTANCE][s]) {
+      float distance =
+          std::min(std::max(mTracks.x[KALMAN_DISTANCE][s], 0.0f),
+                   (float)(UWB_INVALID_DISTANCE - 1));
+      twr_range_measr.distance = (uint16_t)lrintf(distance);
+    } else {
+      twr_range_measr.distance = UWB_INVALID_DISTANCE;
+    }
+    if (mTracks.valid[KALMAN_AZIMUTH][s]) {
+      twr_range_measr.aoa_azimuth =
+          (uint16_t)(int16_t)lrintf(mTracks.x[KALMAN_AZIMUTH][s]);
+    }
+    if (mTracks.valid[KALMAN_ELEVATION][s]) {
+      twr_range_measr.aoa_elevation =
+          (uint16_t)(int16_t)lrintf(mTracks.x[KALMAN_ELEVATION][s]);
+    }
+  }
+}
+
+/* Predict then correct the tracks of quantity q for the first n slots.
+ * accelNoise is the standard deviation of the white acceleration noise, r[i]
+ * the variance of sample z[i] or 0 if there is none, gate[i] the squared
+ * innovation gate in standard deviations. */
+void UwbRangingFilter::updateKalman(int q, int n, float dt, float accelNoise,
+                                    const float *z, const float *r,
+                                    const float *gate, bool wrap) {
+  float *x = mTracks.x[q];
+  float *v = mTracks.v[q];
+  float *p00 = mTracks.p00[q];
+  float *p01 = mTracks.p01[q];
+  float *p11 = mTracks.p11[q];
+  uint8_t *valid = mTracks.valid[q];
+  uint8_t *rejects = mTracks.rejects[q];
+
+  const float accelVar = accelNoise * accelNoise;
+  const float q00 = accelVar * dt * dt * dt * dt / 4;
+  const float q01 = accelVar * dt * dt * dt / 2;
+  const float q11 = accelVar * dt * dt;
+
+  /* Prediction, every track advances whether or not it has a sample */
+  for (int i = 0; i < n; i++) {
+    x[i] += v[i] * dt;
+    p00[i] += dt * (2 * p01[i] + dt * p11[i]) + q00;
+    p01[i] += dt * p11[i] + q01;
+    p11[i] += q11;
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (r[i] <= 0) {
+      if (wrap) {
+        x[i] = wrapAngle(x[i]);
+      }
+      continue;
+    }
+    float y = z[i] - x[i];
+    if (wrap) {
+      y = wrapAngle(y);
+    }
+    float s = p00[i] + r[i];
+    bool accept = valid[i] && y * y <= gate[i] * s;
+    if (!accept && (!valid[i] || ++rejects[i] >= UWB_KALMAN_MAX_REJECTS)) {
+      /* No track yet, or the track lost the target: restart on the sample */
+      x[i] = z[i];
+      v[i] = 0;
+      p00[i] = r[i];
+      p01[i] = 0;
+      p11[i] = accelVar;
+      valid[i] = 1;
+      rejects[i] = 0;
+      continue;
+    }
+    if (accept) {
+      float k0 = p00[i] / s;
+      float k1 = p01[i] / s;
+      x[i] += k0 * y;
+      v[i] += k1 * y;
+      p11[i] -= k1 * p01[i];
+      p01[i] -= k0 * p01[i];
+      p00[i] -= k0 * p00[i];
+      rejects[i] = 0;
+    }
+    if (wrap) {
+      x[i] = wrapAngle(x[i]);
+    }
+  }
+}
+
+uint16_t UwbRangingFilter::filterSample(AnchorRing &ring, uint16_t sample) {
+  switch (mConfig.mode) {
+  case UWB_RANGING_FILTER_MEAN:
+    push(ring, sample);
+    return ring.validCount > 0 ? ring.sum / ring.validCount
+                               : UWB_INVALID_DISTANCE;
+  case UWB_RANGING_FILTER_MEDIAN:
+    push(ring, sample);
+    return median(ring);
+  case UWB_RANGING_FILTER_EWMA:
+    if (sample != UWB_INVALID_DISTANCE) {
+      int32_t target = (int32_t)sample << 8;
+      if (!ring.hasEstimate) {
+        ring.estimate = target;
+        ring.hasEstimate = true;
+      } else {
+        ring.estimate += (mConfig.ewmaAlpha * (target - ring.estimate)) / 256;
+      }
+    }
+    return ring.hasEstimate ? (uint16_t)((ring.estimate + 128) >> 8)
+                            : UWB_INVALID_DISTANCE;
+  default:
+    return sample;
+  }
+}
+
+/* Insert a sample, evicting the oldest one once the window is full */
+void UwbRangingFilter::push(AnchorRing &ring, uint16_t sample) {
+  if (ring.count == mConfig.window) {
+    uint16_t evicted = ring.samples[ring.head];
+    if (evicted != UWB_INVALID_DISTANCE) {
+      ring.sum -= evicted;
+      ring.validCount--;
+    }
+  } else {
+    ring.count++;
+  }
+  ring.samples[ring.head] = sample;
+  if (sample != UWB_INVALID_DISTANCE) {
+    ring.sum += sample;
+    ring.validCount++;
+  }
+  ring.head = (ring.head + 1) % mConfig.window;
+}
+
+uint16_t UwbRangingFilter::median(const AnchorRing &ring) const {
+  uint16_t valid[UWB_RANGING_FILTER_MAX_WINDOW];
+  int n = 0;
+  for (int i = 0; i < ring.count; i++) {
+    if (ring.samples[i] != UWB_INVALID_DISTANCE) {
+      valid[n++] = ring.samples[i];
+    }
+  }
+  if (n == 0) {
+    return UWB_INVALID_DISTANCE;
+  }
+  std::nth_element(valid, valid + n / 2, valid + n);
+  uint32_t upper = valid[n / 2];
+  if (n % 2 != 0) {
+    return upper;
+  }
+  uint32_t lower = *std::max_element(valid, valid + n / 2);
+  return (lower + upper) / 2;
+}
+
+} // namespace android
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_RANGING_FILTER_H_
+#define _UWB_RANGING_FILTER_H_
+
+#include <stdint.h>
+
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Largest sliding window of a ranging filter */
+#define UWB_RANGING_FILTER_MAX_WINDOW 32
+/* Distance reported by the UWBS when no valid measurement exists */
+#define UWB_INVALID_DISTANCE 0xFFFF
+
+typedef enum {
+  UWB_RANGING_FILTER_NONE = 0,
+  /* Mean of the valid samples in the window */
+  UWB_RANGING_FILTER_MEAN,
+  /* Median of the valid samples in the window */
+  UWB_RANGING_FILTER_MEDIAN,
+  /* Exponentially weighted moving average, alpha = ewmaAlpha / 256 */
+  UWB_RANGING_FILTER_EWMA,
+  /* Constant velocity Kalman filter of distance, azimuth and elevation */
+  UWB_RANGING_FILTER_KALMAN,
+  UWB_RANGING_FILTER_MODE_MAX
+} eUWB_RANGING_FILTER_MODE;
+
+typedef struct {
+  uint8_t mode;
+  uint8_t window;    // MEAN and MEDIAN, 1 to UWB_RANGING_FILTER_MAX_WINDOW
+  uint8_t ewmaAlpha; // EWMA, 1 to 255
+  /* Samples whose azimuth FOM is below this value are treated as invalid,
+   * 0 disables the rejection */
+  uint8_t minFom;
+  /* KALMAN tuning, 0 selects the default of each field */
+  uint16_t accelNoise;        // distance process noise, cm/s^2
+  uint16_t angularAccelNoise; // angle process noise, degree/s^2
+  uint16_t distanceNoise;     // distance measurement noise, cm
+  uint16_t angleNoise;        // AoA measurement noise at FOM 100, degree
+  /* Innovation gate of NLOS samples in standard deviations, LOS samples use
+   * UWB_KALMAN_LOS_GATE */
+  uint8_t nlosGate;
+} tUWB_RANGING_FILTER_CONFIG;
+
+/* KALMAN defaults */
+#define UWB_KALMAN_DEFAULT_ACCEL_NOISE 200
+#define UWB_KALMAN_DEFAULT_ANGULAR_ACCEL_NOISE 90
+#define UWB_KALMAN_DEFAULT_DISTANCE_NOISE 10
+#define UWB_KALMAN_DEFAULT_ANGLE_NOISE 5
+#define UWB_KALMAN_DEFAULT_NLOS_GATE 3
+#define UWB_KALMAN_LOS_GATE 6
+/* Variance factor of NLOS samples */
+#define UWB_KALMAN_NLOS_NOISE_FACTOR 4
+/* Consecutive gated samples after which the track restarts */
+#define UWB_KALMAN_MAX_REJECTS 3
+/* Round period used when the notification reports no ranging interval */
+#define UWB_KALMAN_DEFAULT_INTERVAL_MS 200
+
+/* Distance filter of one ranging session. Every anchor owns a preallocated
+ * ring of samples with a running sum and valid count, so each sample costs
+ * O(1) for MEAN and EWMA and O(window) for MEDIAN. KALMAN keeps one track per
+ * anchor and quantity in separate arrays, so a round updates all anchors in
+ * flat loops the compiler can vectorize. Anchors are slotted by MAC address,
+ * not by their position in the notification, and an anchor missing from a
+ * round gives its slot up. */
+class UwbRangingFilter {
+public:
+  UwbRangingFilter();
+
+  static bool isValidConfig(const tUWB_RANGING_FILTER_CONFIG &config);
+
+  void configure(const tUWB_RANGING_FILTER_CONFIG &config);
+  void reset();
+  bool isActive() const { return mConfig.mode != UWB_RANGING_FILTER_NONE; }
+
+  /* Replace the distance of every two way measurement by its filtered value,
+   * KALMAN also replaces azimuth and elevation */
+  void apply(tUWA_RANGE_DATA_NTF *rangingNtf);
+
+private:
+  struct AnchorRing {
+    uint16_t samples[UWB_RANGING_FILTER_MAX_WINDOW];
+    uint8_t head;
+    uint8_t count;
+    uint8_t validCount;
+    uint32_t sum;
+    bool hasEstimate;
+    int32_t estimate; // EWMA state, Q8 fixed point
+  };
+
+  /* KALMAN state, quantity q of anchor i at [q][i] */
+  enum { KALMAN_DISTANCE = 0, KALMAN_AZIMUTH, KALMAN_ELEVATION, KALMAN_MAX };
+  struct KalmanTracks {
+    float x[KALMAN_MAX][MAX_NUM_RESPONDERS]; // position
+    float v[KALMAN_MAX][MAX_NUM_RESPONDERS]; // velocity per second
+    float p00[KALMAN_MAX][MAX_NUM_RESPONDERS];
+    float p01[KALMAN_MAX][MAX_NUM_RESPONDERS];
+    float p11[KALMAN_MAX][MAX_NUM_RESPONDERS];
+    uint8_t valid[KALMAN_MAX][MAX_NUM_RESPONDERS];
+    uint8_t rejects[KALMAN_MAX][MAX_NUM_RESPONDERS];
+  };
+
+  int mapSlots(const tUWA_RANGE_DATA_NTF *rangingNtf, uint8_t *slots);
+  void resetSlot(int slot);
+  void applyKalman(tUWA_RANGE_DATA_NTF *rangingNtf);
+  void updateKalman(int q, int n, float dt, float accelNoise, const float *z,
+                    const float *r, const float *gate, bool wrap);
+  uint16_t filterSample(AnchorRing &ring, uint16_t sample);
+  void push(AnchorRing &ring, uint16_t sample);
+  uint16_t median(const AnchorRing &ring) const;
+
+  tUWB_RANGING_FILTER_CONFIG mConfig;
+  /* MAC address of the anchor owning each slot, short ones zero extended */
+  uint64_t mSlotAddr[MAX_NUM_RESPONDERS];
+  bool mSlotInUse[MAX_NUM_RESPONDERS];
+  AnchorRing mAnchors[MAX_NUM_RESPONDERS];
+  KalmanTracks mTracks;
+};
+
+} // namespace android
+#endif
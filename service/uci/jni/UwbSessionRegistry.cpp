@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UwbSessionRegistry.h"
+
+namespace android {
+
+UwbSessionRegistry::UwbSessionRegistry() {
+  for (int i = 0; i < UWB_SESSION_REGISTRY_SHARDS; i++) {
+    mShards[i].spilled = 0;
+    for (int j = 0; j < UWB_SESSION_REGISTRY_SHARD_SLOTS; j++) {
+      mShards[i].sessions[j].inUse = false;
+      mShards[i].sessions[j].sessionId = 0;
+    }
+  }
+}
+
+int UwbSessionRegistry::homeOf(uint32_t sessionId) {
+  // Session IDs are often sequential, scramble them before picking a shard.
+  uint32_t hash = sessionId * 2654435761u;
+  return (hash >> 16) & (UWB_SESSION_REGISTRY_SHARDS - 1);
+}
+
+UwbSessionRegistry::Session *UwbSessionRegistry::findLocked(Shard &shard,
+                                                            uint32_t sessionId) {
+  for (int i = 0; i < UWB_SESSION_REGISTRY_SHARD_SLOTS; i++) {
+    Session &session = shard.sessions[i];
+    if (session.inUse && session.sessionId == sessionId) {
+      return &session;
+    }
+  }
+  return NULL;
+}
+
+/* Shard index holding the session, -1 if none. Only called with
+ * mStructureLock held, so no session moves while the shards are probed. */
+int UwbSessionRegistry::locate(uint32_t sessionId) {
+  int home = homeOf(sessionId);
+  for (int probe = 0; probe < UWB_SESSION_REGISTRY_SHARDS; probe++) {
+    int index = (home + probe) & (UWB_SESSION_REGISTRY_SHARDS - 1);
+    std::shared_lock<std::shared_mutex> lock(mShards[index].lock);
+    if (findLocked(mShards[index], sessionId) != NULL) {
+      return index;
+    }
+    if (probe == 0 && mShards[home].spilled == 0) {
+      break;
+    }
+  }
+  return -1;
+}
+
+/* Run f on a registered session with its lock held. A session lives in its
+ * home shard unless that shard was full when it was added, the next shards
+ * are then probed; the hot path only pays for this while a spill exists. */
+template <typename F>
+bool UwbSessionRegistry::withSession(uint32_t sessionId, F f) {
+  int home = homeOf(sessionId);
+  for (int probe = 0; probe < UWB_SESSION_REGISTRY_SHARDS; probe++) {
+    Shard &shard = mShards[(home + probe) & (UWB_SESSION_REGISTRY_SHARDS - 1)];
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    Session *session = findLocked(shard, sessionId);
+    if (session != NULL) {
+      std::lock_guard<std::mutex> sessionLock(session->lock);
+      f(*session);
+      return true;
+    }
+    if (probe == 0 && mShards[home].spilled == 0) {
+      break;
+    }
+  }
+  return false;
+}
+
+/* Run f on a session, registering it first if needed */
+template <typename F>
+bool UwbSessionRegistry::withNewSession(uint32_t sessionId, F f) {
+  if (withSession(sessionId, f)) {
+    return true;
+  }
+  return add(sessionId) && withSession(sessionId, f);
+}
+
+/*******************************************************************************
+**
+** Function:        add
+**
+** Description:     Register a session, nothing happens if it already exists.
+**                  A session whose home shard is full takes the first free
+**                  slot of the following shards.
+**
+** Params:          sessionId: session ID.
+**
+** Returns:         false if every slot of the registry is taken.
+**
+*******************************************************************************/
+bool UwbSessionRegistry::add(uint32_t sessionId) {
+  std::lock_guard<std::mutex> structureLock(mStructureLock);
+  if (locate(sessionId) >= 0) {
+    return true;
+  }
+  int home = homeOf(sessionId);
+  for (int probe = 0; probe < UWB_SESSION_REGISTRY_SHARDS; probe++) {
+    Shard &shard = mShards[(home + probe) & (UWB_SESSION_REGISTRY_SHARDS - 1)];
+    std::unique_lock<std::shared_mutex> lock(shard.lock);
+    for (int i = 0; i < UWB_SESSION_REGISTRY_SHARD_SLOTS; i++) {
+      Session &session = shard.sessions[i];
+      if (session.inUse) {
+        continue;
+      }
+      std::lock_guard<std::mutex> sessionLock(session.lock);
+      session.inUse = true;
+      session.sessionId = sessionId;
+      session.filter.configure(tUWB_RANGING_FILTER_CONFIG());
+      session.delivery.configure(tUWB_DELIVERY_POLICY_CONFIG());
+      session.solver.reset();
+      session.appConfig = UwbAppConfigCache();
+      if (probe > 0) {
+        mShards[home].spilled++;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool UwbSessionRegistry::remove(uint32_t sessionId) {
+  std::lock_guard<std::mutex> structureLock(mStructureLock);
+  int index = locate(sessionId);
+  if (index < 0) {
+    return false;
+  }
+  {
+    std::unique_lock<std::shared_mutex> lock(mShards[index].lock);
+    findLocked(mShards[index], sessionId)->inUse = false;
+  }
+  int home = homeOf(sessionId);
+  if (index != home) {
+    mShards[home].spilled--;
+  }
+  return true;
+}
+
+void UwbSessionRegistry::clear() {
+  std::lock_guard<std::mutex> structureLock(mStructureLock);
+  for (int i = 0; i < UWB_SESSION_REGISTRY_SHARDS; i++) {
+    std::unique_lock<std::shared_mutex> lock(mShards[i].lock);
+    for (int j = 0; j < UWB_SESSION_REGISTRY_SHARD_SLOTS; j++) {
+      Session &session = mShards[i].sessions[j];
+      std::lock_guard<std::mutex> sessionLock(session.lock);
+      session.inUse = false;
+      session.appConfig.reset();
+    }
+    mShards[i].spilled = 0;
+  }
+}
+
+bool UwbSessionRegistry::configureFilter(
+    uint32_t sessionId, const tUWB_RANGING_FILTER_CONFIG &config) {
+  return withNewSession(sessionId, [&config](Session &session) {
+    session.filter.configure(config);
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        applyFilter
+**
+** Description:     Run the ranging filter of the notification's session. Only
+**                  the shard is read locked, so concurrent notifications of
+**                  other sessions proceed in parallel.
+**
+** Params:          rangingNtf: two way ranging data notification.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbSessionRegistry::applyFilter(tUWA_RANGE_DATA_NTF *rangingNtf) {
+  withSession(rangingNtf->session_id, [rangingNtf](Session &session) {
+    if (session.filter.isActive()) {
+      session.filter.apply(rangingNtf);
+    }
+  });
+}
+
+bool UwbSessionRegistry::configureDeliveryPolicy(
+    uint32_t sessionId, const tUWB_DELIVERY_POLICY_CONFIG &config) {
+  return withNewSession(sessionId, [&config](Session &session) {
+    session.delivery.configure(config);
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        admitRangeData
+**
+** Description:     Run the delivery policy of the notification's session.
+**
+** Params:          rangingNtf: ranging data notification, already filtered.
+**                  nowMs: monotonic time of the notification.
+**
+** Returns:         false if the round must not be delivered. Rounds of
+**                  unknown sessions are delivered.
+**
+*******************************************************************************/
+bool UwbSessionRegistry::admitRangeData(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                                        int64_t nowMs) {
+  bool admitted = true;
+  withSession(rangingNtf->session_id, [&](Session &session) {
+    if (session.delivery.isActive()) {
+      admitted = session.delivery.admit(rangingNtf, nowMs);
+    }
+  });
+  return admitted;
+}
+
+bool UwbSessionRegistry::configureAnchors(uint32_t sessionId,
+                                          const tUWB_POSITION_ANCHOR *anchors,
+                                          uint8_t noOfAnchors, uint8_t flags) {
+  return withNewSession(sessionId, [&](Session &session) {
+    session.solver.configure(anchors, noOfAnchors, flags);
+  });
+}
+
+/*******************************************************************************
+**
+** Function:        solvePosition
+**
+** Description:     Solve the tag position of a two way ranging notification
+**                  against the anchors of its session.
+**
+** Params:          rangingNtf: two way ranging data notification, filtered.
+**                  fix: receives the position fix.
+**                  keepMeasurements: receives whether the measurements must
+**                  still be delivered along with the fix.
+**
+** Returns:         false if the session has no anchors, fix is then unset.
+**
+*******************************************************************************/
+bool UwbSessionRegistry::solvePosition(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                                       tUWB_POSITION_FIX *fix,
+                                       bool *keepMeasurements) {
+  bool solved = false;
+  withSession(rangingNtf->session_id, [&](Session &session) {
+    if (!session.solver.isActive()) {
+      return;
+    }
+    session.solver.solve(rangingNtf, fix);
+    *keepMeasurements = session.solver.keepMeasurements();
+    solved = true;
+  });
+  return solved;
+}
+
+/*******************************************************************************
+**
+** Function:        filterAppConfig
+**
+** Description:     Reduce a SET_APP_CONFIG TLV list to the parameters whose
+**                  value is not already known to be applied.
+**
+** Params:          sessionId: session ID.
+**                  tlvs: requested app config TLVs.
+**                  len: length of tlvs.
+**                  delta: receives the TLVs that must be sent.
+**                  noOfChanged: receives the number of TLVs in delta.
+**                  unchangedStatus: receives the UWBS status to answer with
+**                  when noOfChanged is 0.
+**
+** Returns:         false if the session is unknown, the list is malformed or
+**                  nothing changed in a state that may still reject the set,
+**                  the full list must then be sent.
+**
+*******************************************************************************/
+bool UwbSessionRegistry::filterAppConfig(uint32_t sessionId,
+                                         const uint8_t *tlvs, uint16_t len,
+                                         std::vector<uint8_t> &delta,
+                                         uint8_t *noOfChanged,
+                                         uint8_t *unchangedStatus) {
+  bool filtered = false;
+  withSession(sessionId, [&](Session &session) {
+    filtered = session.appConfig.filterChanged(tlvs, len, delta, noOfChanged);
+    if (filtered && *noOfChanged == 0) {
+      filtered = session.appConfig.getUnchangedStatus(unchangedStatus);
+    }
+  });
+  return filtered;
+}
+
+void UwbSessionRegistry::storeAppConfig(uint32_t sessionId,
+                                        const uint8_t *tlvs, uint16_t len) {
+  withSession(sessionId, [&](Session &session) {
+    if (!session.appConfig.store(tlvs, len)) {
+      session.appConfig.reset();
+    }
+  });
+}
+
+void UwbSessionRegistry::storeAppliedAppConfig(uint32_t sessionId,
+                                               const uint8_t *tlvs,
+                                               uint16_t len, uint8_t status) {
+  withSession(sessionId, [&](Session &session) {
+    if (!session.appConfig.storeApplied(tlvs, len, status)) {
+      session.appConfig.reset();
+    }
+  });
+}
+
+/* Called for every SESSION_STATUS_NTF, see UwbAppConfigCache */
+void UwbSessionRegistry::updateSessionState(uint32_t sessionId,
+                                            uint8_t state) {
+  withSession(sessionId, [state](Session &session) {
+    session.appConfig.setSessionState(state);
+  });
+}
+
+bool UwbSessionRegistry::lookupAppConfig(uint32_t sessionId,
+                                         const uint8_t *ids, uint16_t count,
+                                         std::vector<uint8_t> &tlvs) {
+  bool found = false;
+  withSession(sessionId, [&](Session &session) {
+    found = session.appConfig.lookup(ids, count, tlvs);
+  });
+  return found;
+}
+
+void UwbSessionRegistry::invalidateAppConfig(uint32_t sessionId) {
+  withSession(sessionId,
+              [](Session &session) { session.appConfig.reset(); });
+}
+
+void UwbSessionRegistry::invalidateAllAppConfig() {
+  for (int i = 0; i < UWB_SESSION_REGISTRY_SHARDS; i++) {
+    std::shared_lock<std::shared_mutex> lock(mShards[i].lock);
+    for (int j = 0; j < UWB_SESSION_REGISTRY_SHARD_SLOTS; j++) {
+      Session &session = mShards[i].sessions[j];
+      std::lock_guard<std::mutex> sessionLock(session.lock);
+      session.appConfig.reset();
+    }
+  }
+}
+
+} // namespace android
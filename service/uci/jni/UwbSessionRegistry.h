@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_SESSION_REGISTRY_H_
+#define _UWB_SESSION_REGISTRY_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "UwbAppConfigCache.h"
+#include "UwbDeliveryPolicy.h"
+#include "UwbPositionSolver.h"
+#include "UwbRangingFilter.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Number of shards, must be a power of two */
+#define UWB_SESSION_REGISTRY_SHARDS 8
+/* Sessions held by one shard */
+#define UWB_SESSION_REGISTRY_SHARD_SLOTS 4
+
+/* Per-session native state, sharded by session ID. A session whose shard is
+ * full spills into the next one with a free slot. Each shard is guarded by a
+ * read-mostly lock that is only taken exclusively to add or remove a session;
+ * the state of a session is guarded by its own mutex. Ranging notifications
+ * of different sessions therefore never serialize on a common lock. */
+class UwbSessionRegistry {
+public:
+  UwbSessionRegistry();
+
+  bool add(uint32_t sessionId);
+  bool remove(uint32_t sessionId);
+  void clear();
+
+  /* Creates the session entry if needed */
+  bool configureFilter(uint32_t sessionId,
+                       const tUWB_RANGING_FILTER_CONFIG &config);
+  /* Hot path, filters the notification in place if its session has a filter */
+  void applyFilter(tUWA_RANGE_DATA_NTF *rangingNtf);
+
+  /* Creates the session entry if needed */
+  bool configureDeliveryPolicy(uint32_t sessionId,
+                               const tUWB_DELIVERY_POLICY_CONFIG &config);
+  /* Hot path, false if the delivery policy of the session drops the round */
+  bool admitRangeData(const tUWA_RANGE_DATA_NTF *rangingNtf, int64_t nowMs);
+
+  /* Creates the session entry if needed, noOfAnchors 0 disables the solver */
+  bool configureAnchors(uint32_t sessionId, const tUWB_POSITION_ANCHOR *anchors,
+                        uint8_t noOfAnchors, uint8_t flags);
+  /* Hot path, false if the session of the notification has no anchors */
+  bool solvePosition(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                     tUWB_POSITION_FIX *fix, bool *keepMeasurements);
+
+  /* App config cache of the session, unknown sessions cache nothing */
+  bool filterAppConfig(uint32_t sessionId, const uint8_t *tlvs, uint16_t len,
+                       std::vector<uint8_t> &delta, uint8_t *noOfChanged,
+                       uint8_t *unchangedStatus);
+  void storeAppConfig(uint32_t sessionId, const uint8_t *tlvs, uint16_t len);
+  void storeAppliedAppConfig(uint32_t sessionId, const uint8_t *tlvs,
+                             uint16_t len, uint8_t status);
+  void updateSessionState(uint32_t sessionId, uint8_t state);
+  bool lookupAppConfig(uint32_t sessionId, const uint8_t *ids, uint16_t count,
+                       std::vector<uint8_t> &tlvs);
+  void invalidateAppConfig(uint32_t sessionId);
+  void invalidateAllAppConfig();
+
+private:
+  struct Session {
+    bool inUse;
+    uint32_t sessionId;
+    std::mutex lock;
+    UwbRangingFilter filter;
+    UwbDeliveryPolicy delivery;
+    UwbPositionSolver solver;
+    UwbAppConfigCache appConfig;
+  };
+
+  struct alignas(64) Shard {
+    std::shared_mutex lock;
+    /* Sessions of this home shard that live in a following shard */
+    std::atomic<uint8_t> spilled;
+    Session sessions[UWB_SESSION_REGISTRY_SHARD_SLOTS];
+  };
+
+  static int homeOf(uint32_t sessionId);
+  static Session *findLocked(Shard &shard, uint32_t sessionId);
+  int locate(uint32_t sessionId);
+  template <typename F> bool withSession(uint32_t sessionId, F f);
+  template <typename F> bool withNewSession(uint32_t sessionId, F f);
+
+  std::mutex mStructureLock; // serializes add, remove and clear
+  Shard mShards[UWB_SESSION_REGISTRY_SHARDS];
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "UwbTdoaRangeData.h"
+
+namespace android {
+
+UwbTdoaRangeDataBatch::UwbTdoaRangeDataBatch() {
+  mMaxRecords = 1;
+  mRecordCount = 0;
+}
+
+/* Copy len bytes to the payload area, false once it is exhausted */
+static bool appendPayload(tUWB_TDOA_RANGE_DATA *record, const uint8_t *data,
+                          uint8_t len, uint16_t *offset) {
+  if (data == NULL || len == 0 ||
+      record->payload_len + len > UWB_TDOA_PAYLOAD_SIZE) {
+    return false;
+  }
+  *offset = record->payload_len;
+  memcpy(&record->payload[record->payload_len], data, len);
+  record->payload_len += len;
+  return true;
+}
+
+/*******************************************************************************
+**
+** Function:        decode
+**
+** Description:     Flatten a TDoA ranging notification into a record. The
+**                  device info and blink payload pointers are followed and
+**                  their bytes copied into the record.
+**
+** Params:          rangingNtf: one way ranging data notification.
+**                  record: receives the columnar copy.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbTdoaRangeDataBatch::decode(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                                   tUWB_TDOA_RANGE_DATA *record) {
+  uint8_t noOfMeasurements = rangingNtf->no_of_measurements;
+  if (noOfMeasurements > MAX_NUM_OF_TDOA_MEASURES) {
+    noOfMeasurements = MAX_NUM_OF_TDOA_MEASURES;
+  }
+
+  record->session_id = rangingNtf->session_id;
+  record->seq_counter = rangingNtf->seq_counter;
+  record->curr_range_interval = rangingNtf->curr_range_interval;
+  record->rcr_indication = rangingNtf->rcr_indication;
+  record->ranging_measure_type = rangingNtf->ranging_measure_type;
+  record->mac_addr_mode_indicator = rangingNtf->mac_addr_mode_indicator;
+  record->no_of_measurements = noOfMeasurements;
+  record->payload_len = 0;
+
+  for (int i = 0; i < noOfMeasurements; i++) {
+    const tUWA_TDoA_RANGING_MEASR &measr =
+        rangingNtf->ranging_measures.tdoa_range_measr[i];
+    record->timestamp[i] = measr.timeStamp;
+    record->blink_frame_number[i] = measr.blink_frame_number;
+    record->aoa_azimuth[i] = measr.aoa_azimuth;
+    record->aoa_elevation[i] = measr.aoa_elevation;
+    record->frame_type[i] = measr.frame_type;
+    record->nLos[i] = measr.nLos;
+    record->aoa_azimuth_FOM[i] = measr.aoa_azimuth_FOM;
+    record->aoa_elevation_FOM[i] = measr.aoa_elevation_FOM;
+    memcpy(record->mac_addr[i], measr.mac_addr, sizeof(record->mac_addr[i]));
+
+    record->device_info_offset[i] = 0;
+    record->device_info_size[i] =
+        appendPayload(record, measr.device_info, measr.device_info_size,
+                      &record->device_info_offset[i])
+            ? measr.device_info_size
+            : 0;
+    record->blink_payload_offset[i] = 0;
+    record->blink_payload_size[i] =
+        appendPayload(record, measr.blink_payload_data,
+                      measr.blink_payload_size,
+                      &record->blink_payload_offset[i])
+            ? measr.blink_payload_size
+            : 0;
+  }
+}
+
+void UwbTdoaRangeDataBatch::configure(uint16_t maxRecords) {
+  if (maxRecords == 0) {
+    maxRecords = 1;
+  } else if (maxRecords > UWB_TDOA_BATCH_MAX_RECORDS) {
+    maxRecords = UWB_TDOA_BATCH_MAX_RECORDS;
+  }
+  mMaxRecords = maxRecords;
+  mRecordCount = 0;
+}
+
+bool UwbTdoaRangeDataBatch::append(const tUWB_TDOA_RANGE_DATA &record) {
+  if (mRecordCount >= mMaxRecords) {
+    return true;
+  }
+  mRecords[mRecordCount++] = record;
+  return mRecordCount >= mMaxRecords;
+}
+
+} // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_TDOA_RANGE_DATA_H_
+#define _UWB_TDOA_RANGE_DATA_H_
+
+#include <stdint.h>
+
+#include "uci_defs.h"
+#include "uwa_api.h"
+
+namespace android {
+
+/* Maximum number of TDoA rounds held in one batch */
+#define UWB_TDOA_BATCH_MAX_RECORDS 32
+/* Layout version reported to Java, bump on any change of the record below */
+#define UWB_TDOA_BATCH_VERSION 1
+/* Device info and blink payload bytes kept for all measurements of a round */
+#define UWB_TDOA_PAYLOAD_SIZE 256
+
+/* One TDoA round in columnar form, same conventions as
+ * tUWB_RANGE_DATA_BATCH_RECORD. The device info and blink payload of
+ * measurement i are copied to payload at device_info_offset[i] and
+ * blink_payload_offset[i]; a field that does not fit in the remaining payload
+ * space is dropped and its size reported as 0. */
+typedef struct {
+  uint64_t timestamp[MAX_NUM_OF_TDOA_MEASURES];
+  uint32_t session_id;
+  uint32_t seq_counter;
+  uint32_t curr_range_interval;
+  uint8_t rcr_indication;
+  uint8_t ranging_measure_type;
+  uint8_t mac_addr_mode_indicator;
+  uint8_t no_of_measurements;
+  uint32_t blink_frame_number[MAX_NUM_OF_TDOA_MEASURES];
+  uint16_t aoa_azimuth[MAX_NUM_OF_TDOA_MEASURES];
+  uint16_t aoa_elevation[MAX_NUM_OF_TDOA_MEASURES];
+  uint16_t device_info_offset[MAX_NUM_OF_TDOA_MEASURES];
+  uint16_t blink_payload_offset[MAX_NUM_OF_TDOA_MEASURES];
+  uint16_t payload_len;
+  uint8_t frame_type[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t nLos[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t aoa_azimuth_FOM[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t aoa_elevation_FOM[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t device_info_size[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t blink_payload_size[MAX_NUM_OF_TDOA_MEASURES];
+  uint8_t mac_addr[MAX_NUM_OF_TDOA_MEASURES][8];
+  uint8_t payload[UWB_TDOA_PAYLOAD_SIZE];
+} tUWB_TDOA_RANGE_DATA;
+
+/* Fixed-capacity buffer of TDoA records exposed to Java as a direct
+ * ByteBuffer, see UwbRangeDataBatch. Holds at least one record, so rounds are
+ * delivered through the buffer even when batching is off. Not thread safe,
+ * callers serialize access. */
+class UwbTdoaRangeDataBatch {
+public:
+  UwbTdoaRangeDataBatch();
+
+  /* Must run on the UCI callback thread, the notification points into its
+   * buffers */
+  static void decode(const tUWA_RANGE_DATA_NTF *rangingNtf,
+                     tUWB_TDOA_RANGE_DATA *record);
+
+  /* maxRecords of 0 is treated as 1 */
+  void configure(uint16_t maxRecords);
+
+  /* Append one TDoA round, returns true once the batch is full */
+  bool append(const tUWB_TDOA_RANGE_DATA &record);
+  uint16_t getRecordCount() const { return mRecordCount; }
+  void reset() { mRecordCount = 0; }
+
+  void *getBuffer() { return mRecords; }
+  size_t getCapacity() const { return sizeof(mRecords); }
+
+private:
+  uint16_t mMaxRecords;
+  uint16_t mRecordCount;
+  tUWB_TDOA_RANGE_DATA mRecords[UWB_TDOA_BATCH_MAX_RECORDS];
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "UwbJniInternal.h"
+#include "JniLog.h"
+#include "UwbJniStats.h"
+#include "UwbNotificationDispatcher.h"
+#include "UwbUciRecorder.h"
+
+namespace android {
+
+UwbUciRecorder::UwbUciRecorder(UwbNotificationDispatcher &dispatcher)
+    : mDispatcher(dispatcher) {
+  mCapturing = false;
+  mFile = NULL;
+}
+
+/*******************************************************************************
+**
+** Function:        startCapture
+**
+** Description:     Start recording every callback event to a new file. A
+**                  capture already running is stopped first.
+**
+** Params:          path: capture file, truncated if it exists.
+**
+** Returns:         true if the capture started.
+**
+*******************************************************************************/
+bool UwbUciRecorder::startCapture(const char *path) {
+  stopCapture();
+
+  std::lock_guard<std::mutex> lock(mLock);
+  mFile = fopen(path, "wb");
+  if (mFile == NULL) {
+    JNI_TRACE_E("%s: cannot open %s", __func__, path);
+    return false;
+  }
+  tUWB_UCI_CAPTURE_HDR hdr = {};
+  hdr.magic = UWB_UCI_CAPTURE_MAGIC;
+  hdr.version = UWB_UCI_CAPTURE_VERSION;
+  hdr.dmDataSize = sizeof(tUWA_DM_CBACK_DATA);
+  hdr.testDataSize = sizeof(tUWA_DM_TEST_CBACK_DATA);
+  if (fwrite(&hdr, sizeof(hdr), 1, mFile) != 1) {
+    JNI_TRACE_E("%s: cannot write %s", __func__, path);
+    fclose(mFile);
+    mFile = NULL;
+    return false;
+  }
+  mCapturing = true;
+  return true;
+}
+
+void UwbUciRecorder::stopCapture() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mCapturing = false;
+  if (mFile != NULL) {
+    fclose(mFile);
+    mFile = NULL;
+  }
+}
+
+void UwbUciRecorder::recordDmEvent(uint8_t event,
+                                   const tUWA_DM_CBACK_DATA *data) {
+  record(UWB_UCI_RECORD_DM, event, data, sizeof(*data));
+}
+
+void UwbUciRecorder::recordRfTestEvent(uint8_t event,
+                                       const tUWA_DM_TEST_CBACK_DATA *data) {
+  record(UWB_UCI_RECORD_RF_TEST, event, data, sizeof(*data));
+}
+
+/* Trailing zero bytes are not stored, replay zero fills them. Most events
+ * use only the head of the callback data union, so records stay small. */
+void UwbUciRecorder::record(uint8_t source, uint8_t event, const void *data,
+                            uint16_t len) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  if (bytes == NULL) {
+    len = 0;
+  }
+  while (len > 0 && bytes[len - 1] == 0) {
+    len--;
+  }
+  tUWB_UCI_RECORD_HDR hdr;
+  hdr.timestampUs = UwbJniStats::nowUs();
+  hdr.source = source;
+  hdr.event = event;
+  hdr.len = len;
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mFile == NULL) {
+    return;
+  }
+  if (fwrite(&hdr, sizeof(hdr), 1, mFile) != 1 ||
+      (len > 0 && fwrite(bytes, len, 1, mFile) != 1)) {
+    JNI_TRACE_E("%s: write failed, capture stopped", __func__);
+    mCapturing = false;
+    fclose(mFile);
+    mFile = NULL;
+  }
+}
+
+/* Pointers in a recorded event refer to memory of the recording process */
+static void clearRecordedPointers(uint8_t event, tUWA_DM_CBACK_DATA *data) {
+  if (event != UWA_DM_RANGE_DATA_NTF_EVT ||
+      data->sRange_data.ranging_measure_type == MEASUREMENT_TYPE_TWOWAY) {
+    return;
+  }
+  for (int i = 0; i < MAX_NUM_OF_TDOA_MEASURES; i++) {
+    tUWA_TDoA_RANGING_MEASR &tdoa =
+        data->sRange_data.ranging_measures.tdoa_range_measr[i];
+    tdoa.device_info_size = 0;
+    tdoa.device_info = NULL;
+    tdoa.blink_payload_size = 0;
+    tdoa.blink_payload_data = NULL;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        replay
+**
+** Description:     Feed a capture back through the device management
+**                  callbacks, then wait for the notification dispatcher to
+**                  deliver everything that was queued.
+**
+** Params:          path: capture file.
+**                  speedPercent: pace relative to the recording, 0 for as
+**                  fast as possible.
+**                  dmCback: device management callback.
+**                  testCback: RF test callback.
+**                  results: receives the UWB_REPLAY_RESULT_* figures.
+**
+** Returns:         false if the file cannot be read or was recorded with a
+**                  different callback data layout.
+**
+*******************************************************************************/
+bool UwbUciRecorder::replay(const char *path, uint32_t speedPercent,
+                            tUWA_DM_CBACK *dmCback,
+                            tUWA_DM_TEST_CBACK *testCback,
+                            int64_t results[UWB_REPLAY_RESULT_MAX]) {
+  memset(results, 0, sizeof(int64_t) * UWB_REPLAY_RESULT_MAX);
+  std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(path, "rb"), fclose);
+  if (file == nullptr) {
+    JNI_TRACE_E("%s: cannot open %s", __func__, path);
+    return false;
+  }
+  tUWB_UCI_CAPTURE_HDR hdr;
+  if (fread(&hdr, sizeof(hdr), 1, file.get()) != 1 ||
+      hdr.magic != UWB_UCI_CAPTURE_MAGIC ||
+      hdr.version != UWB_UCI_CAPTURE_VERSION ||
+      hdr.dmDataSize != sizeof(tUWA_DM_CBACK_DATA) ||
+      hdr.testDataSize != sizeof(tUWA_DM_TEST_CBACK_DATA)) {
+    JNI_TRACE_E("%s: %s is not a compatible capture", __func__, path);
+    return false;
+  }
+
+  std::unique_ptr<tUWA_DM_CBACK_DATA> dmData(new tUWA_DM_CBACK_DATA);
+  std::unique_ptr<tUWA_DM_TEST_CBACK_DATA> testData(
+      new tUWA_DM_TEST_CBACK_DATA);
+  int64_t firstRecordUs = 0;
+  int64_t startUs = 0;
+  int64_t lastFedUs = 0;
+  int64_t callbackTotalUs = 0;
+  tUWB_UCI_RECORD_HDR record;
+  while (fread(&record, sizeof(record), 1, file.get()) == 1) {
+    uint8_t *dest;
+    uint16_t size;
+    if (record.source == UWB_UCI_RECORD_DM) {
+      dest = (uint8_t *)dmData.get();
+      size = sizeof(tUWA_DM_CBACK_DATA);
+    } else if (record.source == UWB_UCI_RECORD_RF_TEST) {
+      dest = (uint8_t *)testData.get();
+      size = sizeof(tUWA_DM_TEST_CBACK_DATA);
+    } else {
+      JNI_TRACE_E("%s: corrupt record source %d", __func__, record.source);
+      return false;
+    }
+    if (record.len > size ||
+        (record.len > 0 && fread(dest, record.len, 1, file.get()) != 1)) {
+      JNI_TRACE_E("%s: truncated record", __func__);
+      return false;
+    }
+    memset(dest + record.len, 0, size - record.len);
+
+    int64_t nowUs = UwbJniStats::nowUs();
+    if (results[UWB_REPLAY_RESULT_EVENTS] == 0) {
+      firstRecordUs = record.timestampUs;
+      startUs = nowUs;
+    } else if (speedPercent > 0) {
+      int64_t dueUs = startUs + (record.timestampUs - firstRecordUs) * 100 /
+                                    speedPercent;
+      if (dueUs > nowUs) {
+        std::this_thread::sleep_for(std::chrono::microseconds(dueUs - nowUs));
+        nowUs = UwbJniStats::nowUs();
+      } else {
+        results[UWB_REPLAY_RESULT_LAG_MAX_US] = std::max(
+            results[UWB_REPLAY_RESULT_LAG_MAX_US], nowUs - dueUs);
+      }
+    }
+
+    if (record.source == UWB_UCI_RECORD_DM) {
+      clearRecordedPointers(record.event, dmData.get());
+      dmCback(record.event, dmData.get());
+    } else {
+      testCback(record.event, testData.get());
+    }
+    lastFedUs = UwbJniStats::nowUs();
+    int64_t callbackUs = lastFedUs - nowUs;
+    callbackTotalUs += callbackUs;
+    results[UWB_REPLAY_RESULT_CALLBACK_MAX_US] =
+        std::max(results[UWB_REPLAY_RESULT_CALLBACK_MAX_US], callbackUs);
+    results[UWB_REPLAY_RESULT_EVENTS]++;
+  }
+
+  int64_t events = results[UWB_REPLAY_RESULT_EVENTS];
+  if (events == 0) {
+    return true;
+  }
+
+  /* The dispatcher has delivered everything once the queue is empty and the
+   * enqueued count no longer moves */
+  int64_t stats[UWB_NTF_QUEUE_STAT_MAX];
+  int64_t drainedUs = lastFedUs;
+  for (int i = 0; i < UWB_CMD_TIMEOUT; i++) {
+    mDispatcher.getStats(stats);
+    if (stats[UWB_NTF_QUEUE_STAT_DEPTH] == 0) {
+      drainedUs = UwbJniStats::nowUs();
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  results[UWB_REPLAY_RESULT_FEED_US] = lastFedUs - startUs;
+  results[UWB_REPLAY_RESULT_DRAIN_US] = drainedUs - startUs;
+  results[UWB_REPLAY_RESULT_EVENTS_PER_S] =
+      (drainedUs > startUs) ? events * 1000000 / (drainedUs - startUs) : 0;
+  results[UWB_REPLAY_RESULT_CALLBACK_AVG_US] = callbackTotalUs / events;
+  return true;
+}
+
+} // namespace android
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_UCI_RECORDER_H_
+#define _UWB_UCI_RECORDER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "uwa_api.h"
+
+namespace android {
+
+class UwbNotificationDispatcher;
+
+/* Capture file: a tUWB_UCI_CAPTURE_HDR followed by records, each a
+ * tUWB_UCI_RECORD_HDR and len bytes of callback data. Integers are stored in
+ * host byte order; files are meant to be replayed on the same platform. */
+#define UWB_UCI_CAPTURE_MAGIC 0x52425755 // "UWBR"
+#define UWB_UCI_CAPTURE_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t dmDataSize;   // sizeof(tUWA_DM_CBACK_DATA) of the recorder
+  uint16_t testDataSize; // sizeof(tUWA_DM_TEST_CBACK_DATA) of the recorder
+  uint16_t reserved;
+} tUWB_UCI_CAPTURE_HDR;
+
+enum {
+  UWB_UCI_RECORD_DM = 0,
+  UWB_UCI_RECORD_RF_TEST = 1,
+};
+
+typedef struct {
+  int64_t timestampUs;
+  uint8_t source; // UWB_UCI_RECORD_*
+  uint8_t event;
+  uint16_t len;
+} tUWB_UCI_RECORD_HDR;
+
+/* Layout of the array returned by nativeReplayUciCapture() */
+enum {
+  UWB_REPLAY_RESULT_EVENTS = 0,
+  UWB_REPLAY_RESULT_FEED_US,       // first event fed to last event fed
+  UWB_REPLAY_RESULT_DRAIN_US,      // first event fed to last upcall done
+  UWB_REPLAY_RESULT_EVENTS_PER_S,  // events / DRAIN_US
+  UWB_REPLAY_RESULT_CALLBACK_AVG_US,
+  UWB_REPLAY_RESULT_CALLBACK_MAX_US,
+  UWB_REPLAY_RESULT_LAG_MAX_US,    // worst delay behind the recorded pace
+  UWB_REPLAY_RESULT_MAX
+};
+
+/* Records the events delivered by the UCI stack of one chip to its device
+ * management callbacks and feeds such a capture back through the same
+ * callbacks. */
+class UwbUciRecorder {
+public:
+  bool startCapture(const char *path);
+  void stopCapture();
+  bool isCapturing() const {
+    return mCapturing.load(std::memory_order_relaxed);
+  }
+  void recordDmEvent(uint8_t event, const tUWA_DM_CBACK_DATA *data);
+  void recordRfTestEvent(uint8_t event, const tUWA_DM_TEST_CBACK_DATA *data);
+
+  /* Blocks the caller for the whole replay. speedPercent 100 replays at the
+   * recorded pace, 0 as fast as possible. The UCI stack must be disabled,
+   * the calling thread stands in for the UCI callback thread. */
+  bool replay(const char *path, uint32_t speedPercent,
+              tUWA_DM_CBACK *dmCback, tUWA_DM_TEST_CBACK *testCback,
+              int64_t results[UWB_REPLAY_RESULT_MAX]);
+
+private:
+  friend class UwbChipContext;
+  explicit UwbUciRecorder(UwbNotificationDispatcher &dispatcher);
+
+  void record(uint8_t source, uint8_t event, const void *data, uint16_t len);
+
+  UwbNotificationDispatcher &mDispatcher; // drained at the end of a replay
+  std::atomic<bool> mCapturing;
+  std::mutex mLock;
+  FILE *mFile;
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UwbVendorNtfFilter.h"
+
+namespace android {
+
+UwbVendorNtfFilter UwbVendorNtfFilter::mObjFilter;
+
+UwbVendorNtfFilter &UwbVendorNtfFilter::getInstance() { return mObjFilter; }
+
+UwbVendorNtfFilter::UwbVendorNtfFilter() {
+  for (int gid = 0; gid < UWB_VENDOR_NTF_MAX_GID; gid++) {
+    for (int oid = 0; oid < UWB_VENDOR_NTF_MAX_OID; oid++) {
+      Key &key = mKeys[gid][oid];
+      key.policy = UWB_VENDOR_NTF_PASS;
+      key.sampleCount = 0;
+      key.received = 0;
+      key.forwarded = 0;
+      key.dropped = 0;
+      key.batched = 0;
+    }
+  }
+}
+
+bool UwbVendorNtfFilter::isValidPolicy(uint8_t mode, uint16_t param) {
+  switch (mode) {
+  case UWB_VENDOR_NTF_PASS:
+  case UWB_VENDOR_NTF_DROP:
+    return true;
+  case UWB_VENDOR_NTF_SAMPLE:
+  case UWB_VENDOR_NTF_BATCH:
+    return param > 0;
+  default:
+    return false;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        setPolicy
+**
+** Description:     Select how notifications of one key are delivered. The
+**                  counters of the key are kept.
+**
+** Params:          gid: group id.
+**                  oid: opcode id, UWB_VENDOR_NTF_ANY_OID for the whole group.
+**                  mode: UWB_VENDOR_NTF_* mode, validated by isValidPolicy().
+**                  param: sampling interval or batch threshold.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbVendorNtfFilter::setPolicy(uint8_t gid, uint8_t oid, uint8_t mode,
+                                   uint16_t param) {
+  uint32_t policy = mode | ((uint32_t)param << 8);
+  if (oid == UWB_VENDOR_NTF_ANY_OID) {
+    for (int i = 0; i < UWB_VENDOR_NTF_MAX_OID; i++) {
+      getKey(gid, i).policy = policy;
+    }
+  } else {
+    getKey(gid, oid).policy = policy;
+  }
+}
+
+void UwbVendorNtfFilter::reset() {
+  for (int gid = 0; gid < UWB_VENDOR_NTF_MAX_GID; gid++) {
+    setPolicy(gid, UWB_VENDOR_NTF_ANY_OID, UWB_VENDOR_NTF_PASS, 0);
+  }
+}
+
+uint8_t UwbVendorNtfFilter::classify(uint8_t gid, uint8_t oid) {
+  Key &key = getKey(gid, oid);
+  key.received.fetch_add(1, std::memory_order_relaxed);
+  uint32_t policy = key.policy.load(std::memory_order_relaxed);
+  uint8_t mode = policy & 0xFF;
+  uint16_t param = policy >> 8;
+  if (mode == UWB_VENDOR_NTF_SAMPLE) {
+    mode = (key.sampleCount.fetch_add(1, std::memory_order_relaxed) % param ==
+            0)
+               ? UWB_VENDOR_NTF_PASS
+               : UWB_VENDOR_NTF_DROP;
+  }
+  switch (mode) {
+  case UWB_VENDOR_NTF_DROP:
+    key.dropped.fetch_add(1, std::memory_order_relaxed);
+    break;
+  case UWB_VENDOR_NTF_BATCH:
+    key.batched.fetch_add(1, std::memory_order_relaxed);
+    break;
+  default:
+    mode = UWB_VENDOR_NTF_PASS;
+    key.forwarded.fetch_add(1, std::memory_order_relaxed);
+    break;
+  }
+  return mode;
+}
+
+uint16_t UwbVendorNtfFilter::getBatchThreshold(uint8_t gid, uint8_t oid) {
+  uint32_t policy = getKey(gid, oid).policy.load(std::memory_order_relaxed);
+  return ((policy & 0xFF) == UWB_VENDOR_NTF_BATCH) ? (policy >> 8) : 1;
+}
+
+void UwbVendorNtfFilter::getStats(std::vector<int64_t> &stats) {
+  stats.clear();
+  for (int gid = 0; gid < UWB_VENDOR_NTF_MAX_GID; gid++) {
+    for (int oid = 0; oid < UWB_VENDOR_NTF_MAX_OID; oid++) {
+      Key &key = mKeys[gid][oid];
+      uint32_t policy = key.policy.load(std::memory_order_relaxed);
+      int64_t received = key.received.load(std::memory_order_relaxed);
+      if (received == 0 && policy == UWB_VENDOR_NTF_PASS) {
+        continue;
+      }
+      stats.push_back(gid);
+      stats.push_back(oid);
+      stats.push_back(policy & 0xFF);
+      stats.push_back(policy >> 8);
+      stats.push_back(received);
+      stats.push_back(key.forwarded.load(std::memory_order_relaxed));
+      stats.push_back(key.dropped.load(std::memory_order_relaxed));
+      stats.push_back(key.batched.load(std::memory_order_relaxed));
+    }
+  }
+}
+
+} // namespace android
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_VENDOR_NTF_FILTER_H_
+#define _UWB_VENDOR_NTF_FILTER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+namespace android {
+
+#define UWB_VENDOR_NTF_MAX_GID 16 // 4 bit group id
+#define UWB_VENDOR_NTF_MAX_OID 64 // 6 bit opcode id
+/* OID of setPolicy() applying to every OID of the GID */
+#define UWB_VENDOR_NTF_ANY_OID 0xFF
+/* Vendor batch delivered once it would outgrow this size */
+#define UWB_VENDOR_NTF_BATCH_MAX_BYTES 4096
+/* Deadline of a vendor batch, counted from its first record */
+#define UWB_VENDOR_NTF_BATCH_FLUSH_MS 500
+/* raw flag, gid, oid and 16 bit length in front of every batched payload */
+#define UWB_VENDOR_NTF_BATCH_RECORD_HDR_SIZE 5
+/* Size of one row of the array returned by nativeGetVendorNtfStats():
+ * gid, oid, mode, param, received, forwarded, dropped, batched */
+#define UWB_VENDOR_NTF_STATS_ROW_SIZE 8
+
+typedef enum {
+  /* Deliver every notification, the default */
+  UWB_VENDOR_NTF_PASS = 0,
+  /* Deliver none */
+  UWB_VENDOR_NTF_DROP,
+  /* Deliver one out of every param notifications */
+  UWB_VENDOR_NTF_SAMPLE,
+  /* Pack into onVendorUciNotificationBatchReceived(), flushed once param
+   * notifications are pending or the flush timeout expires */
+  UWB_VENDOR_NTF_BATCH,
+  UWB_VENDOR_NTF_MODE_MAX
+} eUWB_VENDOR_NTF_MODE;
+
+/* Subscription table for vendor and raw UCI notifications, indexed by
+ * (GID, OID). The UCI callback thread classifies every notification before
+ * it is copied into the dispatcher queue, so dropped and sampled out ones
+ * never cost a queue slot or a JNI upcall. */
+class UwbVendorNtfFilter {
+public:
+  static UwbVendorNtfFilter &getInstance();
+
+  static bool isValidPolicy(uint8_t mode, uint16_t param);
+
+  void setPolicy(uint8_t gid, uint8_t oid, uint8_t mode, uint16_t param);
+  void reset();
+
+  /* Returns the mode the notification is handled with, PASS or DROP for a
+   * sampling key. UCI stack callback thread only. */
+  uint8_t classify(uint8_t gid, uint8_t oid);
+  /* Pending notifications that flush a batch holding one of (gid, oid) */
+  uint16_t getBatchThreshold(uint8_t gid, uint8_t oid);
+
+  /* One UWB_VENDOR_NTF_STATS_ROW_SIZE row per key seen or configured */
+  void getStats(std::vector<int64_t> &stats);
+
+private:
+  UwbVendorNtfFilter();
+
+  struct Key {
+    std::atomic<uint32_t> policy; // mode | param << 8, read in one load
+    std::atomic<uint32_t> sampleCount;
+    std::atomic<int64_t> received;
+    std::atomic<int64_t> forwarded;
+    std::atomic<int64_t> dropped;
+    std::atomic<int64_t> batched;
+  };
+
+  Key &getKey(uint8_t gid, uint8_t oid) {
+    return mKeys[gid % UWB_VENDOR_NTF_MAX_GID][oid % UWB_VENDOR_NTF_MAX_OID];
+  }
+
+  static UwbVendorNtfFilter mObjFilter;
+
+  Key mKeys[UWB_VENDOR_NTF_MAX_GID][UWB_VENDOR_NTF_MAX_OID];
+};
+
+} // namespace android
+#endif
@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockJvm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace android {
+
+/* Local references of a thread live in its arena until the enclosing local
+ * frame is popped */
+#define MOCK_JVM_ARENA_SIZE (1 << 20)
+#define MOCK_JVM_MAX_FRAMES 16
+
+enum {
+  MOCK_KIND_OBJECT = 0,
+  MOCK_KIND_CLASS,
+  MOCK_KIND_ARRAY,
+  MOCK_KIND_OBJECT_ARRAY,
+  MOCK_KIND_STRING,
+  MOCK_KIND_DIRECT_BUFFER
+};
+
+/* Header of every object, the elements of an array or the characters of a
+ * string follow it */
+struct MockObject {
+  uint8_t kind;
+  jsize length;
+  uint32_t elementSize;
+  void *address;
+  jlong capacity;
+
+  uint8_t *data() { return reinterpret_cast<uint8_t *>(this + 1); }
+  size_t size() const {
+    return (sizeof(MockObject) + (size_t)length * elementSize + 7) & ~7;
+  }
+};
+
+struct MockEnv {
+  JNIEnv env; // first, the JNI functions cast their JNIEnv back
+  uint8_t *arena;
+  size_t top;
+  size_t frames[MOCK_JVM_MAX_FRAMES];
+  int frameCount;
+  bool exceptionPending;
+};
+
+struct MockNative {
+  std::string name;
+  std::string signature;
+  void *fnPtr;
+};
+
+static thread_local MockEnv *tEnv = NULL;
+static std::atomic<uint64_t> sAllocations(0);
+static std::atomic<uint64_t> sUpcalls(0);
+static std::atomic<uintptr_t> sNextMethodId(1);
+static MockObject sClass = {MOCK_KIND_CLASS, 0, 0, NULL, 0};
+static std::mutex sNativesMutex;
+static std::vector<MockNative> sNatives;
+
+static MockEnv *toMockEnv(JNIEnv *env) {
+  return reinterpret_cast<MockEnv *>(env);
+}
+
+static MockObject *toMockObject(jobject object) {
+  return reinterpret_cast<MockObject *>(object);
+}
+
+/* Throw, as far as the caller can tell: ExceptionCheck() reports it */
+static void throwException(JNIEnv *env) {
+  toMockEnv(env)->exceptionPending = true;
+}
+
+static MockObject *newLocal(JNIEnv *env, uint8_t kind, jsize length,
+                            uint32_t elementSize) {
+  MockEnv *mockEnv = toMockEnv(env);
+  if (length < 0) {
+    throwException(env);
+    return NULL;
+  }
+  MockObject header = {kind, length, elementSize, NULL, 0};
+  size_t size = header.size();
+  if (mockEnv->top + size > MOCK_JVM_ARENA_SIZE) {
+    throwException(env); // OutOfMemoryError
+    return NULL;
+  }
+  MockObject *object =
+      reinterpret_cast<MockObject *>(mockEnv->arena + mockEnv->top);
+  mockEnv->top += size;
+  memset(object, 0, size);
+  *object = header;
+  sAllocations.fetch_add(1, std::memory_order_relaxed);
+  return object;
+}
+
+static bool checkRange(JNIEnv *env, jarray array, jsize start, jsize len) {
+  MockObject *object = toMockObject(array);
+  if (object == NULL || start < 0 || len < 0 || start > object->length ||
+      len > object->length - start) {
+    throwException(env); // ArrayIndexOutOfBoundsException
+    return false;
+  }
+  return true;
+}
+
+static jclass findClass(JNIEnv *, const char *) {
+  return reinterpret_cast<jclass>(&sClass);
+}
+
+static jclass getObjectClass(JNIEnv *, jobject) {
+  return reinterpret_cast<jclass>(&sClass);
+}
+
+static jint pushLocalFrame(JNIEnv *env, jint) {
+  MockEnv *mockEnv = toMockEnv(env);
+  if (mockEnv->frameCount == MOCK_JVM_MAX_FRAMES) {
+    throwException(env);
+    return JNI_ERR;
+  }
+  mockEnv->frames[mockEnv->frameCount++] = mockEnv->top;
+  return JNI_OK;
+}
+
+/* The result, if local to the popped frame, moves down to the new top */
+static jobject popLocalFrame(JNIEnv *env, jobject result) {
+  MockEnv *mockEnv = toMockEnv(env);
+  if (mockEnv->frameCount == 0) {
+    return NULL;
+  }
+  size_t top = mockEnv->frames[--mockEnv->frameCount];
+  uint8_t *address = reinterpret_cast<uint8_t *>(result);
+  mockEnv->top = top;
+  if (address < mockEnv->arena + top ||
+      address >= mockEnv->arena + MOCK_JVM_ARENA_SIZE) {
+    return result;
+  }
+  MockObject *object = toMockObject(result);
+  size_t size = object->size();
+  memmove(mockEnv->arena + top, object, size);
+  mockEnv->top += size;
+  return reinterpret_cast<jobject>(mockEnv->arena + top);
+}
+
+static jobject newGlobalRef(JNIEnv *, jobject object) {
+  MockObject *local = toMockObject(object);
+  if (local == NULL || local->kind == MOCK_KIND_CLASS) {
+    return object;
+  }
+  MockObject *global = static_cast<MockObject *>(malloc(local->size()));
+  if (global != NULL) {
+    memcpy(global, local, local->size());
+  }
+  return reinterpret_cast<jobject>(global);
+}
+
+static void deleteGlobalRef(JNIEnv *, jobject object) {
+  MockObject *global = toMockObject(object);
+  if (global != NULL && global->kind != MOCK_KIND_CLASS) {
+    free(global);
+  }
+}
+
+static jobject newLocalRef(JNIEnv *, jobject object) { return object; }
+
+static void deleteLocalRef(JNIEnv *, jobject) {}
+
+static jint ensureLocalCapacity(JNIEnv *, jint) { return JNI_OK; }
+
+static jboolean exceptionCheck(JNIEnv *env) {
+  return toMockEnv(env)->exceptionPending ? JNI_TRUE : JNI_FALSE;
+}
+
+static void exceptionDescribe(JNIEnv *) {}
+
+static void exceptionClear(JNIEnv *env) {
+  toMockEnv(env)->exceptionPending = false;
+}
+
+static jmethodID getMethodID(JNIEnv *, jclass, const char *, const char *) {
+  return reinterpret_cast<jmethodID>(
+      sNextMethodId.fetch_add(1, std::memory_order_relaxed));
+}
+
+static jobject newObjectV(JNIEnv *env, jclass clazz, jmethodID methodID,
+                          va_list) {
+  if (clazz == NULL || methodID == NULL) {
+    throwException(env);
+    return NULL;
+  }
+  return reinterpret_cast<jobject>(newLocal(env, MOCK_KIND_OBJECT, 0, 0));
+}
+
+static jobject callObjectMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+  sUpcalls.fetch_add(1, std::memory_order_relaxed);
+  return NULL;
+}
+
+static void callVoidMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+  sUpcalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+static jstring newStringUTF(JNIEnv *env, const char *chars) {
+  jsize length = strlen(chars);
+  MockObject *object = newLocal(env, MOCK_KIND_STRING, length + 1, 1);
+  if (object != NULL) {
+    memcpy(object->data(), chars, length + 1);
+  }
+  return reinterpret_cast<jstring>(object);
+}
+
+static const char *getStringUTFChars(JNIEnv *, jstring string,
+                                     jboolean *isCopy) {
+  if (isCopy != NULL) {
+    *isCopy = JNI_FALSE;
+  }
+  return reinterpret_cast<const char *>(toMockObject(string)->data());
+}
+
+static void releaseStringUTFChars(JNIEnv *, jstring, const char *) {}
+
+static jsize getArrayLength(JNIEnv *, jarray array) {
+  return toMockObject(array)->length;
+}
+
+static jobjectArray newObjectArray(JNIEnv *env, jsize length, jclass,
+                                   jobject initialElement) {
+  MockObject *object =
+      newLocal(env, MOCK_KIND_OBJECT_ARRAY, length, sizeof(jobject));
+  if (object != NULL) {
+    jobject *elements = reinterpret_cast<jobject *>(object->data());
+    for (jsize i = 0; i < length; i++) {
+      elements[i] = initialElement;
+    }
+  }
+  return reinterpret_cast<jobjectArray>(object);
+}
+
+static jobject getObjectArrayElement(JNIEnv *env, jobjectArray array,
+                                     jsize index) {
+  if (!checkRange(env, array, index, 1)) {
+    return NULL;
+  }
+  return reinterpret_cast<jobject *>(toMockObject(array)->data())[index];
+}
+
+static void setObjectArrayElement(JNIEnv *env, jobjectArray array,
+                                  jsize index, jobject value) {
+  if (checkRange(env, array, index, 1)) {
+    reinterpret_cast<jobject *>(toMockObject(array)->data())[index] = value;
+  }
+}
+
+template <typename T, typename A> static A newArray(JNIEnv *env, jsize length) {
+  return reinterpret_cast<A>(newLocal(env, MOCK_KIND_ARRAY, length, sizeof(T)));
+}
+
+template <typename T, typename A>
+static T *getArrayElements(JNIEnv *, A array, jboolean *isCopy) {
+  if (isCopy != NULL) {
+    *isCopy = JNI_FALSE;
+  }
+  return reinterpret_cast<T *>(toMockObject(array)->data());
+}
+
+template <typename T, typename A>
+static void releaseArrayElements(JNIEnv *, A, T *, jint) {}
+
+template <typename T, typename A>
+static void getArrayRegion(JNIEnv *env, A array, jsize start, jsize len,
+                           T *buf) {
+  if (checkRange(env, array, start, len)) {
+    memcpy(buf, toMockObject(array)->data() + start * sizeof(T),
+           len * sizeof(T));
+  }
+}
+
+template <typename T, typename A>
+static void setArrayRegion(JNIEnv *env, A array, jsize start, jsize len,
+                           const T *buf) {
+  if (checkRange(env, array, start, len)) {
+    memcpy(toMockObject(array)->data() + start * sizeof(T), buf,
+           len * sizeof(T));
+  }
+}
+
+static void *getPrimitiveArrayCritical(JNIEnv *, jarray array,
+                                       jboolean *isCopy) {
+  if (isCopy != NULL) {
+    *isCopy = JNI_FALSE;
+  }
+  return toMockObject(array)->data();
+}
+
+static void releasePrimitiveArrayCritical(JNIEnv *, jarray, void *, jint) {}
+
+static jint registerNatives(JNIEnv *, jclass, const JNINativeMethod *methods,
+                            jint nMethods) {
+  std::lock_guard<std::mutex> lock(sNativesMutex);
+  for (jint i = 0; i < nMethods; i++) {
+    sNatives.push_back({methods[i].name, methods[i].signature,
+                        methods[i].fnPtr});
+  }
+  return JNI_OK;
+}
+
+static jint getJavaVM(JNIEnv *, JavaVM **vm) {
+  *vm = MockJvm::getInstance().getVm();
+  return JNI_OK;
+}
+
+static jobject newDirectByteBuffer(JNIEnv *env, void *address,
+                                   jlong capacity) {
+  MockObject *object = newLocal(env, MOCK_KIND_DIRECT_BUFFER, 0, 0);
+  if (object != NULL) {
+    object->address = address;
+    object->capacity = capacity;
+  }
+  return reinterpret_cast<jobject>(object);
+}
+
+static void *getDirectBufferAddress(JNIEnv *, jobject buffer) {
+  MockObject *object = toMockObject(buffer);
+  return object->kind == MOCK_KIND_DIRECT_BUFFER ? object->address : NULL;
+}
+
+static jlong getDirectBufferCapacity(JNIEnv *, jobject buffer) {
+  MockObject *object = toMockObject(buffer);
+  return object->kind == MOCK_KIND_DIRECT_BUFFER ? object->capacity : -1;
+}
+
+static const JNINativeInterface *getNativeInterface() {
+  static JNINativeInterface functions;
+  static std::once_flag once;
+  std::call_once(once, []() {
+    memset(&functions, 0, sizeof(functions));
+    functions.FindClass = findClass;
+    functions.GetObjectClass = getObjectClass;
+    functions.PushLocalFrame = pushLocalFrame;
+    functions.PopLocalFrame = popLocalFrame;
+    functions.NewGlobalRef = newGlobalRef;
+    functions.DeleteGlobalRef = deleteGlobalRef;
+    functions.NewLocalRef = newLocalRef;
+    functions.DeleteLocalRef = deleteLocalRef;
+    functions.EnsureLocalCapacity = ensureLocalCapacity;
+    functions.ExceptionCheck = exceptionCheck;
+    functions.ExceptionDescribe = exceptionDescribe;
+    functions.ExceptionClear = exceptionClear;
+    functions.GetMethodID = getMethodID;
+    functions.NewObjectV = newObjectV;
+    functions.CallObjectMethodV = callObjectMethodV;
+    functions.CallVoidMethodV = callVoidMethodV;
+    functions.NewStringUTF = newStringUTF;
+    functions.GetStringUTFChars = getStringUTFChars;
+    functions.ReleaseStringUTFChars = releaseStringUTFChars;
+    functions.GetArrayLength = getArrayLength;
+    functions.NewObjectArray = newObjectArray;
+    functions.GetObjectArrayElement = getObjectArrayElement;
+    functions.SetObjectArrayElement = setObjectArrayElement;
+    functions.NewByteArray = newArray<jbyte, jbyteArray>;
+    functions.NewShortArray = newArray<jshort, jshortArray>;
+    functions.NewIntArray = newArray<jint, jintArray>;
+    functions.NewLongArray = newArray<jlong, jlongArray>;
+    functions.NewFloatArray = newArray<jfloat, jfloatArray>;
+    functions.GetByteArrayElements = getArrayElements<jbyte, jbyteArray>;
+    functions.GetIntArrayElements = getArrayElements<jint, jintArray>;
+    functions.GetLongArrayElements = getArrayElements<jlong, jlongArray>;
+    functions.ReleaseByteArrayElements =
+        releaseArrayElements<jbyte, jbyteArray>;
+    functions.ReleaseIntArrayElements = releaseArrayElements<jint, jintArray>;
+    functions.ReleaseLongArrayElements =
+        releaseArrayElements<jlong, jlongArray>;
+    functions.GetByteArrayRegion = getArrayRegion<jbyte, jbyteArray>;
+    functions.GetShortArrayRegion = getArrayRegion<jshort, jshortArray>;
+    functions.GetIntArrayRegion = getArrayRegion<jint, jintArray>;
+    functions.GetLongArrayRegion = getArrayRegion<jlong, jlongArray>;
+    functions.GetFloatArrayRegion = getArrayRegion<jfloat, jfloatArray>;
+    functions.SetByteArrayRegion = setArrayRegion<jbyte, jbyteArray>;
+    functions.SetShortArrayRegion = setArrayRegion<jshort, jshortArray>;
+    functions.SetIntArrayRegion = setArrayRegion<jint, jintArray>;
+    functions.SetLongArrayRegion = setArrayRegion<jlong, jlongArray>;
+    functions.SetFloatArrayRegion = setArrayRegion<jfloat, jfloatArray>;
+    functions.GetPrimitiveArrayCritical = getPrimitiveArrayCritical;
+    functions.ReleasePrimitiveArrayCritical = releasePrimitiveArrayCritical;
+    functions.RegisterNatives = registerNatives;
+    functions.GetJavaVM = getJavaVM;
+    functions.NewDirectByteBuffer = newDirectByteBuffer;
+    functions.GetDirectBufferAddress = getDirectBufferAddress;
+    functions.GetDirectBufferCapacity = getDirectBufferCapacity;
+  });
+  return &functions;
+}
+
+/* The arena is taken with malloc() so that the benchmarks count only the
+ * allocations of the code under test */
+static jint attachCurrentThread(JavaVM *, JNIEnv **env, void *) {
+  if (tEnv == NULL) {
+    MockEnv *mockEnv = static_cast<MockEnv *>(calloc(1, sizeof(MockEnv)));
+    uint8_t *arena = static_cast<uint8_t *>(malloc(MOCK_JVM_ARENA_SIZE));
+    if (mockEnv == NULL || arena == NULL) {
+      free(arena);
+      free(mockEnv);
+      *env = NULL;
+      return JNI_ERR;
+    }
+    mockEnv->env.functions = getNativeInterface();
+    mockEnv->arena = arena;
+    tEnv = mockEnv;
+  }
+  *env = &tEnv->env;
+  return JNI_OK;
+}
+
+static jint detachCurrentThread(JavaVM *) {
+  if (tEnv == NULL) {
+    return JNI_ERR;
+  }
+  free(tEnv->arena);
+  free(tEnv);
+  tEnv = NULL;
+  return JNI_OK;
+}
+
+static jint getEnv(JavaVM *, void **env, jint) {
+  if (tEnv == NULL) {
+    *env = NULL;
+    return JNI_EDETACHED;
+  }
+  *env = &tEnv->env;
+  return JNI_OK;
+}
+
+static const JNIInvokeInterface sInvokeInterface = {
+    NULL, NULL, NULL, NULL, attachCurrentThread, detachCurrentThread, getEnv,
+    NULL};
+
+MockJvm &MockJvm::getInstance() {
+  static MockJvm sMockJvm;
+  return sMockJvm;
+}
+
+MockJvm::MockJvm() { mVm.functions = &sInvokeInterface; }
+
+JNIEnv *MockJvm::getEnv() {
+  JNIEnv *env = NULL;
+  attachCurrentThread(&mVm, &env, NULL);
+  return env;
+}
+
+jobject MockJvm::newPeer() {
+  MockObject *peer = static_cast<MockObject *>(calloc(1, sizeof(MockObject)));
+  if (peer != NULL) {
+    peer->kind = MOCK_KIND_OBJECT;
+  }
+  return reinterpret_cast<jobject>(peer);
+}
+
+void *MockJvm::findNative(const char *name, const char *signature) {
+  std::lock_guard<std::mutex> lock(sNativesMutex);
+  for (const MockNative &native : sNatives) {
+    if (native.name == name && native.signature == signature) {
+      return native.fnPtr;
+    }
+  }
+  return NULL;
+}
+
+uint64_t MockJvm::getAllocations() const {
+  return sAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t MockJvm::getUpcalls() const {
+  return sUpcalls.load(std::memory_order_relaxed);
+}
+
+} // namespace android
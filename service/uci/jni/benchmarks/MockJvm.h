@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_MOCK_JVM_H_
+#define _UWB_MOCK_JVM_H_
+
+#include <stdint.h>
+
+#include <jni.h>
+
+namespace android {
+
+/* Stand-in for the Java VM the JNI sources run in, for the benchmarks. It
+ * implements the JNI functions the sources call; objects and arrays live in
+ * a per thread arena that is reclaimed when the enclosing local frame is
+ * popped, and upcalls return without doing anything. The VM counts the Java
+ * objects allocated through it and the upcalls made, so a benchmark can
+ * report both per event. Globals, classes and natives are only created
+ * during setup. */
+class MockJvm {
+public:
+  static MockJvm &getInstance();
+
+  JavaVM *getVm() { return &mVm; }
+  /* Environment of the calling thread, attached on first use */
+  JNIEnv *getEnv();
+  /* Object standing for the Java peer of a native manager */
+  jobject newPeer();
+  /* Function registered for a native method, NULL if there is none */
+  void *findNative(const char *name, const char *signature);
+
+  uint64_t getAllocations() const;
+  uint64_t getUpcalls() const;
+
+private:
+  MockJvm();
+  MockJvm(const MockJvm &) = delete;
+  MockJvm &operator=(const MockJvm &) = delete;
+
+  JavaVM mVm;
+};
+
+} // namespace android
+#endif
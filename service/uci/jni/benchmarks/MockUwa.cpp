@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Stand-in for the UWB stack the JNI sources link against, for the
+ *  benchmarks. The benchmarks call the notification paths directly, so no
+ *  UWBS is behind the stack: every command is rejected as if the UWBS had
+ *  not been enabled, and nothing is ever delivered to the callbacks.
+ */
+
+#include <stdlib.h>
+
+#include "UwbAdaptation.h"
+#include "uwa_api.h"
+#include "uwb_api.h"
+#include "uwb_config.h"
+#include "uwb_hal_int.h"
+
+/* Debug logging of the stack, read by the JNI log macros */
+bool uwb_debug_enabled = false;
+
+UwbAdaptation &UwbAdaptation::GetInstance() {
+  static UwbAdaptation sAdaptation;
+  return sAdaptation;
+}
+
+void UwbAdaptation::Initialize() {}
+
+void UwbAdaptation::Finalize(bool) {}
+
+tHAL_UWB_ENTRY *UwbAdaptation::GetHalEntryFuncs() { return NULL; }
+
+tUWA_STATUS UwbAdaptation::CoreInitialization() { return UWA_STATUS_FAILED; }
+
+bool UwbConfig::hasKey(const std::string &) { return false; }
+
+unsigned UwbConfig::getUnsigned(const std::string &, unsigned defaultValue) {
+  return defaultValue;
+}
+
+std::string UwbConfig::getString(const std::string &,
+                                 const std::string &defaultValue) {
+  return defaultValue;
+}
+
+void *phUwb_GKI_getbuf(uint16_t size) { return malloc(size); }
+
+void phUwb_GKI_freebuf(void *pBuf) { free(pBuf); }
+
+void UWB_EnableConformanceTest(bool) {}
+
+void UWA_Init(tHAL_UWB_ENTRY *) {}
+
+tUWA_STATUS UWA_Enable(tUWA_DM_CBACK *, tUWA_DM_TEST_CBACK *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_Disable(bool) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_SendDeviceReset(uint8_t) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_GetDeviceInfo() { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_GetCoreGetDeviceCapability() { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_SetCoreConfig(tUWA_PMID, uint8_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_GetCoreConfig(uint8_t, tUWA_PMID *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_ControllerSetCountryCode(uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_SendSessionInit(uint32_t, uint8_t) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_SendSessionDeInit(uint32_t) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_GetSessionCount() { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_GetSessionStatus(uint32_t) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_SetAppConfig(uint32_t, uint8_t, uint8_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_GetAppConfig(uint32_t, uint8_t, uint8_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_StartRangingSession(uint32_t) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_StopRangingSession(uint32_t) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_ControllerMulticastListUpdate(uint32_t, uint8_t, uint8_t,
+                                              uint16_t *, uint32_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_SendRawCommand(uint16_t, uint8_t *, tUWA_RAW_CMD_CBACK *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_TestSetConfig(uint32_t, uint8_t, uint8_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_TestGetConfig(uint32_t, uint8_t, uint8_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_PeriodicTxTest(uint16_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_PerRxTest(uint16_t, uint8_t *) { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_UwbLoopBackTest(uint16_t, uint8_t *) {
+  return UWA_STATUS_FAILED;
+}
+
+tUWA_STATUS UWA_RxTest() { return UWA_STATUS_FAILED; }
+
+tUWA_STATUS UWA_TestStopSession() { return UWA_STATUS_FAILED; }
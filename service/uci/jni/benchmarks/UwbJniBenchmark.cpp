@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Microbenchmarks of the notification paths of the JNI layer, run on the
+ *  host against the UWA stand-ins in mock/ and MockJvm. One iteration is one
+ *  event, so the reported time is ns/event. Every benchmark also reports
+ *  allocs/event (native heap, through the replaced operator new, on all
+ *  threads), java_allocs/event (objects and arrays created through JNI) and
+ *  upcalls/event.
+ *
+ *  Logging is turned off, as it would dominate every path.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "JniLog.h"
+#include "MockJvm.h"
+#include "UwbChipContext.h"
+#include "UwbEventManager.h"
+#include "UwbJniInternal.h"
+#include "UwbNotificationDispatcher.h"
+#include "UwbRangingFilter.h"
+#include "UwbRfTestManager.h"
+#include "uwa_api.h"
+
+using android::MockJvm;
+using android::UwbChipContext;
+using android::UwbEventManager;
+using android::UwbRfTestManager;
+
+#define BENCH_SESSION_ID 0x1234
+#define BENCH_FILTER_WINDOW 8
+
+static std::atomic<uint64_t> sAllocations(0);
+
+void *operator new(size_t size) {
+  sAllocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+typedef jboolean (*tNATIVE_INIT)(JNIEnv *env, jobject o, jint chipId);
+typedef jbyte (*tNATIVE_SET_RANGING_FILTER)(JNIEnv *env, jobject o,
+                                            jint chipId, jint sessionId,
+                                            jint mode, jint window,
+                                            jint ewmaAlpha, jint minFom);
+
+static jobject sPeer = NULL;
+
+/* Load the library as the VM would: JNI_OnLoad, then nativeInit() of the
+ * manager for every chip, which starts the dispatcher thread of each. The
+ * mock stack rejects every command, so the further chips share its entry
+ * points. */
+static JNIEnv *loadNativeManager() {
+  MockJvm &jvm = MockJvm::getInstance();
+  static std::once_flag once;
+  std::call_once(once, [&jvm]() {
+    uwb_debug_enabled = false;
+    android::uwb_debug_enabled = false;
+    JNIEnv *env = jvm.getEnv();
+    if (JNI_OnLoad(jvm.getVm(), NULL) == JNI_ERR) {
+      abort();
+    }
+    sPeer = jvm.newPeer();
+    tNATIVE_INIT init =
+        reinterpret_cast<tNATIVE_INIT>(jvm.findNative("nativeInit", "(I)Z"));
+    if (init == NULL) {
+      abort();
+    }
+    for (jint chipId = 0; chipId < UWB_MAX_CHIPS; chipId++) {
+      if (chipId != UWB_DEFAULT_CHIP_ID &&
+          !UwbChipContext::addChip(chipId,
+                                   UwbChipContext::getDefault().getStack())) {
+        abort();
+      }
+      if (!init(env, sPeer, chipId)) {
+        abort();
+      }
+    }
+    UwbChipContext::getDefault().getRfTestManager().doLoadSymbols(env, sPeer);
+  });
+  return jvm.getEnv();
+}
+
+/* Select the distance filter of the benchmark session of a chip through the
+ * native */
+static void setRangingFilter(JNIEnv *env, jint chipId, uint8_t mode) {
+  tNATIVE_SET_RANGING_FILTER setFilter =
+      reinterpret_cast<tNATIVE_SET_RANGING_FILTER>(
+          MockJvm::getInstance().findNative("nativeSetRangingFilter",
+                                            "(IIIIII)B"));
+  if (setFilter == NULL ||
+      setFilter(env, sPeer, chipId, BENCH_SESSION_ID, mode,
+                BENCH_FILTER_WINDOW, 0, 0) != UWA_STATUS_OK) {
+    abort();
+  }
+}
+
+/* Wait until the dispatcher thread of a chip has taken every queued
+ * notification */
+static void waitForDispatcher(UwbChipContext &chip) {
+  int64_t stats[android::UWB_NTF_QUEUE_STAT_MAX];
+  do {
+    std::this_thread::yield();
+    chip.getDispatcher().getStats(stats);
+  } while (stats[android::UWB_NTF_QUEUE_STAT_DEPTH] != 0);
+}
+
+/* Allocation and upcall counts since construction, reported per event */
+class EventCounters {
+public:
+  EventCounters()
+      : mAllocations(sAllocations.load(std::memory_order_relaxed)),
+        mJavaAllocations(MockJvm::getInstance().getAllocations()),
+        mUpcalls(MockJvm::getInstance().getUpcalls()) {}
+
+  void report(benchmark::State &state) {
+    MockJvm &jvm = MockJvm::getInstance();
+    state.counters["allocs/event"] = benchmark::Counter(
+        sAllocations.load(std::memory_order_relaxed) - mAllocations,
+        benchmark::Counter::kAvgIterations);
+    state.counters["java_allocs/event"] =
+        benchmark::Counter(jvm.getAllocations() - mJavaAllocations,
+                           benchmark::Counter::kAvgIterations);
+    state.counters["upcalls/event"] = benchmark::Counter(
+        jvm.getUpcalls() - mUpcalls, benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  uint64_t mAllocations;
+  uint64_t mJavaAllocations;
+  uint64_t mUpcalls;
+};
+
+/* Two way ranging round of the benchmark session with the given number of
+ * responders, at slowly varying distances */
+static void fillRangeData(tUWA_RANGE_DATA_NTF *ntf, int noOfMeasurements) {
+  memset(ntf, 0, sizeof(*ntf));
+  ntf->session_id = BENCH_SESSION_ID;
+  ntf->curr_range_interval = 200;
+  ntf->ranging_measure_type = MEASUREMENT_TYPE_TWOWAY;
+  ntf->mac_addr_mode_indicator = SHORT_MAC_ADDRESS;
+  ntf->no_of_measurements = noOfMeasurements;
+  for (int i = 0; i < noOfMeasurements; i++) {
+    tUWA_TWR_RANGING_MEASR &measr = ntf->ranging_measures.twr_range_measr[i];
+    measr.mac_addr[0] = i;
+    measr.mac_addr[1] = 0x10;
+    measr.distance = 100 + 10 * i;
+    measr.aoa_azimuth = 30 << 7;
+    measr.aoa_azimuth_FOM = 100;
+    measr.aoa_elevation = 10 << 7;
+    measr.aoa_elevation_FOM = 100;
+    measr.slot_index = i;
+  }
+}
+
+static void nextRound(tUWA_RANGE_DATA_NTF *ntf) {
+  ntf->seq_counter++;
+  for (int i = 0; i < ntf->no_of_measurements; i++) {
+    ntf->ranging_measures.twr_range_measr[i].distance =
+        100 + 10 * i + (ntf->seq_counter & 0x7);
+  }
+}
+
+/* Upcall of one ranging round on the dispatcher thread, here called on the
+ * benchmark thread. Argument: number of responders. */
+static void BM_OnRangeDataNotificationReceived(benchmark::State &state) {
+  loadNativeManager();
+  UwbEventManager &eventManager =
+      UwbChipContext::getDefault().getEventManager();
+  tUWA_RANGE_DATA_NTF ntf;
+  fillRangeData(&ntf, state.range(0));
+  EventCounters counters;
+  for (auto _ : state) {
+    nextRound(&ntf);
+    eventManager.onRangeDataNotificationReceived(&ntf);
+  }
+  counters.report(state);
+}
+BENCHMARK(BM_OnRangeDataNotificationReceived)->DenseRange(1, MAX_NUM_RESPONDERS);
+
+/* Ranging round as received from the UWA stack: filter, admission and post
+ * to the dispatcher, whose thread makes the upcalls concurrently. The time
+ * is that of the UWA callback thread; rounds the dispatcher falls behind on
+ * are coalesced, which shows in upcalls/event. Arguments: number of
+ * responders, averaging off (0) or on (1). */
+static void BM_NotifyRangeDataNotification(benchmark::State &state) {
+  JNIEnv *env = loadNativeManager();
+  UwbChipContext &chip = UwbChipContext::getDefault();
+  setRangingFilter(env, UWB_DEFAULT_CHIP_ID,
+                   state.range(1) ? android::UWB_RANGING_FILTER_MEAN
+                                  : android::UWB_RANGING_FILTER_NONE);
+  tUWA_RANGE_DATA_NTF ntf;
+  fillRangeData(&ntf, state.range(0));
+  EventCounters counters;
+  for (auto _ : state) {
+    nextRound(&ntf);
+    android::notifyRangeDataNotification(chip, &ntf);
+  }
+  waitForDispatcher(chip);
+  counters.report(state);
+}
+BENCHMARK(BM_NotifyRangeDataNotification)
+    ->ArgsProduct({{1, MAX_NUM_RESPONDERS}, {0, 1}});
+
+/* Same path with one UWA callback thread per chip, each feeding its own
+ * context; the time stays flat as long as the chips scale. The counters are
+ * shared by all chips and reported by the first thread only, once its own
+ * dispatcher drained, so they are indicative. Argument: number of
+ * responders. */
+static void BM_NotifyRangeDataNotificationPerChip(benchmark::State &state) {
+  JNIEnv *env = loadNativeManager();
+  jint chipId = state.thread_index();
+  UwbChipContext &chip = *UwbChipContext::get(chipId);
+  setRangingFilter(env, chipId, android::UWB_RANGING_FILTER_MEAN);
+  tUWA_RANGE_DATA_NTF ntf;
+  fillRangeData(&ntf, state.range(0));
+  EventCounters counters;
+  for (auto _ : state) {
+    nextRound(&ntf);
+    android::notifyRangeDataNotification(chip, &ntf);
+  }
+  waitForDispatcher(chip);
+  if (state.thread_index() == 0) {
+    counters.report(state);
+  }
+}
+BENCHMARK(BM_NotifyRangeDataNotificationPerChip)
+    ->Arg(MAX_NUM_RESPONDERS)
+    ->ThreadRange(1, UWB_MAX_CHIPS)
+    ->UseRealTime();
+
+/* Upcall of a multicast list update outside of a controlee update.
+ * Argument: number of controlees. */
+static void BM_OnMulticastListUpdateNotificationReceived(
+    benchmark::State &state) {
+  loadNativeManager();
+  UwbEventManager &eventManager =
+      UwbChipContext::getDefault().getEventManager();
+  tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF ntf;
+  memset(&ntf, 0, sizeof(ntf));
+  ntf.session_id = BENCH_SESSION_ID;
+  ntf.no_of_controlees = state.range(0);
+  for (int i = 0; i < ntf.no_of_controlees; i++) {
+    ntf.controlee_mac_address_list[i] = 0x1000 + i;
+    ntf.subsession_id_list[i] = 0x100 + i;
+  }
+  EventCounters counters;
+  for (auto _ : state) {
+    eventManager.onMulticastListUpdateNotificationReceived(&ntf);
+  }
+  counters.report(state);
+}
+BENCHMARK(BM_OnMulticastListUpdateNotificationReceived)
+    ->DenseRange(1, MAX_NUM_CONTROLLEES);
+
+/* RF test notification payloads, as the UCI stack passes them on */
+static void putUint16(std::vector<uint8_t> &payload, uint16_t value) {
+  payload.push_back(value & 0xFF);
+  payload.push_back(value >> 8);
+}
+
+static void putUint32(std::vector<uint8_t> &payload, uint32_t value) {
+  putUint16(payload, value & 0xFFFF);
+  putUint16(payload, value >> 16);
+}
+
+static void putPsdu(std::vector<uint8_t> &payload, uint16_t psduLen) {
+  putUint16(payload, psduLen);
+  for (uint16_t i = 0; i < psduLen; i++) {
+    payload.push_back(i);
+  }
+}
+
+static std::vector<uint8_t> makePeriodicTxData(uint16_t) {
+  return std::vector<uint8_t>(1, UWA_STATUS_OK);
+}
+
+static std::vector<uint8_t> makePerRxData(uint16_t) {
+  std::vector<uint8_t> payload(1, UWA_STATUS_OK);
+  for (uint32_t i = 0; i < 13; i++) {
+    putUint32(payload, 1000 + i);
+  }
+  return payload;
+}
+
+static std::vector<uint8_t> makeLoopBackData(uint16_t psduLen) {
+  std::vector<uint8_t> payload(1, UWA_STATUS_OK);
+  putUint32(payload, 0x12345678); // TX timestamp
+  putUint16(payload, 0x100);
+  putUint32(payload, 0x12345978); // RX timestamp
+  putUint16(payload, 0x180);
+  putUint16(payload, 30 << 7); // AoA azimuth
+  putUint16(payload, 10 << 7); // AoA elevation
+  putUint16(payload, 0x0A0B);  // PHR
+  putPsdu(payload, psduLen);
+  return payload;
+}
+
+static std::vector<uint8_t> makeRxData(uint16_t psduLen) {
+  std::vector<uint8_t> payload(1, UWA_STATUS_OK);
+  putUint32(payload, 0x12345678); // RX done timestamp
+  putUint16(payload, 0x100);
+  putUint16(payload, 30 << 7); // first AoA
+  putUint16(payload, 31 << 7); // second AoA
+  payload.push_back(2);        // ToA gap
+  putUint16(payload, 0x0A0B);  // PHR
+  putPsdu(payload, psduLen);
+  return payload;
+}
+
+/* Parse and upcall of one RF test notification. Argument: PSDU length. */
+template <void (UwbRfTestManager::*parse)(uint16_t, uint8_t *),
+          std::vector<uint8_t> (*make)(uint16_t)>
+static void BM_RfTestNotification(benchmark::State &state) {
+  loadNativeManager();
+  UwbRfTestManager &rfTestManager =
+      UwbChipContext::getDefault().getRfTestManager();
+  std::vector<uint8_t> payload = make(state.range(0));
+  EventCounters counters;
+  for (auto _ : state) {
+    (rfTestManager.*parse)(payload.size(), payload.data());
+  }
+  counters.report(state);
+}
+BENCHMARK_TEMPLATE(BM_RfTestNotification,
+                   &UwbRfTestManager::onPeriodicTxDataNotificationReceived,
+                   makePeriodicTxData)
+    ->Name("BM_RfTestPeriodicTx")
+    ->Arg(0);
+BENCHMARK_TEMPLATE(BM_RfTestNotification,
+                   &UwbRfTestManager::onPerRxDataNotificationReceived,
+                   makePerRxData)
+    ->Name("BM_RfTestPerRx")
+    ->Arg(0);
+BENCHMARK_TEMPLATE(BM_RfTestNotification,
+                   &UwbRfTestManager::onLoopBackTestDataNotificationReceived,
+                   makeLoopBackData)
+    ->Name("BM_RfTestLoopBack")
+    ->Arg(0)
+    ->Arg(127);
+BENCHMARK_TEMPLATE(BM_RfTestNotification,
+                   &UwbRfTestManager::onRxTestDataNotificationReceived,
+                   makeRxData)
+    ->Name("BM_RfTestRx")
+    ->Arg(0)
+    ->Arg(127);
+
+BENCHMARK_MAIN();
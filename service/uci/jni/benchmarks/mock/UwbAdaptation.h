@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Host stand-in for the adaptation layer of the UWB stack. Only for the
+ *  benchmarks.
+ */
+
+#ifndef UWB_ADAPTATION_H
+#define UWB_ADAPTATION_H
+
+#include "uwa_api.h"
+
+class UwbAdaptation {
+public:
+  static UwbAdaptation &GetInstance();
+  void Initialize();
+  void Finalize(bool graceful);
+  tHAL_UWB_ENTRY *GetHalEntryFuncs();
+  tUWA_STATUS CoreInitialization();
+
+private:
+  UwbAdaptation() {}
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Host stand-in for the UCI definitions of the UWB stack, reduced to what
+ *  the JNI sources use. Only for the benchmarks: the values follow the UCI
+ *  specification, the stream macros the little endian wire format.
+ */
+
+#ifndef UWB_UCI_DEFS_H
+#define UWB_UCI_DEFS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define UCI_MSG_HDR_SIZE 4
+#define UCI_MAX_PAYLOAD_SIZE 255
+#define UCI_MAX_PKT_SIZE (UCI_MSG_HDR_SIZE + UCI_MAX_PAYLOAD_SIZE)
+#define UCI_PSDU_SIZE_4K 4096
+#define UCI_RESPONSE_STATUS_OFFSET 4
+
+/* Message types */
+#define UCI_MT_CMD 1
+#define UCI_MT_RSP 2
+#define UCI_MT_NTF 3
+
+/* Core configuration parameters */
+#define UCI_PARAM_ID_DEVICE_STATE 0x00
+#define UCI_PARAM_ID_LOW_POWER_MODE 0x01
+
+#define MAX_NUM_RESPONDERS 12
+#define MAX_NUM_CONTROLLEES 8
+#define MAX_NUM_OF_TDOA_MEASURES 20
+
+#define SESSION_ID_LEN 4
+#define SHORT_MAC_ADDRESS 0
+#define EXTENDED_MAC_ADDRESS 1
+#define ONE_WAY_RANGING 0
+#define MEASUREMENT_TYPE_TWOWAY 1
+#define CONFORMANCE_TEST_MAX_UCI_PKT_LENGTH 260
+
+/* Session states */
+#define UWB_SESSION_INITIALIZED 0
+#define UWB_SESSION_DEINITIALIZED 1
+#define UWB_SESSION_ACTIVE 2
+#define UWB_SESSION_IDLE 3
+#define UWB_UNKNOWN_SESSION 0xFF
+
+typedef enum {
+  UWBS_STATUS_READY = 0x01,
+  UWBS_STATUS_ACTIVE = 0x02,
+  UWBS_STATUS_TIMEOUT = 0xFE,
+  UWBS_STATUS_ERROR = 0xFF
+} eUWBS_DEVICE_STATUS_t;
+
+#define UCI_MSG_BLD_HDR0(p, mt, gid)                                           \
+  *(p)++ = (uint8_t)(((mt) << 5) | (gid));
+#define UCI_MSG_BLD_HDR1(p, oid) *(p)++ = (uint8_t)(oid);
+
+#define UCI_MSG_PRS_HDR0(p, mt, pbf, gid)                                      \
+  {                                                                            \
+    (mt) = (*(p) >> 5) & 0x07;                                                 \
+    (pbf) = (*(p) >> 4) & 0x01;                                                \
+    (gid) = *(p)++ & 0x0F;                                                     \
+  }
+#define UCI_MSG_PRS_HDR1(p, oid)                                               \
+  { (oid) = *(p)++ & 0x3F; }
+
+#define UINT8_TO_STREAM(p, u8)                                                 \
+  { *(p)++ = (uint8_t)(u8); }
+#define ARRAY_TO_STREAM(p, a, len)                                             \
+  {                                                                            \
+    for (int ijk = 0; ijk < (len); ijk++)                                      \
+      *(p)++ = (uint8_t)(a)[ijk];                                              \
+  }
+
+#define STREAM_TO_UINT8(u8, p)                                                 \
+  {                                                                            \
+    (u8) = (uint8_t)(*(p));                                                    \
+    (p) += 1;                                                                  \
+  }
+#define STREAM_TO_UINT16(u16, p)                                               \
+  {                                                                            \
+    (u16) = ((uint16_t)(*(p)) + (((uint16_t)(*((p) + 1))) << 8));            \
+    (p) += 2;                                                                  \
+  }
+#define STREAM_TO_UINT32(u32, p)                                               \
+  {                                                                            \
+    (u32) = (((uint32_t)(*(p))) + ((((uint32_t)(*((p) + 1)))) << 8) +        \
+             ((((uint32_t)(*((p) + 2)))) << 16) +                              \
+             ((((uint32_t)(*((p) + 3)))) << 24));                              \
+    (p) += 4;                                                                  \
+  }
+#define STREAM_TO_ARRAY(a, p, len)                                             \
+  {                                                                            \
+    for (int ijk = 0; ijk < (len); ijk++)                                      \
+      ((uint8_t *)(a))[ijk] = *(p)++;                                          \
+  }
+
+#endif
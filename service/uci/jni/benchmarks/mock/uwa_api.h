@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Host stand-in for the UWA API of the UWB stack, reduced to the events,
+ *  structures and calls the JNI sources use. Only for the benchmarks, which
+ *  link the JNI sources against MockUwa.cpp instead of the stack.
+ */
+
+#ifndef UWA_API_H
+#define UWA_API_H
+
+#include "uci_defs.h"
+
+typedef uint8_t tUWA_STATUS;
+typedef uint8_t tUWA_PMID;
+
+#define UWA_STATUS_OK 0x00
+#define UWA_STATUS_FAILED 0x01
+
+/* Device management events, delivered to tUWA_DM_CBACK */
+enum {
+  UWA_DM_ENABLE_EVT,
+  UWA_DM_DISABLE_EVT,
+  UWA_DM_DEVICE_RESET_RSP_EVT,
+  UWA_DM_DEVICE_STATUS_NTF_EVT,
+  UWA_DM_CORE_GET_DEVICE_INFO_RSP_EVT,
+  UWA_DM_CORE_SET_CONFIG_RSP_EVT,
+  UWA_DM_CORE_GET_CONFIG_RSP_EVT,
+  UWA_DM_SESSION_INIT_RSP_EVT,
+  UWA_DM_SESSION_DEINIT_RSP_EVT,
+  UWA_DM_SESSION_STATUS_NTF_EVT,
+  UWA_DM_SESSION_SET_CONFIG_RSP_EVT,
+  UWA_DM_SESSION_GET_CONFIG_RSP_EVT,
+  UWA_DM_RANGE_START_RSP_EVT,
+  UWA_DM_RANGE_STOP_RSP_EVT,
+  UWA_DM_GET_RANGE_COUNT_RSP_EVT,
+  UWA_DM_RANGE_DATA_NTF_EVT,
+  UWA_DM_SESSION_GET_COUNT_RSP_EVT,
+  UWA_DM_SESSION_GET_STATE_RSP_EVT,
+  UWA_DM_SESSION_MC_LIST_UPDATE_RSP_EVT,
+  UWA_DM_SESSION_MC_LIST_UPDATE_NTF_EVT,
+  UWA_DM_SET_COUNTRY_CODE_RSP_EVT,
+  UWA_DM_SEND_BLINK_DATA_RSP_EVT,
+  UWA_DM_GET_CORE_DEVICE_CAP_RSP_EVT,
+  UWA_DM_SEND_BLINK_DATA_NTF_EVT,
+  UWA_VENDOR_SPECIFIC_UCI_NTF_EVT,
+  UWA_DM_CONFORMANCE_NTF_EVT,
+  UWA_DM_CORE_GEN_ERR_STATUS_EVT,
+  UWA_DM_UWBS_RESP_TIMEOUT_EVT
+};
+
+/* RF test events, delivered to tUWA_DM_TEST_CBACK */
+enum {
+  UWA_DM_TEST_SET_CONFIG_RSP_EVT,
+  UWA_DM_TEST_GET_CONFIG_RSP_EVT,
+  UWA_DM_TEST_PERIODIC_TX_RSP_EVT,
+  UWA_DM_TEST_PER_RX_RSP_EVT,
+  UWA_DM_TEST_LOOPBACK_RSP_EVT,
+  UWA_DM_TEST_RX_RSP_EVT,
+  UWA_DM_TEST_STOP_SESSION_RSP_EVT,
+  UWA_DM_TEST_PERIODIC_TX_NTF_EVT,
+  UWA_DM_TEST_PER_RX_NTF_EVT,
+  UWA_DM_TEST_LOOPBACK_NTF_EVT,
+  UWA_DM_TEST_RX_NTF_EVT
+};
+
+typedef struct {
+  uint8_t mac_addr[8];
+  uint8_t status;
+  uint8_t nLos;
+  uint16_t distance;
+  uint16_t aoa_azimuth;
+  uint8_t aoa_azimuth_FOM;
+  uint16_t aoa_elevation;
+  uint8_t aoa_elevation_FOM;
+  uint16_t aoa_dest_azimuth;
+  uint8_t aoa_dest_azimuth_FOM;
+  uint16_t aoa_dest_elevation;
+  uint8_t aoa_dest_elevation_FOM;
+  uint8_t slot_index;
+  uint8_t rfu[12];
+} tUWA_TWR_RANGING_MEASR;
+
+typedef struct {
+  uint8_t mac_addr[8];
+  uint8_t frame_type;
+  uint8_t nLos;
+  uint16_t aoa_azimuth;
+  uint8_t aoa_azimuth_FOM;
+  uint16_t aoa_elevation;
+  uint8_t aoa_elevation_FOM;
+  uint64_t timeStamp;
+  uint32_t blink_frame_number;
+  uint8_t rfu[12];
+  uint8_t device_info_size;
+  uint8_t *device_info;
+  uint8_t blink_payload_size;
+  uint8_t *blink_payload_data;
+} tUWA_TDoA_RANGING_MEASR;
+
+typedef struct {
+  uint32_t seq_counter;
+  uint32_t session_id;
+  uint8_t rcr_indication;
+  uint32_t curr_range_interval;
+  uint8_t ranging_measure_type;
+  uint8_t rfu;
+  uint8_t mac_addr_mode_indicator;
+  uint8_t reserved[8];
+  uint8_t no_of_measurements;
+  union {
+    tUWA_TWR_RANGING_MEASR twr_range_measr[MAX_NUM_RESPONDERS];
+    tUWA_TDoA_RANGING_MEASR tdoa_range_measr[MAX_NUM_OF_TDOA_MEASURES];
+  } ranging_measures;
+} tUWA_RANGE_DATA_NTF;
+
+typedef struct {
+  uint32_t session_id;
+  uint8_t remaining_list;
+  uint8_t no_of_controlees;
+  uint16_t controlee_mac_address_list[MAX_NUM_CONTROLLEES];
+  uint32_t subsession_id_list[MAX_NUM_CONTROLLEES];
+  uint8_t status_list[MAX_NUM_CONTROLLEES];
+} tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF;
+
+typedef union {
+  tUWA_STATUS status;
+  struct {
+    uint8_t status;
+  } dev_status;
+  struct {
+    uint8_t status;
+    uint16_t uci_version;
+    uint16_t mac_version;
+    uint16_t phy_version;
+    uint16_t uciTest_version;
+    uint8_t vendor_info_len;
+    uint8_t vendor_info[64];
+  } sGet_device_info;
+  struct {
+    uint8_t status;
+    uint8_t num_param_id;
+    uint8_t tlv_size;
+    uint8_t param_ids[UCI_MAX_PAYLOAD_SIZE];
+  } sCore_set_config;
+  struct {
+    uint8_t status;
+    uint8_t no_of_ids;
+    uint8_t tlv_size;
+    uint8_t param_tlvs[UCI_MAX_PAYLOAD_SIZE];
+  } sCore_get_config;
+  struct {
+    uint32_t session_id;
+    uint8_t state;
+    uint8_t reason_code;
+  } sSessionStatus;
+  struct {
+    uint8_t status;
+    uint8_t num_param_id;
+    uint8_t tlv_size;
+    uint8_t param_ids[UCI_MAX_PAYLOAD_SIZE];
+  } sApp_set_config;
+  struct {
+    uint8_t status;
+    uint8_t no_of_ids;
+    uint8_t tlv_size;
+    uint8_t param_tlvs[UCI_MAX_PAYLOAD_SIZE];
+  } sApp_get_config;
+  struct {
+    uint8_t status;
+    uint32_t count;
+  } sGet_range_cnt;
+  tUWA_RANGE_DATA_NTF sRange_data;
+  struct {
+    uint8_t status;
+    uint8_t count;
+  } sGet_session_cnt;
+  struct {
+    uint8_t status;
+    uint8_t session_state;
+  } sGet_session_state;
+  tUWA_SESSION_UPDATE_MULTICAST_LIST_NTF sMulticast_list_ntf;
+  struct {
+    uint8_t repetition_count_status;
+  } sBlink_data_ntf;
+  struct {
+    uint8_t status;
+    uint8_t no_of_tlvs;
+    uint16_t tlv_buffer_len;
+    uint8_t tlv_buffer[UCI_MAX_PKT_SIZE];
+  } sGet_device_capability;
+  struct {
+    uint16_t len;
+    uint8_t data[UCI_MAX_PKT_SIZE];
+  } sVendor_specific_ntf;
+  struct {
+    uint16_t length;
+    uint8_t data[UCI_MAX_PKT_SIZE];
+  } sConformance_ntf;
+  struct {
+    uint8_t status;
+  } sCore_gen_err_status;
+} tUWA_DM_CBACK_DATA;
+
+typedef union {
+  tUWA_STATUS status;
+  struct {
+    uint8_t status;
+    uint8_t num_param_id;
+    uint8_t tlv_size;
+    uint8_t param_ids[UCI_MAX_PAYLOAD_SIZE];
+  } sTest_set_config;
+  struct {
+    uint8_t status;
+    uint8_t no_of_ids;
+    uint8_t tlv_size;
+    uint8_t param_tlvs[UCI_MAX_PAYLOAD_SIZE];
+  } sTest_get_config;
+  struct {
+    uint16_t length;
+    uint8_t data[UCI_MAX_PAYLOAD_SIZE];
+  } rf_test_data;
+} tUWA_DM_TEST_CBACK_DATA;
+
+typedef void(tUWA_DM_CBACK)(uint8_t dmEvent, tUWA_DM_CBACK_DATA *eventData);
+typedef void(tUWA_DM_TEST_CBACK)(uint8_t dmEvent,
+                                 tUWA_DM_TEST_CBACK_DATA *eventData);
+typedef void(tUWA_RAW_CMD_CBACK)(uint8_t event, uint16_t paramLen,
+                                 uint8_t *pParam);
+
+struct tHAL_UWB_ENTRY;
+
+void UWA_Init(tHAL_UWB_ENTRY *pHalEntry);
+tUWA_STATUS UWA_Enable(tUWA_DM_CBACK *pDmCback,
+                       tUWA_DM_TEST_CBACK *pDmTestCback);
+tUWA_STATUS UWA_Disable(bool graceful);
+tUWA_STATUS UWA_SendDeviceReset(uint8_t resetConfig);
+tUWA_STATUS UWA_GetDeviceInfo();
+tUWA_STATUS UWA_GetCoreGetDeviceCapability();
+tUWA_STATUS UWA_SetCoreConfig(tUWA_PMID paramId, uint8_t length,
+                              uint8_t *pData);
+tUWA_STATUS UWA_GetCoreConfig(uint8_t numIds, tUWA_PMID *pParamIds);
+tUWA_STATUS UWA_ControllerSetCountryCode(uint8_t *countryCode);
+tUWA_STATUS UWA_SendSessionInit(uint32_t sessionId, uint8_t sessionType);
+tUWA_STATUS UWA_SendSessionDeInit(uint32_t sessionId);
+tUWA_STATUS UWA_GetSessionCount();
+tUWA_STATUS UWA_GetSessionStatus(uint32_t sessionId);
+tUWA_STATUS UWA_SetAppConfig(uint32_t sessionId, uint8_t noOfParams,
+                             uint8_t appConfigLen, uint8_t *pAppConfig);
+tUWA_STATUS UWA_GetAppConfig(uint32_t sessionId, uint8_t noOfParams,
+                             uint8_t appConfigLen, uint8_t *pAppConfig);
+tUWA_STATUS UWA_StartRangingSession(uint32_t sessionId);
+tUWA_STATUS UWA_StopRangingSession(uint32_t sessionId);
+tUWA_STATUS UWA_ControllerMulticastListUpdate(uint32_t sessionId,
+                                              uint8_t action,
+                                              uint8_t noOfControlees,
+                                              uint16_t *shortAddressList,
+                                              uint32_t *subSessionIdList);
+tUWA_STATUS UWA_SendRawCommand(uint16_t cmdLen, uint8_t *pCmd,
+                               tUWA_RAW_CMD_CBACK *pCback);
+tUWA_STATUS UWA_TestSetConfig(uint32_t sessionId, uint8_t noOfParams,
+                              uint8_t testConfigLen, uint8_t *pTestConfig);
+tUWA_STATUS UWA_TestGetConfig(uint32_t sessionId, uint8_t noOfParams,
+                              uint8_t testConfigLen, uint8_t *pTestConfig);
+tUWA_STATUS UWA_PeriodicTxTest(uint16_t psduLen, uint8_t *pPsdu);
+tUWA_STATUS UWA_PerRxTest(uint16_t psduLen, uint8_t *pRefPsdu);
+tUWA_STATUS UWA_UwbLoopBackTest(uint16_t psduLen, uint8_t *pPsdu);
+tUWA_STATUS UWA_RxTest();
+tUWA_STATUS UWA_TestStopSession();
+
+#endif
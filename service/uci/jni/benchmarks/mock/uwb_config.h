@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Host stand-in for the configuration file reader of the UWB stack. Only
+ *  for the benchmarks: every key is absent, so the defaults apply.
+ */
+
+#ifndef UWB_CONFIG_H
+#define UWB_CONFIG_H
+
+#include <string>
+
+#define NAME_UWB_LOW_POWER_MODE "UWB_LOW_POWER_MODE"
+
+class UwbConfig {
+public:
+  static bool hasKey(const std::string &key);
+  static unsigned getUnsigned(const std::string &key, unsigned defaultValue);
+  static std::string getString(const std::string &key,
+                               const std::string &defaultValue);
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Host stand-in for the HAL interface of the UWB stack. Only for the
+ *  benchmarks.
+ */
+
+#ifndef UWB_HAL_INT_H
+#define UWB_HAL_INT_H
+
+#include <stdint.h>
+
+void *phUwb_GKI_getbuf(uint16_t size);
+void phUwb_GKI_freebuf(void *pBuf);
+
+#endif
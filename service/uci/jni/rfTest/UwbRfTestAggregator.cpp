@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "JniLog.h"
+#include "UwbRfTestAggregator.h"
+
+namespace android {
+
+/* Raw records are small, buffer them so that the log costs one write per
+ * few hundred notifications */
+#define UWB_RF_TEST_LOG_BUFFER_SIZE (64 * 1024)
+
+UwbRfTestAggregator::UwbRfTestAggregator() {
+  mSummaryIntervalUs = 0;
+  mIntervalStartUs = 0;
+  mLog = NULL;
+  mType = UWB_RF_TEST_PERIODIC_TX;
+  mRecords = 0;
+  mFailed = 0;
+  mIntervalRecords = 0;
+  memset(mPerCounters, 0, sizeof(mPerCounters));
+  mSamples = 0;
+}
+
+/*******************************************************************************
+**
+** Function:        start
+**
+** Description:     Reset the totals and start aggregating notifications. A
+**                  log already open is closed first.
+**
+** Params:          summaryIntervalMs: time between two summaries.
+**                  logPath: raw record log, truncated if it exists, or NULL.
+**                  nowUs: current time.
+**
+** Returns:         true if aggregation started.
+**
+*******************************************************************************/
+bool UwbRfTestAggregator::start(uint32_t summaryIntervalMs,
+                                const char *logPath, int64_t nowUs) {
+  stop();
+  if (summaryIntervalMs == 0) {
+    return false;
+  }
+  if (logPath != NULL) {
+    mLog = fopen(logPath, "wb");
+    if (mLog == NULL) {
+      JNI_TRACE_E("%s: cannot open %s", __func__, logPath);
+      return false;
+    }
+    setvbuf(mLog, NULL, _IOFBF, UWB_RF_TEST_LOG_BUFFER_SIZE);
+    tUWB_RF_TEST_LOG_HDR hdr = {};
+    hdr.magic = UWB_RF_TEST_LOG_MAGIC;
+    hdr.version = UWB_RF_TEST_LOG_VERSION;
+    if (fwrite(&hdr, sizeof(hdr), 1, mLog) != 1) {
+      JNI_TRACE_E("%s: cannot write %s", __func__, logPath);
+      fclose(mLog);
+      mLog = NULL;
+      return false;
+    }
+  }
+  mSummaryIntervalUs = (int64_t)summaryIntervalMs * 1000;
+  mIntervalStartUs = nowUs;
+  mType = UWB_RF_TEST_PERIODIC_TX;
+  mRecords = 0;
+  mFailed = 0;
+  mIntervalRecords = 0;
+  memset(mPerCounters, 0, sizeof(mPerCounters));
+  mSamples = 0;
+  return true;
+}
+
+void UwbRfTestAggregator::stop() {
+  mSummaryIntervalUs = 0;
+  if (mLog != NULL) {
+    fclose(mLog);
+    mLog = NULL;
+  }
+}
+
+bool UwbRfTestAggregator::count(uint8_t type, uint8_t status, int64_t nowUs) {
+  mType = type;
+  mRecords++;
+  mIntervalRecords++;
+  if (status != 0) {
+    mFailed++;
+  }
+  return nowUs - mIntervalStartUs >= mSummaryIntervalUs;
+}
+
+bool UwbRfTestAggregator::addPeriodicTx(uint8_t status, int64_t nowUs) {
+  return count(UWB_RF_TEST_PERIODIC_TX, status, nowUs);
+}
+
+bool UwbRfTestAggregator::addPerRx(
+    uint8_t status, const uint32_t counters[UWB_RF_TEST_PER_COUNTERS],
+    int64_t nowUs) {
+  memcpy(mPerCounters, counters, sizeof(mPerCounters));
+  return count(UWB_RF_TEST_PER_RX, status, nowUs);
+}
+
+bool UwbRfTestAggregator::addLoopBack(uint8_t status, uint32_t txtsInt,
+                                      uint32_t rxtsInt, uint16_t azimuth,
+                                      uint16_t elevation, int64_t nowUs) {
+  if (status == 0 && mSamples < UWB_RF_TEST_MAX_INTERVAL_SAMPLES) {
+    mAzimuth[mSamples] = (int16_t)azimuth;
+    mElevation[mSamples] = (int16_t)elevation;
+    /* Unsigned difference so that a timestamp wrap stays small */
+    mMetric[mSamples] = (int32_t)(rxtsInt - txtsInt);
+    mSamples++;
+  }
+  return count(UWB_RF_TEST_LOOPBACK, status, nowUs);
+}
+
+bool UwbRfTestAggregator::addRx(uint8_t status, uint16_t azimuth,
+                                uint16_t elevation, uint8_t toaGap,
+                                int64_t nowUs) {
+  if (status == 0 && mSamples < UWB_RF_TEST_MAX_INTERVAL_SAMPLES) {
+    mAzimuth[mSamples] = (int16_t)azimuth;
+    mElevation[mSamples] = (int16_t)elevation;
+    mMetric[mSamples] = toaGap;
+    mSamples++;
+  }
+  return count(UWB_RF_TEST_RX, status, nowUs);
+}
+
+/*******************************************************************************
+**
+** Function:        log
+**
+** Description:     Append a raw notification to the log, if one is open. A
+**                  failed write closes the log, aggregation goes on.
+**
+** Params:          type: eUWB_RF_TEST_TYPE of the notification.
+**                  data: notification payload.
+**                  len: length of data.
+**                  nowUs: arrival time.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRfTestAggregator::log(uint8_t type, const uint8_t *data, uint16_t len,
+                              int64_t nowUs) {
+  if (mLog == NULL) {
+    return;
+  }
+  tUWB_RF_TEST_LOG_RECORD_HDR hdr = {};
+  hdr.timestampUs = nowUs;
+  hdr.type = type;
+  hdr.len = len;
+  if (fwrite(&hdr, sizeof(hdr), 1, mLog) != 1 ||
+      (len > 0 && fwrite(data, len, 1, mLog) != 1)) {
+    JNI_TRACE_E("%s: cannot write the RF test log", __func__);
+    fclose(mLog);
+    mLog = NULL;
+  }
+}
+
+/* out receives the p50, p90 and p99 of samples, which get reordered */
+void UwbRfTestAggregator::percentiles(int32_t *samples, uint32_t n,
+                                      int64_t *out) {
+  static const uint32_t kPermille[] = {500, 900, 990};
+  for (uint32_t i = 0; i < 3; i++) {
+    if (n == 0) {
+      out[i] = 0;
+      continue;
+    }
+    uint32_t k = (uint32_t)(((uint64_t)(n - 1) * kPermille[i]) / 1000);
+    std::nth_element(samples, samples + k, samples + n);
+    out[i] = samples[k];
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        takeSummary
+**
+** Description:     Fill the summary of the records seen so far and start a
+**                  new interval. The log is flushed so that it is readable
+**                  up to the summary.
+**
+** Params:          final: last summary of this run.
+**                  nowUs: current time.
+**                  summary: receives UWB_RF_TEST_SUMMARY_MAX values.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbRfTestAggregator::takeSummary(
+    bool final, int64_t nowUs, int64_t summary[UWB_RF_TEST_SUMMARY_MAX]) {
+  summary[UWB_RF_TEST_SUMMARY_TYPE] = mType;
+  summary[UWB_RF_TEST_SUMMARY_FINAL] = final ? 1 : 0;
+  summary[UWB_RF_TEST_SUMMARY_RECORDS] = (int64_t)mRecords;
+  summary[UWB_RF_TEST_SUMMARY_FAILED] = (int64_t)mFailed;
+  summary[UWB_RF_TEST_SUMMARY_INTERVAL_RECORDS] = (int64_t)mIntervalRecords;
+  summary[UWB_RF_TEST_SUMMARY_INTERVAL_US] = nowUs - mIntervalStartUs;
+  for (uint32_t i = 0; i < UWB_RF_TEST_PER_COUNTERS; i++) {
+    summary[UWB_RF_TEST_SUMMARY_PER_COUNTERS + i] = mPerCounters[i];
+  }
+  percentiles(mAzimuth, mSamples, &summary[UWB_RF_TEST_SUMMARY_AZIMUTH_P50]);
+  percentiles(mElevation, mSamples,
+              &summary[UWB_RF_TEST_SUMMARY_ELEVATION_P50]);
+  percentiles(mMetric, mSamples, &summary[UWB_RF_TEST_SUMMARY_METRIC_P50]);
+
+  mIntervalStartUs = nowUs;
+  mIntervalRecords = 0;
+  mSamples = 0;
+  if (mLog != NULL) {
+    fflush(mLog);
+  }
+}
+
+} // namespace android
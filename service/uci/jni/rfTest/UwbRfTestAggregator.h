@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UWB_RFTEST_AGGREGATOR_H_
+#define _UWB_RFTEST_AGGREGATOR_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace android {
+
+typedef enum {
+  UWB_RF_TEST_PERIODIC_TX = 0,
+  UWB_RF_TEST_PER_RX,
+  UWB_RF_TEST_LOOPBACK,
+  UWB_RF_TEST_RX,
+  UWB_RF_TEST_TYPE_MAX
+} eUWB_RF_TEST_TYPE;
+
+/* Counters of a PER RX notification, in notification order */
+#define UWB_RF_TEST_PER_COUNTERS 13
+/* Samples per interval used for the percentiles, later ones only count */
+#define UWB_RF_TEST_MAX_INTERVAL_SAMPLES 4096
+/* Status counted for notifications too short to carry their fields */
+#define UWB_RF_TEST_STATUS_MALFORMED 0xFF
+
+/* Raw log: a tUWB_RF_TEST_LOG_HDR followed by one record per notification,
+ * a tUWB_RF_TEST_LOG_RECORD_HDR and len bytes of the notification payload as
+ * received from the UWBS. Integers are stored in host byte order. */
+#define UWB_RF_TEST_LOG_MAGIC 0x54425755 // "UWBT"
+#define UWB_RF_TEST_LOG_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+} tUWB_RF_TEST_LOG_HDR;
+
+typedef struct {
+  int64_t timestampUs;
+  uint8_t type; // eUWB_RF_TEST_TYPE
+  uint8_t reserved;
+  uint16_t len;
+} tUWB_RF_TEST_LOG_RECORD_HDR;
+
+/* Layout of the summary delivered to onRfTestSummaryReceived(). Counts are
+ * since aggregation started unless marked as interval values. PER counters
+ * are the latest ones reported, the UWBS accumulates them over the test.
+ * Percentiles cover the interval, AoA in Q9.7 degrees; METRIC is the ToA gap
+ * in ns for RX tests and rx - tx timestamp in 1/124.8 us for loopback. */
+enum {
+  UWB_RF_TEST_SUMMARY_TYPE = 0, // type of the latest record
+  UWB_RF_TEST_SUMMARY_FINAL,    // 1 for the last summary of a run
+  UWB_RF_TEST_SUMMARY_RECORDS,
+  UWB_RF_TEST_SUMMARY_FAILED, // records whose status is not OK
+  UWB_RF_TEST_SUMMARY_INTERVAL_RECORDS,
+  UWB_RF_TEST_SUMMARY_INTERVAL_US,
+  UWB_RF_TEST_SUMMARY_PER_COUNTERS,
+  UWB_RF_TEST_SUMMARY_AZIMUTH_P50 =
+      UWB_RF_TEST_SUMMARY_PER_COUNTERS + UWB_RF_TEST_PER_COUNTERS,
+  UWB_RF_TEST_SUMMARY_AZIMUTH_P90,
+  UWB_RF_TEST_SUMMARY_AZIMUTH_P99,
+  UWB_RF_TEST_SUMMARY_ELEVATION_P50,
+  UWB_RF_TEST_SUMMARY_ELEVATION_P90,
+  UWB_RF_TEST_SUMMARY_ELEVATION_P99,
+  UWB_RF_TEST_SUMMARY_METRIC_P50,
+  UWB_RF_TEST_SUMMARY_METRIC_P90,
+  UWB_RF_TEST_SUMMARY_METRIC_P99,
+  UWB_RF_TEST_SUMMARY_MAX
+};
+
+/* Accumulates RF test notifications natively so that Java only receives a
+ * summary per interval instead of one object per packet. Optionally streams
+ * every raw notification to a log file. Not thread safe, callers serialize
+ * access. */
+class UwbRfTestAggregator {
+public:
+  UwbRfTestAggregator();
+
+  /* summaryIntervalMs must not be 0, logPath may be NULL */
+  bool start(uint32_t summaryIntervalMs, const char *logPath, int64_t nowUs);
+  void stop();
+  bool isEnabled() const { return mSummaryIntervalUs > 0; }
+
+  /* Each returns true once a summary is due, see takeSummary() */
+  bool addPeriodicTx(uint8_t status, int64_t nowUs);
+  bool addPerRx(uint8_t status,
+                const uint32_t counters[UWB_RF_TEST_PER_COUNTERS],
+                int64_t nowUs);
+  bool addLoopBack(uint8_t status, uint32_t txtsInt, uint32_t rxtsInt,
+                   uint16_t azimuth, uint16_t elevation, int64_t nowUs);
+  bool addRx(uint8_t status, uint16_t azimuth, uint16_t elevation,
+             uint8_t toaGap, int64_t nowUs);
+  /* Notification too short to be parsed, counted as failed */
+  bool addMalformed(uint8_t type, int64_t nowUs) {
+    return count(type, UWB_RF_TEST_STATUS_MALFORMED, nowUs);
+  }
+  void log(uint8_t type, const uint8_t *data, uint16_t len, int64_t nowUs);
+
+  bool hasIntervalRecords() const { return mIntervalRecords > 0; }
+  /* Fill summary and start a new interval */
+  void takeSummary(bool final, int64_t nowUs,
+                   int64_t summary[UWB_RF_TEST_SUMMARY_MAX]);
+
+private:
+  bool count(uint8_t type, uint8_t status, int64_t nowUs);
+  static void percentiles(int32_t *samples, uint32_t n, int64_t *out);
+
+  int64_t mSummaryIntervalUs;
+  int64_t mIntervalStartUs;
+  FILE *mLog;
+
+  uint8_t mType;
+  uint64_t mRecords;
+  uint64_t mFailed;
+  uint64_t mIntervalRecords;
+  uint32_t mPerCounters[UWB_RF_TEST_PER_COUNTERS];
+
+  uint32_t mSamples;
+  int32_t mAzimuth[UWB_RF_TEST_MAX_INTERVAL_SAMPLES];
+  int32_t mElevation[UWB_RF_TEST_MAX_INTERVAL_SAMPLES];
+  int32_t mMetric[UWB_RF_TEST_MAX_INTERVAL_SAMPLES];
+};
+
+} // namespace android
+#endif
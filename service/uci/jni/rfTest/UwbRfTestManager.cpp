@@ -18,10 +18,14 @@
 
 #include "UwbJniInternal.h"
 #include "UwbRfTestManager.h"
+#include "UwbChipContext.h"
 #include "JniLog.h"
 #include "ScopedJniEnv.h"
 #include "SyncEvent.h"
 #include "UwbAdaptation.h"
+#include "UwbBufferPool.h"
+#include "UwbJniStats.h"
+#include "UwbUciRecorder.h"
 #include "uwb_config.h"
 #include "uwb_hal_int.h"
 
@@ -35,49 +39,193 @@ const char *UWB_LOOPBACK_DATA_CLASS_NAME =
     "com/android/uwb/test/UwbTestLoopBackTestResult";
 const char *RX_DATA_CLASS_NAME = "com/android/uwb/test/UwbTestRxResult";
 
-static SyncEvent sUwaRfTestEvent;
-static SyncEvent sUwaSetTestConfigEvent;
-static SyncEvent sUwaGetTestConfigEvent;
-static uint8_t sSetTestConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sGetTestConfig[UCI_MAX_PAYLOAD_SIZE];
-static uint8_t sNoOfTestConfigIds = 0x00;
-static uint16_t sGetTestConfigLen;
-static uint16_t sSetTestConfigLen;
-static uint8_t sGetTestConfigStatus;
-static uint8_t sSetTestConfigStatus;
-
-/* command response status */
-static bool setTestConfigRespStatus = false;
-static bool getTestConfigRespStatus = false;
-static bool rfTestStatus = false;
-bool IsRfTestOngoing = false; // to track the RF test status whether test is
-                              // sussesffuly completed or not
-
-static UwbRfTestManager &uwbRfTestManager = UwbRfTestManager::getInstance();
-
-void clearRfTestContext() { IsRfTestOngoing = false; }
-
-UwbRfTestManager UwbRfTestManager::mObjTestManager;
-
-UwbRfTestManager &UwbRfTestManager::getInstance() { return mObjTestManager; }
-
-UwbRfTestManager::UwbRfTestManager() {
+/* Fixed part of the test notifications, up to the fields aggregated */
+#define UWB_PER_RX_NTF_LEN (1 + 4 * UWB_RF_TEST_PER_COUNTERS)
+#define UWB_LOOPBACK_NTF_MIN_LEN 17
+#define UWB_RX_NTF_MIN_LEN 12
+
+UwbRfTestManager::UwbRfTestManager(UwbChipContext &chip) : mChip(chip) {
+  mSetTestConfigDest = NULL;
+  mSetTestConfigCapacity = 0;
+  mGetTestConfigDest = NULL;
+  mGetTestConfigCapacity = 0;
+  mNoOfTestConfigIds = 0x00;
+  mGetTestConfigLen = 0;
+  mSetTestConfigLen = 0;
+  mGetTestConfigStatus = 0;
+  mSetTestConfigStatus = 0;
+  mSetTestConfigRespStatus = false;
+  mGetTestConfigRespStatus = false;
+  mRfTestStatus = false;
+  mIsRfTestOngoing = false;
   mVm = NULL;
   mClass = NULL;
   mObject = NULL;
-  ;
-  mPeriodicTxDataClass = NULL;
-  mPerRxDataClass = NULL;
-  mUwbLoopBackDataClass = NULL;
-  mRxDataClass = NULL;
   mOnPeriodicTxDataNotificationReceived = NULL;
   mOnPerRxDataNotificationReceived = NULL;
   mOnLoopBackTestDataNotificationReceived = NULL;
   mOnRxTestDataNotificationReceived = NULL;
+  mSummaryVm = NULL;
+  mSummaryObject = NULL;
+  mOnRfTestSummaryReceived = NULL;
+}
+
+/*******************************************************************************
+**
+** Function:        aggregate
+**
+** Description:     Account a test notification in the aggregator and send a
+**                  summary when one is due.
+**
+** Params:          type: eUWB_RF_TEST_TYPE of the notification.
+**                  len: length of data.
+**                  data: notification payload.
+**
+** Returns:         true if the notification was aggregated and must not be
+**                  delivered on its own.
+**
+*******************************************************************************/
+bool UwbRfTestManager::aggregate(uint8_t type, uint16_t len, uint8_t *data) {
+  std::lock_guard<std::mutex> lock(mAggregatorMutex);
+  if (!mAggregator.isEnabled()) {
+    return false;
+  }
+  int64_t nowUs = UwbJniStats::nowUs();
+  mAggregator.log(type, data, len, nowUs);
+
+  uint8_t status, toaGap;
+  uint16_t txtsFrac, rxtsFrac, azimuth, elevation;
+  uint32_t txtsInt, rxtsInt;
+  uint32_t counters[UWB_RF_TEST_PER_COUNTERS];
+  bool due;
+  STREAM_TO_UINT8(status, data);
+  switch (type) {
+  case UWB_RF_TEST_PERIODIC_TX:
+    due = mAggregator.addPeriodicTx(status, nowUs);
+    break;
+  case UWB_RF_TEST_PER_RX:
+    if (len < UWB_PER_RX_NTF_LEN) {
+      due = mAggregator.addMalformed(type, nowUs);
+      break;
+    }
+    for (int i = 0; i < UWB_RF_TEST_PER_COUNTERS; i++) {
+      STREAM_TO_UINT32(counters[i], data);
+    }
+    due = mAggregator.addPerRx(status, counters, nowUs);
+    break;
+  case UWB_RF_TEST_LOOPBACK:
+    if (len < UWB_LOOPBACK_NTF_MIN_LEN) {
+      due = mAggregator.addMalformed(type, nowUs);
+      break;
+    }
+    STREAM_TO_UINT32(txtsInt, data);
+    STREAM_TO_UINT16(txtsFrac, data);
+    STREAM_TO_UINT32(rxtsInt, data);
+    STREAM_TO_UINT16(rxtsFrac, data);
+    STREAM_TO_UINT16(azimuth, data);
+    STREAM_TO_UINT16(elevation, data);
+    (void)txtsFrac;
+    (void)rxtsFrac;
+    due = mAggregator.addLoopBack(status, txtsInt, rxtsInt, azimuth, elevation,
+                                  nowUs);
+    break;
+  default:
+    if (len < UWB_RX_NTF_MIN_LEN) {
+      due = mAggregator.addMalformed(type, nowUs);
+      break;
+    }
+    STREAM_TO_UINT32(rxtsInt, data);
+    STREAM_TO_UINT16(rxtsFrac, data);
+    STREAM_TO_UINT16(azimuth, data);
+    STREAM_TO_UINT16(elevation, data);
+    STREAM_TO_UINT8(toaGap, data);
+    (void)rxtsFrac;
+    due = mAggregator.addRx(status, azimuth, elevation, toaGap, nowUs);
+    break;
+  }
+  if (due) {
+    sendSummaryLocked(false);
+  }
+  return true;
+}
+
+void UwbRfTestManager::sendSummaryLocked(bool final) {
+  int64_t summary[UWB_RF_TEST_SUMMARY_MAX];
+  mAggregator.takeSummary(final, UwbJniStats::nowUs(), summary);
+  if (mOnRfTestSummaryReceived == NULL) {
+    return;
+  }
+  ScopedJniEnv env(mSummaryVm);
+  if (env == NULL) {
+    JNI_TRACE_E("%s: jni env is null", __func__);
+    return;
+  }
+  jlongArray summaryArray = env->NewLongArray(UWB_RF_TEST_SUMMARY_MAX);
+  if (summaryArray == NULL) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to allocate the summary", __func__);
+    return;
+  }
+  env->SetLongArrayRegion(summaryArray, 0, UWB_RF_TEST_SUMMARY_MAX,
+                          (jlong *)summary);
+  env->CallVoidMethod(mSummaryObject, mOnRfTestSummaryReceived, summaryArray);
+  if (env->ExceptionCheck()) {
+    env->ExceptionClear();
+    JNI_TRACE_E("%s: fail to send RF test summary", __func__);
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        setAggregation
+**
+** Description:     Aggregate the RF test notifications natively instead of
+**                  delivering one Java object per notification. Summaries go
+**                  to onRfTestSummaryReceived(long[]) of o, see
+**                  UWB_RF_TEST_SUMMARY_*. Changing the settings sends the
+**                  final summary of the previous run.
+**
+** Params:          env: JVM environment.
+**                  o: Java object receiving the summaries.
+**                  summaryIntervalMs: time between two summaries, 0 stops
+**                  aggregating.
+**                  logPath: file receiving every raw notification, or NULL.
+**
+** Returns:         true if the settings were applied.
+**
+*******************************************************************************/
+bool UwbRfTestManager::setAggregation(JNIEnv *env, jobject o,
+                                      uint32_t summaryIntervalMs,
+                                      const char *logPath) {
+  std::lock_guard<std::mutex> lock(mAggregatorMutex);
+  if (mSummaryObject == NULL) {
+    env->GetJavaVM(&mSummaryVm);
+    mSummaryObject = env->NewGlobalRef(o);
+    jclass clazz = env->GetObjectClass(o);
+    // Optional, without it the summaries only end up in the log.
+    mOnRfTestSummaryReceived =
+        env->GetMethodID(clazz, "onRfTestSummaryReceived", "([J)V");
+    if (mOnRfTestSummaryReceived == NULL) {
+      env->ExceptionClear();
+      JNI_TRACE_I("%s: no RF test summary callback", __func__);
+    }
+    env->DeleteLocalRef(clazz);
+  }
+  if (mAggregator.isEnabled()) {
+    sendSummaryLocked(true);
+    mAggregator.stop();
+  }
+  if (summaryIntervalMs == 0) {
+    return true;
+  }
+  return mAggregator.start(summaryIntervalMs, logPath, UwbJniStats::nowUs());
 }
 
 void UwbRfTestManager::onPeriodicTxDataNotificationReceived(uint16_t len,
                                                             uint8_t *data) {
+  if (len != 0 && aggregate(UWB_RF_TEST_PERIODIC_TX, len, data)) {
+    return;
+  }
   ScopedJniEnv env(mVm);
   if (env == NULL) {
     JNI_TRACE_E("%s: jni env is null", __func__);
@@ -89,10 +237,9 @@ void UwbRfTestManager::onPeriodicTxDataNotificationReceived(uint16_t len,
   if (len != 0) {
     STREAM_TO_UINT8(sPeriodic_tx_data.status, data);
 
-    jmethodID periodicTxCtor =
-        env->GetMethodID(mPeriodicTxDataClass, "<init>", "(I)V");
     jobject periodicTxObject = env->NewObject(
-        mPeriodicTxDataClass, periodicTxCtor, (int)sPeriodic_tx_data.status);
+        gUwbJniSymbols.periodicTxDataClass, gUwbJniSymbols.periodicTxDataCtor,
+        (int)sPeriodic_tx_data.status);
 
     if (mOnPeriodicTxDataNotificationReceived != NULL) {
       env->CallVoidMethod(mObject, mOnPeriodicTxDataNotificationReceived,
@@ -109,6 +256,9 @@ void UwbRfTestManager::onPeriodicTxDataNotificationReceived(uint16_t len,
 
 void UwbRfTestManager::onPerRxDataNotificationReceived(uint16_t len,
                                                        uint8_t *data) {
+  if (len != 0 && aggregate(UWB_RF_TEST_PER_RX, len, data)) {
+    return;
+  }
   ScopedJniEnv env(mVm);
   if (env == NULL) {
     JNI_TRACE_E("%s: jni env is null", __func__);
@@ -134,10 +284,9 @@ void UwbRfTestManager::onPerRxDataNotificationReceived(uint16_t len,
     STREAM_TO_UINT32(sPer_rx_data.sts_found, data);
     STREAM_TO_UINT32(sPer_rx_data.eof, data);
 
-    jmethodID perRxCtor =
-        env->GetMethodID(mPerRxDataClass, "<init>", "(IJJJJJJJJJJJJJ)V");
     jobject perRxObject = env->NewObject(
-        mPerRxDataClass, perRxCtor, (int)sPer_rx_data.status,
+        gUwbJniSymbols.perRxDataClass, gUwbJniSymbols.perRxDataCtor,
+        (int)sPer_rx_data.status,
         (long)sPer_rx_data.attempts, (long)sPer_rx_data.ACQ_detect,
         (long)sPer_rx_data.ACQ_rejects, (long)sPer_rx_data.RX_fail,
         (long)sPer_rx_data.sync_cir_ready, (long)sPer_rx_data.sfd_fail,
@@ -160,6 +309,9 @@ void UwbRfTestManager::onPerRxDataNotificationReceived(uint16_t len,
 
 void UwbRfTestManager::onLoopBackTestDataNotificationReceived(uint16_t len,
                                                               uint8_t *data) {
+  if (len != 0 && aggregate(UWB_RF_TEST_LOOPBACK, len, data)) {
+    return;
+  }
   ScopedJniEnv env(mVm);
   if (env == NULL) {
     JNI_TRACE_E("%s: jni env is null", __func__);
@@ -189,10 +341,9 @@ void UwbRfTestManager::onLoopBackTestDataNotificationReceived(uint16_t len,
                               (jbyte *)sUwb_loopback_data.psdu_data);
     }
 
-    jmethodID uwbLoopBackCtor =
-        env->GetMethodID(mUwbLoopBackDataClass, "<init>", "(IJIJIIII[B)V");
     jobject uwbLoopBackObject = env->NewObject(
-        mUwbLoopBackDataClass, uwbLoopBackCtor, (int)sUwb_loopback_data.status,
+        gUwbJniSymbols.uwbLoopBackDataClass, gUwbJniSymbols.uwbLoopBackDataCtor,
+        (int)sUwb_loopback_data.status,
         (long)sUwb_loopback_data.txts_int, (int)sUwb_loopback_data.txts_frac,
         (long)sUwb_loopback_data.rxts_int, (int)sUwb_loopback_data.rxts_frac,
         (int)sUwb_loopback_data.aoa_azimuth,
@@ -213,6 +364,9 @@ void UwbRfTestManager::onLoopBackTestDataNotificationReceived(uint16_t len,
 
 void UwbRfTestManager::onRxTestDataNotificationReceived(uint16_t len,
                                                         uint8_t *data) {
+  if (len != 0 && aggregate(UWB_RF_TEST_RX, len, data)) {
+    return;
+  }
   ScopedJniEnv env(mVm);
   if (env == NULL) {
     JNI_TRACE_E("%s: jni env is null", __func__);
@@ -243,10 +397,9 @@ void UwbRfTestManager::onRxTestDataNotificationReceived(uint16_t len,
                               (jbyte *)sRx_data.psdu_data);
     }
 
-    jmethodID rxDataCtor =
-        env->GetMethodID(mRxDataClass, "<init>", "(IJIIIII[B)V");
     jobject rxDataObject = env->NewObject(
-        mRxDataClass, rxDataCtor, (int)sRx_data.status,
+        gUwbJniSymbols.rxDataClass, gUwbJniSymbols.rxDataCtor,
+        (int)sRx_data.status,
         (long)sRx_data.rx_done_ts_int, (int)sRx_data.rx_done_ts_frac,
         (int)aoaFirst, (int)aoaSecond, (int)sRx_data.toa_gap, (int)sRx_data.phr,
         psduData);
@@ -285,12 +438,17 @@ void UwbRfTestManager::doLoadSymbols(JNIEnv *env, jobject thiz) {
         env->GetMethodID(clazz, "onRxTestDataNotificationReceived",
                          "(Lcom/android/uwb/test/UwbTestRxResult;)V");
 
-    uwb_jni_cache_jclass(env, PERIODIC_TX_DATA_CLASS_NAME,
-                         &mPeriodicTxDataClass);
-    uwb_jni_cache_jclass(env, PER_RX_DATA_CLASS_NAME, &mPerRxDataClass);
-    uwb_jni_cache_jclass(env, UWB_LOOPBACK_DATA_CLASS_NAME,
-                         &mUwbLoopBackDataClass);
-    uwb_jni_cache_jclass(env, RX_DATA_CLASS_NAME, &mRxDataClass);
+    uwb_jni_cache_ctor(env, PERIODIC_TX_DATA_CLASS_NAME, "(I)V",
+                       &gUwbJniSymbols.periodicTxDataClass,
+                       &gUwbJniSymbols.periodicTxDataCtor);
+    uwb_jni_cache_ctor(env, PER_RX_DATA_CLASS_NAME, "(IJJJJJJJJJJJJJ)V",
+                       &gUwbJniSymbols.perRxDataClass,
+                       &gUwbJniSymbols.perRxDataCtor);
+    uwb_jni_cache_ctor(env, UWB_LOOPBACK_DATA_CLASS_NAME, "(IJIJIIII[B)V",
+                       &gUwbJniSymbols.uwbLoopBackDataClass,
+                       &gUwbJniSymbols.uwbLoopBackDataCtor);
+    uwb_jni_cache_ctor(env, RX_DATA_CLASS_NAME, "(IJIIIII[B)V",
+                       &gUwbJniSymbols.rxDataClass, &gUwbJniSymbols.rxDataCtor);
   }
   JNI_TRACE_I("%s: exit", __func__);
 }
@@ -322,39 +480,47 @@ jbyteArray UwbRfTestManager::setTestConfigurations(JNIEnv *env, jobject o,
                                                    jbyteArray TestConfig) {
   tUWA_STATUS status;
   jbyteArray testConfigArray = NULL;
-  uint8_t *testConfigData = NULL;
   JNI_TRACE_I("%s: Enter", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return testConfigArray;
   }
+  if (testConfigLen < 0 || testConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: invalid test config length %d", __func__, testConfigLen);
+    return testConfigArray;
+  }
 
-  testConfigData = (uint8_t *)malloc(sizeof(uint8_t) * testConfigLen);
-  if (testConfigData != NULL) {
-    memset(testConfigData, 0, (sizeof(uint8_t) * testConfigLen));
+  // The block carries the command, then receives the response.
+  UwbBufferLease testConfigData =
+      UwbBufferPool::getPacketPool().lease(UCI_MAX_PAYLOAD_SIZE);
+  if (testConfigData.isValid()) {
     env->GetByteArrayRegion(TestConfig, 0, testConfigLen,
-                            (jbyte *)testConfigData);
-    setTestConfigRespStatus = false;
-    SyncEventGuard guard(sUwaSetTestConfigEvent);
+                            (jbyte *)testConfigData.data());
+    mSetTestConfigRespStatus = false;
+    SyncEventGuard guard(mSetTestConfigEvent);
     JNI_TRACE_I("%d: testConfigLen", testConfigLen);
-    status =
-        UWA_TestSetConfig(sessionId, noOfParams, testConfigLen, testConfigData);
-    free(testConfigData);
+    status = mChip.getStack().testSetConfig(sessionId, noOfParams,
+                                            testConfigLen,
+                                            testConfigData.data());
     if (status == UWA_STATUS_OK) {
-      sUwaSetTestConfigEvent.wait(UWB_CMD_TIMEOUT);
+      mSetTestConfigDest = testConfigData.data();
+      mSetTestConfigCapacity = testConfigData.size();
+      mSetTestConfigEvent.wait(UWB_CMD_TIMEOUT);
+      mSetTestConfigDest = NULL;
+      mSetTestConfigCapacity = 0;
       JNI_TRACE_E("%s: Success UWA_TestSetConfig Command", __func__);
-      if (setTestConfigRespStatus) {
+      if (mSetTestConfigRespStatus) {
         testConfigArray =
-            env->NewByteArray(sSetTestConfigLen + sizeof(sSetTestConfigStatus) +
-                              sizeof(sNoOfTestConfigIds));
+            env->NewByteArray(mSetTestConfigLen + sizeof(mSetTestConfigStatus) +
+                              sizeof(mNoOfTestConfigIds));
         env->SetByteArrayRegion(testConfigArray, 0, 1,
-                                (jbyte *)&sSetTestConfigStatus);
+                                (jbyte *)&mSetTestConfigStatus);
         env->SetByteArrayRegion(testConfigArray, 1, 1,
-                                (jbyte *)&sNoOfTestConfigIds);
-        if (sSetTestConfigLen > 0) {
-          env->SetByteArrayRegion(testConfigArray, 2, sSetTestConfigLen,
-                                  (jbyte *)&sSetTestConfig[0]);
+                                (jbyte *)&mNoOfTestConfigIds);
+        if (mSetTestConfigLen > 0) {
+          env->SetByteArrayRegion(testConfigArray, 2, mSetTestConfigLen,
+                                  (jbyte *)testConfigData.data());
         }
       }
     } else {
@@ -362,7 +528,7 @@ jbyteArray UwbRfTestManager::setTestConfigurations(JNIEnv *env, jobject o,
       return testConfigArray;
     }
   } else {
-    JNI_TRACE_E("%s: Unable to Allocate Memory", __func__);
+    JNI_TRACE_E("%s: no buffer for the test config", __func__);
   }
   JNI_TRACE_I("%s: Exit", __func__);
   return testConfigArray;
@@ -391,42 +557,50 @@ jbyteArray UwbRfTestManager::getTestConfigurations(JNIEnv *env, jobject o,
                                                    jbyteArray TestConfig) {
   tUWA_STATUS status;
   jbyteArray testConfigArray = NULL;
-  uint8_t *testConfigData = NULL;
   JNI_TRACE_I("%s: Enter", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return testConfigArray;
   }
+  if (testConfigLen < 0 || testConfigLen > UCI_MAX_PAYLOAD_SIZE) {
+    JNI_TRACE_E("%s: invalid test config length %d", __func__, testConfigLen);
+    return testConfigArray;
+  }
 
-  getTestConfigRespStatus = false;
-  testConfigData = (uint8_t *)malloc(sizeof(uint8_t) * testConfigLen);
-  if (testConfigData != NULL) {
-    memset(testConfigData, 0, (sizeof(uint8_t) * testConfigLen));
+  mGetTestConfigRespStatus = false;
+  // The block carries the command, then receives the response.
+  UwbBufferLease testConfigData =
+      UwbBufferPool::getPacketPool().lease(UCI_MAX_PAYLOAD_SIZE);
+  if (testConfigData.isValid()) {
     env->GetByteArrayRegion(TestConfig, 0, testConfigLen,
-                            (jbyte *)testConfigData);
-    SyncEventGuard guard(sUwaGetTestConfigEvent);
-    status =
-        UWA_TestGetConfig(sessionId, noOfParams, testConfigLen, testConfigData);
+                            (jbyte *)testConfigData.data());
+    SyncEventGuard guard(mGetTestConfigEvent);
+    status = mChip.getStack().testGetConfig(sessionId, noOfParams,
+                                            testConfigLen,
+                                            testConfigData.data());
     if (status == UWA_STATUS_OK) {
-      sUwaGetTestConfigEvent.wait(UWB_CMD_TIMEOUT);
-      if (getTestConfigRespStatus) {
+      mGetTestConfigDest = testConfigData.data();
+      mGetTestConfigCapacity = testConfigData.size();
+      mGetTestConfigEvent.wait(UWB_CMD_TIMEOUT);
+      mGetTestConfigDest = NULL;
+      mGetTestConfigCapacity = 0;
+      if (mGetTestConfigRespStatus) {
         testConfigArray =
-            env->NewByteArray(sGetTestConfigLen + sizeof(sNoOfTestConfigIds) +
-                              sizeof(sGetTestConfigStatus));
+            env->NewByteArray(mGetTestConfigLen + sizeof(mNoOfTestConfigIds) +
+                              sizeof(mGetTestConfigStatus));
         env->SetByteArrayRegion(testConfigArray, 0, 1,
-                                (jbyte *)&sGetTestConfigStatus);
+                                (jbyte *)&mGetTestConfigStatus);
         env->SetByteArrayRegion(testConfigArray, 1, 1,
-                                (jbyte *)&sNoOfTestConfigIds);
-        env->SetByteArrayRegion(testConfigArray, 2, sGetTestConfigLen,
-                                (jbyte *)&sGetTestConfig[0]);
+                                (jbyte *)&mNoOfTestConfigIds);
+        env->SetByteArrayRegion(testConfigArray, 2, mGetTestConfigLen,
+                                (jbyte *)testConfigData.data());
       }
     } else {
       JNI_TRACE_E("%s: Failed UWA_TestGetConfig", __func__);
     }
-    free(testConfigData);
   } else {
-    JNI_TRACE_E("%s: Unable to Allocate Memory", __func__);
+    JNI_TRACE_E("%s: no buffer for the test config", __func__);
   }
   JNI_TRACE_I("%s: Exit", __func__);
   return testConfigArray;
@@ -449,51 +623,49 @@ jbyte UwbRfTestManager::startPerRxTest(JNIEnv *env, jobject o,
                                        jbyteArray refPsduData) {
   tUWA_STATUS status = UWA_STATUS_FAILED;
   uint16_t dataLen = 0;
-  uint8_t *ref_psdu_data = NULL;
   JNI_TRACE_I("%s: Enter; ", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return status;
   }
 
-  if (IsRfTestOngoing) {
+  if (mIsRfTestOngoing) {
     JNI_TRACE_E("%s: UWB device Rf Test is Ongoing already", __func__);
     return status;
   }
 
-  rfTestStatus = false;
+  mRfTestStatus = false;
   if (refPsduData != NULL) {
     dataLen = env->GetArrayLength(refPsduData);
     if (dataLen > 0) {
-      ref_psdu_data = (uint8_t *)malloc(sizeof(uint8_t) * dataLen);
-      if (ref_psdu_data != NULL) {
-        memset(ref_psdu_data, 0, (sizeof(uint8_t) * dataLen));
+      UwbBufferLease ref_psdu_data =
+          UwbBufferPool::getPsduPool().lease(dataLen);
+      if (ref_psdu_data.isValid()) {
         env->GetByteArrayRegion(refPsduData, 0, dataLen,
-                                (jbyte *)ref_psdu_data);
+                                (jbyte *)ref_psdu_data.data());
 
-        SyncEventGuard guard(sUwaRfTestEvent);
-        IsRfTestOngoing = true;
-        status = UWA_PerRxTest(dataLen, ref_psdu_data);
+        SyncEventGuard guard(mRfTestEvent);
+        mIsRfTestOngoing = true;
+        status = mChip.getStack().perRxTest(dataLen, ref_psdu_data.data());
         if (UWA_STATUS_OK == status) {
-          sUwaRfTestEvent.wait(UWB_CMD_TIMEOUT);
-          if (!rfTestStatus) {
-            IsRfTestOngoing = false;
+          mRfTestEvent.wait(UWB_CMD_TIMEOUT);
+          if (!mRfTestStatus) {
+            mIsRfTestOngoing = false;
           }
         } else {
-          IsRfTestOngoing = false;
+          mIsRfTestOngoing = false;
           JNI_TRACE_E("%s: UWA_PerRxTest Failed", __func__);
         }
-        free(ref_psdu_data);
       } else {
-        JNI_TRACE_E("%s: Unable to Allocate Memory", __func__);
+        JNI_TRACE_E("%s: no buffer for %d bytes of PSDU", __func__, dataLen);
       }
     } else {
       JNI_TRACE_I("%s: Length of refPsduData array is 0; ", __func__);
     }
   }
   JNI_TRACE_I("%s: Exit", __func__);
-  return (rfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (mRfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -514,20 +686,19 @@ jbyte UwbRfTestManager::startPeriodicTxTest(JNIEnv *env, jobject o,
                                             jbyteArray psduData) {
   tUWA_STATUS status = UWA_STATUS_FAILED;
   uint16_t dataLen = 0;
-  uint8_t *psdu_Data = NULL;
   JNI_TRACE_I("%s: Enter; ", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return status;
   }
 
-  if (IsRfTestOngoing) {
+  if (mIsRfTestOngoing) {
     JNI_TRACE_E("%s: UWB device Rf Test is Ongoing already", __func__);
     return status;
   }
 
-  rfTestStatus = false;
+  mRfTestStatus = false;
   if (psduData != NULL) {
     dataLen = env->GetArrayLength(psduData);
     if (dataLen > UCI_MAX_PAYLOAD_SIZE) {
@@ -535,31 +706,30 @@ jbyte UwbRfTestManager::startPeriodicTxTest(JNIEnv *env, jobject o,
                   UCI_MAX_PAYLOAD_SIZE);
       return status;
     }
-    psdu_Data = (uint8_t *)malloc(sizeof(uint8_t) * dataLen);
-    if (psdu_Data != NULL) {
-      memset(psdu_Data, 0, (sizeof(uint8_t) * dataLen));
-      env->GetByteArrayRegion(psduData, 0, dataLen, (jbyte *)psdu_Data);
-
-      SyncEventGuard guard(sUwaRfTestEvent);
-      IsRfTestOngoing = true;
-      status = UWA_PeriodicTxTest(dataLen, psdu_Data);
+    UwbBufferLease psdu_Data = UwbBufferPool::getPacketPool().lease(dataLen);
+    if (psdu_Data.isValid()) {
+      env->GetByteArrayRegion(psduData, 0, dataLen,
+                              (jbyte *)psdu_Data.data());
+
+      SyncEventGuard guard(mRfTestEvent);
+      mIsRfTestOngoing = true;
+      status = mChip.getStack().periodicTxTest(dataLen, psdu_Data.data());
       if (UWA_STATUS_OK == status) {
-        sUwaRfTestEvent.wait(UWB_CMD_TIMEOUT);
-        if (!rfTestStatus) {
-          IsRfTestOngoing = false;
+        mRfTestEvent.wait(UWB_CMD_TIMEOUT);
+        if (!mRfTestStatus) {
+          mIsRfTestOngoing = false;
         }
       } else {
-        IsRfTestOngoing = false;
+        mIsRfTestOngoing = false;
         JNI_TRACE_E("%s: UWA_PeriodicTxTest Failed", __func__);
       }
-      free(psdu_Data);
     } else {
-      JNI_TRACE_E("%s: Unable to Allocate Memory", __func__);
+      JNI_TRACE_E("%s: no buffer for %d bytes of PSDU", __func__, dataLen);
     }
   }
 
   JNI_TRACE_I("%s: Exit", __func__);
-  return (rfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (mRfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -580,20 +750,19 @@ jbyte UwbRfTestManager::startUwbLoopBackTest(JNIEnv *env, jobject o,
                                              jbyteArray psduData) {
   tUWA_STATUS status = UWA_STATUS_FAILED;
   uint16_t dataLen = 0;
-  uint8_t *psdu_Data = NULL;
   JNI_TRACE_I("%s: Enter; ", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return status;
   }
 
-  if (IsRfTestOngoing) {
+  if (mIsRfTestOngoing) {
     JNI_TRACE_I("%s: UWB device Rf Test is Ongoing already", __func__);
     return status;
   }
 
-  rfTestStatus = false;
+  mRfTestStatus = false;
   if (psduData != NULL) {
     dataLen = env->GetArrayLength(psduData);
     if (dataLen > UCI_MAX_PAYLOAD_SIZE) {
@@ -601,31 +770,30 @@ jbyte UwbRfTestManager::startUwbLoopBackTest(JNIEnv *env, jobject o,
                   UCI_MAX_PAYLOAD_SIZE);
       return UWA_STATUS_FAILED;
     }
-    psdu_Data = (uint8_t *)malloc(sizeof(uint8_t) * dataLen);
-    if (psdu_Data != NULL) {
-      memset(psdu_Data, 0, (sizeof(uint8_t) * dataLen));
-      env->GetByteArrayRegion(psduData, 0, dataLen, (jbyte *)psdu_Data);
-
-      SyncEventGuard guard(sUwaRfTestEvent);
-      IsRfTestOngoing = true;
-      status = UWA_UwbLoopBackTest(dataLen, psdu_Data);
+    UwbBufferLease psdu_Data = UwbBufferPool::getPacketPool().lease(dataLen);
+    if (psdu_Data.isValid()) {
+      env->GetByteArrayRegion(psduData, 0, dataLen,
+                              (jbyte *)psdu_Data.data());
+
+      SyncEventGuard guard(mRfTestEvent);
+      mIsRfTestOngoing = true;
+      status = mChip.getStack().loopBackTest(dataLen, psdu_Data.data());
       if (UWA_STATUS_OK == status) {
-        sUwaRfTestEvent.wait(UWB_CMD_TIMEOUT);
-        if (!rfTestStatus) {
-          IsRfTestOngoing = false;
+        mRfTestEvent.wait(UWB_CMD_TIMEOUT);
+        if (!mRfTestStatus) {
+          mIsRfTestOngoing = false;
         }
       } else {
-        IsRfTestOngoing = false;
+        mIsRfTestOngoing = false;
         JNI_TRACE_E("%s: UWA_UwbLoopBackTest failed", __func__);
       }
-      free(psdu_Data);
     } else {
-      JNI_TRACE_E("%s: Unable to Allocate Memory", __func__);
+      JNI_TRACE_E("%s: no buffer for %d bytes of PSDU", __func__, dataLen);
     }
   }
 
   JNI_TRACE_I("%s: Exit", __func__);
-  return (rfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (mRfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -645,32 +813,32 @@ jbyte UwbRfTestManager::startRxTest(JNIEnv *env, jobject o) {
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: Enter; ", __func__);
 
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return status;
   }
 
-  if (IsRfTestOngoing) {
+  if (mIsRfTestOngoing) {
     JNI_TRACE_I("%s: UWB device Rf Test is Ongoing already", __func__);
     return status;
   }
 
-  rfTestStatus = false;
-  SyncEventGuard guard(sUwaRfTestEvent);
-  IsRfTestOngoing = true;
-  status = UWA_RxTest();
+  mRfTestStatus = false;
+  SyncEventGuard guard(mRfTestEvent);
+  mIsRfTestOngoing = true;
+  status = mChip.getStack().rxTest();
   if (UWA_STATUS_OK == status) {
-    sUwaRfTestEvent.wait(UWB_CMD_TIMEOUT);
-    if (!rfTestStatus) {
-      IsRfTestOngoing = false;
+    mRfTestEvent.wait(UWB_CMD_TIMEOUT);
+    if (!mRfTestStatus) {
+      mIsRfTestOngoing = false;
     }
   } else {
-    IsRfTestOngoing = false;
+    mIsRfTestOngoing = false;
     JNI_TRACE_E("%s: UWA_RxTest failed", __func__);
   }
 
   JNI_TRACE_I("%s: Exit", __func__);
-  return (rfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (mRfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
@@ -688,151 +856,165 @@ jbyte UwbRfTestManager::startRxTest(JNIEnv *env, jobject o) {
 jbyte UwbRfTestManager::stopRfTest(JNIEnv *env, jobject o) {
   tUWA_STATUS status = UWA_STATUS_FAILED;
   JNI_TRACE_I("%s: Enter; ", __func__);
-  if (!gIsUwaEnabled) {
+  if (!mChip.getState().isUwaEnabled) {
     JNI_TRACE_E("%s: UWB device is not initialized", __func__);
     return status;
   }
 
-  rfTestStatus = false;
-  SyncEventGuard guard(sUwaRfTestEvent);
-  status = UWA_TestStopSession();
+  mRfTestStatus = false;
+  SyncEventGuard guard(mRfTestEvent);
+  status = mChip.getStack().testStopSession();
   if (UWA_STATUS_OK == status) {
-    sUwaRfTestEvent.wait(UWB_CMD_TIMEOUT);
+    mRfTestEvent.wait(UWB_CMD_TIMEOUT);
   } else {
     JNI_TRACE_E("%s: UWA_TestStopSession failed", __func__);
   }
 
-  if (rfTestStatus) {
-    IsRfTestOngoing = false;
+  if (mRfTestStatus) {
+    mIsRfTestOngoing = false;
+    std::lock_guard<std::mutex> lock(mAggregatorMutex);
+    if (mAggregator.isEnabled() && mAggregator.hasIntervalRecords()) {
+      sendSummaryLocked(true);
+    }
   }
   JNI_TRACE_I("%s: Exit", __func__);
-  return (rfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
+  return (mRfTestStatus) ? UWA_STATUS_OK : UWA_STATUS_FAILED;
 }
 
 /*******************************************************************************
 **
-** Function:        uwaRfTestDeviceManagementCallback
+** Function:        onDeviceManagementEvent
 **
-** Description:     Receive Rf Test related device management events from UCI
-*stack
+** Description:     Receive Rf Test related device management events from the
+**                  UCI stack of the chip
 **                  dmEvent: Device-management event ID.
 **                  eventData: Data associated with event ID.
 **
 ** Returns:         None
 **
 *******************************************************************************/
-void uwaRfTestDeviceManagementCallback(uint8_t dmEvent,
-                                       tUWA_DM_TEST_CBACK_DATA *eventData) {
+void UwbRfTestManager::onDeviceManagementEvent(
+    uint8_t dmEvent, tUWA_DM_TEST_CBACK_DATA *eventData) {
   JNI_TRACE_I("%s: enter; event=0x%X", __func__, dmEvent);
+  UwbUciRecorder &recorder = mChip.getRecorder();
+  if (recorder.isCapturing()) {
+    recorder.recordRfTestEvent(dmEvent, eventData);
+  }
 
   switch (dmEvent) {
   case UWA_DM_TEST_SET_CONFIG_RSP_EVT: // result of UWA_TestSetConfig
     JNI_TRACE_I("%s: UWA_DM_TEST_SET_CONFIG_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaSetTestConfigEvent);
-      setTestConfigRespStatus = true;
-      sSetTestConfigStatus = eventData->status;
-      sSetTestConfigLen = eventData->sTest_set_config.tlv_size;
-      sNoOfTestConfigIds = eventData->sTest_set_config.num_param_id;
-      if (eventData->sTest_set_config.tlv_size > 0) {
-        memcpy(sSetTestConfig, eventData->sTest_set_config.param_ids,
-               eventData->sTest_set_config.tlv_size);
+      SyncEventGuard guard(mSetTestConfigEvent);
+      mSetTestConfigRespStatus = true;
+      mSetTestConfigStatus = eventData->status;
+      mSetTestConfigLen = eventData->sTest_set_config.tlv_size;
+      mNoOfTestConfigIds = eventData->sTest_set_config.num_param_id;
+      if (mSetTestConfigDest == NULL ||
+          mSetTestConfigLen > mSetTestConfigCapacity) {
+        mSetTestConfigRespStatus = false;
+      } else if (mSetTestConfigLen > 0) {
+        memcpy(mSetTestConfigDest, eventData->sTest_set_config.param_ids,
+               mSetTestConfigLen);
       }
-      sUwaSetTestConfigEvent.notifyOne();
+      mSetTestConfigEvent.notifyOne();
     }
     break;
   case UWA_DM_TEST_GET_CONFIG_RSP_EVT: /* Result of UWA_TestGetConfig */
     JNI_TRACE_I("%s: UWA_DM_TEST_GET_CONFIG_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaGetTestConfigEvent);
-      getTestConfigRespStatus = true;
-      sGetTestConfigStatus = eventData->status;
-      sGetTestConfigLen = eventData->sTest_get_config.tlv_size;
-      sNoOfTestConfigIds = eventData->sTest_get_config.no_of_ids;
-      if (eventData->sTest_get_config.tlv_size) {
-        memcpy(sGetTestConfig, eventData->sTest_get_config.param_tlvs,
-               eventData->sTest_get_config.tlv_size);
+      SyncEventGuard guard(mGetTestConfigEvent);
+      mGetTestConfigRespStatus = true;
+      mGetTestConfigStatus = eventData->status;
+      mGetTestConfigLen = eventData->sTest_get_config.tlv_size;
+      mNoOfTestConfigIds = eventData->sTest_get_config.no_of_ids;
+      if (mGetTestConfigDest == NULL ||
+          mGetTestConfigLen > mGetTestConfigCapacity) {
+        mGetTestConfigRespStatus = false;
+      } else if (mGetTestConfigLen > 0) {
+        memcpy(mGetTestConfigDest, eventData->sTest_get_config.param_tlvs,
+               mGetTestConfigLen);
       }
-      sUwaGetTestConfigEvent.notifyOne();
+      mGetTestConfigEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_PERIODIC_TX_RSP_EVT: /* result of periodic tx command */
     JNI_TRACE_I("%s: UWA_DM_TEST_PERIODIC_TX_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaRfTestEvent);
+      SyncEventGuard guard(mRfTestEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        rfTestStatus = true;
+        mRfTestStatus = true;
         JNI_TRACE_I("%s: UWA_DM_TEST_PERIODIC_TX_RSP_EVT Success", __func__);
       } else {
         JNI_TRACE_E("%s: UWA_DM_TEST_PERIODIC_TX_RSP_EVT failed", __func__);
       }
-      sUwaRfTestEvent.notifyOne();
+      mRfTestEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_PER_RX_RSP_EVT: /* result of per rx command */
     JNI_TRACE_I("%s: UWA_DM_TEST_PER_RX_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaRfTestEvent);
+      SyncEventGuard guard(mRfTestEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        rfTestStatus = true;
+        mRfTestStatus = true;
         JNI_TRACE_I("%s: UWA_DM_TEST_PER_RX_RSP_EVT Success", __func__);
       } else {
         JNI_TRACE_E("%s: UWA_DM_TEST_PER_RX_RSP_EVT failed", __func__);
       }
-      sUwaRfTestEvent.notifyOne();
+      mRfTestEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_LOOPBACK_RSP_EVT: /* result of rf loop back command */
     JNI_TRACE_I("%s: UWA_DM_TEST_UWB_LOOPBACK_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaRfTestEvent);
+      SyncEventGuard guard(mRfTestEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        rfTestStatus = true;
+        mRfTestStatus = true;
         JNI_TRACE_I("%s: UWA_DM_TEST_UWB_LOOPBACK_EVT Success", __func__);
       } else {
         JNI_TRACE_E("%s: UWA_DM_TEST_UWB_LOOPBACK_EVT failed", __func__);
       }
-      sUwaRfTestEvent.notifyOne();
+      mRfTestEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_RX_RSP_EVT: /* result of rx test command */
     JNI_TRACE_I("%s: UWA_DM_TEST_RX_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaRfTestEvent);
+      SyncEventGuard guard(mRfTestEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        rfTestStatus = true;
+        mRfTestStatus = true;
         JNI_TRACE_I("%s: UWA_DM_TEST_RX_RSP_EVT Success", __func__);
       } else {
         JNI_TRACE_E("%s: UWA_DM_TEST_RX_RSP_EVT failed", __func__);
       }
-      sUwaRfTestEvent.notifyOne();
+      mRfTestEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_STOP_SESSION_RSP_EVT: /* result of per stop command */
     JNI_TRACE_I("%s: UWA_DM_TEST_STOP_SESSION_RSP_EVT", __func__);
     {
-      SyncEventGuard guard(sUwaRfTestEvent);
+      SyncEventGuard guard(mRfTestEvent);
       if (eventData->status == UWA_STATUS_OK) {
-        rfTestStatus = true;
+        mRfTestStatus = true;
         JNI_TRACE_I("%s: UWA_DM_TEST_STOP_SESSION_RSP_EVT Success", __func__);
       } else {
         JNI_TRACE_E("%s: UWA_DM_TEST_STOP_SESSION_RSP_EVT failed", __func__);
       }
-      sUwaRfTestEvent.notifyOne();
+      mRfTestEvent.notifyOne();
     }
     break;
 
   case UWA_DM_TEST_PERIODIC_TX_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_TEST_PERIODIC_TX_NTF_EVT", __func__);
     {
-      IsRfTestOngoing = false;
+      mIsRfTestOngoing = false;
       if (eventData->rf_test_data.length > 0) {
-        uwbRfTestManager.onPeriodicTxDataNotificationReceived(
+        onPeriodicTxDataNotificationReceived(
             eventData->rf_test_data.length, &eventData->rf_test_data.data[0]);
       }
     }
@@ -841,9 +1023,9 @@ void uwaRfTestDeviceManagementCallback(uint8_t dmEvent,
   case UWA_DM_TEST_PER_RX_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_TEST_PER_RX_NTF_EVT", __func__);
     {
-      IsRfTestOngoing = false;
+      mIsRfTestOngoing = false;
       if (eventData->rf_test_data.length > 0) {
-        uwbRfTestManager.onPerRxDataNotificationReceived(
+        onPerRxDataNotificationReceived(
             eventData->rf_test_data.length, &eventData->rf_test_data.data[0]);
       }
     }
@@ -852,9 +1034,9 @@ void uwaRfTestDeviceManagementCallback(uint8_t dmEvent,
   case UWA_DM_TEST_LOOPBACK_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_TEST_LOOPBACK_NTF_EVT", __func__);
     {
-      IsRfTestOngoing = false;
+      mIsRfTestOngoing = false;
       if (eventData->rf_test_data.length > 0) {
-        uwbRfTestManager.onLoopBackTestDataNotificationReceived(
+        onLoopBackTestDataNotificationReceived(
             eventData->rf_test_data.length, &eventData->rf_test_data.data[0]);
       }
     }
@@ -863,9 +1045,9 @@ void uwaRfTestDeviceManagementCallback(uint8_t dmEvent,
   case UWA_DM_TEST_RX_NTF_EVT:
     JNI_TRACE_I("%s: UWA_DM_TEST_RX_NTF_EVT", __func__);
     {
-      IsRfTestOngoing = false;
+      mIsRfTestOngoing = false;
       if (eventData->rf_test_data.length > 0) {
-        uwbRfTestManager.onRxTestDataNotificationReceived(
+        onRxTestDataNotificationReceived(
             eventData->rf_test_data.length, &eventData->rf_test_data.data[0]);
       }
     }
@@ -18,8 +18,17 @@
 
 #ifndef _UWB_RFTEST_NATIVE_MANAGER_H_
 #define _UWB_RFTEST_NATIVE_MANAGER_H_
+
+#include <mutex>
+
+#include "SyncEvent.h"
+#include "UwbRfTestAggregator.h"
+#include "uwa_api.h"
+
 namespace android {
 
+class UwbChipContext;
+
 typedef struct {
   uint8_t status;          ///< Status
   uint32_t attempts;       ///< No. of RX attempts
@@ -74,11 +83,17 @@ typedef struct {
   uint8_t status; ///< Status
 } tPERIODIC_TX_DATA;
 
+/* RF test natives and notifications of one chip */
 class UwbRfTestManager {
 public:
-  static UwbRfTestManager &getInstance();
   void doLoadSymbols(JNIEnv *env, jobject o);
 
+  /* Test callback given to the UWA stack of the chip */
+  void onDeviceManagementEvent(uint8_t dmEvent,
+                               tUWA_DM_TEST_CBACK_DATA *eventData);
+  /* The UWBS was reset or disabled, no test is running any more */
+  void clearTestContext() { mIsRfTestOngoing = false; }
+
   /* CallBack functions */
   void onPeriodicTxDataNotificationReceived(uint16_t len, uint8_t *data);
   void onPerRxDataNotificationReceived(uint16_t len, uint8_t *data);
@@ -98,25 +113,58 @@ public:
   jbyte startRxTest(JNIEnv *env, jobject o);
   jbyte stopRfTest(JNIEnv *env, jobject o);
 
+  /* Must not be called from within onRfTestSummaryReceived() */
+  bool setAggregation(JNIEnv *env, jobject o, uint32_t summaryIntervalMs,
+                      const char *logPath);
+
 private:
-  UwbRfTestManager();
+  friend class UwbChipContext;
+  explicit UwbRfTestManager(UwbChipContext &chip);
 
-  static UwbRfTestManager mObjTestManager;
+  bool aggregate(uint8_t type, uint16_t len, uint8_t *data);
+  void sendSummaryLocked(bool final);
+
+  UwbChipContext &mChip; // stack, enable state and recorder of the chip
+
+  SyncEvent mRfTestEvent;
+  SyncEvent mSetTestConfigEvent;
+  SyncEvent mGetTestConfigEvent;
+  /* Leased buffers the config responses are copied to, attached by the
+   * waiting caller under the guard of the command's SyncEvent */
+  uint8_t *mSetTestConfigDest;
+  uint16_t mSetTestConfigCapacity;
+  uint8_t *mGetTestConfigDest;
+  uint16_t mGetTestConfigCapacity;
+  uint8_t mNoOfTestConfigIds;
+  uint16_t mGetTestConfigLen;
+  uint16_t mSetTestConfigLen;
+  uint8_t mGetTestConfigStatus;
+  uint8_t mSetTestConfigStatus;
+
+  /* command response status */
+  bool mSetTestConfigRespStatus;
+  bool mGetTestConfigRespStatus;
+  bool mRfTestStatus;
+  bool mIsRfTestOngoing; // to track the RF test status whether test is
+                         // sussesffuly completed or not
 
   JavaVM *mVm;
 
   jclass mClass;   // Reference to Java  class
   jobject mObject; // Weak ref to Java object to call on
 
-  jclass mPeriodicTxDataClass;
-  jclass mPerRxDataClass;
-  jclass mUwbLoopBackDataClass;
-  jclass mRxDataClass;
-
   jmethodID mOnPeriodicTxDataNotificationReceived;
   jmethodID mOnPerRxDataNotificationReceived;
   jmethodID mOnLoopBackTestDataNotificationReceived;
   jmethodID mOnRxTestDataNotificationReceived;
+
+  /* Guards the aggregator, held across the summary upcalls. The summary
+   * receiver is set with setAggregation(), independent of doLoadSymbols() */
+  std::mutex mAggregatorMutex;
+  UwbRfTestAggregator mAggregator;
+  JavaVM *mSummaryVm;
+  jobject mSummaryObject;
+  jmethodID mOnRfTestSummaryReceived;
 };
 
 } // namespace android
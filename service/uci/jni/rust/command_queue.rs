@@ -0,0 +1,196 @@
+//! Non-blocking submission of JNI commands to the dispatcher.
+use std::collections::{HashMap, HashSet};
+use std::sync::mpsc;
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use log::error;
+use uwb_uci_rust::error::UwbErr;
+use uwb_uci_rust::uci::{uci_hrcv::UciResponse, JNICommand};
+
+/// Identifies a submitted command, unique for the lifetime of a queue.
+pub type CommandToken = u64;
+pub type CommandResult = Result<UciResponse, UwbErr>;
+/// Receives the result of a command once its response arrived.
+pub type CommandCallback = Box<dyn FnOnce(CommandToken, CommandResult) + Send>;
+
+enum Completion {
+    /// Kept until poll() or wait() takes it.
+    Poll,
+    Callback(CommandCallback),
+}
+
+struct Job {
+    token: CommandToken,
+    cmd: JNICommand,
+    completion: Completion,
+}
+
+struct Submitter {
+    next_token: CommandToken,
+    sender: Option<mpsc::Sender<Job>>,
+}
+
+#[derive(Default)]
+struct Results {
+    /// Polled commands not answered yet.
+    pending: HashSet<CommandToken>,
+    ready: HashMap<CommandToken, CommandResult>,
+    /// Pending commands nobody takes the result of anymore, dropped on arrival.
+    abandoned: HashSet<CommandToken>,
+}
+
+#[derive(Default)]
+struct Completed {
+    results: Mutex<Results>,
+    done: Condvar,
+}
+
+/// Queue of JNI commands executed in submission order by a worker thread, so that the JNI
+/// threads submitting them do not wait for the responses. UCI allows a single outstanding
+/// command, the worker hands the next one to the dispatcher as soon as the previous one is
+/// answered.
+pub struct CommandQueue {
+    submitter: Mutex<Submitter>,
+    completed: Arc<Completed>,
+    worker: Mutex<Option<thread::JoinHandle<()>>>,
+}
+
+impl CommandQueue {
+    /// Create a queue whose worker runs every command through execute, typically
+    /// Dispatcher::block_on_jni_command.
+    pub fn new<F>(execute: F) -> Self
+    where
+        F: Fn(JNICommand) -> CommandResult + Send + 'static,
+    {
+        let (sender, receiver) = mpsc::channel::<Job>();
+        let completed = Arc::new(Completed::default());
+        let worker_completed = completed.clone();
+        let worker = thread::Builder::new()
+            .name("uwb_cmd_queue".to_owned())
+            .spawn(move || {
+                for job in receiver {
+                    let result = execute(job.cmd);
+                    match job.completion {
+                        Completion::Poll => {
+                            let mut results = worker_completed.results.lock().unwrap();
+                            results.pending.remove(&job.token);
+                            if !results.abandoned.remove(&job.token) {
+                                results.ready.insert(job.token, result);
+                                worker_completed.done.notify_all();
+                            }
+                        }
+                        Completion::Callback(callback) => callback(job.token, result),
+                    }
+                }
+            })
+            .map_err(|err| error!("Fail to start the command queue {:?}", err))
+            .ok();
+        let sender = if worker.is_some() { Some(sender) } else { None };
+        Self {
+            submitter: Mutex::new(Submitter { next_token: 1, sender }),
+            completed,
+            worker: Mutex::new(worker),
+        }
+    }
+
+    /// Queue a command whose result is taken with poll() or wait().
+    pub fn submit(&self, cmd: JNICommand) -> Result<CommandToken, UwbErr> {
+        self.enqueue(vec![(cmd, Completion::Poll)]).map(|tokens| tokens[0])
+    }
+
+    /// Queue a command whose result is handed to callback on the worker thread.
+    pub fn submit_with_callback(
+        &self,
+        cmd: JNICommand,
+        callback: CommandCallback,
+    ) -> Result<CommandToken, UwbErr> {
+        self.enqueue(vec![(cmd, Completion::Callback(callback))]).map(|tokens| tokens[0])
+    }
+
+    /// Queue the commands back to back, no command of another submitter runs in between.
+    pub fn submit_batch(&self, cmds: Vec<JNICommand>) -> Result<Vec<CommandToken>, UwbErr> {
+        self.enqueue(cmds.into_iter().map(|cmd| (cmd, Completion::Poll)).collect())
+    }
+
+    /// Take the result of a command submitted with submit() or submit_batch(), None while it is
+    /// still pending.
+    pub fn poll(&self, token: CommandToken) -> Option<CommandResult> {
+        self.completed.results.lock().unwrap().ready.remove(&token)
+    }
+
+    /// Wait up to timeout for the result of a command. On timeout the command is cancelled and
+    /// None returned, its result is dropped whenever it arrives.
+    pub fn wait(&self, token: CommandToken, timeout: Duration) -> Option<CommandResult> {
+        let deadline = Instant::now() + timeout;
+        let mut results = self.completed.results.lock().unwrap();
+        loop {
+            if let Some(result) = results.ready.remove(&token) {
+                return Some(result);
+            }
+            let now = Instant::now();
+            if now >= deadline {
+                Self::cancel_locked(&mut results, token);
+                return None;
+            }
+            results = self.completed.done.wait_timeout(results, deadline - now).unwrap().0;
+        }
+    }
+
+    /// Give up on the result of a command submitted with submit() or submit_batch(). The command
+    /// still runs if it was not answered yet, but its result is not kept.
+    pub fn cancel(&self, token: CommandToken) {
+        Self::cancel_locked(&mut self.completed.results.lock().unwrap(), token);
+    }
+
+    /// Number of results kept for poll() or wait().
+    #[cfg(test)]
+    pub fn kept_results(&self) -> usize {
+        let results = self.completed.results.lock().unwrap();
+        results.ready.len() + results.abandoned.len()
+    }
+
+    fn cancel_locked(results: &mut Results, token: CommandToken) {
+        if results.pending.contains(&token) {
+            results.abandoned.insert(token);
+        } else {
+            results.ready.remove(&token);
+        }
+    }
+
+    /// Run the commands already queued, then stop the worker. Later submissions fail.
+    pub fn shutdown(&self) {
+        self.submitter.lock().unwrap().sender = None;
+        if let Some(worker) = self.worker.lock().unwrap().take() {
+            if worker.join().is_err() {
+                error!("The command queue worker panicked");
+            }
+        }
+    }
+
+    fn enqueue(&self, jobs: Vec<(JNICommand, Completion)>) -> Result<Vec<CommandToken>, UwbErr> {
+        let mut submitter = self.submitter.lock().unwrap();
+        let mut tokens = Vec::with_capacity(jobs.len());
+        for (cmd, completion) in jobs {
+            let token = submitter.next_token;
+            submitter.next_token += 1;
+            let sender = submitter.sender.as_ref().ok_or_else(UwbErr::failed)?;
+            if let Completion::Poll = completion {
+                self.completed.results.lock().unwrap().pending.insert(token);
+            }
+            if sender.send(Job { token, cmd, completion }).is_err() {
+                self.completed.results.lock().unwrap().pending.remove(&token);
+                return Err(UwbErr::failed());
+            }
+            tokens.push(token);
+        }
+        Ok(tokens)
+    }
+}
+
+impl Drop for CommandQueue {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
@@ -1,22 +1,29 @@
 //! jni for uwb native stack
-use jni::objects::{JObject, JValue};
+use std::time::Duration;
+
+use jni::errors::JniError;
+use jni::objects::{GlobalRef, JByteBuffer, JClass, JMethodID, JObject, JValue};
 use jni::sys::{
-    jarray, jboolean, jbyte, jbyteArray, jint, jintArray, jlong, jobject, jshort, jshortArray,
-    jsize,
+    jarray, jboolean, jbyte, jbyteArray, jint, jintArray, jlong, jmethodID, jobject, jshort,
+    jshortArray, jsize,
 };
 use jni::JNIEnv;
 use log::{error, info};
 use num_traits::ToPrimitive;
 use uwb_uci_packets::{
-    GetCapsInfoRspPacket, Packet, SessionGetAppConfigRspPacket, SessionSetAppConfigRspPacket,
-    StatusCode, UciResponseChild, UciResponsePacket, UciVendor_9_ResponseChild,
-    UciVendor_A_ResponseChild, UciVendor_B_ResponseChild, UciVendor_E_ResponseChild,
-    UciVendor_F_ResponseChild,
+    AppConfigStatus, AppConfigTlv, CapTlv, GetCapsInfoRspPacket, Packet,
+    SessionGetAppConfigRspPacket, SessionSetAppConfigRspPacket, StatusCode, UciResponseChild,
+    UciResponsePacket, UciVendor_9_ResponseChild, UciVendor_A_ResponseChild,
+    UciVendor_B_ResponseChild, UciVendor_E_ResponseChild, UciVendor_F_ResponseChild,
 };
 use uwb_uci_rust::error::UwbErr;
 use uwb_uci_rust::event_manager::EventManagerImpl as EventManager;
 use uwb_uci_rust::uci::{uci_hrcv::UciResponse, Dispatcher, DispatcherImpl, JNICommand};
 
+use crate::command_queue::CommandQueue;
+
+mod command_queue;
+
 trait Context<'a> {
     fn convert_byte_array(&self, array: jbyteArray) -> Result<Vec<u8>, jni::errors::Error>;
     fn get_array_length(&self, array: jarray) -> Result<jsize, jni::errors::Error>;
@@ -32,6 +39,12 @@ trait Context<'a> {
         start: jsize,
         buf: &mut [jint],
     ) -> Result<(), jni::errors::Error>;
+    fn read_direct_buffer(
+        &self,
+        buffer: jobject,
+        len: usize,
+    ) -> Result<Vec<u8>, jni::errors::Error>;
+    fn write_direct_buffer(&self, buffer: jobject, data: &[u8]) -> Result<(), jni::errors::Error>;
     fn get_dispatcher(&self) -> Result<&'a mut dyn Dispatcher, UwbErr>;
 }
 
@@ -44,6 +57,27 @@ impl<'a> JniContext<'a> {
     fn new(env: JNIEnv<'a>, obj: JObject<'a>) -> Self {
         Self { env, obj }
     }
+
+    fn get_native_dispatcher(&self) -> Result<*mut NativeDispatcher, UwbErr> {
+        let dispatcher_ptr_value = self.env.get_field(self.obj, "mDispatcherPointer", "J")?;
+        let dispatcher_ptr = dispatcher_ptr_value.j()?;
+        if dispatcher_ptr == 0i64 {
+            error!("The dispatcher is not initialized.");
+            return Err(UwbErr::NoneDispatcher);
+        }
+        Ok(dispatcher_ptr as *mut NativeDispatcher)
+    }
+
+    fn get_command_queue(&self) -> Result<&'a CommandQueue, UwbErr> {
+        // Safety: see get_dispatcher.
+        unsafe { Ok(&(*self.get_native_dispatcher()?).queue) }
+    }
+
+    /// Response class cache of this dispatcher, None before it is created or if loading failed.
+    fn jni_symbols(&self) -> Option<&'a JniSymbols> {
+        // Safety: see get_dispatcher.
+        unsafe { (*self.get_native_dispatcher().ok()?).symbols.as_ref() }
+    }
 }
 
 impl<'a> Context<'a> for JniContext<'a> {
@@ -69,17 +103,197 @@ impl<'a> Context<'a> for JniContext<'a> {
     ) -> Result<(), jni::errors::Error> {
         self.env.get_int_array_region(array, start, buf)
     }
-    fn get_dispatcher(&self) -> Result<&'a mut dyn Dispatcher, UwbErr> {
-        let dispatcher_ptr_value = self.env.get_field(self.obj, "mDispatcherPointer", "J")?;
-        let dispatcher_ptr = dispatcher_ptr_value.j()?;
-        if dispatcher_ptr == 0i64 {
-            error!("The dispatcher is not initialized.");
-            return Err(UwbErr::NoneDispatcher);
+    fn read_direct_buffer(
+        &self,
+        buffer: jobject,
+        len: usize,
+    ) -> Result<Vec<u8>, jni::errors::Error> {
+        let memory = self.env.get_direct_buffer_address(JByteBuffer::from(buffer))?;
+        if memory.len() < len {
+            return Err(jni::errors::Error::JniCall(JniError::InvalidArguments));
+        }
+        Ok(memory[..len].to_vec())
+    }
+    fn write_direct_buffer(&self, buffer: jobject, data: &[u8]) -> Result<(), jni::errors::Error> {
+        let memory = self.env.get_direct_buffer_address(JByteBuffer::from(buffer))?;
+        if memory.len() < data.len() {
+            return Err(jni::errors::Error::JniCall(JniError::InvalidArguments));
         }
+        memory[..data.len()].copy_from_slice(data);
+        Ok(())
+    }
+    fn get_dispatcher(&self) -> Result<&'a mut dyn Dispatcher, UwbErr> {
+        let native_dispatcher = self.get_native_dispatcher()?;
         // Safety: dispatcher pointer must not be a null pointer and it must point to a valid dispatcher object.
         // This can be ensured because the dispatcher is created in an earlier stage and
         // won't be deleted before calling doDeinitialize.
-        unsafe { Ok(&mut *(dispatcher_ptr as *mut DispatcherImpl)) }
+        unsafe { Ok(&mut *(*native_dispatcher).dispatcher) }
+    }
+}
+
+/// Java classes the responses are returned as.
+#[derive(Clone, Copy, Debug)]
+enum ResponseClass {
+    ConfigStatusData,
+    TlvData,
+    VendorUciResponse,
+    PowerStats,
+}
+
+impl ResponseClass {
+    const ALL: [ResponseClass; 4] = [
+        ResponseClass::ConfigStatusData,
+        ResponseClass::TlvData,
+        ResponseClass::VendorUciResponse,
+        ResponseClass::PowerStats,
+    ];
+
+    fn name(self) -> &'static str {
+        match self {
+            ResponseClass::ConfigStatusData => "com/android/server/uwb/data/UwbConfigStatusData",
+            ResponseClass::TlvData => "com/android/server/uwb/data/UwbTlvData",
+            ResponseClass::VendorUciResponse => "com/android/server/uwb/data/UwbVendorUciResponse",
+            ResponseClass::PowerStats => "com/android/server/uwb/info/UwbPowerStats",
+        }
+    }
+
+    fn ctor_sig(self) -> &'static str {
+        match self {
+            ResponseClass::ConfigStatusData | ResponseClass::TlvData => "(II[B)V",
+            ResponseClass::VendorUciResponse => "(BII[B)V",
+            ResponseClass::PowerStats => "(IIII)V",
+        }
+    }
+}
+
+struct CachedClass {
+    class: GlobalRef,
+    ctor: jmethodID,
+}
+
+/// Global class refs and constructor IDs of the response classes, indexed by ResponseClass.
+struct JniSymbols {
+    classes: Vec<CachedClass>,
+}
+
+// Safety: a method ID is valid on every thread as long as its class is loaded, which the global
+// class ref held next to it guarantees.
+unsafe impl Send for JniSymbols {}
+unsafe impl Sync for JniSymbols {}
+
+impl JniSymbols {
+    fn load(env: &JNIEnv) -> Result<Self, jni::errors::Error> {
+        let mut classes = Vec::with_capacity(ResponseClass::ALL.len());
+        for response_class in ResponseClass::ALL {
+            let class = env.find_class(response_class.name())?;
+            let ctor = env.get_method_id(class, "<init>", response_class.ctor_sig())?.into_inner();
+            classes.push(CachedClass { class: env.new_global_ref(class)?, ctor });
+            env.delete_local_ref(JObject::from(class))?;
+        }
+        Ok(Self { classes })
+    }
+}
+
+/// Construct a response object through the cached constructor ID. args must match
+/// ResponseClass::ctor_sig. Without a cache, the class and constructor are looked up by name.
+fn new_response_object<'a>(
+    env: &JNIEnv<'a>,
+    symbols: Option<&JniSymbols>,
+    response_class: ResponseClass,
+    args: &[JValue],
+) -> Result<JObject<'a>, jni::errors::Error> {
+    if let Some(symbols) = symbols {
+        let cached = &symbols.classes[response_class as usize];
+        return env.new_object_unchecked(
+            JClass::from(cached.class.as_obj()),
+            JMethodID::from(cached.ctor),
+            args,
+        );
+    }
+    env.new_object(response_class.name(), response_class.ctor_sig(), args)
+}
+
+/// Build a UwbTlvData from a response status and its serialized TLVs
+fn new_tlv_data_object<'a>(
+    env: &JNIEnv<'a>,
+    symbols: Option<&JniSymbols>,
+    status: StatusCode,
+    no_of_tlvs: usize,
+    tlvs: &[u8],
+) -> Result<JObject<'a>, jni::errors::Error> {
+    let tlv_jbytearray = env.byte_array_from_slice(tlvs)?;
+    new_response_object(
+        env,
+        symbols,
+        ResponseClass::TlvData,
+        &[
+            JValue::Int(status.to_i32().unwrap()),
+            JValue::Int(no_of_tlvs.to_i32().unwrap()),
+            JValue::Object(JObject::from(tlv_jbytearray)),
+        ],
+    )
+}
+
+/// (cfg_id, status) pairs of a set app config response
+fn config_status_to_bytes(cfg_status: &[AppConfigStatus]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(2 * cfg_status.len());
+    for iter in cfg_status {
+        buf.extend_from_slice(&[iter.cfg_id as u8, iter.status as u8]);
+    }
+    buf
+}
+
+fn app_config_tlvs_to_bytes(tlvs: &[AppConfigTlv]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(tlvs.iter().map(|tlv| 2 + tlv.v.len()).sum());
+    for tlv in tlvs {
+        buf.extend_from_slice(&[tlv.cfg_id as u8, tlv.v.len() as u8]);
+        buf.extend_from_slice(&tlv.v);
+    }
+    buf
+}
+
+fn caps_tlvs_to_bytes(tlvs: &[CapTlv]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(tlvs.iter().map(|tlv| 2 + tlv.v.len()).sum());
+    for tlv in tlvs {
+        buf.extend_from_slice(&[tlv.t as u8, tlv.v.len() as u8]);
+        buf.extend_from_slice(&tlv.v);
+    }
+    buf
+}
+
+/// Upper bound of the wait for a queued command, above the response timeout of the dispatcher.
+const COMMAND_QUEUE_WAIT_TIMEOUT: Duration = Duration::from_secs(10);
+
+/// Dispatcher of a NativeDispatcher, shared with its command queue worker.
+struct DispatcherPtr(*const DispatcherImpl);
+
+// Safety: the worker only uses the dispatcher through &self, as concurrent JNI threads already
+// do, and the queue is shut down before the dispatcher is freed.
+unsafe impl Send for DispatcherPtr {}
+
+impl DispatcherPtr {
+    fn get(&self) -> &DispatcherImpl {
+        // Safety: see above, the pointer outlives the command queue.
+        unsafe { &*self.0 }
+    }
+}
+
+/// What mDispatcherPointer points to: a dispatcher and the state tied to its lifetime, so that
+/// several Java objects each own their own. Fields drop in declaration order, the queue worker
+/// stops before the dispatcher it runs commands on is freed.
+struct NativeDispatcher {
+    queue: CommandQueue,
+    dispatcher: Box<DispatcherImpl>,
+    symbols: Option<JniSymbols>,
+}
+
+impl NativeDispatcher {
+    fn new(dispatcher: DispatcherImpl, symbols: Option<JniSymbols>) -> Self {
+        // The dispatcher is boxed first so that the worker's pointer stays valid once moved.
+        let dispatcher = Box::new(dispatcher);
+        let worker_dispatcher = DispatcherPtr(&*dispatcher);
+        let queue = CommandQueue::new(move |cmd| worker_dispatcher.get().block_on_jni_command(cmd));
+        Self { queue, dispatcher, symbols }
     }
 }
 
@@ -167,6 +381,30 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSe
     )
 }
 
+/// init several sessions, returns the status of each session or null
+#[no_mangle]
+pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSessionInitBatch(
+    env: JNIEnv,
+    obj: JObject,
+    session_ids: jintArray,
+    session_types: jbyteArray,
+) -> jbyteArray {
+    info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeSessionInitBatch: enter");
+    let context = JniContext::new(env, obj);
+    let result = read_session_init_batch(&context, session_ids, session_types)
+        .and_then(|(ids, types)| session_init_batch(context.get_command_queue()?, &ids, &types));
+    match result {
+        Ok(statuses) => {
+            let buf: Vec<u8> = statuses.iter().map(|status| *status as u8).collect();
+            env.byte_array_from_slice(&buf).unwrap()
+        }
+        Err(e) => {
+            error!("SessionInitBatch failed with: {:?}", e);
+            *JObject::null()
+        }
+    }
+}
+
 /// deinit the session
 #[no_mangle]
 pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSessionDeInit(
@@ -247,25 +485,21 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSe
     app_config_params: jbyteArray,
 ) -> jbyteArray {
     info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeSetAppConfigurations: enter");
+    let context = JniContext::new(env, obj);
     match set_app_configurations(
-        &JniContext::new(env, obj),
+        &context,
         session_id as u32,
         no_of_params as u32,
         app_config_param_len as u32,
         app_config_params,
     ) {
         Ok(data) => {
-            let uwb_config_status_class =
-                env.find_class("com/android/server/uwb/data/UwbConfigStatusData").unwrap();
-            let mut buf: Vec<u8> = Vec::new();
-            for iter in data.get_cfg_status() {
-                buf.push(iter.cfg_id as u8);
-                buf.push(iter.status as u8);
-            }
+            let buf = config_status_to_bytes(data.get_cfg_status());
             let cfg_jbytearray = env.byte_array_from_slice(&buf).unwrap();
-            let uwb_config_status_object = env.new_object(
-                uwb_config_status_class,
-                "(II[B)V",
+            let uwb_config_status_object = new_response_object(
+                &env,
+                context.jni_symbols(),
+                ResponseClass::ConfigStatusData,
                 &[
                     JValue::Int(data.get_status().to_i32().unwrap()),
                     JValue::Int(data.get_cfg_status().len().to_i32().unwrap()),
@@ -281,6 +515,36 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSe
     }
 }
 
+/// set app configurations from and into direct ByteBuffers, returns the response length or -1
+#[no_mangle]
+pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSetAppConfigurationsDirect(
+    env: JNIEnv,
+    obj: JObject,
+    session_id: jint,
+    no_of_params: jint,
+    app_config_param_len: jint,
+    app_config_params: jobject,
+    response: jobject,
+) -> jint {
+    info!(
+        "Java_com_android_server_uwb_jni_NativeUwbManager_nativeSetAppConfigurationsDirect: enter"
+    );
+    match set_app_configurations_direct(
+        &JniContext::new(env, obj),
+        session_id as u32,
+        no_of_params as u32,
+        app_config_param_len as u32,
+        app_config_params,
+        response,
+    ) {
+        Ok(len) => len as jint,
+        Err(e) => {
+            error!("SetAppConfigDirect failed with: {:?}", e);
+            -1
+        }
+    }
+}
+
 /// get app configurations
 #[no_mangle]
 pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeGetAppConfigurations(
@@ -292,33 +556,24 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeGe
     app_config_params: jbyteArray,
 ) -> jbyteArray {
     info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeGetAppConfigurations: enter");
+    let context = JniContext::new(env, obj);
     match get_app_configurations(
-        &JniContext::new(env, obj),
+        &context,
         session_id as u32,
         no_of_params as u32,
         app_config_param_len as u32,
         app_config_params,
     ) {
         Ok(data) => {
-            let uwb_tlv_info_class =
-                env.find_class("com/android/server/uwb/data/UwbTlvData").unwrap();
-            let mut buf: Vec<u8> = Vec::new();
-            for tlv in data.get_tlvs() {
-                buf.push(tlv.cfg_id as u8);
-                buf.push(tlv.v.len() as u8);
-                buf.extend(&tlv.v);
-            }
-            let tlv_jbytearray = env.byte_array_from_slice(&buf).unwrap();
-            let uwb_tlv_info_object = env.new_object(
-                uwb_tlv_info_class,
-                "(II[B)V",
-                &[
-                    JValue::Int(data.get_status().to_i32().unwrap()),
-                    JValue::Int(data.get_tlvs().len().to_i32().unwrap()),
-                    JValue::Object(JObject::from(tlv_jbytearray)),
-                ],
-            );
-            *uwb_tlv_info_object.unwrap()
+            let buf = app_config_tlvs_to_bytes(data.get_tlvs());
+            *new_tlv_data_object(
+                &env,
+                context.jni_symbols(),
+                data.get_status(),
+                data.get_tlvs().len(),
+                &buf,
+            )
+            .unwrap()
         }
         Err(e) => {
             error!("GetAppConfig failed with: {:?}", e);
@@ -334,27 +589,18 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeGe
     obj: JObject,
 ) -> jbyteArray {
     info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeGetCapsInfo: enter");
-    match get_caps_info(&JniContext::new(env, obj)) {
+    let context = JniContext::new(env, obj);
+    match get_caps_info(&context) {
         Ok(data) => {
-            let uwb_tlv_info_class =
-                env.find_class("com/android/server/uwb/data/UwbTlvData").unwrap();
-            let mut buf: Vec<u8> = Vec::new();
-            for tlv in data.get_tlvs() {
-                buf.push(tlv.t as u8);
-                buf.push(tlv.v.len() as u8);
-                buf.extend(&tlv.v);
-            }
-            let tlv_jbytearray = env.byte_array_from_slice(&buf).unwrap();
-            let uwb_tlv_info_object = env.new_object(
-                uwb_tlv_info_class,
-                "(II[B)V",
-                &[
-                    JValue::Int(data.get_status().to_i32().unwrap()),
-                    JValue::Int(data.get_tlvs().len().to_i32().unwrap()),
-                    JValue::Object(JObject::from(tlv_jbytearray)),
-                ],
-            );
-            *uwb_tlv_info_object.unwrap()
+            let buf = caps_tlvs_to_bytes(data.get_tlvs());
+            *new_tlv_data_object(
+                &env,
+                context.jni_symbols(),
+                data.get_status(),
+                data.get_tlvs().len(),
+                &buf,
+            )
+            .unwrap()
         }
         Err(e) => {
             error!("GetCapsInfo failed with: {:?}", e);
@@ -409,33 +655,31 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSe
     payload: jbyteArray,
 ) -> jobject {
     info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeRawVendor: enter");
-    let uwb_vendor_uci_response_class =
-        env.find_class("com/android/server/uwb/data/UwbVendorUciResponse").unwrap();
+    let context = JniContext::new(env, obj);
     match send_raw_vendor_cmd(
-        &JniContext::new(env, obj),
+        &context,
         gid.try_into().expect("invalid gid"),
         oid.try_into().expect("invalid oid"),
         payload,
     ) {
-        Ok((gid, oid, payload)) => *env
-            .new_object(
-                uwb_vendor_uci_response_class,
-                "(BII[B)V",
-                &[
-                    JValue::Byte(StatusCode::UciStatusOk.to_i8().unwrap()),
-                    JValue::Int(gid.to_i32().unwrap()),
-                    JValue::Int(oid.to_i32().unwrap()),
-                    JValue::Object(JObject::from(
-                        env.byte_array_from_slice(payload.as_ref()).unwrap(),
-                    )),
-                ],
-            )
-            .unwrap(),
+        Ok((gid, oid, payload)) => *new_response_object(
+            &env,
+            context.jni_symbols(),
+            ResponseClass::VendorUciResponse,
+            &[
+                JValue::Byte(StatusCode::UciStatusOk.to_i8().unwrap()),
+                JValue::Int(gid.to_i32().unwrap()),
+                JValue::Int(oid.to_i32().unwrap()),
+                JValue::Object(JObject::from(env.byte_array_from_slice(payload.as_ref()).unwrap())),
+            ],
+        )
+        .unwrap(),
         Err(e) => {
             error!("send raw uci cmd failed with: {:?}", e);
-            *env.new_object(
-                uwb_vendor_uci_response_class,
-                "(BII[B)V",
+            *new_response_object(
+                &env,
+                context.jni_symbols(),
+                ResponseClass::VendorUciResponse,
                 &[
                     JValue::Byte(StatusCode::UciStatusFailed.to_i8().unwrap()),
                     JValue::Int(-1),
@@ -448,6 +692,38 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSe
     }
 }
 
+/// send raw vendor command from and into direct ByteBuffers, returns the response length or -1
+#[no_mangle]
+pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeSendRawVendorCmdDirect(
+    env: JNIEnv,
+    obj: JObject,
+    gid: jint,
+    oid: jint,
+    payload: jobject,
+    payload_len: jint,
+    response: jobject,
+) -> jint {
+    info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeSendRawVendorCmdDirect: enter");
+    if payload_len < 0 {
+        error!("invalid payload length {}", payload_len);
+        return -1;
+    }
+    match send_raw_vendor_cmd_direct(
+        &JniContext::new(env, obj),
+        gid.try_into().expect("invalid gid"),
+        oid.try_into().expect("invalid oid"),
+        payload,
+        payload_len as usize,
+        response,
+    ) {
+        Ok(len) => len as jint,
+        Err(e) => {
+            error!("send raw uci cmd direct failed with: {:?}", e);
+            -1
+        }
+    }
+}
+
 /// retrieve the UWB power stats
 #[no_mangle]
 pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeGetPowerStats(
@@ -455,12 +731,11 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeGe
     obj: JObject,
 ) -> jobject {
     info!("Java_com_android_server_uwb_jni_NativeUwbManager_nativeGetPowerStats: enter");
-    let uwb_power_stats_class =
-        env.find_class("com/android/server/uwb/info/UwbPowerStats").unwrap();
-    match get_power_stats(&JniContext::new(env, obj)) {
+    let context = JniContext::new(env, obj);
+    match get_power_stats(&context) {
         Ok(para) => {
-            let power_stats = env.new_object(uwb_power_stats_class, "(IIII)V", &para).unwrap();
-            *power_stats
+            *new_response_object(&env, context.jni_symbols(), ResponseClass::PowerStats, &para)
+                .unwrap()
         }
         Err(e) => {
             error!("Get power stats failed with: {:?}", e);
@@ -565,6 +840,51 @@ fn session_init<'a, T: Context<'a>>(
     status_code_to_res(res.get_status())
 }
 
+fn read_session_init_batch<'a, T: Context<'a>>(
+    context: &T,
+    session_ids: jintArray,
+    session_types: jbyteArray,
+) -> Result<(Vec<i32>, Vec<u8>), UwbErr> {
+    let mut ids = vec![0i32; context.get_array_length(session_ids)?.try_into().unwrap()];
+    context.get_int_array_region(session_ids, 0, &mut ids)?;
+    let types = context.convert_byte_array(session_types)?;
+    Ok((ids, types))
+}
+
+/// Queue the session inits back to back, so the UWBS gets the next command as soon as it
+/// answered the previous one, and collect the status of each session.
+fn session_init_batch(
+    queue: &CommandQueue,
+    session_ids: &[i32],
+    session_types: &[u8],
+) -> Result<Vec<jbyte>, UwbErr> {
+    if session_ids.len() != session_types.len() {
+        error!("{} session ids but {} session types", session_ids.len(), session_types.len());
+        return Err(UwbErr::failed());
+    }
+    let tokens = queue.submit_batch(
+        session_ids
+            .iter()
+            .zip(session_types)
+            .map(|(id, session_type)| JNICommand::UciSessionInit(*id as u32, *session_type))
+            .collect(),
+    )?;
+    Ok(tokens
+        .into_iter()
+        .map(|token| {
+            let res = match queue.wait(token, COMMAND_QUEUE_WAIT_TIMEOUT) {
+                Some(Ok(UciResponse::SessionInitRsp(data))) => {
+                    status_code_to_res(data.get_status())
+                }
+                Some(Ok(_)) => Err(UwbErr::failed()),
+                Some(Err(err)) => Err(err),
+                None => Err(UwbErr::failed()),
+            };
+            byte_result_helper(res, "SessionInitBatch")
+        })
+        .collect())
+}
+
 fn session_deinit<'a, T: Context<'a>>(context: &T, session_id: u32) -> Result<(), UwbErr> {
     let dispatcher = context.get_dispatcher()?;
     let res = match dispatcher.block_on_jni_command(JNICommand::UciSessionDeinit(session_id))? {
@@ -631,6 +951,34 @@ fn set_app_configurations<'a, T: Context<'a>>(
     }
 }
 
+/// Writes status, number of config status entries and the (cfg_id, status) pairs into response.
+fn set_app_configurations_direct<'a, T: Context<'a>>(
+    context: &T,
+    session_id: u32,
+    no_of_params: u32,
+    app_config_param_len: u32,
+    app_config_params: jobject,
+    response: jobject,
+) -> Result<usize, UwbErr> {
+    let app_configs =
+        context.read_direct_buffer(app_config_params, app_config_param_len as usize)?;
+    let dispatcher = context.get_dispatcher()?;
+    let data = match dispatcher.block_on_jni_command(JNICommand::UciSetAppConfig {
+        session_id,
+        no_of_params,
+        app_config_param_len,
+        app_configs,
+    })? {
+        UciResponse::SessionSetAppConfigRsp(data) => data,
+        _ => return Err(UwbErr::failed()),
+    };
+    let cfg_status = data.get_cfg_status();
+    let mut buf = vec![data.get_status().to_u8().unwrap(), cfg_status.len() as u8];
+    buf.extend(config_status_to_bytes(cfg_status));
+    context.write_direct_buffer(response, &buf)?;
+    Ok(buf.len())
+}
+
 fn get_app_configurations<'a, T: Context<'a>>(
     context: &T,
     session_id: u32,
@@ -749,6 +1097,27 @@ fn send_raw_vendor_cmd<'a, T: Context<'a>>(
     }
 }
 
+/// Writes the response payload into response and returns its length.
+fn send_raw_vendor_cmd_direct<'a, T: Context<'a>>(
+    context: &T,
+    gid: u32,
+    oid: u32,
+    payload: jobject,
+    payload_len: usize,
+    response: jobject,
+) -> Result<usize, UwbErr> {
+    let payload = context.read_direct_buffer(payload, payload_len)?;
+    let dispatcher = context.get_dispatcher()?;
+    match dispatcher.block_on_jni_command(JNICommand::UciRawVendorCmd { gid, oid, payload })? {
+        UciResponse::RawVendorRsp(rsp) => {
+            let rsp_payload = get_vendor_uci_payload(rsp)?;
+            context.write_direct_buffer(response, &rsp_payload)?;
+            Ok(rsp_payload.len())
+        }
+        _ => Err(UwbErr::failed()),
+    }
+}
+
 fn status_code_to_res(status_code: StatusCode) -> Result<(), UwbErr> {
     match status_code {
         StatusCode::UciStatusOk => Ok(()),
@@ -762,6 +1131,9 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeDi
     env: JNIEnv,
     obj: JObject,
 ) -> jlong {
+    let symbols = JniSymbols::load(&env)
+        .map_err(|err| error!("Fail to cache the JNI symbols {:?}", err))
+        .ok();
     let eventmanager = match EventManager::new(env, obj) {
         Ok(evtmgr) => evtmgr,
         Err(err) => {
@@ -770,7 +1142,9 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeDi
         }
     };
     match DispatcherImpl::new(eventmanager) {
-        Ok(dispatcher) => Box::into_raw(Box::new(dispatcher)) as jlong,
+        Ok(dispatcher) => {
+            Box::into_raw(Box::new(NativeDispatcher::new(dispatcher, symbols))) as jlong
+        }
         Err(err) => {
             error!("Fail to create dispatcher {:?}", err);
             *JObject::null() as jlong
@@ -802,7 +1176,10 @@ pub extern "system" fn Java_com_android_server_uwb_jni_NativeUwbManager_nativeDi
     // This can be ensured because the dispatcher is created in an earlier stage and
     // won't be deleted before calling this destroy function.
     // This function will early return if the instance is already destroyed.
-    let _boxed_dispatcher = unsafe { Box::from_raw(dispatcher_ptr as *mut DispatcherImpl) };
+    let native_dispatcher = unsafe { Box::from_raw(dispatcher_ptr as *mut NativeDispatcher) };
+    // The queue worker must not outlive the dispatcher it runs commands on.
+    native_dispatcher.queue.shutdown();
+    drop(native_dispatcher);
     info!("The dispatcher successfully destroyed.");
 }
 
@@ -842,6 +1219,8 @@ mod mock_dispatcher;
 mod tests {
     use super::*;
 
+    use std::sync::Arc;
+
     use crate::mock_context::MockContext;
     use crate::mock_dispatcher::MockDispatcher;
 
@@ -864,6 +1243,80 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_config_status_to_bytes() {
+        let cfg_status = vec![
+            AppConfigStatus {
+                cfg_id: uwb_uci_packets::AppConfigTlvType::RangingRoundUsage,
+                status: StatusCode::UciStatusInvalidRange,
+            },
+            AppConfigStatus {
+                cfg_id: uwb_uci_packets::AppConfigTlvType::DeviceType,
+                status: StatusCode::UciStatusOk,
+            },
+        ];
+        assert_eq!(
+            config_status_to_bytes(&cfg_status),
+            vec![
+                uwb_uci_packets::AppConfigTlvType::RangingRoundUsage as u8,
+                StatusCode::UciStatusInvalidRange as u8,
+                uwb_uci_packets::AppConfigTlvType::DeviceType as u8,
+                StatusCode::UciStatusOk as u8,
+            ]
+        );
+        assert!(config_status_to_bytes(&[]).is_empty());
+    }
+
+    #[test]
+    fn test_app_config_tlvs_to_bytes() {
+        let tlvs = vec![
+            AppConfigTlv { cfg_id: uwb_uci_packets::AppConfigTlvType::DeviceType, v: vec![1] },
+            AppConfigTlv {
+                cfg_id: uwb_uci_packets::AppConfigTlvType::RangingRoundUsage,
+                v: vec![2, 3],
+            },
+        ];
+        let buf = app_config_tlvs_to_bytes(&tlvs);
+        assert_eq!(
+            buf,
+            vec![
+                uwb_uci_packets::AppConfigTlvType::DeviceType as u8,
+                1,
+                1,
+                uwb_uci_packets::AppConfigTlvType::RangingRoundUsage as u8,
+                2,
+                2,
+                3,
+            ]
+        );
+        assert_eq!(buf.capacity(), buf.len());
+    }
+
+    #[test]
+    fn test_caps_tlvs_to_bytes() {
+        let tlvs = vec![CapTlv {
+            t: uwb_uci_packets::CapTlvType::SupportedFiraPhyVersionRange,
+            v: vec![1, 1, 1, 3],
+        }];
+        let buf = caps_tlvs_to_bytes(&tlvs);
+        assert_eq!(
+            buf,
+            vec![uwb_uci_packets::CapTlvType::SupportedFiraPhyVersionRange as u8, 4, 1, 1, 1, 3]
+        );
+        assert_eq!(buf.capacity(), buf.len());
+    }
+
+    #[test]
+    fn test_response_class_signatures() {
+        for response_class in ResponseClass::ALL {
+            assert!(response_class.name().starts_with("com/android/server/uwb/"));
+            assert!(response_class.ctor_sig().ends_with(")V"));
+        }
+        for (index, response_class) in ResponseClass::ALL.iter().enumerate() {
+            assert_eq!(*response_class as usize, index);
+        }
+    }
+
     #[test]
     fn test_do_initialize() {
         let packet = uwb_uci_packets::GetDeviceInfoRspBuilder {
@@ -951,6 +1404,171 @@ mod tests {
         assert!(result.is_ok());
     }
 
+    fn session_init_rsp(status: StatusCode) -> UciResponse {
+        UciResponse::SessionInitRsp(uwb_uci_packets::SessionInitRspBuilder { status }.build())
+    }
+
+    fn new_command_queue(dispatcher: &Arc<MockDispatcher>) -> CommandQueue {
+        let worker_dispatcher = dispatcher.clone();
+        CommandQueue::new(move |cmd| worker_dispatcher.block_on_jni_command(cmd))
+    }
+
+    #[test]
+    fn test_command_queue_runs_batch_in_order() {
+        let mut dispatcher = MockDispatcher::new();
+        for session_id in 1..=3 {
+            dispatcher.expect_block_on_jni_command(
+                JNICommand::UciSessionInit(session_id, 0),
+                Ok(session_init_rsp(StatusCode::UciStatusOk)),
+            );
+        }
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let tokens = queue
+            .submit_batch(
+                (1..=3).map(|session_id| JNICommand::UciSessionInit(session_id, 0)).collect(),
+            )
+            .unwrap();
+        assert_eq!(tokens.len(), 3);
+        // Results can be taken in any order.
+        for token in tokens.iter().rev() {
+            assert!(queue.wait(*token, COMMAND_QUEUE_WAIT_TIMEOUT).unwrap().is_ok());
+        }
+        assert!(queue.poll(tokens[0]).is_none());
+        assert!(
+            dispatcher.take_executed_cmds()
+                == (1..=3)
+                    .map(|session_id| JNICommand::UciSessionInit(session_id, 0))
+                    .collect::<Vec<_>>()
+        );
+        assert_eq!(dispatcher.max_in_flight(), 1);
+    }
+
+    #[test]
+    fn test_command_queue_submit_does_not_block() {
+        let mut dispatcher = MockDispatcher::new();
+        let release = dispatcher.expect_block_on_jni_command_deferred(
+            JNICommand::UciSessionInit(1, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSessionInit(2, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let first = queue.submit(JNICommand::UciSessionInit(1, 0)).unwrap();
+        let second = queue.submit(JNICommand::UciSessionInit(2, 0)).unwrap();
+        assert_ne!(first, second);
+        std::thread::sleep(Duration::from_millis(50));
+        assert!(queue.poll(second).is_none());
+        assert!(queue.poll(first).is_none());
+
+        release.send(()).unwrap();
+        assert!(queue.wait(first, COMMAND_QUEUE_WAIT_TIMEOUT).unwrap().is_ok());
+        assert!(queue.wait(second, COMMAND_QUEUE_WAIT_TIMEOUT).unwrap().is_ok());
+        assert_eq!(dispatcher.max_in_flight(), 1);
+    }
+
+    #[test]
+    fn test_command_queue_wait_timeout_drops_result() {
+        let mut dispatcher = MockDispatcher::new();
+        let release = dispatcher.expect_block_on_jni_command_deferred(
+            JNICommand::UciSessionInit(1, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSessionInit(2, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let first = queue.submit(JNICommand::UciSessionInit(1, 0)).unwrap();
+        assert!(queue.wait(first, Duration::from_millis(50)).is_none());
+        let second = queue.submit(JNICommand::UciSessionInit(2, 0)).unwrap();
+        release.send(()).unwrap();
+        assert!(queue.wait(second, COMMAND_QUEUE_WAIT_TIMEOUT).unwrap().is_ok());
+        // The late result of the abandoned command is not kept.
+        assert!(queue.poll(first).is_none());
+        assert_eq!(queue.kept_results(), 0);
+    }
+
+    #[test]
+    fn test_command_queue_callback() {
+        let mut dispatcher = MockDispatcher::new();
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSessionInit(1, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let (sender, receiver) = std::sync::mpsc::channel();
+        let token = queue
+            .submit_with_callback(
+                JNICommand::UciSessionInit(1, 0),
+                Box::new(move |token, result| sender.send((token, result.is_ok())).unwrap()),
+            )
+            .unwrap();
+        assert_eq!(receiver.recv_timeout(COMMAND_QUEUE_WAIT_TIMEOUT).unwrap(), (token, true));
+        // Callback results are not kept for polling.
+        assert!(queue.poll(token).is_none());
+    }
+
+    #[test]
+    fn test_command_queue_shutdown() {
+        let mut dispatcher = MockDispatcher::new();
+        let release = dispatcher.expect_block_on_jni_command_deferred(
+            JNICommand::UciSessionInit(1, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let token = queue.submit(JNICommand::UciSessionInit(1, 0)).unwrap();
+        drop(release);
+        // The command already queued still runs.
+        queue.shutdown();
+        assert!(queue.poll(token).unwrap().is_ok());
+        assert!(queue.submit(JNICommand::UciSessionInit(2, 0)).is_err());
+    }
+
+    #[test]
+    fn test_session_init_batch() {
+        let mut dispatcher = MockDispatcher::new();
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSessionInit(1, 0),
+            Ok(session_init_rsp(StatusCode::UciStatusOk)),
+        );
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSessionInit(2, 1),
+            Ok(session_init_rsp(StatusCode::UciStatusSessionDuplicate)),
+        );
+        let dispatcher = Arc::new(dispatcher);
+        let queue = new_command_queue(&dispatcher);
+
+        let statuses = session_init_batch(&queue, &[1, 2], &[0, 1]).unwrap();
+        assert_eq!(
+            statuses,
+            vec![
+                StatusCode::UciStatusOk.to_i8().unwrap(),
+                StatusCode::UciStatusSessionDuplicate.to_i8().unwrap(),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_session_init_batch_length_mismatch() {
+        let dispatcher = Arc::new(MockDispatcher::new());
+        let queue = new_command_queue(&dispatcher);
+
+        assert!(session_init_batch(&queue, &[1, 2], &[0]).is_err());
+        assert!(dispatcher.take_executed_cmds().is_empty());
+    }
+
     #[test]
     fn test_session_deinit() {
         let session_id = 1234;
@@ -1080,6 +1698,59 @@ mod tests {
         assert_eq!(result.to_vec(), packet.to_vec());
     }
 
+    #[test]
+    fn test_set_app_configurations_direct() {
+        let session_id = 1234;
+        let no_of_params = 2;
+        let app_config_param_len = 6;
+        let app_configs = vec![1, 1, 5, 2, 1, 7];
+        let fake_app_config_buffer = std::ptr::null_mut();
+        let fake_response_buffer = std::ptr::null_mut();
+        let packet = uwb_uci_packets::SessionSetAppConfigRspBuilder {
+            status: StatusCode::UciStatusInvalidParam,
+            cfg_status: vec![uwb_uci_packets::AppConfigStatus {
+                cfg_id: uwb_uci_packets::AppConfigTlvType::RangingRoundUsage,
+                status: StatusCode::UciStatusInvalidRange,
+            }],
+        }
+        .build();
+
+        let mut dispatcher = MockDispatcher::new();
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciSetAppConfig {
+                session_id,
+                no_of_params,
+                app_config_param_len,
+                app_configs: app_configs.clone(),
+            },
+            Ok(UciResponse::SessionSetAppConfigRsp(packet)),
+        );
+        let mut context = MockContext::new(dispatcher);
+        context.expect_read_direct_buffer(
+            fake_app_config_buffer,
+            app_config_param_len as usize,
+            Ok(app_configs),
+        );
+        let expected_response = vec![
+            StatusCode::UciStatusInvalidParam.to_u8().unwrap(),
+            1,
+            uwb_uci_packets::AppConfigTlvType::RangingRoundUsage as u8,
+            StatusCode::UciStatusInvalidRange.to_u8().unwrap(),
+        ];
+        context.expect_write_direct_buffer(fake_response_buffer, expected_response.clone(), Ok(()));
+
+        let result = set_app_configurations_direct(
+            &context,
+            session_id,
+            no_of_params,
+            app_config_param_len,
+            fake_app_config_buffer,
+            fake_response_buffer,
+        )
+        .unwrap();
+        assert_eq!(result, expected_response.len());
+    }
+
     #[test]
     fn test_get_app_configurations() {
         let session_id = 1234;
@@ -1228,6 +1899,65 @@ mod tests {
         assert_eq!(result.2, response);
     }
 
+    #[test]
+    fn test_send_raw_vendor_cmd_direct() {
+        let gid = 2;
+        let oid = 4;
+        let opcode = 6;
+        let fake_payload_buffer = std::ptr::null_mut();
+        let fake_response_buffer = std::ptr::null_mut();
+        let payload = vec![1, 2, 4, 8];
+        let response = vec![3, 6, 9];
+        let packet = uwb_uci_packets::UciVendor_9_ResponseBuilder {
+            opcode,
+            payload: Some(response.clone().into()),
+        }
+        .build()
+        .into();
+
+        let mut dispatcher = MockDispatcher::new();
+        dispatcher.expect_block_on_jni_command(
+            JNICommand::UciRawVendorCmd { gid, oid, payload: payload.clone() },
+            Ok(UciResponse::RawVendorRsp(packet)),
+        );
+        let mut context = MockContext::new(dispatcher);
+        context.expect_read_direct_buffer(fake_payload_buffer, payload.len(), Ok(payload.clone()));
+        context.expect_write_direct_buffer(fake_response_buffer, response.clone(), Ok(()));
+
+        let result = send_raw_vendor_cmd_direct(
+            &context,
+            gid,
+            oid,
+            fake_payload_buffer,
+            payload.len(),
+            fake_response_buffer,
+        )
+        .unwrap();
+        assert_eq!(result, response.len());
+    }
+
+    #[test]
+    fn test_send_raw_vendor_cmd_direct_short_buffer() {
+        let fake_payload_buffer = std::ptr::null_mut();
+        let fake_response_buffer = std::ptr::null_mut();
+        let mut context = MockContext::new(MockDispatcher::new());
+        context.expect_read_direct_buffer(
+            fake_payload_buffer,
+            16,
+            Err(jni::errors::Error::JniCall(JniError::InvalidArguments)),
+        );
+
+        let result = send_raw_vendor_cmd_direct(
+            &context,
+            2,
+            4,
+            fake_payload_buffer,
+            16,
+            fake_response_buffer,
+        );
+        assert!(result.is_err());
+    }
+
     #[test]
     fn test_get_power_stats() {
         let idle_time_ms = 5;
@@ -1,7 +1,7 @@
 use std::cell::{Cell, RefCell};
 use std::collections::VecDeque;
 
-use jni::sys::{jarray, jbyteArray, jint, jintArray, jshort, jshortArray, jsize};
+use jni::sys::{jarray, jbyteArray, jint, jintArray, jobject, jshort, jshortArray, jsize};
 use uwb_uci_rust::error::UwbErr;
 use uwb_uci_rust::uci::Dispatcher;
 
@@ -69,6 +69,32 @@ impl MockContext {
             out,
         });
     }
+
+    pub fn expect_read_direct_buffer(
+        &mut self,
+        expected_buffer: jobject,
+        expected_len: usize,
+        out: Result<Vec<u8>, jni::errors::Error>,
+    ) {
+        self.expected_calls.borrow_mut().push_back(ExpectedCall::ReadDirectBuffer {
+            expected_buffer,
+            expected_len,
+            out,
+        });
+    }
+
+    pub fn expect_write_direct_buffer(
+        &mut self,
+        expected_buffer: jobject,
+        expected_data: Vec<u8>,
+        out: Result<(), jni::errors::Error>,
+    ) {
+        self.expected_calls.borrow_mut().push_back(ExpectedCall::WriteDirectBuffer {
+            expected_buffer,
+            expected_data,
+            out,
+        });
+    }
 }
 
 #[cfg(test)]
@@ -159,6 +185,42 @@ impl<'a> Context<'a> for MockContext {
         }
     }
 
+    fn read_direct_buffer(
+        &self,
+        buffer: jobject,
+        len: usize,
+    ) -> Result<Vec<u8>, jni::errors::Error> {
+        let mut expected_calls = self.expected_calls.borrow_mut();
+        match expected_calls.pop_front() {
+            Some(ExpectedCall::ReadDirectBuffer { expected_buffer, expected_len, out })
+                if buffer == expected_buffer && len == expected_len =>
+            {
+                out
+            }
+            Some(call) => {
+                expected_calls.push_front(call);
+                Err(jni::errors::Error::JniCall(jni::errors::JniError::Unknown))
+            }
+            None => Err(jni::errors::Error::JniCall(jni::errors::JniError::Unknown)),
+        }
+    }
+
+    fn write_direct_buffer(&self, buffer: jobject, data: &[u8]) -> Result<(), jni::errors::Error> {
+        let mut expected_calls = self.expected_calls.borrow_mut();
+        match expected_calls.pop_front() {
+            Some(ExpectedCall::WriteDirectBuffer { expected_buffer, expected_data, out })
+                if buffer == expected_buffer && data == expected_data.as_slice() =>
+            {
+                out
+            }
+            Some(call) => {
+                expected_calls.push_front(call);
+                Err(jni::errors::Error::JniCall(jni::errors::JniError::Unknown))
+            }
+            None => Err(jni::errors::Error::JniCall(jni::errors::JniError::Unknown)),
+        }
+    }
+
     fn get_dispatcher(&self) -> Result<&'a mut dyn Dispatcher, UwbErr> {
         unsafe { Ok(&mut *(self.dispatcher.as_ptr())) }
     }
@@ -184,4 +246,14 @@ enum ExpectedCall {
         expected_start: jsize,
         out: Result<Box<[jint]>, jni::errors::Error>,
     },
+    ReadDirectBuffer {
+        expected_buffer: jobject,
+        expected_len: usize,
+        out: Result<Vec<u8>, jni::errors::Error>,
+    },
+    WriteDirectBuffer {
+        expected_buffer: jobject,
+        expected_data: Vec<u8>,
+        out: Result<(), jni::errors::Error>,
+    },
 }
@@ -1,14 +1,20 @@
-use std::cell::RefCell;
 use std::collections::VecDeque;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{mpsc, Mutex};
 
 use uwb_uci_packets::GetDeviceInfoRspPacket;
 use uwb_uci_rust::error::UwbErr;
 use uwb_uci_rust::uci::{uci_hrcv::UciResponse, Dispatcher, JNICommand, Result};
 
+/// Expectations are shared behind a mutex so that the mock can be driven from the worker thread
+/// of a CommandQueue while the test thread submits.
 #[cfg(test)]
 #[derive(Default)]
 pub struct MockDispatcher {
-    expected_calls: RefCell<VecDeque<ExpectedCall>>,
+    expected_calls: Mutex<VecDeque<ExpectedCall>>,
+    executed_cmds: Mutex<Vec<JNICommand>>,
+    in_flight: AtomicUsize,
+    max_in_flight: AtomicUsize,
     device_info: Option<GetDeviceInfoRspPacket>,
 }
 
@@ -20,7 +26,8 @@ impl MockDispatcher {
 
     pub fn expect_send_jni_command(&mut self, expected_cmd: JNICommand, out: Result<()>) {
         self.expected_calls
-            .borrow_mut()
+            .lock()
+            .unwrap()
             .push_back(ExpectedCall::SendJniCommand { expected_cmd, out })
     }
 
@@ -29,27 +36,55 @@ impl MockDispatcher {
         expected_cmd: JNICommand,
         out: Result<UciResponse>,
     ) {
-        self.expected_calls
-            .borrow_mut()
-            .push_back(ExpectedCall::BlockOnJniCommand { expected_cmd, out })
+        self.expected_calls.lock().unwrap().push_back(ExpectedCall::BlockOnJniCommand {
+            expected_cmd,
+            out,
+            release: None,
+        })
+    }
+
+    /// Like expect_block_on_jni_command, but the call only returns once the returned sender is
+    /// signaled or dropped.
+    pub fn expect_block_on_jni_command_deferred(
+        &mut self,
+        expected_cmd: JNICommand,
+        out: Result<UciResponse>,
+    ) -> mpsc::Sender<()> {
+        let (sender, receiver) = mpsc::channel();
+        self.expected_calls.lock().unwrap().push_back(ExpectedCall::BlockOnJniCommand {
+            expected_cmd,
+            out,
+            release: Some(receiver),
+        });
+        sender
     }
 
     pub fn expect_wait_for_exit(&mut self, out: Result<()>) {
-        self.expected_calls.borrow_mut().push_back(ExpectedCall::WaitForExit { out })
+        self.expected_calls.lock().unwrap().push_back(ExpectedCall::WaitForExit { out })
+    }
+
+    /// Commands passed to block_on_jni_command so far, in completion order.
+    pub fn take_executed_cmds(&self) -> Vec<JNICommand> {
+        std::mem::take(&mut *self.executed_cmds.lock().unwrap())
+    }
+
+    /// Largest number of block_on_jni_command calls seen running at the same time.
+    pub fn max_in_flight(&self) -> usize {
+        self.max_in_flight.load(Ordering::SeqCst)
     }
 }
 
 #[cfg(test)]
 impl Drop for MockDispatcher {
     fn drop(&mut self) {
-        assert!(self.expected_calls.borrow().is_empty());
+        assert!(self.expected_calls.lock().unwrap().is_empty());
     }
 }
 
 #[cfg(test)]
 impl Dispatcher for MockDispatcher {
     fn send_jni_command(&self, cmd: JNICommand) -> Result<()> {
-        let mut expected_calls = self.expected_calls.borrow_mut();
+        let mut expected_calls = self.expected_calls.lock().unwrap();
         match expected_calls.pop_front() {
             Some(ExpectedCall::SendJniCommand { expected_cmd, out }) if cmd == expected_cmd => out,
             Some(call) => {
@@ -60,20 +95,38 @@ impl Dispatcher for MockDispatcher {
         }
     }
     fn block_on_jni_command(&self, cmd: JNICommand) -> Result<UciResponse> {
-        let mut expected_calls = self.expected_calls.borrow_mut();
-        match expected_calls.pop_front() {
-            Some(ExpectedCall::BlockOnJniCommand { expected_cmd, out }) if cmd == expected_cmd => {
-                out
+        let in_flight = self.in_flight.fetch_add(1, Ordering::SeqCst) + 1;
+        self.max_in_flight.fetch_max(in_flight, Ordering::SeqCst);
+        let call = {
+            let mut expected_calls = self.expected_calls.lock().unwrap();
+            match expected_calls.pop_front() {
+                Some(ExpectedCall::BlockOnJniCommand { expected_cmd, out, release })
+                    if cmd == expected_cmd =>
+                {
+                    Some((out, release))
+                }
+                Some(call) => {
+                    expected_calls.push_front(call);
+                    None
+                }
+                None => None,
             }
-            Some(call) => {
-                expected_calls.push_front(call);
-                Err(UwbErr::Undefined)
+        };
+        let out = match call {
+            Some((out, Some(release))) => {
+                // Wait without holding the expectations, a disconnect also releases the call.
+                let _ = release.recv();
+                out
             }
+            Some((out, None)) => out,
             None => Err(UwbErr::Undefined),
-        }
+        };
+        self.executed_cmds.lock().unwrap().push(cmd);
+        self.in_flight.fetch_sub(1, Ordering::SeqCst);
+        out
     }
     fn wait_for_exit(&mut self) -> Result<()> {
-        let mut expected_calls = self.expected_calls.borrow_mut();
+        let mut expected_calls = self.expected_calls.lock().unwrap();
         match expected_calls.pop_front() {
             Some(ExpectedCall::WaitForExit { out }) => out,
             Some(call) => {
@@ -95,7 +148,16 @@ impl Dispatcher for MockDispatcher {
 
 #[cfg(test)]
 enum ExpectedCall {
-    SendJniCommand { expected_cmd: JNICommand, out: Result<()> },
-    BlockOnJniCommand { expected_cmd: JNICommand, out: Result<UciResponse> },
-    WaitForExit { out: Result<()> },
+    SendJniCommand {
+        expected_cmd: JNICommand,
+        out: Result<()>,
+    },
+    BlockOnJniCommand {
+        expected_cmd: JNICommand,
+        out: Result<UciResponse>,
+        release: Option<mpsc::Receiver<()>>,
+    },
+    WaitForExit {
+        out: Result<()>,
+    },
 }
@@ -26,66 +26,47 @@
 
 using android::base::StringPrintf;
 
-IntervalTimer::IntervalTimer() {
-  mTimerId = 0;
-  mCb = NULL;
-}
+IntervalTimer::IntervalTimer() { mCb = NULL; }
 
+/* A zero or negative interval disarms the timer */
 bool IntervalTimer::set(int ms, TIMER_FUNC cb) {
-  if (mTimerId == 0) {
-    if (cb == NULL)
-      return false;
+  if (cb == NULL && mCb == NULL)
+    return false;
+  if (cb != NULL)
+    mCb = cb;
 
-    if (!create(cb))
-      return false;
+  if (ms <= 0) {
+    UwbTimerWheel::getInstance().cancel(mEntry);
+    return true;
   }
-  if (cb != mCb) {
-    kill();
-    if (!create(cb))
-      return false;
-  }
-
-  int stat = 0;
-  struct itimerspec ts;
-  ts.it_value.tv_sec = ms / 1000;
-  ts.it_value.tv_nsec = (ms % 1000) * 1000000;
-
-  ts.it_interval.tv_sec = 0;
-  ts.it_interval.tv_nsec = 0;
-
-  stat = timer_settime(mTimerId, 0, &ts, 0);
-  if (stat == -1)
-    LOG(ERROR) << StringPrintf("fail set timer");
-  return stat == 0;
+  UwbTimerWheel::getInstance().arm(mEntry, ms, expired, this);
+  return true;
 }
 
-IntervalTimer::~IntervalTimer() { kill(); }
+IntervalTimer::~IntervalTimer() {
+  UwbTimerWheel::getInstance().cancelSync(mEntry);
+}
 
 void IntervalTimer::kill() {
-  if (mTimerId == 0)
-    return;
-
-  if (timer_delete(mTimerId) == -1)
-    LOG(ERROR) << StringPrintf("timer delete ERROR");
-  mTimerId = 0;
+  UwbTimerWheel::getInstance().cancel(mEntry);
   mCb = NULL;
 }
 
 bool IntervalTimer::create(TIMER_FUNC cb) {
-  static struct sigevent se;
-  int stat = 0;
-
-  /*
-   * Set the sigevent structure to cause the signal to be
-   * delivered by creating a new thread.
-   */
-  se.sigev_notify = SIGEV_THREAD;
-  se.sigev_value.sival_ptr = &mTimerId;
-  se.sigev_notify_function = cb;
-  se.sigev_notify_attributes = NULL;
-  mCb = cb;
-  stat = timer_create(CLOCK_MONOTONIC, &se, &mTimerId);
-  if (stat == -1)
+  if (cb == NULL) {
     LOG(ERROR) << StringPrintf("fail create timer");
-  return stat == 0;
+    return false;
+  }
+  mCb = cb;
+  return true;
+}
+
+void IntervalTimer::expired(void *arg) {
+  IntervalTimer *timer = (IntervalTimer *)arg;
+  TIMER_FUNC cb = timer->mCb;
+  if (cb != NULL) {
+    union sigval value;
+    value.sival_ptr = timer;
+    cb(value);
+  }
 }
@@ -19,8 +19,16 @@
  *  Asynchronous interval timer.
  */
 
-#include <time.h>
+#pragma once
 
+#include <signal.h>
+
+#include <atomic>
+
+#include "UwbTimerWheel.h"
+
+/* One shot timer on the shared UwbTimerWheel. The callback runs on the wheel
+ * thread with sival_ptr pointing to this timer and must not block. */
 class IntervalTimer {
 public:
   typedef void (*TIMER_FUNC)(union sigval);
@@ -32,6 +40,8 @@ public:
   bool create(TIMER_FUNC);
 
 private:
-  timer_t mTimerId;
-  TIMER_FUNC mCb;
+  static void expired(void *arg);
+
+  UwbTimerEntry mEntry;
+  std::atomic<TIMER_FUNC> mCb;
 };
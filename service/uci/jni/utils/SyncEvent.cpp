@@ -17,15 +17,32 @@
 
 #include "SyncEvent.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
 #include <android-base/stringprintf.h>
 #include <android-base/logging.h>
 
 using android::base::StringPrintf;
 
-std::list<SyncEvent *> syncEventList;
-std::mutex syncEventListMutex;
+/* Registry of all events, only touched on construction, destruction and
+ * notifyAll() */
+static SyncEvent *sSyncEventHead = NULL;
+static std::mutex sSyncEventListMutex;
+static std::atomic<uint32_t> sAbortEpoch(0);
+/* Longest a wait sleeps between checks of the abort epoch. notifyAll() never
+ * blocks on an event mutex, so a waiter it could not signal notices the abort
+ * within this time. */
+static const long ABORT_POLL_MS = 50;
+
+SyncEvent::SyncEvent() { addEvent(); }
 
-SyncEvent::~SyncEvent() { mWait = false; }
+SyncEvent::~SyncEvent() {
+  mWait = false;
+  removeEvent();
+}
 
 void SyncEvent::start() {
   mWait = false;
@@ -33,28 +50,51 @@ void SyncEvent::start() {
 }
 
 void SyncEvent::wait() {
+  uint32_t epoch = sAbortEpoch.load();
   mWait = true;
-  addEvent();
-  while (mWait) {
-    mCondVar.wait(mMutex);
+  mAborted = false;
+  for (;;) {
+    if (sAbortEpoch.load() != epoch) {
+      mAborted = true;
+      break;
+    }
+    if (!mWait)
+      break;
+    mCondVar.wait(mMutex, ABORT_POLL_MS);
   }
+  mWait = false;
 }
 
 bool SyncEvent::wait(long millisec) {
-  bool retVal;
+  bool retVal = true;
+  uint32_t epoch = sAbortEpoch.load();
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(millisec);
   mWait = true;
-  addEvent();
-  while (mWait) {
-    retVal = mCondVar.wait(mMutex, millisec);
-    if (!retVal)
-      mWait = false;
+  mAborted = false;
+  for (;;) {
+    if (sAbortEpoch.load() != epoch) {
+      mAborted = true;
+      break;
+    }
+    if (!mWait)
+      break;
+    long remainingMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now())
+            .count();
+    if (remainingMs <= 0) {
+      retVal = false;
+      break;
+    }
+    mCondVar.wait(mMutex, std::min(remainingMs, ABORT_POLL_MS));
   }
+  mWait = false;
   return retVal;
 }
 
 void SyncEvent::notifyOne() {
   mWait = false;
-  removeEvent();
   mCondVar.notifyOne();
 }
 
@@ -69,26 +109,44 @@ void SyncEvent::end() {
 }
 
 void SyncEvent::addEvent() {
-  std::lock_guard<std::mutex> guard(
-      syncEventListMutex); // with lock access list
-  bool contains = (std::find(syncEventList.begin(), syncEventList.end(),
-                             this) != syncEventList.end());
-  if (!contains)
-    syncEventList.push_back(this);
+  std::lock_guard<std::mutex> guard(sSyncEventListMutex);
+  mPrev = NULL;
+  mNext = sSyncEventHead;
+  if (sSyncEventHead != NULL)
+    sSyncEventHead->mPrev = this;
+  sSyncEventHead = this;
 }
 
 void SyncEvent::removeEvent() {
-  std::lock_guard<std::mutex> guard(
-      syncEventListMutex); // with lock access list
-  syncEventList.remove(this);
+  std::lock_guard<std::mutex> guard(sSyncEventListMutex);
+  if (mPrev != NULL)
+    mPrev->mNext = mNext;
+  else if (sSyncEventHead == this)
+    sSyncEventHead = mNext;
+  if (mNext != NULL)
+    mNext->mPrev = mPrev;
+  mPrev = NULL;
+  mNext = NULL;
+}
+
+/* Never blocks. With the event mutex free, signalling under it guarantees the
+ * waiter either sees the new epoch before sleeping or gets the signal. A held
+ * mutex is signalled directly; a waiter between its epoch check and its sleep
+ * misses the signal and wakes at its next poll. */
+void SyncEvent::wake() {
+  if (mMutex.tryLock()) {
+    mCondVar.notifyOne();
+    mMutex.unlock();
+    return;
+  }
+  mCondVar.notifyOne();
 }
 
 void SyncEvent::notifyAll() {
-  std::lock_guard<std::mutex> guard(
-      syncEventListMutex); // with lock access list
-  for (auto &i : syncEventList) {
-    if (i != NULL)
-      i->notify();
+  sAbortEpoch++;
+  std::lock_guard<std::mutex> guard(sSyncEventListMutex);
+  for (SyncEvent *event = sSyncEventHead; event != NULL;
+       event = event->mNext) {
+    event->wake();
   }
-  syncEventList.clear();
 }
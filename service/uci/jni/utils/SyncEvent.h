@@ -19,18 +19,30 @@
  *  Synchronize two or more threads using a condition variable and a mutex.
  */
 #pragma once
-#include <list>
+#include <stdint.h>
 
 #include "CondVar.h"
 #include "Mutex.h"
 using namespace std;
 
-class SyncEvent;
-
-extern std::list<SyncEvent *> syncEventList;
-
+/* Every SyncEvent is linked into one intrusive list for its whole lifetime,
+ * so waiting and notifying never touch shared state. notifyAll() aborts the
+ * current waiters of all events by advancing a global epoch: a wait returns
+ * once the epoch differs from the one it started in. Waits re-check the epoch
+ * periodically, so notifyAll() never has to take an event mutex. */
 class SyncEvent {
 public:
+  /*******************************************************************************
+  **
+  ** Function:        SyncEvent
+  **
+  ** Description:     Register the event for notifyAll().
+  **
+  ** Returns:         None.
+  **
+  *******************************************************************************/
+  SyncEvent();
+
   /*******************************************************************************
   **
   ** Function:        ~SyncEvent
@@ -119,7 +131,7 @@ public:
   **
   ** Function:        addEvent
   **
-  ** Description:     cache event locally
+  ** Description:     Link the event into the registry, O(1).
   **
   ** Returns:         None.
   **
@@ -130,19 +142,33 @@ public:
   **
   ** Function:        notifyAll
   **
-  ** Description:     Notify all blocked thread that the event has occurred.
-  *Unblocks it.
-  **                  clears the event cache
+  ** Description:     Abort the waits in progress on every event, e.g. on a
+  **                  device error. The waits return as if notified and
+  **                  isAborted() becomes true. Never blocks on an event
+  **                  mutex, so it may be called while any thread holds a
+  **                  SyncEventGuard.
+  **
   ** Returns:         None.
   **
   *******************************************************************************/
   void notifyAll();
 
+  /*******************************************************************************
+  **
+  ** Function:        isAborted
+  **
+  ** Description:     Whether the last wait was ended by notifyAll().
+  **
+  ** Returns:         True if aborted.
+  **
+  *******************************************************************************/
+  bool isAborted() const { return mAborted; }
+
   /*******************************************************************************
   **
   ** Function:        removeEvent
   **
-  ** Description:     remove event from cache event.
+  ** Description:     Unlink the event from the registry, O(1).
   **
   ** Returns:         None.
   **
@@ -150,9 +176,14 @@ public:
   void removeEvent();
 
 private:
+  void wake();
+
   CondVar mCondVar;
   Mutex mMutex;
   bool mWait = false;
+  bool mAborted = false;
+  SyncEvent *mPrev = NULL; // registry links, under the registry lock
+  SyncEvent *mNext = NULL;
 };
 
 /*****************************************************************************/
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Bounded lock-free queue.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/* Fixed-capacity queue over a preallocated array of cells, each tagged with a
+ * sequence number so neither side ever takes a lock. Intended for one producer
+ * and one consumer; the producer may additionally evict from the head with
+ * tryPopIf() to implement a drop-oldest policy. */
+template <typename T, size_t N> class UwbBoundedQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  UwbBoundedQueue() {
+    for (size_t i = 0; i < N; i++) {
+      mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mEnqueuePos.store(0, std::memory_order_relaxed);
+    mDequeuePos.store(0, std::memory_order_relaxed);
+  }
+
+  bool tryPush(const T &item) {
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &mCells[pos & (N - 1)];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mEnqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = item;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T &item) {
+    return tryPopIf([](const T &) { return true; }, item);
+  }
+
+  /* Pop the head only if pred(head) holds. pred reads the cell before it is
+   * claimed, which is only safe when called from the sole producer thread or
+   * the sole consumer thread. */
+  template <typename Pred> bool tryPopIf(Pred pred, T &item) {
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &mCells[pos & (N - 1)];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (!pred(cell->data))
+          return false;
+        if (mDequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mDequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    item = cell->data;
+    cell->sequence.store(pos + N, std::memory_order_release);
+    return true;
+  }
+
+  /* Approximate while the other side is running */
+  size_t size() const {
+    size_t enqueuePos = mEnqueuePos.load(std::memory_order_acquire);
+    size_t dequeuePos = mDequeuePos.load(std::memory_order_acquire);
+    return enqueuePos >= dequeuePos ? enqueuePos - dequeuePos : 0;
+  }
+  bool empty() const { return size() == 0; }
+  bool full() const { return size() >= N; }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  Cell mCells[N];
+  alignas(64) std::atomic<size_t> mEnqueuePos;
+  alignas(64) std::atomic<size_t> mDequeuePos;
+};
@@ -23,6 +23,8 @@
 #include "JniLog.h"
 #include "UwbJniInternal.h"
 
+struct uwb_jni_symbols gUwbJniSymbols;
+
 /*******************************************************************************
 **
 ** Function:        JNI_OnLoad
@@ -79,4 +81,32 @@ int uwb_jni_cache_jclass(JNIEnv *env, const char *className,
     return -1;
   }
   return 0;
-}
\ No newline at end of file
+}
+/*******************************************************************************
+**
+** Function:        uwb_jni_cache_ctor
+**
+** Description:     Cache the global reference of the given class together with
+**                  the ID of its constructor matching the given signature.
+**                  Invoked once during JNI initialization.
+**
+** Returns:         Status code.
+**
+*******************************************************************************/
+int uwb_jni_cache_ctor(JNIEnv *env, const char *className,
+                       const char *signature, jclass *cachedJclass,
+                       jmethodID *cachedCtor) {
+  *cachedCtor = NULL;
+  if (uwb_jni_cache_jclass(env, className, cachedJclass) != 0) {
+    return -1;
+  }
+
+  *cachedCtor = env->GetMethodID(*cachedJclass, "<init>", signature);
+  if (*cachedCtor == NULL) {
+    JNI_TRACE_E("%s: cannot find constructor %s of %s", __func__, signature,
+                className);
+    env->ExceptionClear();
+    return -1;
+  }
+  return 0;
+}
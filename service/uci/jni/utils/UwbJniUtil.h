@@ -35,11 +35,44 @@ struct uwb_jni_native_data {
   jclass multicastUpdateListDataClass;
 };
 
+/* Classes (global refs) and constructor IDs of every object built by the JNI
+ * layer. Resolved once from doLoadSymbols() so notification and response
+ * paths never call FindClass/GetMethodID. */
+struct uwb_jni_symbols {
+  jclass rangeDataClass;
+  jmethodID rangeDataTwoWayCtor;
+  jclass rangingTwoWayMeasuresClass;
+  jmethodID rangingTwoWayMeasuresCtor;
+  jclass multicastUpdateListDataClass;
+  jmethodID multicastUpdateListDataCtor;
+  jclass vendorUciResponseClass;
+  jmethodID vendorUciResponseCtor;
+  jclass configStatusDataClass;
+  jmethodID configStatusDataCtor;
+  jclass tlvDataClass;
+  jmethodID tlvDataCtor;
+  jclass specificationInfoClass;
+  jmethodID specificationInfoCtor;
+  jclass periodicTxDataClass;
+  jmethodID periodicTxDataCtor;
+  jclass perRxDataClass;
+  jmethodID perRxDataCtor;
+  jclass uwbLoopBackDataClass;
+  jmethodID uwbLoopBackDataCtor;
+  jclass rxDataClass;
+  jmethodID rxDataCtor;
+};
+
+extern struct uwb_jni_symbols gUwbJniSymbols;
+
 jint JNI_OnLoad(JavaVM *jvm, void *reserved);
 
 int uwb_jni_cache_jclass(JNIEnv *env, const char *clsname,
                          jclass *cached_jclass);
 
+int uwb_jni_cache_ctor(JNIEnv *env, const char *clsname, const char *signature,
+                       jclass *cached_jclass, jmethodID *cached_ctor);
+
 namespace android {
 int register_com_android_uwb_dhimpl_UwbNativeManager(JNIEnv *env);
 int register_com_android_uwb_dhimpl_NxpUwbNativeManager(JNIEnv *env);
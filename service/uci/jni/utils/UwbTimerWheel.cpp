@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Hierarchical timer wheel shared by all interval timers.
+ */
+
+#include "UwbTimerWheel.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <chrono>
+
+#define LEVEL_SHIFT(level) ((level) * UWB_TIMER_WHEEL_SLOT_BITS)
+#define SLOT_MASK (UWB_TIMER_WHEEL_SLOTS - 1)
+#define MAX_DELTA                                                              \
+  ((1ULL << (UWB_TIMER_WHEEL_LEVELS * UWB_TIMER_WHEEL_SLOT_BITS)) - 1)
+
+static void unlink(UwbTimerEntry &entry) {
+  entry.prev->next = entry.next;
+  entry.next->prev = entry.prev;
+  entry.prev = &entry;
+  entry.next = &entry;
+}
+
+static void link(UwbTimerEntry &head, UwbTimerEntry &entry) {
+  entry.prev = head.prev;
+  entry.next = &head;
+  head.prev->next = &entry;
+  head.prev = &entry;
+}
+
+static uint64_t monotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+UwbTimerWheel UwbTimerWheel::mObjWheel;
+
+UwbTimerWheel &UwbTimerWheel::getInstance() { return mObjWheel; }
+
+UwbTimerWheel::UwbTimerWheel() {
+  mEpochNs = monotonicNs();
+  mTick = 0;
+  mArmed = 0;
+  mRunning = NULL;
+}
+
+uint64_t UwbTimerWheel::nowTick() const {
+  return (monotonicNs() - mEpochNs) / 1000000;
+}
+
+void UwbTimerWheel::arm(UwbTimerEntry &entry, uint32_t ms,
+                        UwbTimerEntry::FUNC func, void *arg) {
+  std::call_once(mStartOnce, [this]() {
+    mThread = std::thread(&UwbTimerWheel::run, this);
+    mThread.detach();
+  });
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if (entry.isArmed()) {
+    unlink(entry);
+    mArmed--;
+  }
+  uint64_t now = nowTick();
+  if (mArmed == 0 && mRunning == NULL) {
+    // Nothing is linked, so skipping the idle ticks cannot miss an expiry.
+    mTick = now;
+  }
+  uint64_t delta = (now - mTick) + ms;
+  if (delta == 0) {
+    delta = 1;
+  } else if (delta > MAX_DELTA) {
+    delta = MAX_DELTA;
+  }
+  entry.expiry = mTick + delta;
+  entry.func = func;
+  entry.arg = arg;
+  insertLocked(entry);
+  mArmed++;
+  mChanged.notify_one();
+}
+
+void UwbTimerWheel::cancel(UwbTimerEntry &entry) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (entry.isArmed()) {
+    unlink(entry);
+    mArmed--;
+  }
+}
+
+void UwbTimerWheel::cancelSync(UwbTimerEntry &entry) {
+  std::unique_lock<std::mutex> lock(mLock);
+  if (entry.isArmed()) {
+    unlink(entry);
+    mArmed--;
+  }
+  if (std::this_thread::get_id() != mThreadId) {
+    mCallbackDone.wait(lock, [this, &entry]() { return mRunning != &entry; });
+  }
+}
+
+/* Place the entry on the lowest level whose span covers its expiry */
+void UwbTimerWheel::insertLocked(UwbTimerEntry &entry) {
+  uint64_t delta = entry.expiry > mTick ? entry.expiry - mTick : 0;
+  int level = 0;
+  while (level < UWB_TIMER_WHEEL_LEVELS - 1 &&
+         delta >= (1ULL << LEVEL_SHIFT(level + 1))) {
+    level++;
+  }
+  int slot = (entry.expiry >> LEVEL_SHIFT(level)) & SLOT_MASK;
+  link(mSlots[level][slot], entry);
+}
+
+/* Redistribute the current slot of a level over the lower levels */
+void UwbTimerWheel::cascadeLocked(int level) {
+  UwbTimerEntry &head =
+      mSlots[level][(mTick >> LEVEL_SHIFT(level)) & SLOT_MASK];
+  while (head.next != &head) {
+    UwbTimerEntry &entry = *head.next;
+    unlink(entry);
+    insertLocked(entry);
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        nextEventTickLocked
+**
+** Description:     Find the first tick at which a linked entry either
+**                  expires (level 0) or cascades (upper levels). Ticks before
+**                  it touch only empty slots and can be skipped.
+**
+** Returns:         The tick, UINT64_MAX if nothing is armed.
+**
+*******************************************************************************/
+uint64_t UwbTimerWheel::nextEventTickLocked() const {
+  uint64_t next = UINT64_MAX;
+  if (mArmed == 0) {
+    return next;
+  }
+  for (int level = 0; level < UWB_TIMER_WHEEL_LEVELS; level++) {
+    uint64_t current = mTick >> LEVEL_SHIFT(level);
+    for (int k = 1; k <= UWB_TIMER_WHEEL_SLOTS; k++) {
+      const UwbTimerEntry &head = mSlots[level][(current + k) & SLOT_MASK];
+      if (head.next != &head) {
+        uint64_t tick = (current + k) << LEVEL_SHIFT(level);
+        if (tick < next) {
+          next = tick;
+        }
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void UwbTimerWheel::run() {
+  pthread_setname_np(pthread_self(), "uwb_timer");
+  std::unique_lock<std::mutex> lock(mLock);
+  mThreadId = std::this_thread::get_id();
+  for (;;) {
+    uint64_t next = nextEventTickLocked();
+    uint64_t now = nowTick();
+    if (next > now) {
+      if (next == UINT64_MAX) {
+        mChanged.wait(lock);
+      } else {
+        mChanged.wait_for(lock, std::chrono::milliseconds(next - now));
+      }
+      continue;
+    }
+
+    mTick = next;
+    for (int level = 1; level < UWB_TIMER_WHEEL_LEVELS; level++) {
+      if ((mTick & ((1ULL << LEVEL_SHIFT(level)) - 1)) != 0) {
+        break;
+      }
+      cascadeLocked(level);
+    }
+    UwbTimerEntry &head = mSlots[0][mTick & SLOT_MASK];
+    while (head.next != &head) {
+      UwbTimerEntry &entry = *head.next;
+      unlink(entry);
+      mArmed--;
+      UwbTimerEntry::FUNC func = entry.func;
+      void *arg = entry.arg;
+      mRunning = &entry;
+      lock.unlock();
+      func(arg);
+      lock.lock();
+      mRunning = NULL;
+      mCallbackDone.notify_all();
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Hierarchical timer wheel shared by all interval timers.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/* 4 levels of 64 slots with a 1 ms tick cover about 4.6 hours, longer
+ * timeouts are clamped. */
+#define UWB_TIMER_WHEEL_LEVELS 4
+#define UWB_TIMER_WHEEL_SLOT_BITS 6
+#define UWB_TIMER_WHEEL_SLOTS (1 << UWB_TIMER_WHEEL_SLOT_BITS)
+
+/* Intrusive list node, owned by the timer it belongs to. All fields are
+ * protected by the wheel lock. */
+struct UwbTimerEntry {
+  typedef void (*FUNC)(void *arg);
+
+  UwbTimerEntry() : prev(this), next(this), expiry(0), func(NULL), arg(NULL) {}
+  bool isArmed() const { return next != this; }
+
+  UwbTimerEntry *prev;
+  UwbTimerEntry *next;
+  uint64_t expiry; // wheel tick
+  FUNC func;
+  void *arg;
+};
+
+/* One thread owns the wheel and runs every expired callback, without the
+ * wheel lock held. Arming and cancelling unlink or link one list node. */
+class UwbTimerWheel {
+public:
+  static UwbTimerWheel &getInstance();
+
+  /* Arm or re-arm entry to fire once after ms milliseconds */
+  void arm(UwbTimerEntry &entry, uint32_t ms, UwbTimerEntry::FUNC func,
+           void *arg);
+  /* Disarm entry. Does not wait for a callback that is already running. */
+  void cancel(UwbTimerEntry &entry);
+  /* Disarm entry and wait until its callback is no longer running, unless
+   * called from that callback. */
+  void cancelSync(UwbTimerEntry &entry);
+
+private:
+  UwbTimerWheel();
+
+  uint64_t nowTick() const;
+  void insertLocked(UwbTimerEntry &entry);
+  void cascadeLocked(int level);
+  uint64_t nextEventTickLocked() const;
+  void run();
+
+  static UwbTimerWheel mObjWheel;
+
+  std::mutex mLock;
+  std::condition_variable mChanged;
+  std::condition_variable mCallbackDone;
+  std::once_flag mStartOnce;
+  std::thread mThread;
+  std::thread::id mThreadId;
+
+  uint64_t mEpochNs;
+  uint64_t mTick;     // last processed tick
+  uint32_t mArmed;    // entries linked in the wheel
+  UwbTimerEntry *mRunning; // entry whose callback runs now
+  UwbTimerEntry mSlots[UWB_TIMER_WHEEL_LEVELS][UWB_TIMER_WHEEL_SLOTS];
+};
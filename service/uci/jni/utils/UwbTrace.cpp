@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "UwbTrace.h"
+
+static const char *TRACE_EVENT_NAMES[UWB_TRACE_EVENT_MAX] = {
+    "UCI_EVENT",    "RANGE_NTF",  "RANGE_MEASUREMENT",
+    "RANGE_UPCALL", "NTF_POST",   "NTF_DISPATCH",
+    "CMD_SUBMIT",   "CMD_COMPLETE", "CMD_TIMEOUT",
+};
+
+UwbTraceRing UwbTraceRing::mObjTraceRing;
+
+UwbTraceRing &UwbTraceRing::getInstance() { return mObjTraceRing; }
+
+UwbTraceRing::UwbTraceRing() {
+  mEnabled = true;
+  mNext = 0;
+  for (int i = 0; i < UWB_TRACE_RING_SIZE; i++) {
+    mRecords[i].sequence = 0;
+  }
+}
+
+/*******************************************************************************
+**
+** Function:        record
+**
+** Description:     Append a record, overwriting the oldest one when the ring
+**                  is full.
+**
+** Params:          event: one of eUWB_TRACE_EVENT.
+**                  arg0..arg3: event specific arguments.
+**
+** Returns:         None
+**
+*******************************************************************************/
+void UwbTraceRing::record(uint16_t event, uint32_t arg0, uint32_t arg1,
+                          uint32_t arg2, uint32_t arg3) {
+  static thread_local uint32_t tid = syscall(SYS_gettid);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  uint64_t index = mNext.fetch_add(1, std::memory_order_relaxed);
+  Record &record = mRecords[index & (UWB_TRACE_RING_SIZE - 1)];
+  record.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  record.timestampNs = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+  record.tid = tid;
+  record.event = event;
+  record.args[0] = arg0;
+  record.args[1] = arg1;
+  record.args[2] = arg2;
+  record.args[3] = arg3;
+  record.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::string UwbTraceRing::dump() {
+  std::string out;
+  uint64_t next = mNext.load(std::memory_order_acquire);
+  uint64_t first = (next > UWB_TRACE_RING_SIZE) ? next - UWB_TRACE_RING_SIZE : 0;
+  char line[160];
+  for (uint64_t index = first; index < next; index++) {
+    const Record &record = mRecords[index & (UWB_TRACE_RING_SIZE - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != index + 1) {
+      continue;
+    }
+    int64_t timestampNs = record.timestampNs;
+    uint32_t tid = record.tid;
+    uint16_t event = record.event;
+    uint32_t args[UWB_TRACE_MAX_ARGS] = {record.args[0], record.args[1],
+                                         record.args[2], record.args[3]};
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (record.sequence.load(std::memory_order_relaxed) != index + 1) {
+      continue; // overwritten while copying
+    }
+    snprintf(line, sizeof(line),
+             "%" PRId64 ".%06" PRId64 " %5u %-18s %08x %08x %08x %08x\n",
+             timestampNs / 1000000000, (timestampNs % 1000000000) / 1000,
+             tid,
+             (event < UWB_TRACE_EVENT_MAX) ? TRACE_EVENT_NAMES[event] : "?",
+             args[0], args[1], args[2], args[3]);
+    out += line;
+  }
+  return out;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Binary trace ring.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+/* Trace events. The name table in UwbTrace.cpp must follow this order. */
+typedef enum {
+  UWB_TRACE_UCI_EVENT = 0,     // dm event
+  UWB_TRACE_RANGE_NTF,         // session id, seq counter, measurements
+  UWB_TRACE_RANGE_MEASUREMENT, // session id, index, distance, azimuth
+  UWB_TRACE_RANGE_UPCALL,      // session id, seq counter
+  UWB_TRACE_NTF_POST,          // type, queue depth
+  UWB_TRACE_NTF_DISPATCH,      // type, duration us
+  UWB_TRACE_CMD_SUBMIT,        // cmd, token
+  UWB_TRACE_CMD_COMPLETE,      // cmd, token, status, latency us
+  UWB_TRACE_CMD_TIMEOUT,       // cmd, token
+  UWB_TRACE_EVENT_MAX
+} eUWB_TRACE_EVENT;
+
+/* Records kept, must be a power of two */
+#define UWB_TRACE_RING_SIZE 4096
+#define UWB_TRACE_MAX_ARGS 4
+
+/* Fixed-size records written without locks by any number of threads. A
+ * writer claims a slot with one fetch_add and publishes it by storing the
+ * slot sequence last; a reader skips slots whose sequence does not match,
+ * i.e. records being overwritten while dumping. Nothing is formatted until
+ * dump() is called. */
+class UwbTraceRing {
+public:
+  static UwbTraceRing &getInstance();
+
+  bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+  void setEnabled(bool enabled) {
+    mEnabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  void record(uint16_t event, uint32_t arg0, uint32_t arg1, uint32_t arg2,
+              uint32_t arg3);
+  /* Oldest to newest, one line per record */
+  std::string dump();
+
+private:
+  UwbTraceRing();
+
+  struct Record {
+    std::atomic<uint64_t> sequence; // claim index + 1, 0 while unwritten
+    int64_t timestampNs;
+    uint32_t tid;
+    uint16_t event;
+    uint32_t args[UWB_TRACE_MAX_ARGS];
+  };
+
+  static UwbTraceRing mObjTraceRing;
+
+  std::atomic<bool> mEnabled;
+  alignas(64) std::atomic<uint64_t> mNext;
+  Record mRecords[UWB_TRACE_RING_SIZE];
+};
+
+#define UWB_TRACE(event, a0, a1, a2, a3)                                       \
+  {                                                                            \
+    UwbTraceRing &traceRing = UwbTraceRing::getInstance();                     \
+    if (traceRing.isEnabled())                                                 \
+      traceRing.record((event), (uint32_t)(a0), (uint32_t)(a1),                \
+                       (uint32_t)(a2), (uint32_t)(a3));                        \
+  }